@@ -3,10 +3,13 @@
 #pragma once
 
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
 
 #include <nmpc_cgmres/CgmresProblem.h>
+#include <nmpc_common/ThreadPool.h>
+#include <nmpc_cgmres/Gmres.h>
 #include <nmpc_cgmres/OdeSolver.h>
 
 namespace nmpc_cgmres
@@ -18,6 +21,8 @@ namespace nmpc_cgmres
    2004.
       - https://www.coronasha.co.jp/np/isbn/9784339033182/
       - https://www.coronasha.co.jp/np/isbn/9784339032109/
+
+    \note calcControlInput() does not allocate memory after setup() if the problem does not allocate memory.
  */
 class CgmresSolver
 {
@@ -57,6 +62,26 @@ public:
   /** \brief Function to return \f$ A * v \f$ where \f$ v \f$ is given. */
   Eigen::VectorXd eqAmulFunc(const Eigen::Ref<const Eigen::VectorXd> & vec);
 
+  /** \brief Function to set \f$ A * v \f$ to ret where \f$ v \f$ is given. */
+  void eqAmulFunc(const Eigen::Ref<const Eigen::VectorXd> & vec, Eigen::Ref<Eigen::VectorXd> ret);
+
+  /** \brief Set thread pool.
+      \param thread_pool thread pool shared with other solvers to calculate DhDu in parallel along the horizon (nullptr
+      for serial)
+
+      calcDhDu of the problem must be thread-safe if the thread pool is set.
+   */
+  inline void setThreadPool(const std::shared_ptr<nmpc_common::ThreadPool> & thread_pool)
+  {
+    thread_pool_ = thread_pool;
+  }
+
+  /** \brief Get thread pool (nullptr for serial). */
+  inline const std::shared_ptr<nmpc_common::ThreadPool> & threadPool() const
+  {
+    return thread_pool_;
+  }
+
 public:
   std::shared_ptr<CgmresProblem> problem_;
   std::shared_ptr<OdeSolver> ode_solver_;
@@ -78,6 +103,10 @@ public:
 
   int dump_step_ = 5;
 
+  // GMRES solver, which keeps the workspace between control cycles
+  // gmres_.iter_callback_ is called in each GMRES iteration with the iteration number and residual norm
+  Gmres gmres_;
+
   //////// variables that are set during processing ////////
   Eigen::VectorXd x_;
   Eigen::VectorXd u_;
@@ -95,16 +124,24 @@ public:
   Eigen::MatrixXd DhDu_list_with_delta_;
   Eigen::MatrixXd DhDu_list_Amul_func_;
   // Eigen::Map does not have a default constructor
+  // the maps are created in setup() because the data of matrices are not reallocated afterwards
   std::shared_ptr<Eigen::Map<Eigen::VectorXd>> DhDu_vec_;
   std::shared_ptr<Eigen::Map<Eigen::VectorXd>> DhDu_vec_with_delta_;
   std::shared_ptr<Eigen::Map<Eigen::VectorXd>> DhDu_vec_Amul_func_;
 
+  Eigen::VectorXd eq_b_;
   Eigen::VectorXd delta_u_vec_;
 
+  Eigen::VectorXd xu_;
+
   //////// variables for utility ////////
   std::ofstream ofs_x_;
   std::ofstream ofs_u_;
   std::ofstream ofs_err_;
   const Eigen::IOFormat vecfmt_dump_ = Eigen::IOFormat(Eigen::StreamPrecision, 0, ", ", ", ", "", "", "", "");
+
+protected:
+  // thread pool to calculate DhDu in parallel (see setThreadPool())
+  std::shared_ptr<nmpc_common::ThreadPool> thread_pool_;
 };
 } // namespace nmpc_cgmres
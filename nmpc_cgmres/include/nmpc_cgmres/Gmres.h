@@ -17,6 +17,9 @@ namespace nmpc_cgmres
     See the following articles about the GMRES method:
       - C T Kelley. Iterative methods for linear and nonlinear equations. 1995.
       - https://www.coronasha.co.jp/np/isbn/9784339032109/
+
+    \note The workspace is kept in the members, so that solve() with AmulInPlaceFunc does not allocate memory after the
+    first call when the dimension and the maximum number of iterations are unchanged (and make_triangular_ is true).
  */
 class Gmres
 {
@@ -24,6 +27,12 @@ public:
   /** \brief Type of function that returns x multiplied by A. */
   using AmulFunc = std::function<Eigen::VectorXd(const Eigen::Ref<const Eigen::VectorXd> &)>;
 
+  /** \brief Type of function that sets x multiplied by A to the second argument. */
+  using AmulInPlaceFunc = std::function<void(const Eigen::Ref<const Eigen::VectorXd> &, Eigen::Ref<Eigen::VectorXd>)>;
+
+  /** \brief Type of function called in each GMRES iteration with the iteration number and residual norm. */
+  using IterCallback = std::function<void(int, double)>;
+
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
@@ -46,7 +55,8 @@ public:
                     double eps = 1e-10)
   {
     assert(A.rows() == b.size());
-    AmulFunc Amul_func = [&](const Eigen::Ref<const Eigen::VectorXd> & vec) { return A * vec; };
+    AmulInPlaceFunc Amul_func = [&](const Eigen::Ref<const Eigen::VectorXd> & vec, Eigen::Ref<Eigen::VectorXd> ret)
+    { ret.noalias() = A * vec; };
     solve(Amul_func, b, x, k_max, eps);
   }
 
@@ -58,27 +68,63 @@ public:
       \param eps the required solution tolerance
 
       Solve the linear equation: \f$ A x = b \f$.
+   */
+  inline void solve(const AmulFunc & Amul_func,
+                    const Eigen::Ref<const Eigen::VectorXd> & b,
+                    Eigen::Ref<Eigen::VectorXd> x,
+                    int k_max = 100,
+                    double eps = 1e-10)
+  {
+    AmulInPlaceFunc Amul_in_place_func = [&](const Eigen::Ref<const Eigen::VectorXd> & vec,
+                                             Eigen::Ref<Eigen::VectorXd> ret) { ret = Amul_func(vec); };
+    solve(Amul_in_place_func, b, x, k_max, eps);
+  }
+
+  /** \brief Solve.
+      \param Amul_func the function to set \f$ A * v \f$ to the second argument where \f$ v \f$ is given
+      \param b the vector of linear equation
+      \param x the initial guess of solution, which is overwritten by the final solution
+      \param k_max the maximum number of GMRES iteration
+      \param eps the required solution tolerance
+
+      Solve the linear equation: \f$ A x = b \f$.
 
       Refer to the Algorithm 3.5.1. in [1] for the case that make_triangular_ is true.
       Refer to the Algorithm 3.4.2. in [1] for the case that make_triangular_ is false.
       [1] Kelley, Carl T. Iterative methods for linear and nonlinear equations. Society for Industrial and Applied
      Mathematics, 1995.
    */
-  inline void solve(const AmulFunc & Amul_func,
+  inline void solve(const AmulInPlaceFunc & Amul_func,
                     const Eigen::Ref<const Eigen::VectorXd> & b,
                     Eigen::Ref<Eigen::VectorXd> x,
                     int k_max = 100,
                     double eps = 1e-10)
   {
     k_max = std::min(k_max, static_cast<int>(x.size()));
+    int dim = static_cast<int>(x.size());
 
+    // Allocate workspace (no allocation if the sizes are unchanged)
     err_list_.clear();
-    basis_.clear();
+    err_list_.reserve(k_max + 1);
+    if(basis_.size() < static_cast<size_t>(k_max + 1))
+    {
+      basis_.resize(k_max + 1);
+    }
+    for(auto & basis : basis_)
+    {
+      basis.resize(dim);
+    }
+    r_.resize(dim);
+    Avk_.resize(dim);
+    y_.resize(k_max);
+    c_list_.resize(k_max);
+    s_list_.resize(k_max);
 
     // 1.
-    Eigen::VectorXd r = b - Amul_func(x);
-    basis_.push_back(r.normalized());
-    double rho = r.norm();
+    Amul_func(x, r_);
+    r_ = b - r_;
+    double rho = r_.norm();
+    setNormalized(r_, rho, basis_[0]);
     int k = 0;
     g_.setZero(k_max + 1);
     g_(0) = rho;
@@ -88,9 +134,6 @@ public:
     err_list_.push_back(rho);
 
     // 2.
-    Eigen::VectorXd y_k;
-    std::vector<double> c_list;
-    std::vector<double> s_list;
     while(rho > eps * b_norm && k < k_max)
     {
       // (a).
@@ -98,39 +141,10 @@ public:
       k++;
 
       // (b).
-      // new_basis corresponds to $v_{k+1}$ in the paper
-      Eigen::VectorXd Avk = Amul_func(basis_.back());
-      Eigen::VectorXd new_basis = Avk;
-      for(int j = 0; j < k; j++)
-      {
-        // i.
-        H_(j, k - 1) = new_basis.dot(basis_[j]);
-        // ii.
-        new_basis = new_basis - H_(j, k - 1) * basis_[j];
-      }
-
-      // (c).
-      double new_basis_norm = new_basis.norm();
-      H_(k, k - 1) = new_basis_norm;
-
-      // (d).
-      if(apply_reorth_)
-      {
-        double Avk_norm = Avk.norm();
-        if(Avk_norm + 1e-3 * new_basis_norm == Avk_norm)
-        {
-          // std::cout << "apply reorthogonalization. (loop: " << k << ")" << std::endl;
-          for(int j = 0; j < k; j++)
-          {
-            double h_tmp = new_basis.dot(basis_[j]);
-            H_(j, k - 1) += h_tmp;
-            new_basis -= h_tmp * basis_[j];
-          }
-        }
-      }
+      Amul_func(basis_[k - 1], Avk_);
 
-      // (e).
-      basis_.push_back(new_basis.normalized());
+      // (c)-(e).
+      orthogonalize(k);
 
       if(make_triangular_)
       {
@@ -140,8 +154,8 @@ public:
         {
           double h0 = H_(i, k - 1);
           double h1 = H_(i + 1, k - 1);
-          double c = c_list[i];
-          double s = s_list[i];
+          double c = c_list_[i];
+          double s = s_list_[i];
           H_(i, k - 1) = c * h0 - s * h1;
           H_(i + 1, k - 1) = s * h0 + c * h1;
         }
@@ -152,8 +166,8 @@ public:
         // iii.
         double c_k = H_(k - 1, k - 1) / nu;
         double s_k = -H_(k, k - 1) / nu;
-        c_list.push_back(c_k);
-        s_list.push_back(s_k);
+        c_list_[k - 1] = c_k;
+        s_list_[k - 1] = s_k;
         H_(k - 1, k - 1) = c_k * H_(k - 1, k - 1) - s_k * H_(k, k - 1);
         H_(k, k - 1) = 0;
 
@@ -169,25 +183,86 @@ public:
       else
       {
         // (f).
-        y_k = H_.topLeftCorner(k + 1, k).householderQr().solve(g_.head(k + 1));
+        y_.head(k) = H_.topLeftCorner(k + 1, k).householderQr().solve(g_.head(k + 1));
 
         // (g).
-        rho = (g_.head(k + 1) - H_.topLeftCorner(k + 1, k) * y_k).norm();
+        rho = (g_.head(k + 1) - H_.topLeftCorner(k + 1, k) * y_.head(k)).norm();
       }
 
       err_list_.push_back(rho);
+
+      if(iter_callback_)
+      {
+        iter_callback_(k, rho);
+      }
     }
 
     if(make_triangular_)
     {
       // 3.
-      y_k = H_.topLeftCorner(k, k).triangularView<Eigen::Upper>().solve(g_.head(k));
+      y_.head(k) = g_.head(k);
+      H_.topLeftCorner(k, k).triangularView<Eigen::Upper>().solveInPlace(y_.head(k));
     }
 
     // 4.
     for(int i = 0; i < k; i++)
     {
-      x += y_k(i) * basis_[i];
+      x += y_(i) * basis_[i];
+    }
+  }
+
+protected:
+  /** \brief Orthogonalize Avk_ against the first k bases by the modified Gram-Schmidt process, and set the result to
+      the (k+1)-th basis.
+   */
+  inline void orthogonalize(int k)
+  {
+    // (b).
+    // new_basis corresponds to $v_{k+1}$ in the paper
+    Eigen::VectorXd & new_basis = r_;
+    new_basis = Avk_;
+    for(int j = 0; j < k; j++)
+    {
+      // i.
+      H_(j, k - 1) = new_basis.dot(basis_[j]);
+      // ii.
+      new_basis -= H_(j, k - 1) * basis_[j];
+    }
+
+    // (c).
+    double new_basis_norm = new_basis.norm();
+    H_(k, k - 1) = new_basis_norm;
+
+    // (d).
+    if(apply_reorth_)
+    {
+      double Avk_norm = Avk_.norm();
+      if(Avk_norm + 1e-3 * new_basis_norm == Avk_norm)
+      {
+        // std::cout << "apply reorthogonalization. (loop: " << k << ")" << std::endl;
+        for(int j = 0; j < k; j++)
+        {
+          double h_tmp = new_basis.dot(basis_[j]);
+          H_(j, k - 1) += h_tmp;
+          new_basis -= h_tmp * basis_[j];
+        }
+      }
+    }
+
+    // (e).
+    setNormalized(new_basis, new_basis.norm(), basis_[k]);
+  }
+
+  /** \brief Set normalized vector (the vector itself if the norm is zero). */
+  static inline void setNormalized(const Eigen::VectorXd & vec, double norm, Eigen::VectorXd & ret)
+  {
+    if(norm > 0)
+    {
+      ret = vec / norm;
+    }
+    else
+    {
+      ret = vec;
     }
   }
 
@@ -195,11 +270,32 @@ public:
   bool make_triangular_ = true;
   bool apply_reorth_ = true;
 
+  IterCallback iter_callback_;
+
   Eigen::MatrixXd H_;
   Eigen::VectorXd g_;
 
   std::vector<double> err_list_;
 
+  /** \brief Orthonormal basis of the Krylov subspace.
+
+      Only the first (err_list_.size()) elements are the basis of the last solve(). This is also used as the workspace,
+      so it has k_max + 1 elements, and the remaining elements are left from the previous solves.
+   */
   std::vector<Eigen::VectorXd> basis_;
+
+protected:
+  //! Workspace of residual and new basis
+  Eigen::VectorXd r_;
+
+  //! Workspace of A multiplied by basis
+  Eigen::VectorXd Avk_;
+
+  //! Workspace of solution in the Krylov subspace
+  Eigen::VectorXd y_;
+
+  //! Workspace of Givens rotation
+  Eigen::VectorXd c_list_;
+  Eigen::VectorXd s_list_;
 };
 } // namespace nmpc_cgmres
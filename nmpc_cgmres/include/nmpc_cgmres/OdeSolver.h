@@ -30,7 +30,10 @@ public:
                      Eigen::Ref<Eigen::VectorXd> ret) = 0;
 };
 
-/** \brief Class to solve Ordinaly Diferential Equation by Euler method. */
+/** \brief Class to solve Ordinaly Diferential Equation by Euler method.
+
+    \note The workspace is kept in the members, so that solve() does not allocate memory after the first call.
+ */
 class EulerOdeSolver : public OdeSolver
 {
 public:
@@ -43,13 +46,20 @@ public:
                      double dt,
                      Eigen::Ref<Eigen::VectorXd> ret) override
   {
-    Eigen::VectorXd dotx(x.size());
-    state_eq(t, x, u, dotx);
-    ret = x + dt * dotx;
+    dotx_.resize(x.size());
+    state_eq(t, x, u, dotx_);
+    ret = x + dt * dotx_;
   }
+
+protected:
+  //! Workspace of time derivative of state
+  Eigen::VectorXd dotx_;
 };
 
-/** \brief Class to solve Ordinaly Diferential Equation by Runge-Kutta method. */
+/** \brief Class to solve Ordinaly Diferential Equation by Runge-Kutta method.
+
+    \note The workspace is kept in the members, so that solve() does not allocate memory after the first call.
+ */
 class RungeKuttaOdeSolver : public OdeSolver
 {
 public:
@@ -63,12 +73,26 @@ public:
                      Eigen::Ref<Eigen::VectorXd> ret) override
   {
     double dt_half = dt / 2;
-    Eigen::VectorXd k1(x.size()), k2(x.size()), k3(x.size()), k4(x.size());
-    state_eq(t, x, u, k1);
-    state_eq(t + dt_half, x + dt_half * k1, u, k2);
-    state_eq(t + dt_half, x + dt_half * k2, u, k3);
-    state_eq(t + dt, x + dt * k3, u, k4);
-    ret = x + (dt / 6) * (k1 + 2 * k2 + 2 * k3 + k4);
+    k1_.resize(x.size());
+    k2_.resize(x.size());
+    k3_.resize(x.size());
+    k4_.resize(x.size());
+    x_tmp_.resize(x.size());
+    state_eq(t, x, u, k1_);
+    x_tmp_ = x + dt_half * k1_;
+    state_eq(t + dt_half, x_tmp_, u, k2_);
+    x_tmp_ = x + dt_half * k2_;
+    state_eq(t + dt_half, x_tmp_, u, k3_);
+    x_tmp_ = x + dt * k3_;
+    state_eq(t + dt, x_tmp_, u, k4_);
+    ret = x + (dt / 6) * (k1_ + 2 * k2_ + 2 * k3_ + k4_);
   }
+
+protected:
+  //! Workspace of intermediate time derivatives of state
+  Eigen::VectorXd k1_, k2_, k3_, k4_;
+
+  //! Workspace of intermediate state
+  Eigen::VectorXd x_tmp_;
 };
 } // namespace nmpc_cgmres
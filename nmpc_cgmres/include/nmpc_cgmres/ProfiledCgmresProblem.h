@@ -0,0 +1,116 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <memory>
+
+#include <nmpc_cgmres/CgmresProblem.h>
+#include <nmpc_common/ProblemProfile.h>
+
+namespace nmpc_cgmres
+{
+/** \brief Decorator of C/GMRES problem to profile the calls of its callbacks.
+
+    Each callback is forwarded to the decorated problem, counting the calls and accumulating the duration in profile()
+    (see nmpc_common::ProblemProfile). The dimensions and the initial values are copied from the decorated problem.
+ */
+class ProfiledCgmresProblem : public CgmresProblem
+{
+public:
+  /*! \brief Index of callback in profile. */
+  enum Call : int
+  {
+    //! stateEquation()
+    StateEquation = 0,
+
+    //! costateEquation()
+    CostateEquation,
+
+    //! calcDphiDx()
+    DphiDx,
+
+    //! calcDhDu()
+    DhDu,
+
+    //! Number of callbacks
+    CallNum
+  };
+
+public:
+  /** \brief Constructor.
+      \param problem decorated problem
+   */
+  ProfiledCgmresProblem(const std::shared_ptr<CgmresProblem> & problem)
+  : problem_(problem), profile_(std::make_shared<nmpc_common::ProblemProfile>(
+                           std::vector<std::string>{"stateEquation", "costateEquation", "calcDphiDx", "calcDhDu"}))
+  {
+    dim_x_ = problem_->dim_x_;
+    dim_u_ = problem_->dim_u_;
+    dim_c_ = problem_->dim_c_;
+    dim_uc_ = problem_->dim_uc_;
+    state_eq_param_ = problem_->state_eq_param_;
+    x_initial_ = problem_->x_initial_;
+    u_initial_ = problem_->u_initial_;
+  }
+
+  /** \brief Const accessor to decorated problem. */
+  inline const std::shared_ptr<CgmresProblem> & problem() const
+  {
+    return problem_;
+  }
+
+  /** \brief Accessor to profile. */
+  inline nmpc_common::ProblemProfile & profile() const
+  {
+    return *profile_;
+  }
+
+  virtual void stateEquation(double t,
+                             const Eigen::Ref<const Eigen::VectorXd> & x,
+                             const Eigen::Ref<const Eigen::VectorXd> & u,
+                             Eigen::Ref<Eigen::VectorXd> dotx) override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, Call::StateEquation);
+    problem_->stateEquation(t, x, u, dotx);
+  }
+
+  virtual void costateEquation(double t,
+                               const Eigen::Ref<const Eigen::VectorXd> & lmd,
+                               const Eigen::Ref<const Eigen::VectorXd> & xu,
+                               Eigen::Ref<Eigen::VectorXd> dotlmd) override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, Call::CostateEquation);
+    problem_->costateEquation(t, lmd, xu, dotlmd);
+  }
+
+  virtual void calcDphiDx(double t,
+                          const Eigen::Ref<const Eigen::VectorXd> & x,
+                          Eigen::Ref<Eigen::VectorXd> DphiDx) override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, Call::DphiDx);
+    problem_->calcDphiDx(t, x, DphiDx);
+  }
+
+  virtual void calcDhDu(double t,
+                        const Eigen::Ref<const Eigen::VectorXd> & x,
+                        const Eigen::Ref<const Eigen::VectorXd> & u,
+                        const Eigen::Ref<const Eigen::VectorXd> & lmd,
+                        Eigen::Ref<Eigen::VectorXd> DhDu) override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, Call::DhDu);
+    problem_->calcDhDu(t, x, u, lmd, DhDu);
+  }
+
+  virtual void dumpData(std::ofstream & ofs) override
+  {
+    problem_->dumpData(ofs);
+  }
+
+protected:
+  //! Decorated problem
+  std::shared_ptr<CgmresProblem> problem_;
+
+  //! Profile of calls
+  std::shared_ptr<nmpc_common::ProblemProfile> profile_;
+};
+} // namespace nmpc_cgmres
@@ -1,7 +1,6 @@
 /* Author: Masaki Murooka */
 
 #include <nmpc_cgmres/CgmresSolver.h>
-#include <nmpc_cgmres/Gmres.h>
 
 using namespace nmpc_cgmres;
 
@@ -60,7 +59,15 @@ void CgmresSolver::setup()
   }
   DhDu_list_with_delta_.resize(problem_->dim_uc_, horizon_divide_num_);
   DhDu_list_Amul_func_.resize(problem_->dim_uc_, horizon_divide_num_);
+  // assume that the matrix is column major order, which is the default setting of Eigen
+  DhDu_vec_ = std::make_shared<Eigen::Map<Eigen::VectorXd>>(DhDu_list_.data(), DhDu_list_.size());
+  DhDu_vec_with_delta_ =
+      std::make_shared<Eigen::Map<Eigen::VectorXd>>(DhDu_list_with_delta_.data(), DhDu_list_with_delta_.size());
+  DhDu_vec_Amul_func_ =
+      std::make_shared<Eigen::Map<Eigen::VectorXd>>(DhDu_list_Amul_func_.data(), DhDu_list_Amul_func_.size());
+  eq_b_.resize(horizon_divide_num_ * problem_->dim_uc_);
   delta_u_vec_.setZero(horizon_divide_num_ * problem_->dim_uc_);
+  xu_.resize(problem_->dim_x_ + problem_->dim_uc_);
 }
 
 void CgmresSolver::run()
@@ -122,16 +129,14 @@ void CgmresSolver::calcControlInput(double t,
   calcDhDuList(t_with_delta_, x_with_delta_, u_list_, DhDu_list_with_delta_);
 
   // 2.1 calculate a vector of the linear equation
-  // assume that the matrix is column major order, which is the default setting of Eigen
-  DhDu_vec_ = std::make_shared<Eigen::Map<Eigen::VectorXd>>(DhDu_list_.data(), DhDu_list_.size());
-  DhDu_vec_with_delta_ =
-      std::make_shared<Eigen::Map<Eigen::VectorXd>>(DhDu_list_with_delta_.data(), DhDu_list_with_delta_.size());
-  const Eigen::VectorXd & eq_b =
-      ((1 - eq_zeta_ * finite_diff_delta_) * (*DhDu_vec_) - (*DhDu_vec_with_delta_)) / finite_diff_delta_;
+  // DhDu_vec_ and DhDu_vec_with_delta_ are the maps of DhDu_list_ and DhDu_list_with_delta_ created in setup()
+  eq_b_ = ((1 - eq_zeta_ * finite_diff_delta_) * (*DhDu_vec_) - (*DhDu_vec_with_delta_)) / finite_diff_delta_;
 
   // 2.2 solve the linear equation by GMRES method
-  Gmres gmres;
-  gmres.solve(std::bind(&CgmresSolver::eqAmulFunc, this, std::placeholders::_1), eq_b, delta_u_vec_, k_max_, 1e-10);
+  // the lambda only captures this so that std::function does not allocate memory
+  gmres_.solve(Gmres::AmulInPlaceFunc([this](const Eigen::Ref<const Eigen::VectorXd> & vec,
+                                             Eigen::Ref<Eigen::VectorXd> ret) { eqAmulFunc(vec, ret); }),
+               eq_b_, delta_u_vec_, k_max_, 1e-10);
 
   // 2.3 update u_list_ from delta_u_vec_
   for(int i = 0; i < horizon_divide_num_; i++)
@@ -154,36 +159,66 @@ void CgmresSolver::calcDhDuList(double t,
   // 1.1 calculate x_list_[0]
   x_list_.col(0) = x;
 
+  // the lambdas only capture a pointer so that std::function does not allocate memory
+  CgmresProblem * problem = problem_.get();
+  const OdeSolver::StateEquation state_eq = [problem](double t, const Eigen::Ref<const Eigen::VectorXd> & x,
+                                                      const Eigen::Ref<const Eigen::VectorXd> & u,
+                                                      Eigen::Ref<Eigen::VectorXd> dotx)
+  { problem->stateEquation(t, x, u, dotx); };
+  const OdeSolver::StateEquation costate_eq = [problem](double t, const Eigen::Ref<const Eigen::VectorXd> & lmd,
+                                                        const Eigen::Ref<const Eigen::VectorXd> & xu,
+                                                        Eigen::Ref<Eigen::VectorXd> dotlmd)
+  { problem->costateEquation(t, lmd, xu, dotlmd); };
+
   double tau = t;
   for(int i = 0; i < horizon_divide_num_; i++)
   {
     // 1.2 calculate x_list_[1, ..., horizon_divide_num_]
-    ode_solver_->solve(std::bind(&CgmresProblem::stateEquation, problem_.get(), std::placeholders::_1,
-                                 std::placeholders::_2, std::placeholders::_3, std::placeholders::_4),
-                       tau, x_list_.col(i), u_list.col(i), horizon_divide_step, x_list_.col(i + 1));
+    ode_solver_->solve(state_eq, tau, x_list_.col(i), u_list.col(i), horizon_divide_step, x_list_.col(i + 1));
     tau += horizon_divide_step;
   }
 
   // 2.1 calculate lmd_list_[horizon_divide_num_]
   problem_->calcDphiDx(tau, x_list_.col(horizon_divide_num_), lmd_list_.col(horizon_divide_num_));
 
-  Eigen::VectorXd xu(problem_->dim_x_ + problem_->dim_uc_);
+  xu_.resize(problem_->dim_x_ + problem_->dim_uc_);
   for(int i = horizon_divide_num_ - 1; i >= 0; i--)
   {
     // 2.2 calculate lmd_list_[horizon_divide_num_-1, ..., 0]
-    xu.head(problem_->dim_x_) = x_list_.col(i);
-    xu.tail(problem_->dim_uc_) = u_list.col(i);
-    ode_solver_->solve(std::bind(&CgmresProblem::costateEquation, problem_.get(), std::placeholders::_1,
-                                 std::placeholders::_2, std::placeholders::_3, std::placeholders::_4),
-                       tau, lmd_list_.col(i + 1), xu, -horizon_divide_step, lmd_list_.col(i));
+    xu_.head(problem_->dim_x_) = x_list_.col(i);
+    xu_.tail(problem_->dim_uc_) = u_list.col(i);
+    ode_solver_->solve(costate_eq, tau, lmd_list_.col(i + 1), xu_, -horizon_divide_step, lmd_list_.col(i));
     tau -= horizon_divide_step;
+  }
 
-    // 3. DhDu_list[horizon_divide_num_-1, ..., 0]
-    problem_->calcDhDu(tau, x_list_.col(i), u_list.col(i), lmd_list_.col(i + 1), DhDu_list.col(i));
+  // 3. DhDu_list[0, ..., horizon_divide_num_-1]
+  // the steps are independent of each other and are calculated in parallel if the thread pool is set
+  auto calc_DhDu = [&](int i)
+  {
+    problem_->calcDhDu(t + i * horizon_divide_step, x_list_.col(i), u_list.col(i), lmd_list_.col(i + 1),
+                       DhDu_list.col(i));
+  };
+  if(thread_pool_)
+  {
+    thread_pool_->parallelFor(0, horizon_divide_num_, calc_DhDu);
+  }
+  else
+  {
+    for(int i = 0; i < horizon_divide_num_; i++)
+    {
+      calc_DhDu(i);
+    }
   }
 }
 
 Eigen::VectorXd CgmresSolver::eqAmulFunc(const Eigen::Ref<const Eigen::VectorXd> & vec)
+{
+  Eigen::VectorXd ret(vec.size());
+  eqAmulFunc(vec, ret);
+  return ret;
+}
+
+void CgmresSolver::eqAmulFunc(const Eigen::Ref<const Eigen::VectorXd> & vec, Eigen::Ref<Eigen::VectorXd> ret)
 {
   // 1. calculate u_list_Amul_func_
   for(int i = 0; i < horizon_divide_num_; i++)
@@ -196,7 +231,6 @@ Eigen::VectorXd CgmresSolver::eqAmulFunc(const Eigen::Ref<const Eigen::VectorXd>
   calcDhDuList(t_with_delta_, x_with_delta_, u_list_Amul_func_, DhDu_list_Amul_func_);
 
   // 3. calculate the finite difference
-  DhDu_vec_Amul_func_ =
-      std::make_shared<Eigen::Map<Eigen::VectorXd>>(DhDu_list_Amul_func_.data(), DhDu_list_Amul_func_.size());
-  return ((*DhDu_vec_Amul_func_) - (*DhDu_vec_with_delta_)) / finite_diff_delta_;
+  // DhDu_vec_Amul_func_ is the map of DhDu_list_Amul_func_ created in setup()
+  ret = ((*DhDu_vec_Amul_func_) - (*DhDu_vec_with_delta_)) / finite_diff_delta_;
 }
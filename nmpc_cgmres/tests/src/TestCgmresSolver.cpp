@@ -3,18 +3,24 @@
 #include <gtest/gtest.h>
 
 #include <nmpc_cgmres/CgmresSolver.h>
+#include <nmpc_cgmres/ProfiledCgmresProblem.h>
 
 #include "CartPoleProblem.h"
 #include "SemiactiveDamperProblem.h"
 
-void testCgmresSolver(const std::shared_ptr<nmpc_cgmres::CgmresProblem> & problem, double x_thre)
+std::shared_ptr<nmpc_cgmres::CgmresSolver> testCgmresSolver(
+    const std::shared_ptr<nmpc_cgmres::CgmresProblem> & problem,
+    double x_thre,
+    const std::shared_ptr<nmpc_common::ThreadPool> & thread_pool = nullptr)
 {
   auto ode_solver = std::make_shared<nmpc_cgmres::EulerOdeSolver>();
   auto sim_ode_solver = std::make_shared<nmpc_cgmres::RungeKuttaOdeSolver>();
   auto solver = std::make_shared<nmpc_cgmres::CgmresSolver>(problem, ode_solver, sim_ode_solver);
   solver->sim_duration_ = 20.0;
+  solver->setThreadPool(thread_pool);
   solver->run();
   EXPECT_LT(solver->x_.norm(), x_thre);
+  return solver;
 }
 
 TEST(TestCgmresSolver, SemiactiveDamperProblem)
@@ -27,6 +33,38 @@ TEST(TestCgmresSolver, CartPoleProblem)
   testCgmresSolver(std::make_shared<CartPoleProblem>(nullptr, true), 0.1);
 }
 
+TEST(TestCgmresSolver, ThreadPool)
+{
+  nmpc_common::ThreadPool::Configuration config;
+  config.thread_num = 2;
+  auto thread_pool = std::make_shared<nmpc_common::ThreadPool>(config);
+
+  // Check that the result does not depend on the thread pool
+  auto serial_solver = testCgmresSolver(std::make_shared<CartPoleProblem>(nullptr, true), 0.1);
+  auto parallel_solver = testCgmresSolver(std::make_shared<CartPoleProblem>(nullptr, true), 0.1, thread_pool);
+  EXPECT_EQ(serial_solver->x_, parallel_solver->x_);
+  EXPECT_EQ(serial_solver->u_, parallel_solver->u_);
+}
+
+TEST(TestCgmresSolver, ProfiledProblem)
+{
+  auto profiled_problem =
+      std::make_shared<nmpc_cgmres::ProfiledCgmresProblem>(std::make_shared<CartPoleProblem>(nullptr, true));
+
+  // Check that the result does not depend on the profile
+  auto ref_solver = testCgmresSolver(std::make_shared<CartPoleProblem>(nullptr, true), 0.1);
+  auto solver = testCgmresSolver(profiled_problem, 0.1);
+  EXPECT_EQ(ref_solver->x_, solver->x_);
+  EXPECT_EQ(ref_solver->u_, solver->u_);
+
+  auto report = profiled_problem->profile().report();
+  report.print();
+  for(const auto & entry : report.entries)
+  {
+    EXPECT_GT(entry.count, 0) << entry.name;
+  }
+}
+
 int main(int argc, char ** argv)
 {
   testing::InitGoogleTest(&argc, argv);
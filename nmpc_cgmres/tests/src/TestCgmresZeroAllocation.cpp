@@ -0,0 +1,67 @@
+/* Author: Masaki Murooka */
+
+// AllocationCounter.h must be included before any Eigen header
+#include <nmpc_common/AllocationCounter.h>
+
+#include <gtest/gtest.h>
+
+#include <nmpc_cgmres/CgmresSolver.h>
+
+#include "CartPoleProblem.h"
+#include "SemiactiveDamperProblem.h"
+
+NMPC_DEFINE_ALLOCATION_COUNTER()
+
+void testCgmresSolver(const std::shared_ptr<nmpc_cgmres::CgmresProblem> & problem)
+{
+  auto ode_solver = std::make_shared<nmpc_cgmres::EulerOdeSolver>();
+  auto sim_ode_solver = std::make_shared<nmpc_cgmres::RungeKuttaOdeSolver>();
+  auto solver = std::make_shared<nmpc_cgmres::CgmresSolver>(problem, ode_solver, sim_ode_solver);
+  solver->setup();
+
+  Eigen::VectorXd x = problem->x_initial_;
+  Eigen::VectorXd next_x(problem->dim_x_);
+  Eigen::VectorXd u = solver->u_;
+  auto sim_state_eq = [&](double t, const Eigen::Ref<const Eigen::VectorXd> & x,
+                          const Eigen::Ref<const Eigen::VectorXd> & u, Eigen::Ref<Eigen::VectorXd> dotx)
+  { problem->stateEquation(t, x, u, dotx); };
+
+  double t = 0;
+  for(int i = 0; i < 20; i++)
+  {
+    sim_ode_solver->solve(sim_state_eq, t, x, u, solver->dt_, next_x);
+
+    // The GMRES workspace is allocated in the first control cycle
+    nmpc_common::AllocationCounter counter;
+    solver->calcControlInput(t, x, next_x, u);
+    size_t allocation_num = counter.stop();
+    if(i == 0)
+    {
+      EXPECT_GT(allocation_num, 0);
+    }
+    else
+    {
+      EXPECT_EQ(allocation_num, 0) << "control cycle: " << i;
+    }
+
+    x = next_x;
+    t += solver->dt_;
+  }
+  EXPECT_TRUE(u.allFinite());
+}
+
+TEST(TestCgmresZeroAllocation, SemiactiveDamperProblem)
+{
+  testCgmresSolver(std::make_shared<SemiactiveDamperProblem>());
+}
+
+TEST(TestCgmresZeroAllocation, CartPoleProblem)
+{
+  testCgmresSolver(std::make_shared<CartPoleProblem>(nullptr, true));
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -155,6 +155,33 @@ TEST(TestGmres, TestCase1)
   }
 }
 
+TEST(TestGmres, IterCallback)
+{
+  int eq_size = 50;
+  Eigen::MatrixXd A = Eigen::MatrixXd::Random(eq_size, eq_size);
+  Eigen::VectorXd b = Eigen::VectorXd::Random(eq_size);
+  Eigen::VectorXd x = Eigen::VectorXd::Zero(eq_size);
+
+  std::vector<int> iter_list;
+  std::vector<double> err_list;
+  nmpc_cgmres::Gmres gmres;
+  gmres.iter_callback_ = [&](int k, double err)
+  {
+    iter_list.push_back(k);
+    err_list.push_back(err);
+  };
+  gmres.solve(static_cast<const Eigen::Ref<const Eigen::MatrixXd> &>(A), b, x, eq_size);
+
+  ASSERT_GT(iter_list.size(), 0);
+  EXPECT_EQ(iter_list.size() + 1, gmres.err_list_.size());
+  for(size_t i = 0; i < iter_list.size(); i++)
+  {
+    EXPECT_EQ(iter_list[i], static_cast<int>(i) + 1);
+    EXPECT_EQ(err_list[i], gmres.err_list_[i + 1]);
+  }
+  EXPECT_LT((A * x - b).norm(), 1e-10);
+}
+
 int main(int argc, char ** argv)
 {
   testing::InitGoogleTest(&argc, argv);
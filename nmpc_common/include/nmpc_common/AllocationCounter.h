@@ -0,0 +1,221 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+/** \file
+    \brief Utility to verify that no heap memory is allocated in a code section (e.g., steady-state solve).
+
+    Both C++ allocations (operator new, used by std::vector, std::make_shared, std::function, etc.) and Eigen
+    allocations (Eigen::internal::aligned_malloc, which bypasses operator new) are counted.
+    This header must be included before any Eigen header, and NMPC_DEFINE_ALLOCATION_COUNTER() must be placed once
+    in the executable (at global scope) to replace the global operator new.
+
+    \code
+    #include <nmpc_common/AllocationCounter.h> // must be the first include
+    ...
+    NMPC_DEFINE_ALLOCATION_COUNTER()
+
+    solver->solve(...); // warm-up
+    nmpc_common::AllocationCounter counter;
+    solver->solve(...);
+    EXPECT_EQ(counter.stop(), 0);
+    \endcode
+ */
+
+#if defined(EIGEN_CORE_H) || defined(EIGEN_CORE_MODULE_H)
+#  error "nmpc_common/AllocationCounter.h must be included before any Eigen header."
+#endif
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace nmpc_common
+{
+/** \brief Counter of heap memory allocation in the calling thread.
+
+    Counting starts in the constructor and ends in stop() or the destructor. Counting is thread-local, so allocations
+    in other threads (e.g., by test framework) are ignored.
+ */
+class AllocationCounter
+{
+public:
+  /** \brief Constructor (start counting). */
+  AllocationCounter();
+
+  /** \brief Destructor (stop counting). */
+  ~AllocationCounter()
+  {
+    stop();
+  }
+
+  /** \brief Stop counting.
+      \return number of allocations since construction
+   */
+  inline size_t stop();
+
+  /** \brief Get the number of allocations since construction. */
+  inline size_t count() const
+  {
+    return state().count;
+  }
+
+  /** \brief Notify allocation (called by the replaced operator new and Eigen). */
+  static inline void notifyAllocation()
+  {
+    if(state().counting)
+    {
+      state().count++;
+    }
+  }
+
+  /** \brief Handle assertion of Eigen.
+
+      With EIGEN_RUNTIME_NO_MALLOC, Eigen asserts that malloc is allowed before every heap allocation. The failure of
+      this assertion is counted as allocation, and other assertions behave as the default eigen_assert.
+   */
+  static inline void eigenAssert(bool cond, const char * expr, const char * file, int line)
+  {
+    if(cond)
+    {
+      return;
+    }
+    if(std::strstr(expr, "is_malloc_allowed") != nullptr)
+    {
+      notifyAllocation();
+      return;
+    }
+#ifndef NDEBUG
+    std::fprintf(stderr, "%s:%d: Eigen assertion failed: %s\n", file, line, expr);
+    std::abort();
+#else
+    (void)file;
+    (void)line;
+#endif
+  }
+
+protected:
+  /*! \brief Thread-local counting state. */
+  struct State
+  {
+    //! Whether to count
+    bool counting = false;
+
+    //! Number of allocations
+    size_t count = 0;
+  };
+
+  /** \brief Accessor to thread-local counting state. */
+  static inline State & state()
+  {
+    thread_local State state;
+    return state;
+  }
+
+protected:
+  //! Whether counting is active in this instance
+  bool active_ = false;
+};
+} // namespace nmpc_common
+
+// Make Eigen check whether malloc is allowed before each allocation, and count the check failures
+#ifndef EIGEN_RUNTIME_NO_MALLOC
+#  define EIGEN_RUNTIME_NO_MALLOC
+#endif
+#ifndef eigen_assert
+#  define eigen_assert(x) nmpc_common::AllocationCounter::eigenAssert(static_cast<bool>(x), #x, __FILE__, __LINE__)
+#endif
+
+#include <Eigen/Core>
+
+namespace nmpc_common
+{
+inline AllocationCounter::AllocationCounter()
+{
+  state().count = 0;
+  state().counting = true;
+  active_ = true;
+  Eigen::internal::set_is_malloc_allowed(false);
+}
+
+inline size_t AllocationCounter::stop()
+{
+  if(active_)
+  {
+    state().counting = false;
+    active_ = false;
+    Eigen::internal::set_is_malloc_allowed(true);
+  }
+  return state().count;
+}
+} // namespace nmpc_common
+
+/** \brief Define replacement of global operator new and delete to count allocations.
+
+    This must be placed once in the executable at global scope. The operators are not inlined so that the compiler
+    does not warn about the pair of operator new and free.
+ */
+#define NMPC_DEFINE_ALLOCATION_COUNTER()                                                               \
+  __attribute__((noinline)) void * operator new(std::size_t size)                                      \
+  {                                                                                                    \
+    nmpc_common::AllocationCounter::notifyAllocation();                                                \
+    void * ptr = std::malloc(size > 0 ? size : 1);                                                     \
+    if(!ptr)                                                                                           \
+    {                                                                                                  \
+      throw std::bad_alloc();                                                                          \
+    }                                                                                                  \
+    return ptr;                                                                                        \
+  }                                                                                                    \
+  void * operator new[](std::size_t size)                                                              \
+  {                                                                                                    \
+    return operator new(size);                                                                         \
+  }                                                                                                    \
+  __attribute__((noinline)) void * operator new(std::size_t size, std::align_val_t align)              \
+  {                                                                                                    \
+    nmpc_common::AllocationCounter::notifyAllocation();                                                \
+    size_t alignment = static_cast<size_t>(align);                                                     \
+    void * ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);        \
+    if(!ptr)                                                                                           \
+    {                                                                                                  \
+      throw std::bad_alloc();                                                                          \
+    }                                                                                                  \
+    return ptr;                                                                                        \
+  }                                                                                                    \
+  void * operator new[](std::size_t size, std::align_val_t align)                                      \
+  {                                                                                                    \
+    return operator new(size, align);                                                                  \
+  }                                                                                                    \
+  __attribute__((noinline)) void operator delete(void * ptr) noexcept                                  \
+  {                                                                                                    \
+    std::free(ptr);                                                                                    \
+  }                                                                                                    \
+  __attribute__((noinline)) void operator delete[](void * ptr) noexcept                                \
+  {                                                                                                    \
+    std::free(ptr);                                                                                    \
+  }                                                                                                    \
+  __attribute__((noinline)) void operator delete(void * ptr, std::size_t) noexcept                     \
+  {                                                                                                    \
+    std::free(ptr);                                                                                    \
+  }                                                                                                    \
+  __attribute__((noinline)) void operator delete[](void * ptr, std::size_t) noexcept                   \
+  {                                                                                                    \
+    std::free(ptr);                                                                                    \
+  }                                                                                                    \
+  __attribute__((noinline)) void operator delete(void * ptr, std::align_val_t) noexcept                \
+  {                                                                                                    \
+    std::free(ptr);                                                                                    \
+  }                                                                                                    \
+  __attribute__((noinline)) void operator delete[](void * ptr, std::align_val_t) noexcept              \
+  {                                                                                                    \
+    std::free(ptr);                                                                                    \
+  }                                                                                                    \
+  __attribute__((noinline)) void operator delete(void * ptr, std::size_t, std::align_val_t) noexcept   \
+  {                                                                                                    \
+    std::free(ptr);                                                                                    \
+  }                                                                                                    \
+  __attribute__((noinline)) void operator delete[](void * ptr, std::size_t, std::align_val_t) noexcept \
+  {                                                                                                    \
+    std::free(ptr);                                                                                    \
+  }
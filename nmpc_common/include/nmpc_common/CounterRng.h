@@ -0,0 +1,96 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace nmpc_common
+{
+/** \brief Counter-based random number generator (Philox4x32-10).
+
+    A random number is a pure function of the key (seed) and the counter, unlike the sequential generators of the
+    standard library whose output depends on the number of previous calls. Therefore, each element of a large random
+    array can be generated independently from its index (e.g., rollout and step indices), and the array is the same
+    regardless of how it is divided among threads.
+
+    See J. K. Salmon et al., Parallel random numbers: as easy as 1, 2, 3, SC'11.
+ */
+class CounterRng
+{
+public:
+  /** \brief Type of counter. */
+  using Counter = std::array<uint32_t, 4>;
+
+  /** \brief Type of key. */
+  using Key = std::array<uint32_t, 2>;
+
+public:
+  /** \brief Constructor.
+      \param seed seed used as key
+   */
+  explicit CounterRng(uint64_t seed = 0)
+  : key_{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}
+  {
+  }
+
+  /** \brief Constructor.
+      \param key key
+   */
+  explicit CounterRng(const Key & key) : key_(key) {}
+
+  /** \brief Generate four 32-bit random integers.
+      \param counter counter
+   */
+  inline Counter generate(Counter counter) const
+  {
+    Key key = key_;
+    for(int i = 0; i < 10; i++)
+    {
+      if(i > 0)
+      {
+        key[0] += 0x9E3779B9;
+        key[1] += 0xBB67AE85;
+      }
+      uint64_t prod0 = static_cast<uint64_t>(0xD2511F53) * counter[0];
+      uint64_t prod1 = static_cast<uint64_t>(0xCD9E8D57) * counter[2];
+      counter = {static_cast<uint32_t>(prod1 >> 32) ^ counter[1] ^ key[0], static_cast<uint32_t>(prod1),
+                 static_cast<uint32_t>(prod0 >> 32) ^ counter[3] ^ key[1], static_cast<uint32_t>(prod0)};
+    }
+    return counter;
+  }
+
+  /** \brief Generate four uniform random numbers in (0, 1).
+      \param counter counter
+   */
+  inline std::array<double, 4> uniform(const Counter & counter) const
+  {
+    Counter bits = generate(counter);
+    return {toUniform(bits[0]), toUniform(bits[1]), toUniform(bits[2]), toUniform(bits[3])};
+  }
+
+  /** \brief Generate four standard normal random numbers by Box-Muller transform.
+      \param counter counter
+   */
+  inline std::array<double, 4> normal(const Counter & counter) const
+  {
+    std::array<double, 4> u = uniform(counter);
+    double r0 = std::sqrt(-2 * std::log(u[0]));
+    double r1 = std::sqrt(-2 * std::log(u[2]));
+    double theta0 = 2 * M_PI * u[1];
+    double theta1 = 2 * M_PI * u[3];
+    return {r0 * std::cos(theta0), r0 * std::sin(theta0), r1 * std::cos(theta1), r1 * std::sin(theta1)};
+  }
+
+  /** \brief Convert 32-bit integer to uniform random number in (0, 1). */
+  static inline double toUniform(uint32_t bits)
+  {
+    return (static_cast<double>(bits) + 0.5) * (1.0 / 4294967296.0);
+  }
+
+protected:
+  //! Key
+  Key key_;
+};
+} // namespace nmpc_common
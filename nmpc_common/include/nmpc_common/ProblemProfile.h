@@ -0,0 +1,255 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nmpc_common
+{
+/** \brief Profile of the callbacks of a problem (number of calls and accumulated duration).
+
+    The callbacks are identified by indices given in the constructor, and each call is measured by ScopedCall. The
+    counters are lock-free atomics, so the callbacks may be called concurrently (e.g., from ThreadPool). The overhead of
+    a call is two reads of the steady clock and two relaxed atomic additions, which can be removed by setEnabled().
+
+    To obtain a report per solve, call takeReport() after each solve, which returns the counts since the last call and
+    resets them.
+ */
+class ProblemProfile
+{
+public:
+  /** \brief Type of clock to measure duration. */
+  using Clock = std::chrono::steady_clock;
+
+  /*! \brief Report of profile. */
+  struct Report
+  {
+    /*! \brief Entry of callback. */
+    struct Entry
+    {
+      //! Name of callback
+      std::string name;
+
+      //! Number of calls
+      uint64_t count = 0;
+
+      //! Accumulated duration [ms]
+      double duration = 0;
+
+      /** \brief Mean duration per call [us]. */
+      inline double meanDuration() const
+      {
+        return count > 0 ? 1e3 * duration / static_cast<double>(count) : 0.0;
+      }
+    };
+
+    //! Entries of callbacks
+    std::vector<Entry> entries;
+
+    /** \brief Get entry by name (nullptr if not found). */
+    inline const Entry * find(const std::string & name) const
+    {
+      for(const auto & entry : entries)
+      {
+        if(entry.name == name)
+        {
+          return &entry;
+        }
+      }
+      return nullptr;
+    }
+
+    /** \brief Total number of calls. */
+    inline uint64_t totalCount() const
+    {
+      uint64_t count = 0;
+      for(const auto & entry : entries)
+      {
+        count += entry.count;
+      }
+      return count;
+    }
+
+    /** \brief Total duration of calls [ms]. */
+    inline double totalDuration() const
+    {
+      double duration = 0;
+      for(const auto & entry : entries)
+      {
+        duration += entry.duration;
+      }
+      return duration;
+    }
+
+    /** \brief Print report.
+        \param os output stream
+
+        The callbacks that are not called are omitted.
+     */
+    inline void print(std::ostream & os = std::cout) const
+    {
+      double total_duration = totalDuration();
+      os << "[ProblemProfile] total calls: " << totalCount() << ", total duration: " << total_duration << " [ms]"
+         << std::endl;
+      for(const auto & entry : entries)
+      {
+        if(entry.count == 0)
+        {
+          continue;
+        }
+        os << "  " << std::left << std::setw(28) << entry.name << std::right << " calls: " << std::setw(8)
+           << entry.count << ", duration: " << std::setw(10) << entry.duration << " [ms], mean: " << std::setw(10)
+           << entry.meanDuration() << " [us] ("
+           << (total_duration > 0 ? 100 * entry.duration / total_duration : 0.0) << " [%])" << std::endl;
+      }
+    }
+  };
+
+  /*! \brief Measure a call of callback from construction to destruction. */
+  class ScopedCall
+  {
+  public:
+    /** \brief Constructor.
+        \param profile profile
+        \param idx index of callback
+     */
+    ScopedCall(ProblemProfile & profile, int idx) : profile_(profile), idx_(idx)
+    {
+      if(profile_.enabled())
+      {
+        start_time_ = Clock::now();
+      }
+    }
+
+    /** \brief Destructor. */
+    ~ScopedCall()
+    {
+      if(profile_.enabled())
+      {
+        profile_.add(idx_, Clock::now() - start_time_);
+      }
+    }
+
+    ScopedCall(const ScopedCall &) = delete;
+    ScopedCall & operator=(const ScopedCall &) = delete;
+
+  protected:
+    //! Profile
+    ProblemProfile & profile_;
+
+    //! Index of callback
+    int idx_;
+
+    //! Start time of call
+    Clock::time_point start_time_;
+  };
+
+protected:
+  /*! \brief Counter of callback (aligned to cache line to avoid false sharing between callbacks). */
+  struct alignas(64) Counter
+  {
+    //! Number of calls
+    std::atomic<uint64_t> count{0};
+
+    //! Accumulated duration [ns]
+    std::atomic<uint64_t> duration{0};
+  };
+
+public:
+  /** \brief Constructor.
+      \param name_list names of callbacks
+   */
+  ProblemProfile(const std::vector<std::string> & name_list)
+  : name_list_(name_list), counter_list_(std::make_unique<Counter[]>(name_list.size()))
+  {
+  }
+
+  /** \brief Get number of callbacks. */
+  inline int callbackNum() const
+  {
+    return static_cast<int>(name_list_.size());
+  }
+
+  /** \brief Get whether the calls are measured. */
+  inline bool enabled() const
+  {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /** \brief Set whether the calls are measured. */
+  inline void setEnabled(bool enabled)
+  {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /** \brief Add a call of callback.
+      \param idx index of callback
+      \param duration duration of call
+   */
+  inline void add(int idx, Clock::duration duration)
+  {
+    Counter & counter = counter_list_[idx];
+    counter.count.fetch_add(1, std::memory_order_relaxed);
+    counter.duration.fetch_add(
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()),
+        std::memory_order_relaxed);
+  }
+
+  /** \brief Get report of calls since the construction or the last reset. */
+  inline Report report() const
+  {
+    Report report;
+    report.entries.resize(name_list_.size());
+    for(size_t i = 0; i < name_list_.size(); i++)
+    {
+      report.entries[i].name = name_list_[i];
+      report.entries[i].count = counter_list_[i].count.load(std::memory_order_relaxed);
+      report.entries[i].duration =
+          1e-6 * static_cast<double>(counter_list_[i].duration.load(std::memory_order_relaxed));
+    }
+    return report;
+  }
+
+  /** \brief Get report of calls since the construction or the last reset, and reset the counters. */
+  inline Report takeReport()
+  {
+    Report report;
+    report.entries.resize(name_list_.size());
+    for(size_t i = 0; i < name_list_.size(); i++)
+    {
+      report.entries[i].name = name_list_[i];
+      report.entries[i].count = counter_list_[i].count.exchange(0, std::memory_order_relaxed);
+      report.entries[i].duration =
+          1e-6 * static_cast<double>(counter_list_[i].duration.exchange(0, std::memory_order_relaxed));
+    }
+    return report;
+  }
+
+  /** \brief Reset counters. */
+  inline void reset()
+  {
+    for(size_t i = 0; i < name_list_.size(); i++)
+    {
+      counter_list_[i].count.store(0, std::memory_order_relaxed);
+      counter_list_[i].duration.store(0, std::memory_order_relaxed);
+    }
+  }
+
+protected:
+  //! Names of callbacks
+  std::vector<std::string> name_list_;
+
+  //! Counters of callbacks
+  std::unique_ptr<Counter[]> counter_list_;
+
+  //! Whether the calls are measured
+  std::atomic<bool> enabled_{true};
+};
+} // namespace nmpc_common
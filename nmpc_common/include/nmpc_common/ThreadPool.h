@@ -0,0 +1,512 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+namespace nmpc_common
+{
+/** \brief Work-stealing thread pool shared by solvers.
+
+    parallelFor() divides an index range (e.g., steps of horizon) into contiguous chunks whose boundaries depend only
+    on the range and the number of chunks, so that the same chunks are executed regardless of the thread timing. This
+    makes reductions over chunks deterministic. The chunks are distributed to the queues of the worker threads, and an
+    idle worker steals chunks from the queues of the others. If Configuration::caller_participates is true, the calling
+    thread executes the first chunk and steals the others while waiting; otherwise, it sleeps until all chunks are
+    finished. parallelFor() may be called from multiple threads and from inside a chunk (the worker always
+    participates in that case).
+
+    The queues are allocated in the constructor and parallelFor() does not allocate memory. If a queue is full, the
+    chunk is executed by the calling thread.
+ */
+class ThreadPool
+{
+public:
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Number of worker threads (negative for the number of hardware threads minus one)
+    int thread_num = -1;
+
+    //! Whether the calling thread of parallelFor() executes chunks while waiting
+    bool caller_participates = true;
+
+    //! CPU indices to which the worker threads are pinned in order (cyclically if shorter; empty for no pinning)
+    std::vector<int> cpu_list;
+
+    //! Real-time priority of the worker threads with SCHED_FIFO policy (zero for the default scheduling)
+    int priority = 0;
+
+    //! Capacity of the chunk queue of each worker thread
+    int queue_capacity = 256;
+
+    //! Print level (0: no print, 1: print warnings)
+    int print_level = 1;
+  };
+
+protected:
+  /*! \brief Job of parallelFor() shared by its chunks. */
+  struct Job
+  {
+    /** \brief Execute chunk. */
+    virtual void runChunk(int chunk_idx) = 0;
+
+    //! Number of chunks not finished yet (modified with mutex locked)
+    int remaining_num = 0;
+
+    //! Exception thrown in the first failed chunk
+    std::exception_ptr exception;
+
+    //! Mutex to finish chunks
+    std::mutex mutex;
+
+    //! Condition variable notified when all chunks are finished
+    std::condition_variable cond;
+  };
+
+  /*! \brief Job of parallelFor() with chunk function. */
+  template<class ChunkFunc>
+  struct ChunkJob : public Job
+  {
+    /** \brief Constructor. */
+    ChunkJob(int _begin, int _end, int _chunk_num, ChunkFunc & _func)
+    : begin(_begin), end(_end), chunk_num(_chunk_num), func(_func)
+    {
+    }
+
+    /** \brief Execute chunk. */
+    void runChunk(int chunk_idx) override
+    {
+      auto range = chunkRange(begin, end, chunk_num, chunk_idx);
+      func(chunk_idx, range.first, range.second);
+    }
+
+    //! Begin of index range
+    int begin;
+
+    //! End of index range
+    int end;
+
+    //! Number of chunks
+    int chunk_num;
+
+    //! Function called for each chunk
+    ChunkFunc & func;
+  };
+
+  /*! \brief Chunk in queue. */
+  struct Task
+  {
+    //! Job
+    Job * job = nullptr;
+
+    //! Chunk index
+    int chunk_idx = 0;
+  };
+
+  /*! \brief Fixed-capacity chunk queue of worker thread. */
+  struct Queue
+  {
+    //! Mutex
+    std::mutex mutex;
+
+    //! Ring buffer of chunks
+    std::vector<Task> task_list;
+
+    //! Index of the front chunk
+    int head = 0;
+
+    //! Number of chunks in queue
+    int size = 0;
+  };
+
+public:
+  /** \brief Constructor. */
+  ThreadPool() : ThreadPool(Configuration()) {}
+
+  /** \brief Constructor.
+      \param config configuration
+   */
+  ThreadPool(const Configuration & config)
+  : config_(config),
+    thread_num_(config.thread_num >= 0 ? config.thread_num
+                                       : std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 0))
+  {
+    queue_list_ = std::vector<Queue>(thread_num_);
+    for(auto & queue : queue_list_)
+    {
+      queue.task_list.resize(std::max(config_.queue_capacity, 1));
+    }
+    // Worker threads use thread_num_ instead of thread_list_, which grows while the threads are started
+    thread_list_.reserve(thread_num_);
+    for(int i = 0; i < thread_num_; i++)
+    {
+      thread_list_.emplace_back(&ThreadPool::workerLoop, this, i);
+      configureThread(i);
+    }
+  }
+
+  /** \brief Destructor. */
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(wake_mutex_);
+      stop_ = true;
+    }
+    wake_cond_.notify_all();
+    for(auto & thread : thread_list_)
+    {
+      thread.join();
+    }
+  }
+
+  // Not copyable because the threads are owned
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool & operator=(const ThreadPool &) = delete;
+
+  /** \brief Const accessor to configuration. */
+  inline const Configuration & config() const
+  {
+    return config_;
+  }
+
+  /** \brief Get number of worker threads. */
+  inline int threadNum() const
+  {
+    return thread_num_;
+  }
+
+  /** \brief Get number of threads executing chunks of parallelFor() (including the calling thread if it
+      participates). */
+  inline int concurrency() const
+  {
+    return std::max(threadNum() + (config_.caller_participates ? 1 : 0), 1);
+  }
+
+  /** \brief Get index range of chunk.
+      \param begin begin of index range
+      \param end end of index range
+      \param chunk_num number of chunks
+      \param chunk_idx chunk index
+      \return pair of begin and end of chunk
+   */
+  static inline std::pair<int, int> chunkRange(int begin, int end, int chunk_num, int chunk_idx)
+  {
+    long long num = end - begin;
+    return {begin + static_cast<int>(num * chunk_idx / chunk_num),
+            begin + static_cast<int>(num * (chunk_idx + 1) / chunk_num)};
+  }
+
+  /** \brief Execute function for each chunk of index range in parallel.
+      \param begin begin of index range
+      \param end end of index range
+      \param chunk_num number of chunks (concurrency() if not positive; limited to the range size)
+      \param func function called as func(chunk_idx, chunk_begin, chunk_end) for each chunk
+
+      An exception thrown by the function is rethrown after all chunks are finished.
+   */
+  template<class ChunkFunc>
+  void parallelForChunk(int begin, int end, int chunk_num, ChunkFunc && func)
+  {
+    if(end <= begin)
+    {
+      return;
+    }
+    if(chunk_num <= 0)
+    {
+      chunk_num = concurrency();
+    }
+    chunk_num = std::min(chunk_num, end - begin);
+
+    int worker_idx = currentWorkerIdx();
+    bool participates = config_.caller_participates || worker_idx >= 0;
+    if(thread_num_ == 0 || (chunk_num == 1 && participates))
+    {
+      for(int chunk_idx = 0; chunk_idx < chunk_num; chunk_idx++)
+      {
+        auto range = chunkRange(begin, end, chunk_num, chunk_idx);
+        func(chunk_idx, range.first, range.second);
+      }
+      return;
+    }
+
+    ChunkJob<std::remove_reference_t<ChunkFunc>> job(begin, end, chunk_num, func);
+    job.remaining_num = chunk_num;
+
+    // Distribute chunks to queues
+    int queue_num = threadNum();
+    int first_queue_idx = worker_idx >= 0 ? worker_idx : 0;
+    int pushed_num = 0;
+    for(int chunk_idx = participates ? 1 : 0; chunk_idx < chunk_num; chunk_idx++)
+    {
+      if(push((first_queue_idx + chunk_idx) % queue_num, Task{&job, chunk_idx}))
+      {
+        pushed_num++;
+      }
+      else
+      {
+        runTask(Task{&job, chunk_idx});
+      }
+    }
+    if(pushed_num > 0)
+    {
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+      }
+      wake_cond_.notify_all();
+    }
+
+    // Execute chunks while waiting
+    if(participates)
+    {
+      runTask(Task{&job, 0});
+      Task task;
+      while(!isFinished(job) && pop(worker_idx, task))
+      {
+        runTask(task);
+      }
+    }
+    {
+      // Wait with mutex locked so that the job is not destructed while it is accessed by other threads
+      std::unique_lock<std::mutex> lock(job.mutex);
+      job.cond.wait(lock, [&job]() { return job.remaining_num == 0; });
+    }
+
+    if(job.exception)
+    {
+      std::rethrow_exception(job.exception);
+    }
+  }
+
+  /** \brief Execute function for each index of range in parallel.
+      \param begin begin of index range
+      \param end end of index range
+      \param func function called as func(idx) for each index
+      \param chunk_num number of chunks (concurrency() if not positive)
+
+      Each chunk of contiguous indices is executed by one thread (see parallelForChunk()).
+   */
+  template<class Func>
+  void parallelFor(int begin, int end, Func && func, int chunk_num = 0)
+  {
+    parallelForChunk(begin, end, chunk_num,
+                     [&func](int, // chunk_idx
+                             int chunk_begin, int chunk_end)
+                     {
+                       for(int idx = chunk_begin; idx < chunk_end; idx++)
+                       {
+                         func(idx);
+                       }
+                     });
+  }
+
+protected:
+  /** \brief Get index of worker thread of this pool executing the current function (-1 for other threads). */
+  inline int currentWorkerIdx() const
+  {
+    const auto & state = threadState();
+    return state.first == this ? state.second : -1;
+  }
+
+  /** \brief Accessor to pool and worker index of the current thread. */
+  static inline std::pair<const ThreadPool *, int> & threadState()
+  {
+    static thread_local std::pair<const ThreadPool *, int> state(nullptr, -1);
+    return state;
+  }
+
+  /** \brief Whether all chunks of job are finished. */
+  static inline bool isFinished(Job & job)
+  {
+    std::lock_guard<std::mutex> lock(job.mutex);
+    return job.remaining_num == 0;
+  }
+
+  /** \brief Push chunk to the back of queue.
+      \return false if the queue is full
+   */
+  bool push(int queue_idx, const Task & task)
+  {
+    auto & queue = queue_list_[queue_idx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    int capacity = static_cast<int>(queue.task_list.size());
+    if(queue.size == capacity)
+    {
+      return false;
+    }
+    queue.task_list[(queue.head + queue.size) % capacity] = task;
+    queue.size++;
+    pending_num_.fetch_add(1, std::memory_order_release);
+    return true;
+  }
+
+  /** \brief Pop chunk from the back of own queue, or steal one from the front of the other queues.
+      \param worker_idx index of worker thread (-1 for other threads)
+      \param task popped chunk
+      \return false if all queues are empty
+   */
+  bool pop(int worker_idx, Task & task)
+  {
+    if(pending_num_.load(std::memory_order_acquire) == 0)
+    {
+      return false;
+    }
+
+    if(worker_idx >= 0)
+    {
+      auto & queue = queue_list_[worker_idx];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if(queue.size > 0)
+      {
+        queue.size--;
+        task = queue.task_list[(queue.head + queue.size) % queue.task_list.size()];
+        pending_num_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+
+    int queue_num = threadNum();
+    for(int i = 1; i <= queue_num; i++)
+    {
+      int queue_idx = (std::max(worker_idx, 0) + i) % queue_num;
+      if(queue_idx == worker_idx)
+      {
+        continue;
+      }
+      auto & queue = queue_list_[queue_idx];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if(queue.size > 0)
+      {
+        task = queue.task_list[queue.head];
+        queue.head = (queue.head + 1) % static_cast<int>(queue.task_list.size());
+        queue.size--;
+        pending_num_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** \brief Execute chunk and notify the job if all chunks are finished. */
+  static void runTask(const Task & task)
+  {
+    Job & job = *task.job;
+    std::exception_ptr exception;
+    try
+    {
+      job.runChunk(task.chunk_idx);
+    }
+    catch(...)
+    {
+      exception = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock(job.mutex);
+    if(exception && !job.exception)
+    {
+      job.exception = exception;
+    }
+    if(--job.remaining_num == 0)
+    {
+      job.cond.notify_all();
+    }
+  }
+
+  /** \brief Loop of worker thread. */
+  void workerLoop(int worker_idx)
+  {
+    threadState() = {this, worker_idx};
+
+    Task task;
+    while(true)
+    {
+      if(pop(worker_idx, task))
+      {
+        runTask(task);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      wake_cond_.wait(lock, [this]() { return stop_ || pending_num_.load(std::memory_order_acquire) > 0; });
+      if(stop_)
+      {
+        break;
+      }
+    }
+  }
+
+  /** \brief Set CPU affinity and priority of worker thread. */
+  void configureThread(int worker_idx)
+  {
+#if defined(__linux__)
+    auto handle = thread_list_[worker_idx].native_handle();
+
+    if(!config_.cpu_list.empty())
+    {
+      cpu_set_t cpu_set;
+      CPU_ZERO(&cpu_set);
+      CPU_SET(config_.cpu_list[worker_idx % config_.cpu_list.size()], &cpu_set);
+      if(pthread_setaffinity_np(handle, sizeof(cpu_set), &cpu_set) != 0 && config_.print_level >= 1)
+      {
+        std::cerr << "[ThreadPool] Failed to set CPU affinity of worker " << worker_idx << "." << std::endl;
+      }
+    }
+
+    if(config_.priority > 0)
+    {
+      sched_param param;
+      param.sched_priority = config_.priority;
+      if(pthread_setschedparam(handle, SCHED_FIFO, &param) != 0 && config_.print_level >= 1)
+      {
+        std::cerr << "[ThreadPool] Failed to set priority of worker " << worker_idx
+                  << ". Real-time scheduling may require privileges." << std::endl;
+      }
+    }
+#else
+    if((!config_.cpu_list.empty() || config_.priority > 0) && config_.print_level >= 1)
+    {
+      std::cerr << "[ThreadPool] CPU affinity and priority are supported only on Linux." << std::endl;
+    }
+#endif
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! Number of worker threads
+  const int thread_num_;
+
+  //! Chunk queues of worker threads
+  std::vector<Queue> queue_list_;
+
+  //! Worker threads
+  std::vector<std::thread> thread_list_;
+
+  //! Number of chunks in all queues
+  std::atomic<int> pending_num_ = 0;
+
+  //! Mutex to wake up worker threads
+  std::mutex wake_mutex_;
+
+  //! Condition variable to wake up worker threads
+  std::condition_variable wake_cond_;
+
+  //! Whether to stop worker threads
+  bool stop_ = false;
+};
+} // namespace nmpc_common
@@ -0,0 +1,57 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_common/CounterRng.h>
+
+TEST(TestCounterRng, KnownAnswer)
+{
+  // Known-answer tests of Philox4x32-10 distributed with Random123
+  {
+    nmpc_common::CounterRng rng(nmpc_common::CounterRng::Key{0, 0});
+    nmpc_common::CounterRng::Counter ref = {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8};
+    EXPECT_EQ(rng.generate({0, 0, 0, 0}), ref);
+  }
+  {
+    nmpc_common::CounterRng rng(nmpc_common::CounterRng::Key{0xffffffff, 0xffffffff});
+    nmpc_common::CounterRng::Counter ref = {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd};
+    EXPECT_EQ(rng.generate({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}), ref);
+  }
+  {
+    nmpc_common::CounterRng rng(nmpc_common::CounterRng::Key{0xa4093822, 0x299f31d0});
+    nmpc_common::CounterRng::Counter ref = {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1};
+    EXPECT_EQ(rng.generate({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}), ref);
+  }
+}
+
+TEST(TestCounterRng, Normal)
+{
+  nmpc_common::CounterRng rng(42);
+  constexpr int num = 100000;
+  double sum = 0;
+  double squared_sum = 0;
+  for(uint32_t i = 0; i < num / 4; i++)
+  {
+    for(double value : rng.normal({i, 0, 0, 0}))
+    {
+      EXPECT_TRUE(std::isfinite(value));
+      sum += value;
+      squared_sum += value * value;
+    }
+  }
+  EXPECT_NEAR(sum / num, 0.0, 0.02);
+  EXPECT_NEAR(squared_sum / num, 1.0, 0.02);
+
+  // Check that the numbers depend only on the seed and counter
+  EXPECT_EQ(rng.normal({1, 2, 3, 4}), nmpc_common::CounterRng(42).normal({1, 2, 3, 4}));
+  EXPECT_NE(rng.normal({1, 2, 3, 4}), nmpc_common::CounterRng(43).normal({1, 2, 3, 4}));
+  EXPECT_NE(rng.normal({1, 2, 3, 4}), rng.normal({1, 2, 3, 5}));
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,80 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <nmpc_common/ProblemProfile.h>
+#include <nmpc_common/ThreadPool.h>
+
+TEST(TestProblemProfile, Count)
+{
+  nmpc_common::ProblemProfile profile({"foo", "bar", "baz"});
+  EXPECT_EQ(profile.callbackNum(), 3);
+
+  for(int i = 0; i < 10; i++)
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(profile, 0);
+  }
+  for(int i = 0; i < 3; i++)
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(profile, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+
+  auto report = profile.report();
+  ASSERT_EQ(report.entries.size(), 3);
+  EXPECT_EQ(report.find("foo")->count, 10);
+  EXPECT_EQ(report.find("bar")->count, 3);
+  EXPECT_EQ(report.find("baz")->count, 0);
+  EXPECT_EQ(report.find("qux"), nullptr);
+  EXPECT_EQ(report.totalCount(), 13);
+  EXPECT_GE(report.find("bar")->duration, 6.0);
+  EXPECT_GE(report.find("bar")->meanDuration(), 2e3);
+  EXPECT_EQ(report.find("baz")->meanDuration(), 0.0);
+  EXPECT_GE(report.totalDuration(), report.find("bar")->duration);
+  report.print();
+
+  // Take report and reset counters
+  auto taken_report = profile.takeReport();
+  EXPECT_EQ(taken_report.find("foo")->count, 10);
+  EXPECT_EQ(profile.report().totalCount(), 0);
+  EXPECT_EQ(profile.report().totalDuration(), 0.0);
+
+  // Disable profile
+  profile.setEnabled(false);
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(profile, 2);
+  }
+  EXPECT_EQ(profile.report().find("baz")->count, 0);
+  profile.setEnabled(true);
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(profile, 2);
+  }
+  EXPECT_EQ(profile.report().find("baz")->count, 1);
+  profile.reset();
+  EXPECT_EQ(profile.report().totalCount(), 0);
+}
+
+TEST(TestProblemProfile, Concurrent)
+{
+  nmpc_common::ProblemProfile profile({"foo", "bar"});
+  nmpc_common::ThreadPool::Configuration config;
+  config.thread_num = 3;
+  nmpc_common::ThreadPool thread_pool(config);
+  constexpr int call_num = 10000;
+  thread_pool.parallelFor(0, call_num,
+                          [&](int i)
+                          {
+                            nmpc_common::ProblemProfile::ScopedCall call(profile, i % 2);
+                          });
+  auto report = profile.report();
+  EXPECT_EQ(report.find("foo")->count, call_num / 2);
+  EXPECT_EQ(report.find("bar")->count, call_num / 2);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,182 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <nmpc_common/ThreadPool.h>
+
+#if defined(__linux__)
+#  include <sched.h>
+#endif
+
+TEST(TestThreadPool, ChunkRange)
+{
+  for(int chunk_num : {1, 3, 7, 10})
+  {
+    int expected_begin = 5;
+    for(int chunk_idx = 0; chunk_idx < chunk_num; chunk_idx++)
+    {
+      auto range = nmpc_common::ThreadPool::chunkRange(5, 15, chunk_num, chunk_idx);
+      EXPECT_EQ(range.first, expected_begin);
+      EXPECT_GE(range.second - range.first, 10 / chunk_num);
+      EXPECT_LE(range.second - range.first, 10 / chunk_num + 1);
+      expected_begin = range.second;
+    }
+    EXPECT_EQ(expected_begin, 15);
+  }
+}
+
+TEST(TestThreadPool, ParallelFor)
+{
+  for(bool caller_participates : {true, false})
+  {
+    for(int thread_num : {0, 1, 3})
+    {
+      nmpc_common::ThreadPool::Configuration config;
+      config.thread_num = thread_num;
+      config.caller_participates = caller_participates;
+      nmpc_common::ThreadPool pool(config);
+      EXPECT_EQ(pool.threadNum(), thread_num);
+
+      // Check that each index is executed exactly once
+      std::vector<int> count_list(1000, 0);
+      for(int chunk_num : {0, 1, 4, 50, 2000})
+      {
+        pool.parallelFor(0, static_cast<int>(count_list.size()), [&](int i) { count_list[i]++; }, chunk_num);
+      }
+      for(int count : count_list)
+      {
+        EXPECT_EQ(count, 5);
+      }
+
+      // Check empty range
+      pool.parallelFor(3, 3, [&](int) { FAIL(); });
+    }
+  }
+}
+
+TEST(TestThreadPool, Determinism)
+{
+  nmpc_common::ThreadPool::Configuration config;
+  config.thread_num = 3;
+  nmpc_common::ThreadPool pool(config);
+
+  // Sum with rounding errors in chunks and reduce the partial sums in order
+  std::vector<double> value_list(10000);
+  for(size_t i = 0; i < value_list.size(); i++)
+  {
+    value_list[i] = std::sin(0.1 * i) * std::pow(10.0, static_cast<double>(i % 17) - 8.0);
+  }
+  int chunk_num = 8;
+  auto calc_sum = [&]()
+  {
+    std::vector<double> partial_sum_list(chunk_num, 0.0);
+    pool.parallelForChunk(0, static_cast<int>(value_list.size()), chunk_num,
+                          [&](int chunk_idx, int chunk_begin, int chunk_end)
+                          {
+                            for(int i = chunk_begin; i < chunk_end; i++)
+                            {
+                              partial_sum_list[chunk_idx] += value_list[i];
+                            }
+                            // Disturb the thread timing
+                            std::this_thread::sleep_for(std::chrono::microseconds((chunk_idx * 37) % 100));
+                          });
+    return std::accumulate(partial_sum_list.begin(), partial_sum_list.end(), 0.0);
+  };
+  double sum = calc_sum();
+  for(int i = 0; i < 20; i++)
+  {
+    EXPECT_EQ(calc_sum(), sum);
+  }
+}
+
+TEST(TestThreadPool, NestedAndConcurrent)
+{
+  nmpc_common::ThreadPool::Configuration config;
+  config.thread_num = 2;
+  config.caller_participates = false;
+  nmpc_common::ThreadPool pool(config);
+
+  // Call parallelFor from chunks and from multiple threads
+  std::atomic<int> count = 0;
+  auto run = [&]()
+  {
+    pool.parallelFor(0, 8, [&](int) { pool.parallelFor(0, 10, [&](int) { count++; }); });
+  };
+  std::vector<std::thread> thread_list;
+  for(int i = 0; i < 4; i++)
+  {
+    thread_list.emplace_back(run);
+  }
+  for(auto & thread : thread_list)
+  {
+    thread.join();
+  }
+  EXPECT_EQ(count.load(), 4 * 8 * 10);
+}
+
+TEST(TestThreadPool, Exception)
+{
+  nmpc_common::ThreadPool::Configuration config;
+  config.thread_num = 2;
+  nmpc_common::ThreadPool pool(config);
+
+  std::atomic<int> count = 0;
+  EXPECT_THROW(pool.parallelFor(0, 100,
+                                [&](int i)
+                                {
+                                  count++;
+                                  if(i == 50)
+                                  {
+                                    throw std::runtime_error("test");
+                                  }
+                                }),
+               std::runtime_error);
+
+  // Check that the pool is still available
+  count = 0;
+  pool.parallelFor(0, 100, [&](int) { count++; });
+  EXPECT_EQ(count.load(), 100);
+}
+
+#if defined(__linux__)
+TEST(TestThreadPool, Affinity)
+{
+  // Select a CPU available for this process
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  ASSERT_EQ(sched_getaffinity(0, sizeof(cpu_set), &cpu_set), 0);
+  int cpu = 0;
+  while(!CPU_ISSET(cpu, &cpu_set))
+  {
+    cpu++;
+  }
+
+  nmpc_common::ThreadPool::Configuration config;
+  config.thread_num = 2;
+  config.caller_participates = false;
+  config.cpu_list = {cpu};
+  config.priority = 10; // Ignored with a warning if not permitted
+  nmpc_common::ThreadPool pool(config);
+
+  std::vector<int> cpu_list(100, -1);
+  pool.parallelFor(0, static_cast<int>(cpu_list.size()), [&](int i) { cpu_list[i] = sched_getcpu(); });
+  for(int worker_cpu : cpu_list)
+  {
+    EXPECT_EQ(worker_cpu, cpu);
+  }
+}
+#endif
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
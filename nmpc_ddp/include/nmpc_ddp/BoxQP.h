@@ -2,20 +2,29 @@
 
 #pragma once
 
+#include <chrono>
+#include <memory>
 #include <vector>
 
 #include <Eigen/Dense>
 
+#include <nmpc_ddp/SolverObserver.h>
+#include <nmpc_ddp/TraceRing.h>
+
 namespace nmpc_ddp
 {
 /** \brief Solver for quadratic programming problems with box constraints (i.e., only upper and lower bounds).
     \tparam VarDim dimension of decision variables
+    \tparam Observer type of observer notified of events (see NullObserver for the interface)
 
     See the following for a detailed algorithm.
       - Y Tassa, N Mansard, E Todorov. Control-limited differential dynamic programming. ICRA, 2014.
       - https://www.mathworks.com/matlabcentral/fileexchange/52069-ilqg-ddp-trajectory-optimization
+
+    If VarDim is fixed, solve() does not allocate heap memory after the first call (with the same max_iter), because
+    the matrices whose size depends on the number of free dimensions have VarDim as their maximum size.
  */
-template<int VarDim>
+template<int VarDim, class Observer = PrintObserver>
 class BoxQP
 {
 public:
@@ -28,6 +37,12 @@ public:
   /** \brief Type of boolean array of variables dimension. */
   using VarDimArray = Eigen::Array<bool, VarDim, 1>;
 
+  /** \brief Type of vector whose maximum dimension is variables dimension. */
+  using VarDimMaxVector = Eigen::Matrix<double, Eigen::Dynamic, 1, Eigen::ColMajor, VarDim, 1>;
+
+  /** \brief Type of matrix whose maximum dimension is variables x variables dimension. */
+  using VarVarDimMaxMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor, VarDim, VarDim>;
+
 public:
   /*! \brief Configuration. */
   struct Configuration
@@ -115,6 +130,9 @@ public:
                                  + " != " + std::to_string(VarDim));
       }
     }
+
+    free_idxs_.reserve(var_dim_);
+    clamped_idxs_.reserve(var_dim_);
   }
 
   /** \brief Solve optimization.
@@ -144,6 +162,9 @@ public:
                             const VarDimVector & upper,
                             const VarDimVector & initial_x)
   {
+    // The clock is read only when traced
+    auto start_time = trace_ring_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
     // Initialize objective value
     VarDimVector x = initial_x.cwiseMin(upper).cwiseMax(lower);
     double obj = x.dot(g) + 0.5 * x.dot(H * x);
@@ -151,6 +172,7 @@ public:
 
     // Initialize trace data
     trace_data_list_.clear();
+    trace_data_list_.reserve(config_.max_iter + 1);
     TraceData initial_trace_data(var_dim_);
     initial_trace_data.iter = 0;
     initial_trace_data.x = x;
@@ -191,13 +213,13 @@ public:
               .select(true, clamped_flag);
 
       // Set clamped and free indices
-      std::vector<int> clamped_idxs;
+      clamped_idxs_.clear();
       free_idxs_.clear();
       for(int i = 0; i < clamped_flag.size(); i++)
       {
         if(clamped_flag[i])
         {
-          clamped_idxs.push_back(i);
+          clamped_idxs_.push_back(i);
         }
         else
         {
@@ -216,7 +238,7 @@ public:
       if(iter == 1 || (clamped_flag != old_clamped_flag).any())
       {
         // Set H_free
-        Eigen::MatrixXd H_free(free_idxs_.size(), free_idxs_.size());
+        VarVarDimMaxMatrix H_free(free_idxs_.size(), free_idxs_.size());
         for(size_t i = 0; i < free_idxs_.size(); i++)
         {
           for(size_t j = 0; j < free_idxs_.size(); j++)
@@ -226,12 +248,13 @@ public:
         }
 
         // Cholesky decomposition
-        llt_free_ = std::make_unique<Eigen::LLT<Eigen::MatrixXd>>(H_free);
-        if(llt_free_->info() == Eigen::NumericalIssue)
+        llt_free_.compute(H_free);
+        if(llt_free_.info() == Eigen::NumericalIssue)
         {
           if(config_.print_level >= 1)
           {
-            std::cout << "[BoxQP] H_free is not positive definite in Cholesky decomposition (LLT)." << std::endl;
+            observer_.notify(SolverEvent(SolverEventType::Failure, 1, "BoxQP",
+                                         "H_free is not positive definite in Cholesky decomposition (LLT).", iter));
           }
           retval_ = -1;
           break;
@@ -253,25 +276,26 @@ public:
       }
 
       // Calculate search direction
-      Eigen::VectorXd x_clamped(clamped_idxs.size());
-      Eigen::VectorXd x_free(free_idxs_.size());
-      Eigen::VectorXd g_free(free_idxs_.size());
-      Eigen::MatrixXd H_free_clamped(free_idxs_.size(), clamped_idxs.size());
-      for(size_t i = 0; i < clamped_idxs.size(); i++)
+      VarDimMaxVector x_clamped(clamped_idxs_.size());
+      VarDimMaxVector x_free(free_idxs_.size());
+      VarDimMaxVector g_free(free_idxs_.size());
+      VarVarDimMaxMatrix H_free_clamped(free_idxs_.size(), clamped_idxs_.size());
+      for(size_t i = 0; i < clamped_idxs_.size(); i++)
       {
-        x_clamped[i] = x[clamped_idxs[i]];
+        x_clamped[i] = x[clamped_idxs_[i]];
       }
       for(size_t i = 0; i < free_idxs_.size(); i++)
       {
         x_free[i] = x[free_idxs_[i]];
         g_free[i] = g[free_idxs_[i]];
-        for(size_t j = 0; j < clamped_idxs.size(); j++)
+        for(size_t j = 0; j < clamped_idxs_.size(); j++)
         {
-          H_free_clamped(i, j) = H(free_idxs_[i], clamped_idxs[j]);
+          H_free_clamped(i, j) = H(free_idxs_[i], clamped_idxs_[j]);
         }
       }
-      Eigen::VectorXd grad_free_clamped = g_free + H_free_clamped * x_clamped;
-      Eigen::VectorXd search_dir_free = -1 * llt_free_->solve(grad_free_clamped) - x_free;
+      VarDimMaxVector grad_free_clamped = g_free;
+      grad_free_clamped.noalias() += H_free_clamped * x_clamped;
+      VarDimMaxVector search_dir_free = -1 * llt_free_.solve(grad_free_clamped) - x_free;
       VarDimVector search_dir = VarDimVector::Zero(var_dim_);
       for(size_t i = 0; i < free_idxs_.size(); i++)
       {
@@ -284,7 +308,8 @@ public:
       {
         if(config_.print_level >= 1)
         {
-          std::cout << "[BoxQP] search_dir_grad is positive: " << search_dir_grad << std::endl;
+          observer_.notify(SolverEvent(SolverEventType::Failure, 1, "BoxQP", "search_dir_grad is positive.", iter,
+                                       {{"search_dir_grad", search_dir_grad}}));
         }
         retval_ = -2;
         break;
@@ -311,9 +336,11 @@ public:
       // Print
       if(config_.print_level >= 3)
       {
-        std::cout << "[BoxQP] iter: " << iter << ", obj: " << obj << ", grad_norm: " << grad_norm
-                  << ", obj_update, : " << old_obj - obj_candidate << ", step: " << step
-                  << ", clamped_flag_num: " << clamped_idxs.size() << std::endl;
+        observer_.notify(SolverEvent(SolverEventType::LineSearch, 3, "BoxQP", "Line search finished.", iter,
+                                     {{"obj", obj},
+                                      {"obj_update", old_obj - obj_candidate},
+                                      {"step", step},
+                                      {"clamped_num", static_cast<double>(clamped_idxs_.size())}}));
       }
 
       // Set trace data
@@ -336,12 +363,18 @@ public:
       }
     }
 
+    if(trace_ring_)
+    {
+      trace_ring_->pushComplete("BoxQP", "solve", start_time, std::chrono::steady_clock::now(), iter, retval_);
+    }
+
     // Print
     if(config_.print_level >= 2)
     {
-      std::cout << "[BoxQP] result: " << retval_ << " (" << retstr_.at(retval_) << "), iter: " << iter
-                << ", obj: " << obj << ", factorization_num: " << factorization_num << std::endl;
+      observer_.notify(SolverEvent(SolverEventType::Termination, 2, "BoxQP", retstr_.at(retval_).c_str(), iter,
+                                   {{"result", retval_}, {"obj", obj}, {"factorization_num", factorization_num}}));
     }
+    observer_.flush();
 
     return x;
   }
@@ -364,6 +397,28 @@ public:
     return trace_data_list_;
   }
 
+  /** \brief Set ring buffer of trace events.
+      \param trace_ring ring buffer (nullptr to disable tracing)
+   */
+  inline void setTraceRing(const std::shared_ptr<TraceRing> & trace_ring)
+  {
+    trace_ring_ = trace_ring;
+  }
+
+  /** \brief Accessor to observer. */
+  inline Observer & observer()
+  {
+    return observer_;
+  }
+
+  /** \brief Set observer.
+      \param observer observer notified of events
+   */
+  inline void setObserver(const Observer & observer)
+  {
+    observer_ = observer;
+  }
+
 public:
   //! Dimension of decision variables
   const int var_dim_ = 0;
@@ -372,18 +427,19 @@ public:
   int retval_ = 0;
 
   //! Return string
-  const std::unordered_map<int, std::string> retstr_ = {{-2, "Gradient of search direction is positive"},
-                                                        {-1, "Hessian is not positive definite"},
-                                                        {0, "Computation is not finished"},
-                                                        {1, "Maximum main iterations exceeded"},
-                                                        {2, "Maximum line-search iterations exceeded"},
-                                                        {3, "No bounds, returning Newton point"},
-                                                        {4, "Improvement smaller than tolerance"},
-                                                        {5, "Gradient norm smaller than tolerance"},
-                                                        {6, "All dimensions are clamped"}};
+  static inline const std::unordered_map<int, std::string> retstr_ = {
+      {-2, "Gradient of search direction is positive"},
+      {-1, "Hessian is not positive definite"},
+      {0, "Computation is not finished"},
+      {1, "Maximum main iterations exceeded"},
+      {2, "Maximum line-search iterations exceeded"},
+      {3, "No bounds, returning Newton point"},
+      {4, "Improvement smaller than tolerance"},
+      {5, "Gradient norm smaller than tolerance"},
+      {6, "All dimensions are clamped"}};
 
   //! Cholesky decomposition (LLT) of free block of objective Hessian matrix
-  std::unique_ptr<Eigen::LLT<Eigen::MatrixXd>> llt_free_;
+  Eigen::LLT<VarVarDimMaxMatrix> llt_free_;
 
   //! Indices of free dimensions in decision variables
   std::vector<int> free_idxs_;
@@ -394,5 +450,14 @@ protected:
 
   //! Sequence of trace data
   std::vector<TraceData> trace_data_list_;
+
+  //! Indices of clamped dimensions in decision variables
+  std::vector<int> clamped_idxs_;
+
+  //! Ring buffer of trace events
+  std::shared_ptr<TraceRing> trace_ring_;
+
+  //! Observer notified of events
+  Observer observer_;
 };
 } // namespace nmpc_ddp
@@ -0,0 +1,273 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <nmpc_ddp/MpcRunner.h>
+#include <nmpc_ddp/SolverObserver.h>
+
+namespace nmpc_ddp
+{
+/** \brief Controller of computation budget (horizon steps and maximum iteration) of solver to hold target latency.
+    \tparam Solver solver type (DDPSolver or nmpc_fmpc::FmpcSolver, see MpcRunnerAdapter)
+
+    The computation durations and iteration counts of the recent solves are collected, and every
+    Configuration::window_size solves, the budget is adapted depending on the percentile of the durations:
+      - If the percentile exceeds the target latency, the maximum iteration is decreased if it is often reached (i.e.,
+    the latency is bounded by the iterations), and otherwise the horizon steps are decreased.
+      - If the percentile is below the target latency multiplied by Configuration::increase_ratio, the maximum iteration
+    is increased if it is often reached (i.e., the solves do not converge), and otherwise the horizon steps are
+    increased.
+
+    The warm-start data is resized to the horizon steps before each solve (see MpcRunnerAdapter::resize()). Each
+    decision is appended to decisionList() and notified to the observer of the solver as an event of print level 1.
+ */
+template<class Solver>
+class BudgetController
+{
+public:
+  /** \brief Type of solver adapter. */
+  using Adapter = MpcRunnerAdapter<Solver>;
+
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename Adapter::StateDimVector;
+
+  /** \brief Type of warm-start data. */
+  using WarmStart = typename Adapter::WarmStart;
+
+  /** \brief Type of clock to measure computation duration. */
+  using Clock = std::chrono::steady_clock;
+
+  /** \brief Type of function to return latency of the last solve [ms] (argument is solver after solve). */
+  using LatencyFunc = std::function<double(const Solver &)>;
+
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Target latency of solve [ms]
+    double target_latency = 1.0;
+
+    //! Percentile of latency to be held below the target latency (0 to 1)
+    double percentile = 0.9;
+
+    //! Number of solves between decisions
+    int window_size = 20;
+
+    //! Ratio of target latency below which the budget is increased
+    double increase_ratio = 0.7;
+
+    //! Ratio of solves reaching the maximum iteration above which the iteration is considered to bound the latency
+    double iter_bound_ratio = 0.5;
+
+    //! Relative change of horizon steps in one decision
+    double horizon_change_rate = 0.1;
+
+    //! Minimum horizon steps
+    int min_horizon_steps = 10;
+
+    //! Maximum horizon steps
+    int max_horizon_steps = 1000;
+
+    //! Minimum of maximum iteration
+    int min_max_iter = 1;
+
+    //! Maximum of maximum iteration
+    int max_max_iter = 10;
+  };
+
+  /*! \brief Type of decision. */
+  enum class DecisionType
+  {
+    //! Decrease maximum iteration
+    DecreaseIter = 0,
+
+    //! Decrease horizon steps
+    DecreaseHorizon,
+
+    //! Increase maximum iteration
+    IncreaseIter,
+
+    //! Increase horizon steps
+    IncreaseHorizon,
+
+    //! Keep budget (within target or limits reached)
+    Keep
+  };
+
+  /*! \brief Decision of budget adaptation. */
+  struct Decision
+  {
+    //! Number of solves at the decision
+    int solve_count = 0;
+
+    //! Decision type
+    DecisionType type = DecisionType::Keep;
+
+    //! Percentile of latency in the window [ms]
+    double latency = 0;
+
+    //! Ratio of solves reaching the maximum iteration in the window
+    double iter_bound_ratio = 0;
+
+    //! Horizon steps after the decision
+    int horizon_steps = 0;
+
+    //! Maximum iteration after the decision
+    int max_iter = 0;
+  };
+
+public:
+  /** \brief Constructor.
+      \param solver solver
+   */
+  BudgetController(const std::shared_ptr<Solver> & solver) : solver_(solver) {}
+
+  /** \brief Accessor to configuration. */
+  inline Configuration & config()
+  {
+    return config_;
+  }
+
+  /** \brief Set function to return latency of the last solve.
+      \param latency_func function to return latency [ms] (e.g., a model of latency for deterministic tests)
+
+      By default (or if latency_func is empty), the computation duration measured by the solver is used, or the
+      wall-clock duration of the solve if it is not measured by the solver policy.
+   */
+  inline void setLatencyFunc(const LatencyFunc & latency_func)
+  {
+    latency_func_ = latency_func;
+  }
+
+  /** \brief Const accessor to decisions (including those to keep the budget). */
+  inline const std::vector<Decision> & decisionList() const
+  {
+    return decision_list_;
+  }
+
+  /** \brief Solve with the current budget and adapt it.
+      \param t current time [sec]
+      \param x current state
+      \param warm_start warm-start data, which is resized to the horizon steps and overwritten with the solution
+      \return whether the solve is finished successfully
+   */
+  bool solve(double t, const StateDimVector & x, WarmStart & warm_start)
+  {
+    Adapter::resize(warm_start, solver_->config().horizon_steps);
+
+    auto start_time = Clock::now();
+    bool succeeded = Adapter::solve(*solver_, t, x, warm_start);
+    double latency = latency_func_ ? latency_func_(*solver_) : solver_->computationDuration().solve;
+    if(!latency_func_ && latency <= 0)
+    {
+      // Not measured by the solver policy
+      latency = 1e3 * std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start_time).count();
+    }
+
+    solve_count_++;
+    latency_list_.push_back(latency);
+    if(!solver_->traceDataList().empty() && solver_->traceDataList().back().iter >= solver_->config().max_iter)
+    {
+      iter_bound_num_++;
+    }
+    if(static_cast<int>(latency_list_.size()) >= config_.window_size)
+    {
+      decide();
+    }
+
+    return succeeded;
+  }
+
+protected:
+  /** \brief Adapt budget from the solves in the window. */
+  void decide()
+  {
+    Decision decision;
+    decision.solve_count = solve_count_;
+    size_t idx = std::min(static_cast<size_t>(config_.percentile * latency_list_.size()), latency_list_.size() - 1);
+    std::nth_element(latency_list_.begin(), latency_list_.begin() + idx, latency_list_.end());
+    decision.latency = latency_list_[idx];
+    decision.iter_bound_ratio = static_cast<double>(iter_bound_num_) / latency_list_.size();
+    bool iter_bound = decision.iter_bound_ratio > config_.iter_bound_ratio;
+
+    auto & solver_config = solver_->config();
+    int horizon_change =
+        std::max(static_cast<int>(std::round(config_.horizon_change_rate * solver_config.horizon_steps)), 1);
+    if(decision.latency > config_.target_latency)
+    {
+      if(iter_bound && solver_config.max_iter > config_.min_max_iter)
+      {
+        decision.type = DecisionType::DecreaseIter;
+        solver_config.max_iter--;
+      }
+      else if(solver_config.horizon_steps > config_.min_horizon_steps)
+      {
+        decision.type = DecisionType::DecreaseHorizon;
+        solver_config.horizon_steps =
+            std::max(solver_config.horizon_steps - horizon_change, config_.min_horizon_steps);
+      }
+    }
+    else if(decision.latency < config_.increase_ratio * config_.target_latency)
+    {
+      if(iter_bound && solver_config.max_iter < config_.max_max_iter)
+      {
+        decision.type = DecisionType::IncreaseIter;
+        solver_config.max_iter++;
+      }
+      else if(solver_config.horizon_steps < config_.max_horizon_steps)
+      {
+        decision.type = DecisionType::IncreaseHorizon;
+        solver_config.horizon_steps =
+            std::min(solver_config.horizon_steps + horizon_change, config_.max_horizon_steps);
+      }
+    }
+    decision.horizon_steps = solver_config.horizon_steps;
+    decision.max_iter = solver_config.max_iter;
+    decision_list_.push_back(decision);
+
+    if(solver_config.print_level >= 1)
+    {
+      static constexpr const char * message_list[] = {"Decrease maximum iteration.", "Decrease horizon steps.",
+                                                      "Increase maximum iteration.", "Increase horizon steps.",
+                                                      "Keep budget."};
+      solver_->observer().notify(SolverEvent(SolverEventType::Info, 1, "BudgetController",
+                                             message_list[static_cast<int>(decision.type)], -1,
+                                             {{"latency", decision.latency},
+                                              {"iter_bound_ratio", decision.iter_bound_ratio},
+                                              {"horizon_steps", decision.horizon_steps},
+                                              {"max_iter", decision.max_iter}}));
+    }
+
+    latency_list_.clear();
+    iter_bound_num_ = 0;
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! Solver
+  std::shared_ptr<Solver> solver_;
+
+  //! Function to return latency of the last solve (computation duration is used if empty)
+  LatencyFunc latency_func_;
+
+  //! Decisions
+  std::vector<Decision> decision_list_;
+
+  //! Latencies of solves in the window [ms]
+  std::vector<double> latency_list_;
+
+  //! Number of solves reaching the maximum iteration in the window
+  int iter_bound_num_ = 0;
+
+  //! Number of solves
+  int solve_count_ = 0;
+};
+} // namespace nmpc_ddp
@@ -0,0 +1,444 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace nmpc_ddp
+{
+/** \brief Headless (i.e., ROS-free) closed-loop simulation harness for MPC.
+    \tparam StateDim state dimension
+    \tparam InputDim input dimension
+
+    The simulation and MPC are processed in a single thread with different periods (sim_dt and mpc_dt) in the same
+    way as the ROS timer-based examples (e.g., TestDDPCartPole). The harness injects scheduled input disturbances and
+    events (e.g., target changes), and reports the distribution of solve latency and the tracking error.
+ */
+template<int StateDim, int InputDim>
+class ClosedLoopHarness
+{
+public:
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = Eigen::Matrix<double, StateDim, 1>;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = Eigen::Matrix<double, InputDim, 1>;
+
+  /** \brief Type of function to simulate one step (arguments are time, state, input, and timestep). */
+  using SimFunc = std::function<StateDimVector(double, const StateDimVector &, const InputDimVector &, double)>;
+
+  /** \brief Type of function to solve MPC (arguments are time and state). */
+  using MpcFunc = std::function<void(double, const StateDimVector &)>;
+
+  /** \brief Type of function to return the input applied in the simulation (arguments are time and state). */
+  using InputFunc = std::function<InputDimVector(double, const StateDimVector &)>;
+
+  /** \brief Type of function to return reference state (argument is time). */
+  using RefFunc = std::function<StateDimVector(double)>;
+
+  /** \brief Type of function called after each simulation step (arguments are time, state, input, and
+      disturbance). */
+  using StepFunc =
+      std::function<void(double, const StateDimVector &, const InputDimVector &, const InputDimVector &)>;
+
+  /** \brief Type of function to return current time of clock [sec]. */
+  using NowFunc = std::function<double()>;
+
+  /** \brief Type of function to sleep until the time of clock (argument is time [sec]). */
+  using SleepUntilFunc = std::function<void(double)>;
+
+  /*! \brief Time mode. */
+  enum class TimeMode
+  {
+    //! Simulated time (simulation proceeds as fast as possible)
+    Simulated = 0,
+
+    //! Wall-clock time (simulation step is synchronized with wall-clock)
+    WallClock = 1
+  };
+
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Print level (0: no print, 1: print only important, 2: print verbose, 3: print very verbose)
+    int print_level = 1;
+
+    //! Time mode
+    TimeMode time_mode = TimeMode::Simulated;
+
+    //! Simulation timestep [sec]
+    double sim_dt = 0.002;
+
+    //! MPC period [sec]
+    double mpc_dt = 0.004;
+
+    //! Simulation start time [sec]
+    double start_t = 0.0;
+
+    //! Simulation end time [sec]
+    double end_t = 10.0;
+  };
+
+  /*! \brief Statistics of solve latency. */
+  struct LatencyStatistics
+  {
+    //! Number of solves
+    int num = 0;
+
+    //! Mean [msec]
+    double mean = 0;
+
+    //! Minimum [msec]
+    double min = 0;
+
+    //! Median [msec]
+    double p50 = 0;
+
+    //! 90th percentile [msec]
+    double p90 = 0;
+
+    //! 99th percentile [msec]
+    double p99 = 0;
+
+    //! Maximum [msec]
+    double max = 0;
+
+    //! Number of solves whose latency exceeds mpc_dt
+    int deadline_miss_num = 0;
+  };
+
+  /*! \brief Result of closed-loop simulation. */
+  struct Result
+  {
+    //! Final time [sec]
+    double final_t = 0;
+
+    //! Final state
+    StateDimVector final_x;
+
+    //! Solve latency statistics
+    LatencyStatistics latency;
+
+    //! Wall-clock duration of simulation [sec]
+    double wall_duration = 0;
+
+    //! Real-time factor (ratio of simulated duration to wall-clock duration)
+    double real_time_factor = 0;
+
+    //! Number of simulation steps that could not keep up with wall-clock (only in TimeMode::WallClock)
+    int sim_overrun_num = 0;
+
+    //! Root mean square of tracking error for each state dimension
+    StateDimVector tracking_error_rms;
+
+    //! Maximum absolute tracking error for each state dimension
+    StateDimVector tracking_error_max;
+  };
+
+  /*! \brief Input disturbance. */
+  struct Disturbance
+  {
+    //! Start time [sec]
+    double start_t;
+
+    //! Duration [sec]
+    double duration;
+
+    //! Additive input
+    InputDimVector u;
+  };
+
+  /*! \brief Scheduled event. */
+  struct Event
+  {
+    //! Time [sec]
+    double t;
+
+    //! Function called at the time
+    std::function<void()> func;
+  };
+
+public:
+  /** \brief Constructor.
+      \param sim_func function to simulate one step
+      \param mpc_func function to solve MPC
+      \param input_func function to return the input applied in the simulation
+   */
+  ClosedLoopHarness(const SimFunc & sim_func, const MpcFunc & mpc_func, const InputFunc & input_func)
+  : sim_func_(sim_func), mpc_func_(mpc_func), input_func_(input_func)
+  {
+  }
+
+  /** \brief Accessor to configuration. */
+  inline Configuration & config()
+  {
+    return config_;
+  }
+
+  /** \brief Const accessor to configuration. */
+  inline const Configuration & config() const
+  {
+    return config_;
+  }
+
+  /** \brief Set function to return reference state for tracking error. */
+  inline void setRefFunc(const RefFunc & ref_func)
+  {
+    ref_func_ = ref_func;
+  }
+
+  /** \brief Set function called after each simulation step. */
+  inline void setStepFunc(const StepFunc & step_func)
+  {
+    step_func_ = step_func;
+  }
+
+  /** \brief Set clock to measure solve latency and to synchronize simulation with wall-clock.
+      \param now_func function to return current time of clock [sec]
+      \param sleep_until_func function to sleep until the time of clock [sec]
+
+      By default, std::chrono::steady_clock is used. A simulated clock can be set to check TimeMode::WallClock (e.g.,
+      overruns of simulation steps) without waiting for real time.
+   */
+  inline void setClock(const NowFunc & now_func, const SleepUntilFunc & sleep_until_func)
+  {
+    now_func_ = now_func;
+    sleep_until_func_ = sleep_until_func;
+  }
+
+  /** \brief Add input disturbance.
+      \param start_t start time [sec]
+      \param u additive input
+      \param duration duration [sec]
+   */
+  inline void addDisturbance(double start_t, const InputDimVector & u, double duration = 0.5)
+  {
+    disturbance_list_.push_back(Disturbance{start_t, duration, u});
+  }
+
+  /** \brief Add scheduled event (e.g., target change).
+      \param t time [sec]
+      \param func function called at the time
+   */
+  inline void addEvent(double t, const std::function<void()> & func)
+  {
+    event_list_.push_back(Event{t, func});
+    std::stable_sort(event_list_.begin(), event_list_.end(),
+                     [](const Event & e1, const Event & e2) { return e1.t < e2.t; });
+  }
+
+  /** \brief Run closed-loop simulation.
+      \param initial_x initial state
+      \return result of closed-loop simulation
+   */
+  Result run(const StateDimVector & initial_x)
+  {
+    Result result;
+    result.tracking_error_rms.setZero(initial_x.size());
+    result.tracking_error_max.setZero(initial_x.size());
+
+    int sim_step_num = static_cast<int>(std::ceil((config_.end_t - config_.start_t) / config_.sim_dt - 1e-9));
+    latency_list_.clear();
+    latency_list_.reserve(static_cast<size_t>(std::ceil(sim_step_num * config_.sim_dt / config_.mpc_dt)) + 1);
+
+    double t = config_.start_t;
+    StateDimVector x = initial_x;
+    InputDimVector dist_u;
+    size_t event_idx = 0;
+    double next_mpc_t = t;
+    int tracking_sample_num = 0;
+
+    double start_time = now();
+    for(int step = 0; step < sim_step_num; step++)
+    {
+      // Process events
+      while(event_idx < event_list_.size() && event_list_[event_idx].t <= t)
+      {
+        event_list_[event_idx].func();
+        event_idx++;
+      }
+
+      // Solve MPC
+      if(t >= next_mpc_t - 1e-10)
+      {
+        double solve_start_time = now();
+        mpc_func_(t, x);
+        latency_list_.push_back(1e3 * (now() - solve_start_time));
+        next_mpc_t += config_.mpc_dt;
+      }
+
+      // Simulate one step
+      InputDimVector u = input_func_(t, x);
+      dist_u.setZero(u.size());
+      for(const auto & disturbance : disturbance_list_)
+      {
+        if(disturbance.start_t <= t && t < disturbance.start_t + disturbance.duration)
+        {
+          dist_u += disturbance.u;
+        }
+      }
+      x = sim_func_(t, x, u + dist_u, config_.sim_dt);
+      t = config_.start_t + (step + 1) * config_.sim_dt;
+
+      // Accumulate tracking error
+      if(ref_func_)
+      {
+        StateDimVector error = (x - ref_func_(t)).cwiseAbs();
+        result.tracking_error_rms += error.cwiseAbs2();
+        result.tracking_error_max = result.tracking_error_max.cwiseMax(error);
+        tracking_sample_num++;
+      }
+
+      if(step_func_)
+      {
+        step_func_(t, x, u, dist_u);
+      }
+
+      // Synchronize with wall-clock
+      if(config_.time_mode == TimeMode::WallClock)
+      {
+        double next_step_time = start_time + (step + 1) * config_.sim_dt;
+        if(now() > next_step_time)
+        {
+          result.sim_overrun_num++;
+        }
+        else
+        {
+          sleepUntil(next_step_time);
+        }
+      }
+    }
+    double end_time = now();
+
+    // Set result
+    result.final_t = t;
+    result.final_x = x;
+    result.wall_duration = end_time - start_time;
+    result.real_time_factor = (t - config_.start_t) / std::max(result.wall_duration, 1e-9);
+    if(tracking_sample_num > 0)
+    {
+      result.tracking_error_rms = (result.tracking_error_rms / tracking_sample_num).cwiseSqrt();
+    }
+    result.latency = calcLatencyStatistics();
+
+    if(config_.print_level >= 1)
+    {
+      std::cout << "[ClosedLoopHarness] solve num: " << result.latency.num << ", latency [ms] mean: "
+                << result.latency.mean << ", p50: " << result.latency.p50 << ", p99: " << result.latency.p99
+                << ", max: " << result.latency.max << ", deadline miss: " << result.latency.deadline_miss_num
+                << ", real-time factor: " << result.real_time_factor << std::endl;
+    }
+
+    return result;
+  }
+
+  /** \brief Const accessor to list of solve latency [msec] in the last run. */
+  inline const std::vector<double> & latencyList() const
+  {
+    return latency_list_;
+  }
+
+protected:
+  /** \brief Get current time of clock [sec]. */
+  inline double now() const
+  {
+    if(now_func_)
+    {
+      return now_func_();
+    }
+    return std::chrono::duration_cast<std::chrono::duration<double>>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /** \brief Sleep until the time of clock [sec]. */
+  inline void sleepUntil(double time) const
+  {
+    if(sleep_until_func_)
+    {
+      sleep_until_func_(time);
+      return;
+    }
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time))));
+  }
+
+  /** \brief Calculate statistics of solve latency. */
+  LatencyStatistics calcLatencyStatistics() const
+  {
+    LatencyStatistics stats;
+    if(latency_list_.empty())
+    {
+      return stats;
+    }
+
+    std::vector<double> sorted_latency_list = latency_list_;
+    std::sort(sorted_latency_list.begin(), sorted_latency_list.end());
+    auto percentile = [&](double ratio)
+    {
+      size_t idx = static_cast<size_t>(std::ceil(ratio * sorted_latency_list.size())) - 1;
+      return sorted_latency_list[std::min(idx, sorted_latency_list.size() - 1)];
+    };
+
+    stats.num = static_cast<int>(sorted_latency_list.size());
+    for(double latency : sorted_latency_list)
+    {
+      stats.mean += latency;
+      if(latency > 1e3 * config_.mpc_dt)
+      {
+        stats.deadline_miss_num++;
+      }
+    }
+    stats.mean /= stats.num;
+    stats.min = sorted_latency_list.front();
+    stats.p50 = percentile(0.5);
+    stats.p90 = percentile(0.9);
+    stats.p99 = percentile(0.99);
+    stats.max = sorted_latency_list.back();
+
+    return stats;
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! Function to simulate one step
+  SimFunc sim_func_;
+
+  //! Function to solve MPC
+  MpcFunc mpc_func_;
+
+  //! Function to return the input applied in the simulation
+  InputFunc input_func_;
+
+  //! Function to return reference state
+  RefFunc ref_func_;
+
+  //! Function called after each simulation step
+  StepFunc step_func_;
+
+  //! Function to return current time of clock (steady clock is used if empty)
+  NowFunc now_func_;
+
+  //! Function to sleep until the time of clock (steady clock is used if empty)
+  SleepUntilFunc sleep_until_func_;
+
+  //! List of input disturbance
+  std::vector<Disturbance> disturbance_list_;
+
+  //! List of scheduled event (sorted by time)
+  std::vector<Event> event_list_;
+
+  //! List of solve latency [msec]
+  std::vector<double> latency_list_;
+};
+} // namespace nmpc_ddp
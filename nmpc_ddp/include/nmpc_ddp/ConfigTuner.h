@@ -0,0 +1,516 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <nmpc_common/ThreadPool.h>
+#include <nmpc_ddp/MpcRunner.h>
+
+namespace nmpc_ddp
+{
+/** \brief Offline tuner of solver configuration.
+    \tparam Solver solver type (DDPSolver or nmpc_fmpc::FmpcSolver, see MpcRunnerAdapter)
+
+    The configuration entries to be tuned are given as knobs, each of which has a list of candidate values. Candidates
+    are sampled randomly from the combinations of the knob values (the baseline configuration is always included), and
+    the fastest candidate is selected by successive halving: in each round, the remaining candidates are evaluated on
+    the first samples (initial conditions), and only the fastest 1 / Configuration::reduction_factor of them proceed to
+    the next round, in which the number of samples is multiplied by Configuration::reduction_factor.
+
+    The speed of a candidate is the percentile of the solve durations over the samples (e.g., median or p99). A
+    candidate is rejected if the cost of a solution is not finite or exceeds the cost by the baseline configuration by
+    more than Configuration::cost_tolerance, so the quality of the solution is preserved. A solve stopped at the
+    maximum iteration is not rejected because the cost decides whether its solution is good enough. The baseline
+    configuration is kept in all rounds so that it is compared with the tuned configuration under the same conditions.
+
+    If a thread pool is set, the candidates are evaluated in parallel, each thread with its own solver created by the
+    solver factory. Since the solve durations are affected by the other threads, the thread pool should not be used
+    when the tuned configuration is sensitive to the durations of the target machine.
+ */
+template<class Solver>
+class ConfigTuner
+{
+public:
+  /** \brief Type of solver adapter. */
+  using Adapter = MpcRunnerAdapter<Solver>;
+
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename Adapter::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename Adapter::InputDimVector;
+
+  /** \brief Type of warm-start data. */
+  using WarmStart = typename Adapter::WarmStart;
+
+  /** \brief Type of solver configuration. */
+  using SolverConfiguration = typename Solver::Configuration;
+
+  /** \brief Type of clock to measure computation duration. */
+  using Clock = std::chrono::steady_clock;
+
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Print level (0: no print, 1: print result, 2: print each round)
+    int print_level = 1;
+
+    //! Percentile of solve durations over samples to be minimized (0.5 for median, 0.99 for p99)
+    double percentile = 0.5;
+
+    //! Relative tolerance of cost compared with the cost by the baseline configuration
+    double cost_tolerance = 1e-3;
+
+    //! Number of candidates sampled randomly in addition to the baseline configuration
+    int candidate_num = 30;
+
+    //! Factor by which the number of candidates is divided and the number of samples is multiplied in each round
+    int reduction_factor = 3;
+
+    //! Number of samples evaluated in the first round
+    int min_sample_num = 3;
+
+    //! Number of repeated solves for each sample (the minimum duration is used)
+    int repeat_num = 1;
+
+    //! Seed of random number generator to sample candidates
+    unsigned int seed = 0;
+  };
+
+  /*! \brief Initial condition of solve. */
+  struct Sample
+  {
+    //! Current time [sec]
+    double t = 0;
+
+    //! Current state
+    StateDimVector x;
+
+    //! Warm-start data (initial guess)
+    WarmStart warm_start;
+  };
+
+  /*! \brief Entry of solver configuration to be tuned. */
+  struct Knob
+  {
+    //! Name of knob
+    std::string name;
+
+    //! Candidate values
+    std::vector<double> value_list;
+
+    //! Function to set value to solver configuration
+    std::function<void(SolverConfiguration &, double)> apply;
+  };
+
+  /*! \brief Candidate of solver configuration. */
+  struct Candidate
+  {
+    //! Indices of knob values (-1 for the value of the baseline configuration)
+    std::vector<int> value_idx_list;
+
+    //! Solver configuration
+    SolverConfiguration config;
+
+    //! Percentile of solve durations [ms] (infinity if rejected)
+    double duration = std::numeric_limits<double>::infinity();
+
+    //! Number of samples evaluated in the last round
+    int sample_num = 0;
+
+    //! Number of rounds survived
+    int round_num = 0;
+
+    //! Whether the candidate is rejected because of non-finite or increased costs
+    bool rejected = false;
+  };
+
+  /*! \brief Result of tuning. */
+  struct Result
+  {
+    //! Knobs
+    std::vector<Knob> knob_list;
+
+    //! Tuned candidate
+    Candidate best;
+
+    //! Baseline candidate (evaluated in the same rounds as the tuned candidate)
+    Candidate baseline;
+
+    //! All candidates
+    std::vector<Candidate> candidate_list;
+
+    /** \brief Print tuned knob values in YAML format.
+        \param os output stream
+
+        The knobs whose values are the same as the baseline configuration are commented out.
+     */
+    void print(std::ostream & os = std::cout) const
+    {
+      os << "# Tuned by ConfigTuner: " << baseline.duration << " [ms] -> " << best.duration << " [ms] for "
+         << best.sample_num << " samples" << std::endl;
+      for(size_t i = 0; i < knob_list.size(); i++)
+      {
+        int value_idx = best.value_idx_list[i];
+        if(value_idx < 0)
+        {
+          os << "# " << knob_list[i].name << ": (baseline)" << std::endl;
+        }
+        else
+        {
+          os << knob_list[i].name << ": " << knob_list[i].value_list[value_idx] << std::endl;
+        }
+      }
+    }
+  };
+
+public:
+  /** \brief Constructor.
+      \param solver_factory function to create solver (called once per thread)
+      \param baseline_config baseline solver configuration, to which the knob values are applied
+   */
+  ConfigTuner(const std::function<std::shared_ptr<Solver>()> & solver_factory,
+              const SolverConfiguration & baseline_config)
+  : solver_factory_(solver_factory), baseline_config_(baseline_config)
+  {
+  }
+
+  /** \brief Accessor to configuration. */
+  inline Configuration & config()
+  {
+    return config_;
+  }
+
+  /** \brief Set thread pool to evaluate candidates in parallel.
+      \param thread_pool thread pool (nullptr to evaluate serially)
+   */
+  inline void setThreadPool(const std::shared_ptr<nmpc_common::ThreadPool> & thread_pool)
+  {
+    thread_pool_ = thread_pool;
+  }
+
+  /** \brief Make knob of a member of solver configuration.
+      \param name name of knob
+      \param member pointer to member of solver configuration (e.g., &SolverConfiguration::max_iter)
+      \param value_list candidate values
+   */
+  template<class T>
+  static Knob makeKnob(const std::string & name, T SolverConfiguration::*member, const std::vector<T> & value_list)
+  {
+    Knob knob;
+    knob.name = name;
+    for(const auto & value : value_list)
+    {
+      knob.value_list.push_back(static_cast<double>(value));
+    }
+    knob.apply = [member](SolverConfiguration & config, double value)
+    {
+      if constexpr(std::is_same<T, bool>::value)
+      {
+        config.*member = (value != 0.0);
+      }
+      else if constexpr(std::is_integral<T>::value)
+      {
+        config.*member = static_cast<T>(std::lround(value));
+      }
+      else
+      {
+        config.*member = static_cast<T>(value);
+      }
+    };
+    return knob;
+  }
+
+  /** \brief Tune solver configuration.
+      \param knob_list knobs
+      \param sample_list samples (initial conditions), which should be shuffled because the first ones are used in
+      the early rounds
+      \return result
+   */
+  Result tune(const std::vector<Knob> & knob_list, const std::vector<Sample> & sample_list)
+  {
+    if(sample_list.empty())
+    {
+      throw std::invalid_argument("[ConfigTuner] sample_list is empty.");
+    }
+    for(const auto & knob : knob_list)
+    {
+      if(knob.value_list.empty() || !knob.apply)
+      {
+        throw std::invalid_argument("[ConfigTuner] Knob " + knob.name + " has no values or function.");
+      }
+    }
+
+    Result result;
+    result.knob_list = knob_list;
+    int sample_num = static_cast<int>(sample_list.size());
+    int reduction_factor = std::max(config_.reduction_factor, 2);
+
+    // Solve with baseline configuration to get reference costs
+    {
+      auto solver = solver_factory_();
+      ref_cost_list_.assign(sample_num, 0.0);
+      double duration = 0;
+      for(int i = 0; i < sample_num; i++)
+      {
+        if(!solve(*solver, baseline_config_, sample_list[i], duration, ref_cost_list_[i]))
+        {
+          throw std::runtime_error("[ConfigTuner] Cost with baseline configuration is not finite for sample "
+                                   + std::to_string(i) + ".");
+        }
+      }
+    }
+
+    // Sample candidates
+    std::vector<Candidate> candidate_list = sampleCandidates(knob_list);
+
+    // Successive halving
+    std::vector<int> remaining_idx_list(candidate_list.size());
+    for(size_t i = 0; i < candidate_list.size(); i++)
+    {
+      remaining_idx_list[i] = static_cast<int>(i);
+    }
+    int round_sample_num = std::min(std::max(config_.min_sample_num, 1), sample_num);
+    for(int round = 0;; round++)
+    {
+      evaluate(candidate_list, remaining_idx_list, sample_list, round_sample_num);
+      std::stable_sort(remaining_idx_list.begin(), remaining_idx_list.end(),
+                       [&](int idx1, int idx2)
+                       { return candidate_list[idx1].duration < candidate_list[idx2].duration; });
+      for(int idx : remaining_idx_list)
+      {
+        candidate_list[idx].round_num = round + 1;
+      }
+
+      if(config_.print_level >= 2)
+      {
+        const auto & best = candidate_list[remaining_idx_list.front()];
+        std::cout << "[ConfigTuner] round: " << round << ", candidates: " << remaining_idx_list.size()
+                  << ", samples: " << round_sample_num << ", best duration: " << best.duration << " [ms]"
+                  << std::endl;
+      }
+
+      if(round_sample_num == sample_num || remaining_idx_list.size() == 1)
+      {
+        break;
+      }
+      remaining_idx_list.resize(
+          std::max<size_t>((remaining_idx_list.size() + reduction_factor - 1) / reduction_factor, 1));
+      // The baseline is kept in all rounds so that it is compared under the same conditions
+      if(std::find(remaining_idx_list.begin(), remaining_idx_list.end(), 0) == remaining_idx_list.end())
+      {
+        remaining_idx_list.push_back(0);
+      }
+      round_sample_num = std::min(round_sample_num * reduction_factor, sample_num);
+    }
+
+    result.baseline = candidate_list[0];
+    result.best = candidate_list[remaining_idx_list.front()];
+    if(result.best.rejected || result.best.duration >= result.baseline.duration)
+    {
+      // Fall back to the baseline if none is faster than the baseline
+      result.best = result.baseline;
+    }
+    result.candidate_list = std::move(candidate_list);
+
+    if(config_.print_level >= 1)
+    {
+      result.print();
+    }
+
+    return result;
+  }
+
+protected:
+  /** \brief Sample candidates including the baseline configuration. */
+  std::vector<Candidate> sampleCandidates(const std::vector<Knob> & knob_list) const
+  {
+    std::mt19937 engine(config_.seed);
+    std::set<std::vector<int>> value_idx_list_set;
+    std::vector<Candidate> candidate_list;
+
+    Candidate baseline;
+    baseline.value_idx_list.assign(knob_list.size(), -1);
+    value_idx_list_set.insert(baseline.value_idx_list);
+    candidate_list.push_back(baseline);
+
+    // The number of combinations may be smaller than candidate_num
+    double combination_num = 1;
+    for(const auto & knob : knob_list)
+    {
+      combination_num *= static_cast<double>(knob.value_list.size());
+    }
+    int candidate_num = static_cast<int>(std::min(static_cast<double>(config_.candidate_num), combination_num));
+    for(int trial = 0; static_cast<int>(candidate_list.size()) < candidate_num + 1 && trial < 100 * candidate_num;
+        trial++)
+    {
+      Candidate candidate;
+      for(const auto & knob : knob_list)
+      {
+        std::uniform_int_distribution<int> dist(0, static_cast<int>(knob.value_list.size()) - 1);
+        candidate.value_idx_list.push_back(dist(engine));
+      }
+      if(value_idx_list_set.insert(candidate.value_idx_list).second)
+      {
+        candidate_list.push_back(candidate);
+      }
+    }
+
+    for(auto & candidate : candidate_list)
+    {
+      candidate.config = baseline_config_;
+      for(size_t i = 0; i < knob_list.size(); i++)
+      {
+        if(candidate.value_idx_list[i] >= 0)
+        {
+          knob_list[i].apply(candidate.config, knob_list[i].value_list[candidate.value_idx_list[i]]);
+        }
+      }
+    }
+
+    return candidate_list;
+  }
+
+  /** \brief Evaluate candidates on the first samples.
+      \param candidate_list candidates
+      \param idx_list indices of candidates to be evaluated
+      \param sample_list samples
+      \param sample_num number of samples to be evaluated
+   */
+  void evaluate(std::vector<Candidate> & candidate_list,
+                const std::vector<int> & idx_list,
+                const std::vector<Sample> & sample_list,
+                int sample_num)
+  {
+    auto evaluate_chunk = [&](int chunk_idx, int chunk_begin, int chunk_end)
+    {
+      auto & solver = solver_list_[chunk_idx];
+      if(!solver)
+      {
+        // Solve once to exclude the memory allocation in the first solve from the measurement
+        solver = solver_factory_();
+        double duration = 0;
+        double cost = 0;
+        solve(*solver, baseline_config_, sample_list.front(), duration, cost);
+      }
+      std::vector<double> duration_list(sample_num);
+      for(int i = chunk_begin; i < chunk_end; i++)
+      {
+        Candidate & candidate = candidate_list[idx_list[i]];
+        candidate.sample_num = sample_num;
+        candidate.rejected = false;
+        for(int j = 0; j < sample_num; j++)
+        {
+          double cost = 0;
+          if(!solve(*solver, candidate.config, sample_list[j], duration_list[j], cost)
+             || cost > ref_cost_list_[j] + config_.cost_tolerance * std::abs(ref_cost_list_[j]))
+          {
+            candidate.rejected = true;
+            break;
+          }
+        }
+        candidate.duration = candidate.rejected ? std::numeric_limits<double>::infinity()
+                                                : calcPercentile(duration_list);
+      }
+    };
+
+    int candidate_num = static_cast<int>(idx_list.size());
+    if(thread_pool_)
+    {
+      int chunk_num = std::min(thread_pool_->concurrency(), candidate_num);
+      if(static_cast<int>(solver_list_.size()) < chunk_num)
+      {
+        solver_list_.resize(chunk_num);
+      }
+      thread_pool_->parallelForChunk(0, candidate_num, chunk_num, evaluate_chunk);
+    }
+    else
+    {
+      if(solver_list_.empty())
+      {
+        solver_list_.resize(1);
+      }
+      evaluate_chunk(0, 0, candidate_num);
+    }
+  }
+
+  /** \brief Solve sample with configuration.
+      \param solver solver
+      \param config solver configuration
+      \param sample sample
+      \param duration minimum duration of repeated solves [ms]
+      \param cost cost of solution
+      \return whether the cost is finite
+
+      The return value of the solver is ignored because the solver may report a failure when it stops at the maximum
+      iteration (e.g., DDPSolver::solve()), which is a valid result for tuning.
+   */
+  bool solve(Solver & solver,
+             const SolverConfiguration & config,
+             const Sample & sample,
+             double & duration,
+             double & cost)
+  {
+    solver.config() = config;
+    duration = std::numeric_limits<double>::infinity();
+    WarmStart warm_start;
+    for(int i = 0; i < std::max(config_.repeat_num, 1); i++)
+    {
+      warm_start = sample.warm_start;
+      auto start_time = Clock::now();
+      Adapter::solve(solver, sample.t, sample.x, warm_start);
+      double solve_duration = solver.computationDuration().solve;
+      if(solve_duration <= 0)
+      {
+        // Not measured by the solver policy
+        solve_duration =
+            1e3 * std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start_time).count();
+      }
+      duration = std::min(duration, solve_duration);
+    }
+    cost = calcSolutionCost(solver, sample.t);
+    return std::isfinite(cost);
+  }
+
+  /** \brief Calculate percentile of durations. */
+  double calcPercentile(std::vector<double> duration_list) const
+  {
+    size_t idx = std::min(static_cast<size_t>(config_.percentile * duration_list.size()), duration_list.size() - 1);
+    std::nth_element(duration_list.begin(), duration_list.begin() + idx, duration_list.end());
+    return duration_list[idx];
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! Function to create solver
+  std::function<std::shared_ptr<Solver>()> solver_factory_;
+
+  //! Baseline solver configuration
+  SolverConfiguration baseline_config_;
+
+  //! Thread pool
+  std::shared_ptr<nmpc_common::ThreadPool> thread_pool_;
+
+  //! Solvers for each chunk of parallel evaluation
+  std::vector<std::shared_ptr<Solver>> solver_list_;
+
+  //! Costs by the baseline configuration for each sample
+  std::vector<double> ref_cost_list_;
+};
+} // namespace nmpc_ddp
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -9,8 +11,13 @@
 namespace nmpc_ddp
 {
 /** \brief DDP problem.
-    \tparam StateDim state dimension (fixed only)
+    \tparam StateDim state dimension (fixed or dynamic (i.e., Eigen::Dynamic))
     \tparam InputDim input dimension (fixed or dynamic (i.e., Eigen::Dynamic))
+
+    If the state dimension is dynamic, it must be passed to the constructor and is constant for the problem. Dynamic
+    state dimension is intended for large models (e.g., hundreds of states), for which fixed-size matrices blow up the
+    compile time and the stack, and the products of the solver are computed by the cache-blocked matrix products of
+    Eigen.
  */
 template<int StateDim, int InputDim>
 class DDPProblem
@@ -39,21 +46,47 @@ public:
 
   /** \brief Constructor.
       \param dt discretization timestep [sec]
+      \param state_dim state dimension (must be passed if StateDim is dynamic)
    */
-  DDPProblem(double dt) : dt_(dt)
+  DDPProblem(double dt, int state_dim = StateDim) : dt_(dt), state_dim_(state_dim)
   {
     // Check dimension
-    static_assert(StateDim > 0, "[DDP] Template param StateDim should be positive.");
+    static_assert(StateDim > 0 || StateDim == Eigen::Dynamic,
+                  "[DDP] Template param StateDim should be positive or Eigen::Dynamic.");
     static_assert(InputDim >= 0 || InputDim == Eigen::Dynamic,
                   "[DDP] Template param InputDim should be non-negative or Eigen::Dynamic.");
+    if(state_dim_ <= 0 || (StateDim != Eigen::Dynamic && state_dim_ != StateDim))
+    {
+      throw std::invalid_argument("[DDP] state_dim should be positive and consistent with StateDim. state_dim: "
+                                  + std::to_string(state_dim_) + ", StateDim: " + std::to_string(StateDim));
+    }
   }
 
-  /** \brief Gets the state dimension. */
+  /** \brief Gets the state dimension.
+      \note If state dimension is dynamic, this must not be called. Instead, runtimeStateDim() must be called.
+   */
   static inline constexpr int stateDim()
   {
+    if constexpr(StateDim == Eigen::Dynamic)
+    {
+      throw std::runtime_error("Since state dimension is dynamic, runtimeStateDim() must be called.");
+    }
     return StateDim;
   }
 
+  /** \brief Gets the state dimension passed to the constructor (same as stateDim() if StateDim is fixed). */
+  inline int runtimeStateDim() const
+  {
+    if constexpr(StateDim == Eigen::Dynamic)
+    {
+      return state_dim_;
+    }
+    else
+    {
+      return StateDim;
+    }
+  }
+
   /** \brief Gets the input dimension.
       \note If input dimension is dynamic, this must not be called. Instead, inputDim(t) must be called passing time as
      a parameter.
@@ -199,5 +232,8 @@ public:
 protected:
   //! Discretization timestep [sec]
   const double dt_ = 0;
+
+  //! State dimension
+  const int state_dim_ = 0;
 };
 } // namespace nmpc_ddp
@@ -2,25 +2,117 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <functional>
 #include <memory>
 
+#include <nmpc_common/ThreadPool.h>
+#include <nmpc_ddp/BoxQP.h>
 #include <nmpc_ddp/DDPProblem.h>
+#include <nmpc_ddp/FeedbackPolicy.h>
+#include <nmpc_ddp/LatencyHistogram.h>
+#include <nmpc_ddp/PerfCounter.h>
+#include <nmpc_ddp/SolveRecorder.h>
+#include <nmpc_ddp/SolverObserver.h>
+#include <nmpc_ddp/SolverPolicy.h>
+#include <nmpc_ddp/TraceRing.h>
 
 namespace nmpc_ddp
 {
+/** \brief Policy of DDPSolver in which all choices are made at runtime by DDPSolver::Configuration.
+
+    Only the phases are measured. Use DDPStepInstrumentedPolicy to also measure each step of horizon.
+ */
+struct DDPRuntimePolicy
+{
+  //! Whether to use second-order derivatives of state equation (0, 1, or PolicyRuntime)
+  static constexpr int use_state_eq_second_derivative = PolicyRuntime;
+
+  //! Whether input has constraints (0, 1, or PolicyRuntime)
+  static constexpr int with_input_constraint = PolicyRuntime;
+
+  //! Regularization type (1, 2, or PolicyRuntime)
+  static constexpr int reg_type = PolicyRuntime;
+
+  //! Maximum print level (prints of higher levels are removed at compile time)
+  static constexpr int max_print_level = 3;
+
+  //! Instrumentation level
+  static constexpr Instrumentation instrumentation = Instrumentation::Phase;
+
+  //! Clock to measure computation duration
+  using Clock = std::chrono::steady_clock;
+
+  //! Observer notified of events
+  using Observer = PrintObserver;
+};
+
+/** \brief Policy of DDPSolver same as DDPRuntimePolicy except that each step of horizon is also measured. */
+struct DDPStepInstrumentedPolicy : public DDPRuntimePolicy
+{
+  //! Instrumentation level
+  static constexpr Instrumentation instrumentation = Instrumentation::Step;
+};
+
+/** \brief Policy of DDPSolver in which the choices are fixed at compile time.
+    \tparam WithInputConstraint whether input has constraints
+    \tparam RegType regularization type (1: Quu + lambda * I, 2: Vxx + lambda * I)
+    \tparam MaxPrintLevel maximum print level
+    \tparam InstrumentationLevel instrumentation level
+    \tparam ObserverType observer notified of events (NullObserver to remove events at compile time)
+    \tparam UseStateEqSecondDerivative whether to use second-order derivatives of state equation
+
+    The corresponding entries of DDPSolver::Configuration are ignored.
+ */
+template<bool WithInputConstraint,
+         int RegType = 1,
+         int MaxPrintLevel = 0,
+         Instrumentation InstrumentationLevel = Instrumentation::Phase,
+         class ObserverType = PrintObserver,
+         bool UseStateEqSecondDerivative = false>
+struct DDPStaticPolicy
+{
+  //! Whether to use second-order derivatives of state equation
+  static constexpr int use_state_eq_second_derivative = UseStateEqSecondDerivative;
+
+  //! Whether input has constraints
+  static constexpr int with_input_constraint = WithInputConstraint;
+
+  //! Regularization type
+  static constexpr int reg_type = RegType;
+
+  //! Maximum print level
+  static constexpr int max_print_level = MaxPrintLevel;
+
+  //! Instrumentation level
+  static constexpr Instrumentation instrumentation = InstrumentationLevel;
+
+  //! Clock to measure computation duration
+  using Clock = std::chrono::steady_clock;
+
+  //! Observer notified of events
+  using Observer = ObserverType;
+};
+
 /** \brief DDP solver.
     \tparam StateDim state dimension
     \tparam InputDim input dimension
+    \tparam Policy policy to fix the choices of configuration and the instrumentation level at compile time (see
+    DDPRuntimePolicy and DDPStaticPolicy)
 
     See the following for a detailed algorithm.
       - Y Tassa, T Erez, E Todorov. Synthesis and stabilization of complex behaviors through online trajectory
    optimization. IROS, 2012.
       - Y Tassa, N Mansard, E Todorov. Control-limited differential dynamic programming. ICRA, 2014.
       - https://www.mathworks.com/matlabcentral/fileexchange/52069-ilqg-ddp-trajectory-optimization
+
+    After the first solve, solve() does not allocate heap memory as long as the horizon steps and the input dimension
+    along the horizon are unchanged and the problem does not allocate memory. With input constraints, this holds only
+    if the input dimension is fixed, because BoxQP and the input limits function use vectors of dynamic size otherwise.
  */
-template<int StateDim, int InputDim>
+template<int StateDim, int InputDim, class Policy = DDPRuntimePolicy>
 class DDPSolver
 {
 public:
@@ -42,8 +134,18 @@ public:
   /** \brief Type of matrix of input x state dimension. */
   using InputStateDimMatrix = typename DDPProblem<StateDim, InputDim>::InputStateDimMatrix;
 
+  /** \brief Type of clock to measure computation duration. */
+  using Clock = typename Policy::Clock;
+
+  /** \brief Type of observer notified of events. */
+  using Observer = typename Policy::Observer;
+
 public:
-  /*! \brief Configuration. */
+  /*! \brief Configuration.
+
+      The entries fixed by the solver policy (use_state_eq_second_derivative, with_input_constraint, reg_type, and the
+      upper bound of print_level) are ignored.
+  */
   struct Configuration
   {
     /** \brief Constructor. */
@@ -107,6 +209,12 @@ public:
 
     //! Termination threshold of cost update
     double cost_update_thre = 1e-7;
+
+    //! Whether to measure hardware performance counters of each phase (see PerfCounter)
+    bool use_perf_counter = false;
+
+    //! Whether to record computation duration of each solve in histograms (see LatencyHistogram)
+    bool use_latency_histogram = false;
   };
 
   /*! \brief Control data. */
@@ -131,12 +239,28 @@ public:
         \param outer_dim outer dimension of tensor
     */
     Derivative(int state_dim, int input_dim, int outer_dim)
+    {
+      resize(state_dim, input_dim, outer_dim);
+    }
+
+    /** \brief Resize variables in place (memory is not reallocated if the dimensions are unchanged).
+        \param state_dim state dimension
+        \param input_dim input dimension
+        \param outer_dim outer dimension of tensor
+    */
+    inline void resize(int state_dim, int input_dim, int outer_dim)
     {
       Fx.resize(state_dim, state_dim);
       Fu.resize(state_dim, input_dim);
-      Fxx.assign(outer_dim, StateStateDimMatrix(state_dim, state_dim));
-      Fuu.assign(outer_dim, InputInputDimMatrix(input_dim, input_dim));
-      Fxu.assign(outer_dim, StateInputDimMatrix(state_dim, input_dim));
+      Fxx.resize(outer_dim);
+      Fuu.resize(outer_dim);
+      Fxu.resize(outer_dim);
+      for(int i = 0; i < outer_dim; i++)
+      {
+        Fxx[i].resize(state_dim, state_dim);
+        Fuu[i].resize(input_dim, input_dim);
+        Fxu[i].resize(state_dim, input_dim);
+      }
       Lx.resize(state_dim);
       Lu.resize(input_dim);
       Lxx.resize(state_dim, state_dim);
@@ -175,6 +299,85 @@ public:
     StateInputDimMatrix Lxu;
   };
 
+  /*! \brief Workspace of backward pass.
+
+      The variables are preallocated once per solve so that the backward pass does not allocate memory even if the
+      state dimension is dynamic. The products of state x state dimension are computed once per step and reused for
+      the Q-function and its regularization, so that they are computed by the cache-blocked matrix products of Eigen
+      for large dimensions.
+   */
+  struct BackwardWorkspace
+  {
+    /** \brief Resize variables of state dimension.
+        \param state_dim state dimension
+
+        The variables of input dimension are resized on the first assignment of each solve.
+    */
+    inline void resize(int state_dim)
+    {
+      Vx.resize(state_dim);
+      Vxx.resize(state_dim, state_dim);
+      Vxx_symmetric.resize(state_dim, state_dim);
+      Qx.resize(state_dim);
+      Qxx.resize(state_dim, state_dim);
+      VxxFx.resize(state_dim, state_dim);
+    }
+
+    //! First-order derivative of value
+    StateDimVector Vx;
+
+    //! Second-order derivative of value
+    StateStateDimMatrix Vxx;
+
+    //! Symmetrized second-order derivative of value
+    StateStateDimMatrix Vxx_symmetric;
+
+    //! First-order derivative of Q-function w.r.t. input
+    InputDimVector Qu;
+
+    //! First-order derivative of Q-function w.r.t. state
+    StateDimVector Qx;
+
+    //! Second-order derivative of Q-function w.r.t. input and state
+    InputStateDimMatrix Qux;
+
+    //! Second-order derivative of Q-function w.r.t. input
+    InputInputDimMatrix Quu;
+
+    //! Second-order derivative of Q-function w.r.t. state
+    StateStateDimMatrix Qxx;
+
+    //! Regularized second-order derivative of Q-function w.r.t. input and state
+    InputStateDimMatrix Qux_reg;
+
+    //! Regularized second-order derivative of Q-function w.r.t. input
+    InputInputDimMatrix Quu_F;
+
+    //! Product of second-order derivative of value and first-order derivative of state equation w.r.t. state
+    StateStateDimMatrix VxxFx;
+
+    //! Product of second-order derivative of value and first-order derivative of state equation w.r.t. input
+    StateInputDimMatrix VxxFu;
+
+    //! Product of Quu and k
+    InputDimVector Quuk;
+
+    //! Product of Quu and K
+    InputStateDimMatrix QuuK;
+
+    //! Feedforward term for input
+    InputDimVector k;
+
+    //! Feedback gain for input w.r.t. state error
+    InputStateDimMatrix K;
+
+    //! Initial guess of feedforward term for QP with input constraints
+    InputDimVector initial_k;
+
+    //! Cholesky decomposition of Quu_F without input constraints
+    Eigen::LLT<InputInputDimMatrix> llt_Quu_F;
+  };
+
   /*! \brief Data to trace optimization loop. */
   struct TraceData
   {
@@ -215,7 +418,10 @@ public:
     double duration_forward = 0;
   };
 
-  /*! \brief Data of computation duration. */
+  /*! \brief Data of computation duration.
+
+      The durations of Q, reg, and gain are measured only with Instrumentation::Step.
+   */
   struct ComputationDuration
   {
     //! Duration to solve [msec]
@@ -246,6 +452,163 @@ public:
     double gain = 0;
   };
 
+  /*! \brief Histograms of computation duration across solves (same fields as ComputationDuration). */
+  struct LatencyHistogramData
+  {
+    //! Histogram of duration of solve
+    LatencyHistogram solve;
+
+    //! Histogram of duration of setup
+    LatencyHistogram setup;
+
+    //! Histogram of duration of opt
+    LatencyHistogram opt;
+
+    //! Histogram of duration of derivative
+    LatencyHistogram derivative;
+
+    //! Histogram of duration of backward
+    LatencyHistogram backward;
+
+    //! Histogram of duration of forward
+    LatencyHistogram forward;
+
+    //! Histogram of duration of Q
+    LatencyHistogram Q;
+
+    //! Histogram of duration of reg
+    LatencyHistogram reg;
+
+    //! Histogram of duration of gain
+    LatencyHistogram gain;
+
+    /** \brief Record computation duration of one solve. */
+    inline void record(const ComputationDuration & computation_duration)
+    {
+      solve.record(computation_duration.solve);
+      setup.record(computation_duration.setup);
+      opt.record(computation_duration.opt);
+      derivative.record(computation_duration.derivative);
+      backward.record(computation_duration.backward);
+      forward.record(computation_duration.forward);
+      Q.record(computation_duration.Q);
+      reg.record(computation_duration.reg);
+      gain.record(computation_duration.gain);
+    }
+
+    /** \brief Clear recorded durations. */
+    inline void reset()
+    {
+      solve.reset();
+      setup.reset();
+      opt.reset();
+      derivative.reset();
+      backward.reset();
+      forward.reset();
+      Q.reset();
+      reg.reset();
+      gain.reset();
+    }
+
+    /** \brief Add durations recorded by another solver instance. */
+    inline void merge(const LatencyHistogramData & data)
+    {
+      solve.merge(data.solve);
+      setup.merge(data.setup);
+      opt.merge(data.opt);
+      derivative.merge(data.derivative);
+      backward.merge(data.backward);
+      forward.merge(data.forward);
+      Q.merge(data.Q);
+      reg.merge(data.reg);
+      gain.merge(data.gain);
+    }
+
+    /** \brief Print summary of each histogram. */
+    inline void print() const
+    {
+      solve.print("solve");
+      setup.print("setup");
+      opt.print("opt");
+      derivative.print("derivative");
+      backward.print("backward");
+      forward.print("forward");
+      Q.print("Q");
+      reg.print("reg");
+      gain.print("gain");
+    }
+  };
+
+  /*! \brief Data of hardware performance counters (all zero if not measured). */
+  struct PerfCounterData
+  {
+    //! Counts to solve
+    PerfCounter::Count solve;
+
+    //! Counts to calculate derivatives (included in solve)
+    PerfCounter::Count derivative;
+
+    //! Counts to process backward pass (included in solve)
+    PerfCounter::Count backward;
+
+    //! Counts to process forward pass (included in solve)
+    PerfCounter::Count forward;
+
+    //! Counts to calculate Q (included in backward)
+    PerfCounter::Count Q;
+
+    //! Counts to calculate regularization (included in backward)
+    PerfCounter::Count reg;
+
+    //! Counts to calculate gains (included in backward)
+    PerfCounter::Count gain;
+  };
+
+  /*! \brief Record of solver inputs and outputs for replay. */
+  struct SolveRecord
+  {
+    /** \brief Read record.
+        \param reader record reader (must be positioned at the beginning of record)
+    */
+    void read(SolveRecordReader & reader);
+
+    /** \brief Calculate error between recorded output and solver output.
+        \param solver solver after replay
+        \return maximum absolute difference of sequence of input
+    */
+    double calcOutputError(const DDPSolver & solver) const;
+
+    //! Configuration
+    Configuration config;
+
+    //! Current time [sec]
+    double current_t = 0;
+
+    //! Current state
+    StateDimVector current_x;
+
+    //! Initial sequence of input
+    std::vector<InputDimVector> initial_u_list;
+
+    //! Sequence of lower limits of input (empty if input constraint is disabled)
+    std::vector<InputDimVector> u_lower_list;
+
+    //! Sequence of upper limits of input (empty if input constraint is disabled)
+    std::vector<InputDimVector> u_upper_list;
+
+    //! Whether the process is finished successfully
+    bool succeeded = false;
+
+    //! Number of iterations
+    int iter = 0;
+
+    //! Control data calculated by solve()
+    ControlData control_data;
+
+    //! Computation duration
+    ComputationDuration computation_duration;
+  };
+
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
@@ -266,6 +629,22 @@ public:
     return config_;
   }
 
+  /** \brief Const accessor to problem. */
+  inline const std::shared_ptr<DDPProblem<StateDim, InputDim>> & problem() const
+  {
+    return problem_;
+  }
+
+  /** \brief Set problem.
+      \param problem problem with the same dimensions
+
+      This allows the solver to be reused for another instance of the problem (e.g., with different parameters).
+   */
+  inline void setProblem(const std::shared_ptr<DDPProblem<StateDim, InputDim>> & problem)
+  {
+    problem_ = problem;
+  }
+
   /** \brief Solve optimization.
       \param current_t current time [sec]
       \param current_x current state
@@ -274,10 +653,55 @@ public:
   */
   bool solve(double current_t, const StateDimVector & current_x, const std::vector<InputDimVector> & initial_u_list);
 
+  /** \brief Begin step-wise optimization.
+      \param current_t current time [sec]
+      \param current_x current state
+      \param initial_u_list initial sequence of input
+
+      solve() is equivalent to calling begin(), then step() until done() returns true, and finally result(). This
+      allows a scheduler to interleave the optimization of multiple solvers in one thread by calling step() of each
+      solver in turn. The result is identical to solve(), except that the computation duration includes only the time
+      spent in begin() and step().
+  */
+  void begin(double current_t, const StateDimVector & current_x, const std::vector<InputDimVector> & initial_u_list);
+
+  /** \brief Process one iteration of step-wise optimization.
+      \return whether the optimization is finished (same as done())
+
+      Nothing is done if the optimization is already finished.
+  */
+  bool step();
+
+  /** \brief Whether step-wise optimization is finished. */
+  inline bool done() const
+  {
+    return step_done_;
+  }
+
+  /** \brief Abort step-wise optimization.
+
+      The optimization is finished with the current solution in the same manner as after the last iteration (e.g., the
+      observer is flushed and the solve is recorded), and result() returns false. Nothing is done if the optimization is
+      already finished.
+  */
+  inline void abort()
+  {
+    if(!step_done_)
+    {
+      finish();
+    }
+  }
+
+  /** \brief Whether step-wise optimization is finished successfully (valid only after done() returns true). */
+  inline bool result() const
+  {
+    return step_retval_ == 1;
+  }
+
   /** \brief Set function to return input limits.
       \param input_limits_func function to return input limits (in the order of lower, upper)
 
-      \note The input limits are only considered when with_input_constraint in configuration is true.
+      \note The input limits are only considered when input has constraints (see Configuration::with_input_constraint).
   */
   inline void setInputLimitsFunc(const std::function<std::array<InputDimVector, 2>(double)> & input_limits_func)
   {
@@ -290,6 +714,13 @@ public:
     return control_data_;
   }
 
+  /** \brief Make snapshot of feedback policy calculated by solve().
+
+      The snapshot holds the nominal state and input sequences, the feedback gains, and the input limits (if input has
+      constraints) of the last solve. It is immutable and can be evaluated in a control thread between solves.
+  */
+  std::shared_ptr<const FeedbackPolicy<StateDim, InputDim>> feedbackPolicy() const;
+
   /** \brief Const accessor to trace data list. */
   inline const std::vector<TraceData> & traceDataList() const
   {
@@ -302,12 +733,157 @@ public:
     return computation_duration_;
   }
 
+  /** \brief Const accessor to hardware performance counter data.
+
+      The data is measured only when Configuration::use_perf_counter is true.
+  */
+  inline const PerfCounterData & perfCounterData() const
+  {
+    return perf_counter_data_;
+  }
+
+  /** \brief Accessor to histograms of computation duration across solves.
+
+      The durations are recorded only when Configuration::use_latency_histogram is true.
+  */
+  inline LatencyHistogramData & latencyHistogramData()
+  {
+    return latency_histogram_data_;
+  }
+
+  /** \brief Const accessor to histograms of computation duration across solves. */
+  inline const LatencyHistogramData & latencyHistogramData() const
+  {
+    return latency_histogram_data_;
+  }
+
   /** \brief Dump trace data list.
       \param file_path path to output file
   */
   void dumpTraceDataList(const std::string & file_path) const;
 
+  /** \brief Set recorder of solver inputs and outputs.
+      \param recorder recorder (nullptr to disable recording)
+
+      When the recorder is set, SolveRecord is appended each time solve() is called.
+  */
+  void setRecorder(const std::shared_ptr<SolveRecorder> & recorder);
+
+  /** \brief Set ring buffer of trace events.
+      \param trace_ring ring buffer (nullptr to disable tracing)
+
+      When the ring buffer is set, the durations of setup, derivative, backward, and forward passes (and of Q, reg,
+      gain, and BoxQP in each step of backward pass) are pushed to it in each solve, depending on the instrumentation
+      level of the solver policy.
+  */
+  void setTraceRing(const std::shared_ptr<TraceRing> & trace_ring);
+
+  /** \brief Set thread pool.
+      \param thread_pool thread pool shared with other solvers (nullptr to differentiate serially)
+
+      When the thread pool is set, the dynamics and cost are differentiated in parallel along the horizon. The
+      derivative functions of the problem must be thread-safe. The result does not depend on the thread pool because
+      each step is differentiated independently.
+  */
+  void setThreadPool(const std::shared_ptr<nmpc_common::ThreadPool> & thread_pool);
+
+  /** \brief Accessor to observer.
+
+      Events of the levels up to Configuration::print_level (e.g., iteration start and end, lambda changes, line-search
+      results, and failures) are notified to the observer in each solve, including those of BoxQP.
+  */
+  inline Observer & observer()
+  {
+    return observer_;
+  }
+
+  /** \brief Solve optimization with recorded inputs.
+      \param record record of solver inputs
+      \return whether the process is finished successfully
+
+      The configuration is overwritten by the recorded one. If input limits are recorded, they are used instead of
+      the function set by setInputLimitsFunc().
+  */
+  bool replay(const SolveRecord & record);
+
+  /** \brief Tag to identify the solver type in record file. */
+  static std::string recordTag();
+
 protected:
+  /** \brief Append solver inputs and outputs to recorder.
+      \param current_t current time [sec]
+      \param current_x current state
+      \param initial_u_list initial sequence of input
+      \param succeeded whether the process is finished successfully
+
+      The order of writing must be the same as the order of reading in SolveRecord::read().
+  */
+  void appendRecord(double current_t,
+                    const StateDimVector & current_x,
+                    const std::vector<InputDimVector> & initial_u_list,
+                    bool succeeded);
+
+  /** \brief Whether to measure at the instrumentation level. */
+  static constexpr bool instrumented(Instrumentation level)
+  {
+    return Policy::instrumentation >= level;
+  }
+
+  /** \brief Get current time (default time if not measured at the instrumentation level). */
+  template<Instrumentation Level>
+  static inline typename Clock::time_point now()
+  {
+    if constexpr(instrumented(Level))
+    {
+      return Clock::now();
+    }
+    else
+    {
+      return typename Clock::time_point();
+    }
+  }
+
+  /** \brief Read hardware performance counters (zeros if not measured at the instrumentation level). */
+  template<Instrumentation Level>
+  inline PerfCounter::Count readPerfCounter() const
+  {
+    if constexpr(instrumented(Level))
+    {
+      return perf_counter_ ? perf_counter_->read() : PerfCounter::Count();
+    }
+    else
+    {
+      return PerfCounter::Count();
+    }
+  }
+
+  /** \brief Print level bounded by the solver policy. */
+  inline int printLevel() const
+  {
+    return std::min(config_.print_level, Policy::max_print_level);
+  }
+
+  /** \brief Whether to use second-order derivatives of state equation. */
+  inline bool useStateEqSecondDerivative() const
+  {
+    return resolvePolicy(Policy::use_state_eq_second_derivative, config_.use_state_eq_second_derivative);
+  }
+
+  /** \brief Whether input has constraints. */
+  inline bool withInputConstraint() const
+  {
+    return resolvePolicy(Policy::with_input_constraint, config_.with_input_constraint);
+  }
+
+  /** \brief Regularization type. */
+  inline int regType() const
+  {
+    return resolvePolicy(Policy::reg_type, config_.reg_type);
+  }
+
+  /** \brief Finish step-wise optimization (e.g., measure computation duration and append record). */
+  void finish();
+
   /** \brief Process one iteration.
       \param iter current iteration
       \return 0 for continue, 1 for terminate, -1 for failure
@@ -370,8 +946,50 @@ protected:
   //! Second-order derivative of value in last step of horizon
   StateStateDimMatrix last_Vxx_;
 
+  //! Workspace of backward pass
+  BackwardWorkspace backward_workspace_;
+
   //! Expected update of value
   Eigen::Vector2d dV_;
+
+  //! Recorder of solver inputs and outputs
+  std::shared_ptr<SolveRecorder> recorder_;
+
+  //! Ring buffer of trace events
+  std::shared_ptr<TraceRing> trace_ring_;
+
+  //! Thread pool to differentiate along the horizon in parallel
+  std::shared_ptr<nmpc_common::ThreadPool> thread_pool_;
+
+  //! QP solver for input constraints (reused to avoid repetitive memory allocation)
+  std::unique_ptr<BoxQP<InputDim, ObserverRef<Observer>>> box_qp_;
+
+  //! Observer notified of events
+  Observer observer_;
+
+  //! Hardware performance counters (nullptr if not measured)
+  std::unique_ptr<PerfCounter> perf_counter_;
+
+  //! Hardware performance counter data
+  PerfCounterData perf_counter_data_;
+
+  //! Histograms of computation duration across solves
+  LatencyHistogramData latency_histogram_data_;
+
+  //! Whether step-wise optimization is finished
+  bool step_done_ = true;
+
+  //! Next iteration of step-wise optimization
+  int step_iter_ = 0;
+
+  //! Return value of last iteration of step-wise optimization (0 for continue, 1 for terminate, -1 for failure)
+  int step_retval_ = 0;
+
+  //! Start time of step-wise optimization
+  typename Clock::time_point step_start_time_;
+
+  //! Initial sequence of input given to begin() (stored only for recorder)
+  std::vector<InputDimVector> record_initial_u_list_;
 };
 } // namespace nmpc_ddp
 
@@ -1,8 +1,10 @@
 /* Author: Masaki Murooka */
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <fstream>
-#include <iostream>
+#include <limits>
 
 #include <nmpc_ddp/BoxQP.h>
 
@@ -17,20 +19,44 @@ double calcDuration(const std::chrono::time_point<Clock> & start_time, const std
 
 namespace nmpc_ddp
 {
-template<int StateDim, int InputDim>
-DDPSolver<StateDim, InputDim>::DDPSolver(const std::shared_ptr<DDPProblem<StateDim, InputDim>> & problem)
+template<int StateDim, int InputDim, class Policy>
+DDPSolver<StateDim, InputDim, Policy>::DDPSolver(const std::shared_ptr<DDPProblem<StateDim, InputDim>> & problem)
 : problem_(problem)
 {
 }
 
-template<int StateDim, int InputDim>
-bool DDPSolver<StateDim, InputDim>::solve(double current_t,
-                                          const StateDimVector & current_x,
-                                          const std::vector<InputDimVector> & initial_u_list)
+template<int StateDim, int InputDim, class Policy>
+bool DDPSolver<StateDim, InputDim, Policy>::solve(double current_t,
+                                                  const StateDimVector & current_x,
+                                                  const std::vector<InputDimVector> & initial_u_list)
+{
+  begin(current_t, current_x, initial_u_list);
+  while(!step())
+  {
+  }
+  return result();
+}
+
+template<int StateDim, int InputDim, class Policy>
+void DDPSolver<StateDim, InputDim, Policy>::begin(double current_t,
+                                                  const StateDimVector & current_x,
+                                                  const std::vector<InputDimVector> & initial_u_list)
 {
   computation_duration_ = ComputationDuration();
+  perf_counter_data_ = PerfCounterData();
+
+  // Counters are reopened if the calling thread changes because they only count the thread that opened them
+  if(!config_.use_perf_counter || !instrumented(Instrumentation::Phase))
+  {
+    perf_counter_.reset();
+  }
+  else if(!perf_counter_ || !perf_counter_->isCountedThread())
+  {
+    perf_counter_ = std::make_unique<PerfCounter>(printLevel());
+  }
 
-  auto start_time = std::chrono::system_clock::now();
+  auto start_time = now<Instrumentation::Phase>();
+  auto start_count = readPerfCounter<Instrumentation::Phase>();
 
   // Initialize variables
   current_t_ = current_t;
@@ -61,23 +87,39 @@ bool DDPSolver<StateDim, InputDim>::solve(double current_t,
   candidate_control_data_.x_list.resize(config_.horizon_steps + 1);
   candidate_control_data_.u_list.resize(config_.horizon_steps);
   candidate_control_data_.cost_list.resize(config_.horizon_steps + 1);
-  int outer_dim = config_.use_state_eq_second_derivative ? problem_->stateDim() : 0;
+  int outer_dim = useStateEqSecondDerivative() ? problem_->runtimeStateDim() : 0;
   if constexpr(InputDim == Eigen::Dynamic)
   {
-    derivative_list_.clear();
+    // Resize each element in place so that memory is not reallocated if the input dimension along the horizon is
+    // unchanged from the previous solve
+    while(static_cast<int>(derivative_list_.size()) > config_.horizon_steps)
+    {
+      derivative_list_.pop_back();
+    }
     for(int i = 0; i < config_.horizon_steps; i++)
     {
       double t = current_t_ + i * problem_->dt();
-      derivative_list_.push_back(Derivative(problem_->stateDim(), problem_->inputDim(t), outer_dim));
+      if(i < static_cast<int>(derivative_list_.size()))
+      {
+        derivative_list_[i].resize(problem_->runtimeStateDim(), problem_->inputDim(t), outer_dim);
+      }
+      else
+      {
+        derivative_list_.emplace_back(problem_->runtimeStateDim(), problem_->inputDim(t), outer_dim);
+      }
     }
   }
   else
   {
     // This assumes that the dimension is fixed, but it is efficient because it preserves existing elements
-    derivative_list_.resize(config_.horizon_steps, Derivative(problem_->stateDim(), problem_->inputDim(), outer_dim));
+    derivative_list_.resize(config_.horizon_steps,
+                            Derivative(problem_->runtimeStateDim(), problem_->inputDim(), outer_dim));
   }
   k_list_.resize(config_.horizon_steps);
   K_list_.resize(config_.horizon_steps);
+  last_Vx_.resize(problem_->runtimeStateDim());
+  last_Vxx_.resize(problem_->runtimeStateDim(), problem_->runtimeStateDim());
+  backward_workspace_.resize(problem_->runtimeStateDim());
 
   // Initialize state and cost sequence
   control_data_.u_list = initial_u_list;
@@ -96,6 +138,7 @@ bool DDPSolver<StateDim, InputDim>::solve(double current_t,
 
   // Initialize trace data
   trace_data_list_.clear();
+  trace_data_list_.reserve(config_.max_iter + 1);
   TraceData initial_trace_data;
   initial_trace_data.iter = 0;
   initial_trace_data.cost = control_data_.cost_list.sum();
@@ -103,49 +146,111 @@ bool DDPSolver<StateDim, InputDim>::solve(double current_t,
   initial_trace_data.dlambda = dlambda_;
   trace_data_list_.push_back(initial_trace_data);
 
-  if(config_.print_level >= 3)
+  if(printLevel() >= 3)
   {
-    std::cout << "[DDP] Initial cost: " << control_data_.cost_list.sum() << std::endl;
+    observer_.notify(SolverEvent(SolverEventType::Info, 3, "DDP", "Initial cost.", -1,
+                                 {{"cost", control_data_.cost_list.sum()}}));
   }
 
-  auto setup_time = std::chrono::system_clock::now();
-  computation_duration_.setup = calcDuration(start_time, setup_time);
+  if(recorder_)
+  {
+    record_initial_u_list_ = initial_u_list;
+  }
 
-  // Optimization loop
-  int retval = 0;
-  for(int iter = 1; iter <= config_.max_iter; iter++)
+  auto setup_time = now<Instrumentation::Phase>();
+  if constexpr(instrumented(Instrumentation::Phase))
   {
-    retval = procOnce(iter);
-    if(retval != 0)
+    computation_duration_.setup = calcDuration(start_time, setup_time);
+    perf_counter_data_.solve = readPerfCounter<Instrumentation::Phase>() - start_count;
+    if(trace_ring_)
     {
-      break;
+      trace_ring_->pushComplete("DDP", "setup", start_time, setup_time);
     }
   }
 
-  if(config_.print_level >= 3)
+  // Prepare optimization loop
+  step_start_time_ = start_time;
+  step_iter_ = 1;
+  step_retval_ = 0;
+  step_done_ = false;
+  if(config_.max_iter < 1)
+  {
+    finish();
+  }
+}
+
+template<int StateDim, int InputDim, class Policy>
+bool DDPSolver<StateDim, InputDim, Policy>::step()
+{
+  if(step_done_)
+  {
+    return true;
+  }
+
+  auto start_time = now<Instrumentation::Phase>();
+  auto start_count = readPerfCounter<Instrumentation::Phase>();
+
+  step_retval_ = procOnce(step_iter_);
+
+  if constexpr(instrumented(Instrumentation::Phase))
+  {
+    computation_duration_.opt += calcDuration(start_time, Clock::now());
+    perf_counter_data_.solve += readPerfCounter<Instrumentation::Phase>() - start_count;
+  }
+
+  if(step_retval_ != 0 || step_iter_ == config_.max_iter)
+  {
+    finish();
+  }
+  step_iter_++;
+
+  return step_done_;
+}
+
+template<int StateDim, int InputDim, class Policy>
+void DDPSolver<StateDim, InputDim, Policy>::finish()
+{
+  if(printLevel() >= 3)
+  {
+    observer_.notify(SolverEvent(SolverEventType::Info, 3, "DDP", "Final cost.", trace_data_list_.back().iter,
+                                 {{"cost", control_data_.cost_list.sum()}}));
+  }
+
+  if constexpr(instrumented(Instrumentation::Phase))
   {
-    std::cout << "[DDP] Final cost: " << control_data_.cost_list.sum() << std::endl;
+    computation_duration_.solve = computation_duration_.setup + computation_duration_.opt;
+    if(config_.use_latency_histogram)
+    {
+      latency_histogram_data_.record(computation_duration_);
+    }
+    if(trace_ring_)
+    {
+      trace_ring_->pushComplete("DDP", "solve", step_start_time_, Clock::now(), trace_data_list_.back().iter,
+                                control_data_.cost_list.sum());
+    }
   }
 
-  auto end_time = std::chrono::system_clock::now();
-  computation_duration_.opt = calcDuration(setup_time, end_time);
-  computation_duration_.solve = calcDuration(start_time, end_time);
+  if(printLevel() >= 3)
+  {
+    observer_.notify(SolverEvent(SolverEventType::Info, 3, "DDP", "Computation duration [ms].", -1,
+                                 {{"setup", computation_duration_.setup}, {"opt", computation_duration_.opt}}));
+  }
+  observer_.flush();
 
-  if(config_.print_level >= 3)
+  if(recorder_)
   {
-    std::cout << "[DDP] Setup duration: " << computation_duration_.setup
-              << " [ms], optimization duration: " << computation_duration_.opt << " [ms]." << std::endl;
+    appendRecord(current_t_, control_data_.x_list[0], record_initial_u_list_, step_retval_ == 1);
   }
 
-  return retval == 1;
+  step_done_ = true;
 }
 
-template<int StateDim, int InputDim>
-int DDPSolver<StateDim, InputDim>::procOnce(int iter)
+template<int StateDim, int InputDim, class Policy>
+int DDPSolver<StateDim, InputDim, Policy>::procOnce(int iter)
 {
-  if(config_.print_level >= 3)
+  if(printLevel() >= 3)
   {
-    std::cout << "[DDP] Start iteration " << iter << std::endl;
+    observer_.notify(SolverEvent(SolverEventType::IterationStart, 3, "DDP", "Start iteration.", iter));
   }
 
   // Append trace data
@@ -155,16 +260,17 @@ int DDPSolver<StateDim, InputDim>::procOnce(int iter)
 
   // Step 1: differentiate dynamics and cost along new trajectory
   {
-    auto start_time = std::chrono::system_clock::now();
+    auto start_time = now<Instrumentation::Phase>();
+    auto start_count = readPerfCounter<Instrumentation::Phase>();
 
-    for(int i = 0; i < config_.horizon_steps; i++)
+    auto calc_derivative = [this](int i)
     {
       auto & derivative = derivative_list_[i];
 
       double t = current_t_ + i * problem_->dt();
       const StateDimVector & x = control_data_.x_list[i];
       const InputDimVector & u = control_data_.u_list[i];
-      if(config_.use_state_eq_second_derivative)
+      if(useStateEqSecondDerivative())
       {
         problem_->calcStateEqDeriv(t, x, u, derivative.Fx, derivative.Fu, derivative.Fxx, derivative.Fuu,
                                    derivative.Fxu);
@@ -175,18 +281,39 @@ int DDPSolver<StateDim, InputDim>::procOnce(int iter)
       }
       problem_->calcRunningCostDeriv(t, x, u, derivative.Lx, derivative.Lu, derivative.Lxx, derivative.Luu,
                                      derivative.Lxu);
+    };
+    if(thread_pool_)
+    {
+      thread_pool_->parallelFor(0, config_.horizon_steps, calc_derivative);
+    }
+    else
+    {
+      for(int i = 0; i < config_.horizon_steps; i++)
+      {
+        calc_derivative(i);
+      }
     }
     double terminal_t = current_t_ + config_.horizon_steps * problem_->dt();
     problem_->calcTerminalCostDeriv(terminal_t, control_data_.x_list[config_.horizon_steps], last_Vx_, last_Vxx_);
 
-    double duration_derivative = calcDuration(start_time, std::chrono::system_clock::now());
-    trace_data.duration_derivative = duration_derivative;
-    computation_duration_.derivative += duration_derivative;
+    if constexpr(instrumented(Instrumentation::Phase))
+    {
+      auto end_time = Clock::now();
+      double duration_derivative = calcDuration(start_time, end_time);
+      if(trace_ring_)
+      {
+        trace_ring_->pushComplete("DDP", "derivative", start_time, end_time, iter);
+      }
+      trace_data.duration_derivative = duration_derivative;
+      computation_duration_.derivative += duration_derivative;
+      perf_counter_data_.derivative += readPerfCounter<Instrumentation::Phase>() - start_count;
+    }
   }
 
   // Step 2: backward pass, compute optimal control law and cost-to-go
   {
-    auto start_time = std::chrono::system_clock::now();
+    auto start_time = now<Instrumentation::Phase>();
+    auto start_count = readPerfCounter<Instrumentation::Phase>();
 
     while(!backwardPass())
     {
@@ -195,22 +322,32 @@ int DDPSolver<StateDim, InputDim>::procOnce(int iter)
       lambda_ = std::max(lambda_ * dlambda_, config_.lambda_min);
       if(lambda_ > config_.lambda_max)
       {
-        if(config_.print_level >= 1)
+        if(printLevel() >= 1)
         {
-          std::cout << "[DDP/Backward] Failure due to large lambda. (time: " << current_t_ << ", iter: " << iter << ")"
-                    << std::endl;
+          observer_.notify(SolverEvent(SolverEventType::Failure, 1, "DDP/Backward", "Failure due to large lambda.",
+                                       iter, {{"time", current_t_}, {"lambda", lambda_}}));
         }
         return -1; // Failure
       }
-      if(config_.print_level >= 3)
+      if(printLevel() >= 3)
       {
-        std::cout << "[DDP/Backward] Increase lambda to " << lambda_ << std::endl;
+        observer_.notify(SolverEvent(SolverEventType::LambdaIncrease, 3, "DDP/Backward", "Increase lambda.", iter,
+                                     {{"lambda", lambda_}}));
       }
     }
 
-    double duration_backward = calcDuration(start_time, std::chrono::system_clock::now());
-    trace_data.duration_backward = duration_backward;
-    computation_duration_.backward += duration_backward;
+    if constexpr(instrumented(Instrumentation::Phase))
+    {
+      auto end_time = Clock::now();
+      double duration_backward = calcDuration(start_time, end_time);
+      if(trace_ring_)
+      {
+        trace_ring_->pushComplete("DDP", "backward", start_time, end_time, iter);
+      }
+      trace_data.duration_backward = duration_backward;
+      computation_duration_.backward += duration_backward;
+      perf_counter_data_.backward += readPerfCounter<Instrumentation::Phase>() - start_count;
+    }
   }
 
   // Check for termination due to small gradient
@@ -222,10 +359,10 @@ int DDPSolver<StateDim, InputDim>::procOnce(int iter)
   trace_data.k_rel_norm = k_rel_norm;
   if(k_rel_norm < config_.k_rel_norm_thre && lambda_ < config_.lambda_thre)
   {
-    if(config_.print_level >= 2)
+    if(printLevel() >= 2)
     {
-      std::cout << "[DDP] Terminate due to small gradient. (time: " << current_t_ << ", iter: " << iter << ")"
-                << std::endl;
+      observer_.notify(SolverEvent(SolverEventType::Termination, 2, "DDP", "Terminate due to small gradient.", iter,
+                                   {{"time", current_t_}, {"k_rel_norm", k_rel_norm}}));
     }
     return 1; // Terminate
   }
@@ -234,7 +371,8 @@ int DDPSolver<StateDim, InputDim>::procOnce(int iter)
   bool forward_pass_success = false;
   double cost_update_actual = 0;
   {
-    auto start_time = std::chrono::system_clock::now();
+    auto start_time = now<Instrumentation::Phase>();
+    auto start_count = readPerfCounter<Instrumentation::Phase>();
 
     double alpha = 0;
     double cost_update_expected = 0;
@@ -250,10 +388,10 @@ int DDPSolver<StateDim, InputDim>::procOnce(int iter)
       cost_update_ratio = cost_update_actual / cost_update_expected;
       if(cost_update_expected < 0)
       {
-        if((!config_.with_input_constraint && config_.print_level >= 0)
-           || (config_.with_input_constraint && config_.print_level >= 2))
+        if((!withInputConstraint() && printLevel() >= 0) || (withInputConstraint() && printLevel() >= 2))
         {
-          std::cout << "[DDP/Forward] Value is not expected to decrease." << std::endl;
+          observer_.notify(SolverEvent(SolverEventType::LineSearch, withInputConstraint() ? 2 : 0, "DDP/Forward",
+                                       "Value is not expected to decrease.", iter, {{"alpha", alpha}}));
         }
         cost_update_ratio = (cost_update_actual >= 0 ? 1 : -1);
       }
@@ -268,13 +406,26 @@ int DDPSolver<StateDim, InputDim>::procOnce(int iter)
     trace_data.cost_update_expected = cost_update_expected;
     trace_data.cost_update_ratio = cost_update_ratio;
 
-    double duration_forward = calcDuration(start_time, std::chrono::system_clock::now());
-    trace_data.duration_forward = duration_forward;
-    computation_duration_.forward += duration_forward;
+    if constexpr(instrumented(Instrumentation::Phase))
+    {
+      auto end_time = Clock::now();
+      double duration_forward = calcDuration(start_time, end_time);
+      if(trace_ring_)
+      {
+        trace_ring_->pushComplete("DDP", "forward", start_time, end_time, iter);
+      }
+      trace_data.duration_forward = duration_forward;
+      computation_duration_.forward += duration_forward;
+      perf_counter_data_.forward += readPerfCounter<Instrumentation::Phase>() - start_count;
+    }
   }
-  if(!forward_pass_success && config_.print_level >= 3)
+  if(printLevel() >= 3)
   {
-    std::cout << "[DDP] Forward pass failed." << std::endl;
+    observer_.notify(SolverEvent(SolverEventType::LineSearch, 3, "DDP/Forward",
+                                 forward_pass_success ? "Forward pass succeeded." : "Forward pass failed.", iter,
+                                 {{"alpha", trace_data.alpha},
+                                  {"cost_update_actual", trace_data.cost_update_actual},
+                                  {"cost_update_ratio", trace_data.cost_update_ratio}}));
   }
 
   // Step 4: accept step (or not)
@@ -289,10 +440,10 @@ int DDPSolver<StateDim, InputDim>::procOnce(int iter)
     // Check for termination due to small cost update
     if(cost_update_actual < config_.cost_update_thre)
     {
-      if(config_.print_level >= 2)
+      if(printLevel() >= 2)
       {
-        std::cout << "[DDP] Terminate due to small cost update. (time: " << current_t_ << ", iter: " << iter << ")"
-                  << std::endl;
+        observer_.notify(SolverEvent(SolverEventType::Termination, 2, "DDP", "Terminate due to small cost update.",
+                                     iter, {{"time", current_t_}, {"cost_update_actual", cost_update_actual}}));
       }
       retval = 1; // Terminate
     }
@@ -307,9 +458,10 @@ int DDPSolver<StateDim, InputDim>::procOnce(int iter)
     {
       lambda_ = 0;
     }
-    if(config_.print_level >= 3)
+    if(printLevel() >= 3)
     {
-      std::cout << "[DDP/Forward] Decrease lambda to " << lambda_ << std::endl;
+      observer_.notify(SolverEvent(SolverEventType::LambdaDecrease, 3, "DDP/Forward", "Decrease lambda.", iter,
+                                   {{"lambda", lambda_}}));
     }
   }
   else
@@ -319,16 +471,17 @@ int DDPSolver<StateDim, InputDim>::procOnce(int iter)
     lambda_ = std::max(lambda_ * dlambda_, config_.lambda_min);
     if(lambda_ > config_.lambda_max)
     {
-      if(config_.print_level >= 1)
+      if(printLevel() >= 1)
       {
-        std::cout << "[DDP/Forward] Failure due to large lambda. (time: " << current_t_ << ", iter: " << iter << ")"
-                  << std::endl;
+        observer_.notify(SolverEvent(SolverEventType::Failure, 1, "DDP/Forward", "Failure due to large lambda.", iter,
+                                     {{"time", current_t_}, {"lambda", lambda_}}));
       }
       retval = -1; // Failure
     }
-    if(config_.print_level >= 3)
+    if(printLevel() >= 3)
     {
-      std::cout << "[DDP/Forward] Increase lambda to " << lambda_ << std::endl;
+      observer_.notify(SolverEvent(SolverEventType::LambdaIncrease, 3, "DDP/Forward", "Increase lambda.", iter,
+                                   {{"lambda", lambda_}}));
     }
   }
 
@@ -336,32 +489,40 @@ int DDPSolver<StateDim, InputDim>::procOnce(int iter)
   trace_data.lambda = lambda_;
   trace_data.dlambda = dlambda_;
 
+  if(printLevel() >= 3)
+  {
+    observer_.notify(SolverEvent(SolverEventType::IterationEnd, 3, "DDP", "End iteration.", iter,
+                                 {{"cost", trace_data.cost}, {"lambda", trace_data.lambda}}));
+  }
+
   return retval;
 }
 
-template<int StateDim, int InputDim>
-bool DDPSolver<StateDim, InputDim>::backwardPass()
+template<int StateDim, int InputDim, class Policy>
+bool DDPSolver<StateDim, InputDim, Policy>::backwardPass()
 {
-  // To avoid repetitive memory allocation, the vector and matrix variables are created outside of loop
-  StateDimVector Vx = last_Vx_;
-  StateStateDimMatrix Vxx = last_Vxx_;
-  StateStateDimMatrix Vxx_reg;
-  StateStateDimMatrix Vxx_symmetric;
-
-  InputDimVector Qu;
-  StateDimVector Qx;
-  InputStateDimMatrix Qux;
-  InputInputDimMatrix Quu;
-  StateStateDimMatrix Qxx;
-  InputStateDimMatrix Qux_reg;
-  InputInputDimMatrix Quu_F;
-
-  InputStateDimMatrix VxFux;
-  InputInputDimMatrix VxFuu;
-
-  InputDimVector k;
-  InputStateDimMatrix K;
-
+  // To avoid repetitive memory allocation, the vector and matrix variables are preallocated in the workspace
+  BackwardWorkspace & ws = backward_workspace_;
+  StateDimVector & Vx = ws.Vx;
+  StateStateDimMatrix & Vxx = ws.Vxx;
+  StateStateDimMatrix & Vxx_symmetric = ws.Vxx_symmetric;
+
+  InputDimVector & Qu = ws.Qu;
+  StateDimVector & Qx = ws.Qx;
+  InputStateDimMatrix & Qux = ws.Qux;
+  InputInputDimMatrix & Quu = ws.Quu;
+  StateStateDimMatrix & Qxx = ws.Qxx;
+  InputStateDimMatrix & Qux_reg = ws.Qux_reg;
+  InputInputDimMatrix & Quu_F = ws.Quu_F;
+
+  StateStateDimMatrix & VxxFx = ws.VxxFx;
+  StateInputDimMatrix & VxxFu = ws.VxxFu;
+
+  InputDimVector & k = ws.k;
+  InputStateDimMatrix & K = ws.K;
+
+  Vx = last_Vx_;
+  Vxx = last_Vxx_;
   dV_.setZero();
 
   for(int i = config_.horizon_steps - 1; i >= 0; i--)
@@ -381,14 +542,19 @@ bool DDPSolver<StateDim, InputDim>::backwardPass()
     int input_dim = static_cast<int>(Fu.cols());
 
     // Calculate Q
-    auto start_time_Q = std::chrono::system_clock::now();
+    auto start_time_Q = now<Instrumentation::Step>();
+    auto start_count_Q = readPerfCounter<Instrumentation::Step>();
+
+    // The products with Vxx are computed once and shared by Qux, Quu, and Qxx
+    VxxFx.noalias() = Vxx * Fx;
+    VxxFu.noalias() = Vxx * Fu;
 
     Qu.noalias() = Lu + Fu.transpose() * Vx;
 
     Qx.noalias() = Lx + Fx.transpose() * Vx;
 
-    Qux.noalias() = Lxu.transpose() + Fu.transpose() * Vxx * Fx;
-    if(config_.use_state_eq_second_derivative)
+    Qux.noalias() = Lxu.transpose() + Fu.transpose() * VxxFx;
+    if(useStateEqSecondDerivative())
     {
       throw std::runtime_error("Vector-tensor product is not implemented yet.");
       // \todo Need operation to compute a matrix by vector and tensor product
@@ -396,8 +562,8 @@ bool DDPSolver<StateDim, InputDim>::backwardPass()
       // Qux += VxFux
     }
 
-    Quu.noalias() = Luu + Fu.transpose() * Vxx * Fu;
-    if(config_.use_state_eq_second_derivative)
+    Quu.noalias() = Luu + Fu.transpose() * VxxFu;
+    if(useStateEqSecondDerivative())
     {
       throw std::runtime_error("Vector-tensor product is not implemented yet.");
       // \todo Need operation to compute a matrix by vector and tensor product
@@ -405,51 +571,62 @@ bool DDPSolver<StateDim, InputDim>::backwardPass()
       // Quu += VxFuu;
     }
 
-    Qxx.noalias() = Lxx + Fx.transpose() * Vxx * Fx;
-    if(config_.use_state_eq_second_derivative)
+    Qxx.noalias() = Lxx + Fx.transpose() * VxxFx;
+    if(useStateEqSecondDerivative())
     {
       throw std::runtime_error("Vector-tensor product is not implemented yet.");
       // \todo Need operation to compute a matrix by vector and tensor product
       // Qxx += Vx * Fxx;
     }
 
-    computation_duration_.Q += calcDuration(start_time_Q, std::chrono::system_clock::now());
-
-    // Calculate regularization
-    auto start_time_reg = std::chrono::system_clock::now();
-
-    Vxx_reg = Vxx;
-    if(config_.reg_type == 2)
+    if constexpr(instrumented(Instrumentation::Step))
     {
-      Vxx_reg.diagonal().array() += lambda_;
+      auto end_time_Q = Clock::now();
+      computation_duration_.Q += calcDuration(start_time_Q, end_time_Q);
+      perf_counter_data_.Q += readPerfCounter<Instrumentation::Step>() - start_count_Q;
+      if(trace_ring_)
+      {
+        trace_ring_->pushComplete("DDP", "Q", start_time_Q, end_time_Q, i);
+      }
     }
 
-    Qux_reg.noalias() = Lxu.transpose() + Fu.transpose() * Vxx_reg * Fx;
-    if(config_.use_state_eq_second_derivative)
-    {
-      Qux_reg += VxFux;
-    }
+    // Calculate regularization
+    auto start_time_reg = now<Instrumentation::Step>();
+    auto start_count_reg = readPerfCounter<Instrumentation::Step>();
 
-    Quu_F.noalias() = Luu + Fu.transpose() * Vxx_reg * Fu;
-    if(config_.use_state_eq_second_derivative)
+    // Since Fu^T (Vxx + lambda I) F = Fu^T Vxx F + lambda Fu^T F, the products with Vxx are not recomputed
+    Qux_reg = Qux;
+    Quu_F = Quu;
+    if(regType() == 2)
     {
-      Quu_F += VxFuu;
+      Qux_reg.noalias() += lambda_ * Fu.transpose() * Fx;
+      Quu_F.noalias() += lambda_ * Fu.transpose() * Fu;
     }
-    if(config_.reg_type == 1)
+    if(regType() == 1)
     {
       Quu_F.diagonal().array() += lambda_;
     }
 
-    computation_duration_.reg += calcDuration(start_time_reg, std::chrono::system_clock::now());
+    if constexpr(instrumented(Instrumentation::Step))
+    {
+      auto end_time_reg = Clock::now();
+      computation_duration_.reg += calcDuration(start_time_reg, end_time_reg);
+      perf_counter_data_.reg += readPerfCounter<Instrumentation::Step>() - start_count_reg;
+      if(trace_ring_)
+      {
+        trace_ring_->pushComplete("DDP", "reg", start_time_reg, end_time_reg, i);
+      }
+    }
 
     // Calculate gains
-    auto start_time_gain = std::chrono::system_clock::now();
+    auto start_time_gain = now<Instrumentation::Step>();
+    auto start_count_gain = readPerfCounter<Instrumentation::Step>();
 
     if(input_dim > 0)
     {
-      if(config_.with_input_constraint)
+      if(withInputConstraint())
       {
-        InputDimVector initial_k;
+        InputDimVector & initial_k = ws.initial_k;
         if(i == config_.horizon_steps - 1)
         {
           initial_k.setZero(input_dim);
@@ -466,62 +643,97 @@ bool DDPSolver<StateDim, InputDim>::backwardPass()
           }
         }
 
-        BoxQP<Eigen::Dynamic> qp(static_cast<int>(Quu_F.cols()));
+        // BoxQP is reused across steps and solves to avoid repetitive memory allocation
+        if(!box_qp_ || box_qp_->var_dim_ != input_dim)
+        {
+          box_qp_ = std::make_unique<BoxQP<InputDim, ObserverRef<Observer>>>(input_dim);
+        }
+        BoxQP<InputDim, ObserverRef<Observer>> & qp = *box_qp_;
+        qp.setTraceRing(instrumented(Instrumentation::Step) ? trace_ring_ : nullptr);
+        qp.setObserver(ObserverRef<Observer>(&observer_));
         const auto & u_limits = input_limits_func_(t);
         k = qp.solve(Quu_F, Qu, u_limits[0] - control_data_.u_list[i], u_limits[1] - control_data_.u_list[i],
                      initial_k);
         if(qp.retval_ < 0)
         {
-          if(config_.print_level >= 1)
+          if(printLevel() >= 1)
           {
-            std::cout << "[DDP/Backward] Failed BoxQP: " << qp.retstr_.at(qp.retval_) << std::endl;
+            observer_.notify(SolverEvent(SolverEventType::Failure, 1, "DDP/Backward", "Failed BoxQP.", -1,
+                                         {{"step", i}, {"result", qp.retval_}}));
           }
           return false;
         }
 
         const auto & free_idxs = qp.free_idxs_;
-        K.setZero(input_dim, problem_->stateDim());
+        K.setZero(input_dim, problem_->runtimeStateDim());
         if(free_idxs.size() > 0)
         {
-          Eigen::MatrixXd Qux_reg_free(free_idxs.size(), problem_->stateDim());
-          for(size_t j = 0; j < free_idxs.size(); j++)
+          // Solve for each column of K so that the size of temporary variable is bounded by InputDim
+          typename BoxQP<InputDim, ObserverRef<Observer>>::VarDimMaxVector K_free_col(free_idxs.size());
+          for(int col = 0; col < problem_->runtimeStateDim(); col++)
           {
-            Qux_reg_free.row(j) = Qux_reg.row(free_idxs[j]);
-          }
-          Eigen::MatrixXd K_free = -1 * qp.llt_free_->solve(Qux_reg_free);
-          for(size_t j = 0; j < free_idxs.size(); j++)
-          {
-            K.row(free_idxs[j]) = K_free.row(j);
+            for(size_t j = 0; j < free_idxs.size(); j++)
+            {
+              K_free_col[j] = -1 * Qux_reg(free_idxs[j], col);
+            }
+            qp.llt_free_.solveInPlace(K_free_col);
+            for(size_t j = 0; j < free_idxs.size(); j++)
+            {
+              K(free_idxs[j], col) = K_free_col[j];
+            }
           }
         }
       }
       else
       {
-        Eigen::LLT<InputInputDimMatrix> llt_Quu_F(Quu_F);
+        Eigen::LLT<InputInputDimMatrix> & llt_Quu_F = ws.llt_Quu_F;
+        llt_Quu_F.compute(Quu_F);
         if(llt_Quu_F.info() == Eigen::NumericalIssue)
         {
-          if(config_.print_level >= 1)
+          if(printLevel() >= 1)
           {
-            std::cout << "[DDP/Backward] Quu_F is not positive definite in Cholesky decomposition (LLT)." << std::endl;
+            observer_.notify(SolverEvent(SolverEventType::Failure, 1, "DDP/Backward",
+                                         "Quu_F is not positive definite in Cholesky decomposition (LLT).", -1,
+                                         {{"step", i}}));
           }
           return false;
         }
-        k = -1 * llt_Quu_F.solve(Qu);
-        K = -1 * llt_Quu_F.solve(Qux_reg);
+        // Solve in place and negate afterwards to avoid temporary variables
+        k = llt_Quu_F.solve(Qu);
+        k *= -1;
+        K = llt_Quu_F.solve(Qux_reg);
+        K *= -1;
       }
     }
     else
     {
       k.setZero(0);
-      K.setZero(0, problem_->stateDim());
+      K.setZero(0, problem_->runtimeStateDim());
     }
 
-    computation_duration_.gain += calcDuration(start_time_gain, std::chrono::system_clock::now());
+    if constexpr(instrumented(Instrumentation::Step))
+    {
+      auto end_time_gain = Clock::now();
+      computation_duration_.gain += calcDuration(start_time_gain, end_time_gain);
+      perf_counter_data_.gain += readPerfCounter<Instrumentation::Step>() - start_count_gain;
+      if(trace_ring_)
+      {
+        trace_ring_->pushComplete("DDP", "gain", start_time_gain, end_time_gain, i);
+      }
+    }
 
     // Update cost-to-go approximation
-    dV_ += Eigen::Vector2d(k.dot(Qu), 0.5 * k.dot(Quu * k));
-    Vx.noalias() = Qx + K.transpose() * Quu * k + K.transpose() * Qu + Qux.transpose() * k;
-    Vxx.noalias() = Qxx + K.transpose() * Quu * K + K.transpose() * Qux + Qux.transpose() * K;
+    ws.Quuk.noalias() = Quu * k;
+    ws.QuuK.noalias() = Quu * K;
+    dV_ += Eigen::Vector2d(k.dot(Qu), 0.5 * k.dot(ws.Quuk));
+    Vx = Qx;
+    Vx.noalias() += K.transpose() * ws.Quuk;
+    Vx.noalias() += K.transpose() * Qu;
+    Vx.noalias() += Qux.transpose() * k;
+    Vxx = Qxx;
+    Vxx.noalias() += K.transpose() * ws.QuuK;
+    Vxx.noalias() += K.transpose() * Qux;
+    Vxx.noalias() += Qux.transpose() * K;
     Vxx_symmetric = 0.5 * (Vxx + Vxx.transpose());
     Vxx = Vxx_symmetric;
 
@@ -533,17 +745,18 @@ bool DDPSolver<StateDim, InputDim>::backwardPass()
   return true;
 }
 
-template<int StateDim, int InputDim>
-void DDPSolver<StateDim, InputDim>::forwardPass(double alpha)
+template<int StateDim, int InputDim, class Policy>
+void DDPSolver<StateDim, InputDim, Policy>::forwardPass(double alpha)
 {
   // Set initial state
   candidate_control_data_.x_list[0] = control_data_.x_list[0];
 
   for(int i = 0; i < config_.horizon_steps; i++)
   {
-    // Calculate input
-    candidate_control_data_.u_list[i] = control_data_.u_list[i] + alpha * k_list_[i]
-                                        + K_list_[i] * (candidate_control_data_.x_list[i] - control_data_.x_list[i]);
+    // Calculate input (the product is accumulated in place to avoid a temporary variable of dynamic size)
+    candidate_control_data_.u_list[i] = control_data_.u_list[i] + alpha * k_list_[i];
+    candidate_control_data_.u_list[i].noalias() +=
+        K_list_[i] * (candidate_control_data_.x_list[i] - control_data_.x_list[i]);
 
     // \todo Impose constraints on input
 
@@ -559,8 +772,29 @@ void DDPSolver<StateDim, InputDim>::forwardPass(double alpha)
       problem_->terminalCost(terminal_t, candidate_control_data_.x_list[config_.horizon_steps]);
 }
 
-template<int StateDim, int InputDim>
-void DDPSolver<StateDim, InputDim>::dumpTraceDataList(const std::string & file_path) const
+template<int StateDim, int InputDim, class Policy>
+std::shared_ptr<const FeedbackPolicy<StateDim, InputDim>> DDPSolver<StateDim, InputDim, Policy>::feedbackPolicy() const
+{
+  std::vector<InputDimVector> u_lower_list;
+  std::vector<InputDimVector> u_upper_list;
+  if(withInputConstraint())
+  {
+    u_lower_list.reserve(config_.horizon_steps);
+    u_upper_list.reserve(config_.horizon_steps);
+    for(int i = 0; i < config_.horizon_steps; i++)
+    {
+      const auto & u_limits = input_limits_func_(current_t_ + i * problem_->dt());
+      u_lower_list.push_back(u_limits[0]);
+      u_upper_list.push_back(u_limits[1]);
+    }
+  }
+  return std::make_shared<const FeedbackPolicy<StateDim, InputDim>>(current_t_, problem_->dt(), control_data_.x_list,
+                                                                    control_data_.u_list, K_list_, u_lower_list,
+                                                                    u_upper_list);
+}
+
+template<int StateDim, int InputDim, class Policy>
+void DDPSolver<StateDim, InputDim, Policy>::dumpTraceDataList(const std::string & file_path) const
 {
   std::ofstream ofs(file_path);
   // clang-format off
@@ -596,4 +830,196 @@ void DDPSolver<StateDim, InputDim>::dumpTraceDataList(const std::string & file_p
     // clang-format on
   }
 }
+
+template<int StateDim, int InputDim, class Policy>
+void DDPSolver<StateDim, InputDim, Policy>::setRecorder(const std::shared_ptr<SolveRecorder> & recorder)
+{
+  recorder_ = recorder;
+  if(recorder_)
+  {
+    recorder_->setTag(recordTag());
+  }
+}
+
+template<int StateDim, int InputDim, class Policy>
+void DDPSolver<StateDim, InputDim, Policy>::setTraceRing(const std::shared_ptr<TraceRing> & trace_ring)
+{
+  trace_ring_ = trace_ring;
+}
+
+template<int StateDim, int InputDim, class Policy>
+void DDPSolver<StateDim, InputDim, Policy>::setThreadPool(const std::shared_ptr<nmpc_common::ThreadPool> & thread_pool)
+{
+  thread_pool_ = thread_pool;
+}
+
+template<int StateDim, int InputDim, class Policy>
+bool DDPSolver<StateDim, InputDim, Policy>::replay(const SolveRecord & record)
+{
+  config_ = record.config;
+
+  if(record.u_lower_list.empty())
+  {
+    return solve(record.current_t, record.current_x, record.initial_u_list);
+  }
+
+  auto input_limits_func = input_limits_func_;
+  input_limits_func_ = [&](double t) -> std::array<InputDimVector, 2>
+  {
+    int i = std::clamp(static_cast<int>(std::round((t - record.current_t) / problem_->dt())), 0,
+                       static_cast<int>(record.u_lower_list.size()) - 1);
+    return {record.u_lower_list[i], record.u_upper_list[i]};
+  };
+  bool succeeded;
+  try
+  {
+    succeeded = solve(record.current_t, record.current_x, record.initial_u_list);
+  }
+  catch(...)
+  {
+    input_limits_func_ = input_limits_func;
+    throw;
+  }
+  input_limits_func_ = input_limits_func;
+  return succeeded;
+}
+
+template<int StateDim, int InputDim, class Policy>
+std::string DDPSolver<StateDim, InputDim, Policy>::recordTag()
+{
+  return "nmpc_ddp::DDPSolver<" + std::to_string(StateDim) + "," + std::to_string(InputDim) + ">";
+}
+
+template<int StateDim, int InputDim, class Policy>
+void DDPSolver<StateDim, InputDim, Policy>::appendRecord(double current_t,
+                                                         const StateDimVector & current_x,
+                                                         const std::vector<InputDimVector> & initial_u_list,
+                                                         bool succeeded)
+{
+  recorder_->beginRecord();
+
+  // Configuration
+  recorder_->write<int32_t>(config_.print_level);
+  recorder_->write<bool>(config_.use_state_eq_second_derivative);
+  recorder_->write<bool>(config_.with_input_constraint);
+  recorder_->write<int32_t>(config_.max_iter);
+  recorder_->write<int32_t>(config_.horizon_steps);
+  recorder_->write<int32_t>(config_.reg_type);
+  recorder_->write(config_.initial_lambda);
+  recorder_->write(config_.initial_dlambda);
+  recorder_->write(config_.lambda_factor);
+  recorder_->write(config_.lambda_min);
+  recorder_->write(config_.lambda_max);
+  recorder_->write(config_.k_rel_norm_thre);
+  recorder_->write(config_.lambda_thre);
+  recorder_->writeMatrix(config_.alpha_list);
+  recorder_->write(config_.cost_update_ratio_thre);
+  recorder_->write(config_.cost_update_thre);
+
+  // Inputs
+  recorder_->write(current_t);
+  recorder_->writeMatrix(current_x);
+  recorder_->writeMatrixList(initial_u_list);
+  if(withInputConstraint())
+  {
+    recorder_->write(static_cast<uint64_t>(config_.horizon_steps));
+    for(int i = 0; i < config_.horizon_steps; i++)
+    {
+      const auto & u_limits = input_limits_func_(current_t + i * problem_->dt());
+      recorder_->writeMatrix(u_limits[0]);
+      recorder_->writeMatrix(u_limits[1]);
+    }
+  }
+  else
+  {
+    recorder_->write(static_cast<uint64_t>(0));
+  }
+
+  // Outputs
+  recorder_->write(succeeded);
+  recorder_->write<int32_t>(trace_data_list_.back().iter);
+  recorder_->writeMatrixList(control_data_.x_list);
+  recorder_->writeMatrixList(control_data_.u_list);
+  recorder_->writeMatrix(control_data_.cost_list);
+  recorder_->write(computation_duration_);
+
+  recorder_->endRecord();
+}
+
+template<int StateDim, int InputDim, class Policy>
+void DDPSolver<StateDim, InputDim, Policy>::SolveRecord::read(SolveRecordReader & reader)
+{
+  // Configuration
+  config.print_level = reader.read<int32_t>();
+  config.use_state_eq_second_derivative = reader.read<bool>();
+  config.with_input_constraint = reader.read<bool>();
+  config.max_iter = reader.read<int32_t>();
+  config.horizon_steps = reader.read<int32_t>();
+  config.reg_type = reader.read<int32_t>();
+  config.initial_lambda = reader.read<double>();
+  config.initial_dlambda = reader.read<double>();
+  config.lambda_factor = reader.read<double>();
+  config.lambda_min = reader.read<double>();
+  config.lambda_max = reader.read<double>();
+  config.k_rel_norm_thre = reader.read<double>();
+  config.lambda_thre = reader.read<double>();
+  reader.readMatrix(config.alpha_list);
+  config.cost_update_ratio_thre = reader.read<double>();
+  config.cost_update_thre = reader.read<double>();
+
+  // Inputs
+  current_t = reader.read<double>();
+  reader.readMatrix(current_x);
+  reader.readMatrixList(initial_u_list);
+  size_t limits_num = static_cast<size_t>(reader.read<uint64_t>());
+  u_lower_list.resize(limits_num);
+  u_upper_list.resize(limits_num);
+  for(size_t i = 0; i < limits_num; i++)
+  {
+    reader.readMatrix(u_lower_list[i]);
+    reader.readMatrix(u_upper_list[i]);
+  }
+
+  // Outputs
+  succeeded = reader.read<bool>();
+  iter = reader.read<int32_t>();
+  reader.readMatrixList(control_data.x_list);
+  reader.readMatrixList(control_data.u_list);
+  reader.readMatrix(control_data.cost_list);
+  computation_duration = reader.read<ComputationDuration>();
+}
+
+template<int StateDim, int InputDim, class Policy>
+double DDPSolver<StateDim, InputDim, Policy>::SolveRecord::calcOutputError(const DDPSolver & solver) const
+{
+  const auto & u_list = solver.controlData().u_list;
+  if(u_list.size() != control_data.u_list.size())
+  {
+    return std::numeric_limits<double>::infinity();
+  }
+  double error = 0;
+  for(size_t i = 0; i < u_list.size(); i++)
+  {
+    if(u_list[i].size() != control_data.u_list[i].size())
+    {
+      return std::numeric_limits<double>::infinity();
+    }
+    if(u_list[i].size() > 0)
+    {
+      error = std::max(error, (u_list[i] - control_data.u_list[i]).cwiseAbs().maxCoeff());
+    }
+  }
+  return error;
+}
+
+#ifdef NMPC_DDP_EXTERN_TEMPLATES
+// Explicitly instantiated in the nmpc_ddp_instantiations library (see src/DDPSolverInstantiations.cpp)
+extern template class DDPSolver<2, 1>;
+extern template class DDPSolver<4, 1>;
+extern template class DDPSolver<6, 3>;
+extern template class DDPSolver<2, Eigen::Dynamic>;
+extern template class DDPSolver<4, Eigen::Dynamic>;
+extern template class DDPSolver<9, Eigen::Dynamic>;
+extern template class DDPSolver<Eigen::Dynamic, Eigen::Dynamic>;
+#endif
 } // namespace nmpc_ddp
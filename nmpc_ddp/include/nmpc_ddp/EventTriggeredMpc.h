@@ -0,0 +1,237 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+#include <nmpc_ddp/FeedbackPolicy.h>
+#include <nmpc_ddp/MpcRunner.h>
+
+namespace nmpc_ddp
+{
+/** \brief MPC that solves only when the measured state deviates from the prediction.
+    \tparam Solver solver type (DDPSolver or nmpc_fmpc::FmpcSolver, see MpcRunnerAdapter)
+
+    In each control step, the measured state is compared with the state predicted by the last solution at the elapsed
+    time. While the prediction error is below Configuration::partial_error_thre, the last solution is applied with its
+    feedback gains (see FeedbackPolicy) without solving. Otherwise, the warm-start data is shifted by the elapsed time
+    and a partial solve (limited iterations) or a full solve is triggered depending on the error.
+ */
+template<class Solver>
+class EventTriggeredMpc
+{
+public:
+  /** \brief Type of solver adapter. */
+  using Adapter = MpcRunnerAdapter<Solver>;
+
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename Adapter::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename Adapter::InputDimVector;
+
+  /** \brief Type of warm-start data. */
+  using WarmStart = typename Adapter::WarmStart;
+
+  /** \brief Type of feedback policy. */
+  using Policy = FeedbackPolicy<Adapter::StateDim, Adapter::InputDim>;
+
+  /** \brief Type of clock to measure computation duration. */
+  using Clock = std::chrono::steady_clock;
+
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Threshold of prediction error norm to trigger a partial solve
+    double partial_error_thre = 1e-2;
+
+    //! Threshold of prediction error norm to trigger a full solve
+    double full_error_thre = 1e-1;
+
+    //! Maximum iteration of partial solve (full solve is always used if this is zero)
+    int partial_max_iter = 1;
+
+    //! Maximum duration to keep applying the last solution without solving [sec]
+    double max_hold_duration = 0.5;
+  };
+
+  /*! \brief Statistics. */
+  struct Statistics
+  {
+    //! Number of control steps
+    int step_num = 0;
+
+    //! Number of partial solves
+    int partial_solve_num = 0;
+
+    //! Number of full solves
+    int full_solve_num = 0;
+
+    //! Total computation duration of solves [ms]
+    double solve_duration = 0;
+
+    /** \brief Number of solves. */
+    inline int solveNum() const
+    {
+      return partial_solve_num + full_solve_num;
+    }
+
+    /** \brief Ratio of control steps in which a solve is triggered. */
+    inline double triggerRate() const
+    {
+      return step_num > 0 ? static_cast<double>(solveNum()) / step_num : 0.0;
+    }
+
+    /** \brief Estimated ratio of saved computation duration compared to solving in every control step.
+
+        The duration of solves in the skipped steps is estimated by the mean duration of the triggered solves.
+     */
+    inline double savingRate() const
+    {
+      return 1.0 - triggerRate();
+    }
+
+    /** \brief Estimated saved computation duration compared to solving in every control step [ms]. */
+    inline double savedDuration() const
+    {
+      return solveNum() > 0 ? (step_num - solveNum()) * solve_duration / solveNum() : 0.0;
+    }
+
+    /** \brief Print statistics. */
+    inline void print() const
+    {
+      std::cout << "[EventTriggeredMpc] steps: " << step_num << ", solves: " << solveNum()
+                << " (partial: " << partial_solve_num << ", full: " << full_solve_num
+                << "), trigger rate: " << triggerRate() << ", saved duration: " << savedDuration() << " [ms] ("
+                << 100 * savingRate() << " [%])" << std::endl;
+    }
+  };
+
+public:
+  /** \brief Constructor.
+      \param solver solver
+      \param initial_warm_start initial warm-start data
+   */
+  EventTriggeredMpc(const std::shared_ptr<Solver> & solver, const WarmStart & initial_warm_start)
+  : solver_(solver), warm_start_(initial_warm_start)
+  {
+  }
+
+  /** \brief Accessor to configuration. */
+  inline Configuration & config()
+  {
+    return config_;
+  }
+
+  /** \brief Const accessor to statistics. */
+  inline const Statistics & statistics() const
+  {
+    return statistics_;
+  }
+
+  /** \brief Reset statistics. */
+  inline void resetStatistics()
+  {
+    statistics_ = Statistics();
+  }
+
+  /** \brief Const accessor to the last solution as feedback policy (nullptr before the first solve). */
+  inline const std::shared_ptr<const Policy> & policy() const
+  {
+    return policy_;
+  }
+
+  /** \brief Get prediction error norm of the last control step. */
+  inline double predictionError() const
+  {
+    return prediction_error_;
+  }
+
+  /** \brief Calculate input, solving if triggered.
+      \param t current time [sec]
+      \param x current state
+      \return input
+   */
+  InputDimVector calcInput(double t, const StateDimVector & x)
+  {
+    statistics_.step_num++;
+
+    // Decide whether to solve
+    bool full = true;
+    bool triggered = true;
+    if(policy_ && t - policy_->startTime() < config_.max_hold_duration && t < policy_->endTime())
+    {
+      prediction_error_ = (x - policy_->calcState(t)).norm();
+      if(prediction_error_ < config_.partial_error_thre)
+      {
+        triggered = false;
+      }
+      else if(prediction_error_ < config_.full_error_thre && config_.partial_max_iter > 0)
+      {
+        full = false;
+      }
+    }
+    else
+    {
+      prediction_error_ = 0;
+    }
+
+    if(triggered)
+    {
+      solve(t, x, full);
+    }
+    return policy_->calcInput(t, x);
+  }
+
+protected:
+  /** \brief Solve from the current state.
+      \param t current time [sec]
+      \param x current state
+      \param full whether to solve with full iterations
+   */
+  void solve(double t, const StateDimVector & x, bool full)
+  {
+    if(policy_)
+    {
+      Adapter::shift(warm_start_,
+                     static_cast<int>(std::round((t - policy_->startTime()) / Adapter::dt(*solver_))));
+    }
+
+    int max_iter = solver_->config().max_iter;
+    if(!full)
+    {
+      solver_->config().max_iter = std::min(config_.partial_max_iter, max_iter);
+    }
+    auto start_time = Clock::now();
+    Adapter::solve(*solver_, t, x, warm_start_);
+    statistics_.solve_duration +=
+        1e3 * std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start_time).count();
+    solver_->config().max_iter = max_iter;
+
+    policy_ = Adapter::feedbackPolicy(*solver_, t);
+    (full ? statistics_.full_solve_num : statistics_.partial_solve_num)++;
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! Solver
+  std::shared_ptr<Solver> solver_;
+
+  //! Warm-start data
+  WarmStart warm_start_;
+
+  //! Last solution as feedback policy
+  std::shared_ptr<const Policy> policy_;
+
+  //! Prediction error norm of the last control step
+  double prediction_error_ = 0;
+
+  //! Statistics
+  Statistics statistics_;
+};
+} // namespace nmpc_ddp
@@ -0,0 +1,169 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nmpc_ddp/DDPProblem.h>
+
+namespace nmpc_ddp
+{
+/** \brief Time-varying affine feedback policy obtained by DDP.
+    \tparam StateDim state dimension
+    \tparam InputDim input dimension
+
+    The policy is an immutable snapshot of the nominal state and input sequences and the feedback gains of a solve, so
+    it can be shared with a control thread running faster than the solver and evaluated between solves by calcInput().
+    The input is calculated as u = u_nom(t) + K_i (x - x_nom(t)), where the nominal state and input are linearly
+    interpolated in time and the feedback gain K_i of the stage i containing t is held. The input is clamped to the
+    input limits of the stage if they are given.
+ */
+template<int StateDim, int InputDim>
+class FeedbackPolicy
+{
+public:
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename DDPProblem<StateDim, InputDim>::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename DDPProblem<StateDim, InputDim>::InputDimVector;
+
+  /** \brief Type of matrix of input x state dimension. */
+  using InputStateDimMatrix = typename DDPProblem<StateDim, InputDim>::InputStateDimMatrix;
+
+public:
+  /** \brief Constructor.
+      \param start_t start time of horizon [sec]
+      \param dt discretization timestep [sec]
+      \param x_list sequence of nominal state (x[0], ..., x[N])
+      \param u_list sequence of nominal input (u[0], ..., u[N-1])
+      \param K_list sequence of feedback gain (K[0], ..., K[N-1])
+      \param u_lower_list sequence of lower input limits (empty if input is not constrained)
+      \param u_upper_list sequence of upper input limits (empty if input is not constrained)
+   */
+  FeedbackPolicy(double start_t,
+                 double dt,
+                 const std::vector<StateDimVector> & x_list,
+                 const std::vector<InputDimVector> & u_list,
+                 const std::vector<InputStateDimMatrix> & K_list,
+                 const std::vector<InputDimVector> & u_lower_list = {},
+                 const std::vector<InputDimVector> & u_upper_list = {})
+  : start_t_(start_t), dt_(dt), x_list_(x_list), u_list_(u_list), K_list_(K_list), u_lower_list_(u_lower_list),
+    u_upper_list_(u_upper_list)
+  {
+    int horizon_steps = static_cast<int>(u_list_.size());
+    if(horizon_steps == 0)
+    {
+      throw std::invalid_argument("[FeedbackPolicy] u_list must not be empty.");
+    }
+    if(static_cast<int>(x_list_.size()) != horizon_steps + 1 || static_cast<int>(K_list_.size()) != horizon_steps)
+    {
+      throw std::invalid_argument("[FeedbackPolicy] Inconsistent list sizes. x_list: " + std::to_string(x_list_.size())
+                                  + ", u_list: " + std::to_string(u_list_.size())
+                                  + ", K_list: " + std::to_string(K_list_.size()));
+    }
+    if(u_lower_list_.size() != u_upper_list_.size()
+       || (!u_lower_list_.empty() && static_cast<int>(u_lower_list_.size()) != horizon_steps))
+    {
+      throw std::invalid_argument("[FeedbackPolicy] Input limit lists must be empty or have the same size as u_list.");
+    }
+  }
+
+  /** \brief Calculate input.
+      \param t time [sec] (clamped to the horizon)
+      \param x current state
+      \return input
+   */
+  inline InputDimVector calcInput(double t, const StateDimVector & x) const
+  {
+    int horizon_steps = static_cast<int>(u_list_.size());
+    double s = std::clamp((t - start_t_) / dt_, 0.0, static_cast<double>(horizon_steps));
+    int i = std::min(static_cast<int>(s), horizon_steps - 1);
+    double r = s - i;
+    int next_i = std::min(i + 1, horizon_steps - 1);
+
+    InputDimVector u = (1.0 - r) * u_list_[i] + r * u_list_[next_i]
+                       + K_list_[i] * (x - (1.0 - r) * x_list_[i] - r * x_list_[i + 1]);
+    if(!u_lower_list_.empty())
+    {
+      u = u.cwiseMax(u_lower_list_[i]).cwiseMin(u_upper_list_[i]);
+    }
+    return u;
+  }
+
+  /** \brief Calculate nominal state.
+      \param t time [sec] (clamped to the horizon)
+      \return nominal state linearly interpolated in time
+   */
+  inline StateDimVector calcState(double t) const
+  {
+    int horizon_steps = static_cast<int>(u_list_.size());
+    double s = std::clamp((t - start_t_) / dt_, 0.0, static_cast<double>(horizon_steps));
+    int i = std::min(static_cast<int>(s), horizon_steps - 1);
+    double r = s - i;
+    return (1.0 - r) * x_list_[i] + r * x_list_[i + 1];
+  }
+
+  /** \brief Get start time of horizon [sec]. */
+  inline double startTime() const
+  {
+    return start_t_;
+  }
+
+  /** \brief Get end time of horizon [sec]. */
+  inline double endTime() const
+  {
+    return start_t_ + static_cast<double>(u_list_.size()) * dt_;
+  }
+
+  /** \brief Get discretization timestep [sec]. */
+  inline double dt() const
+  {
+    return dt_;
+  }
+
+  /** \brief Const accessor to sequence of nominal state. */
+  inline const std::vector<StateDimVector> & xList() const
+  {
+    return x_list_;
+  }
+
+  /** \brief Const accessor to sequence of nominal input. */
+  inline const std::vector<InputDimVector> & uList() const
+  {
+    return u_list_;
+  }
+
+  /** \brief Const accessor to sequence of feedback gain. */
+  inline const std::vector<InputStateDimMatrix> & KList() const
+  {
+    return K_list_;
+  }
+
+protected:
+  //! Start time of horizon [sec]
+  double start_t_;
+
+  //! Discretization timestep [sec]
+  double dt_;
+
+  //! Sequence of nominal state (x[0], ..., x[N])
+  std::vector<StateDimVector> x_list_;
+
+  //! Sequence of nominal input (u[0], ..., u[N-1])
+  std::vector<InputDimVector> u_list_;
+
+  //! Sequence of feedback gain (K[0], ..., K[N-1])
+  std::vector<InputStateDimMatrix> K_list_;
+
+  //! Sequence of lower input limits (empty if input is not constrained)
+  std::vector<InputDimVector> u_lower_list_;
+
+  //! Sequence of upper input limits (empty if input is not constrained)
+  std::vector<InputDimVector> u_upper_list_;
+};
+} // namespace nmpc_ddp
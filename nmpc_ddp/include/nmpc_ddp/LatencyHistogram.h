@@ -0,0 +1,205 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace nmpc_ddp
+{
+/** \brief Histogram of latency with logarithmic buckets (in the manner of HdrHistogram).
+
+    Durations are recorded in nanoseconds into a fixed array of buckets: values below 2^sub_bucket_bits nanoseconds
+    are recorded exactly, and larger values are recorded in 2^(sub_bucket_bits-1) linear sub-buckets per power of two,
+    so that the relative error of percentiles is less than 2^(1-sub_bucket_bits) (about 3%). Recording does not
+    allocate memory and costs a few integer operations.
+
+    \note This class is not thread-safe. Use one instance per thread and merge them with merge().
+ */
+class LatencyHistogram
+{
+public:
+  //! Number of bits of sub-buckets
+  static constexpr int sub_bucket_bits = 6;
+
+  //! Number of bits of the maximum recordable value (larger values are recorded as the maximum) [nsec]
+  static constexpr int max_value_bits = 36;
+
+  //! Number of buckets
+  static constexpr int bucket_num =
+      (1 << sub_bucket_bits) + (max_value_bits - sub_bucket_bits) * (1 << (sub_bucket_bits - 1));
+
+public:
+  /** \brief Constructor. */
+  LatencyHistogram()
+  {
+    reset();
+  }
+
+  /** \brief Record duration.
+      \param duration duration [msec]
+   */
+  inline void record(double duration)
+  {
+    recordNsec(static_cast<uint64_t>(std::max(std::llround(1e6 * duration), 0LL)));
+  }
+
+  /** \brief Record duration.
+      \param duration_ns duration [nsec]
+   */
+  inline void recordNsec(uint64_t duration_ns)
+  {
+    duration_ns = std::min(duration_ns, (uint64_t(1) << max_value_bits) - 1);
+    count_list_[bucketIdx(duration_ns)]++;
+    total_count_++;
+    sum_ns_ += duration_ns;
+    min_ns_ = std::min(min_ns_, duration_ns);
+    max_ns_ = std::max(max_ns_, duration_ns);
+  }
+
+  /** \brief Clear recorded durations. */
+  inline void reset()
+  {
+    count_list_.fill(0);
+    total_count_ = 0;
+    sum_ns_ = 0;
+    min_ns_ = std::numeric_limits<uint64_t>::max();
+    max_ns_ = 0;
+  }
+
+  /** \brief Add durations recorded by another histogram.
+      \param histogram histogram to merge
+   */
+  inline void merge(const LatencyHistogram & histogram)
+  {
+    for(int i = 0; i < bucket_num; i++)
+    {
+      count_list_[i] += histogram.count_list_[i];
+    }
+    total_count_ += histogram.total_count_;
+    sum_ns_ += histogram.sum_ns_;
+    min_ns_ = std::min(min_ns_, histogram.min_ns_);
+    max_ns_ = std::max(max_ns_, histogram.max_ns_);
+  }
+
+  /** \brief Get the number of recorded durations. */
+  inline uint64_t count() const
+  {
+    return total_count_;
+  }
+
+  /** \brief Get the minimum duration [msec] (0 if empty). */
+  inline double min() const
+  {
+    return total_count_ > 0 ? 1e-6 * static_cast<double>(min_ns_) : 0.0;
+  }
+
+  /** \brief Get the maximum duration [msec] (0 if empty). */
+  inline double max() const
+  {
+    return 1e-6 * static_cast<double>(max_ns_);
+  }
+
+  /** \brief Get the mean duration [msec] (0 if empty). */
+  inline double mean() const
+  {
+    return total_count_ > 0 ? 1e-6 * static_cast<double>(sum_ns_) / static_cast<double>(total_count_) : 0.0;
+  }
+
+  /** \brief Get the duration at percentile [msec] (0 if empty).
+      \param percentile percentile in [0, 100] (e.g., 50 for median, 99 for p99)
+
+      The returned value is the upper limit of the bucket that contains the percentile, so that at least the given
+      percentage of recorded durations are less than or equal to it (up to the bucket resolution).
+   */
+  double percentile(double percentile) const
+  {
+    if(total_count_ == 0)
+    {
+      return 0.0;
+    }
+
+    double ratio = std::clamp(percentile, 0.0, 100.0) / 100.0;
+    uint64_t target_count =
+        std::max<uint64_t>(static_cast<uint64_t>(std::ceil(ratio * static_cast<double>(total_count_))), 1);
+    uint64_t accum_count = 0;
+    for(int i = 0; i < bucket_num; i++)
+    {
+      accum_count += count_list_[i];
+      if(accum_count >= target_count)
+      {
+        uint64_t value_ns = std::clamp(bucketUpperNsec(i), min_ns_, max_ns_);
+        return 1e-6 * static_cast<double>(value_ns);
+      }
+    }
+    return max();
+  }
+
+  /** \brief Print summary.
+      \param name name to print
+   */
+  void print(const std::string & name) const
+  {
+    std::cout << std::fixed << std::setprecision(3) << "[LatencyHistogram] " << name << " count: " << count()
+              << ", mean: " << mean() << ", min: " << min() << ", p50: " << percentile(50)
+              << ", p90: " << percentile(90) << ", p99: " << percentile(99) << ", p99.9: " << percentile(99.9)
+              << ", max: " << max() << " [ms]" << std::defaultfloat << std::endl;
+  }
+
+protected:
+  /** \brief Get bucket index of value. */
+  static inline int bucketIdx(uint64_t value_ns)
+  {
+    constexpr uint64_t sub_bucket_num = uint64_t(1) << sub_bucket_bits;
+    if(value_ns < sub_bucket_num)
+    {
+      return static_cast<int>(value_ns);
+    }
+    // Values in [2^(sub_bucket_bits+g-1), 2^(sub_bucket_bits+g)) belong to group g and have a width of 2^g
+    int group = msb(value_ns) - sub_bucket_bits + 1;
+    return static_cast<int>(sub_bucket_num + (group - 1) * (sub_bucket_num / 2)
+                            + ((value_ns >> group) - sub_bucket_num / 2));
+  }
+
+  /** \brief Get the maximum value in bucket. */
+  static inline uint64_t bucketUpperNsec(int idx)
+  {
+    constexpr int sub_bucket_num = 1 << sub_bucket_bits;
+    if(idx < sub_bucket_num)
+    {
+      return static_cast<uint64_t>(idx);
+    }
+    int group = (idx - sub_bucket_num) / (sub_bucket_num / 2) + 1;
+    uint64_t sub_idx = static_cast<uint64_t>((idx - sub_bucket_num) % (sub_bucket_num / 2) + sub_bucket_num / 2);
+    return ((sub_idx + 1) << group) - 1;
+  }
+
+  /** \brief Get the index of the most significant bit. */
+  static inline int msb(uint64_t value)
+  {
+    return 63 - __builtin_clzll(value);
+  }
+
+protected:
+  //! Counts of buckets
+  std::array<uint64_t, bucket_num> count_list_;
+
+  //! Total count
+  uint64_t total_count_ = 0;
+
+  //! Sum of recorded values [nsec]
+  uint64_t sum_ns_ = 0;
+
+  //! Minimum recorded value [nsec]
+  uint64_t min_ns_ = std::numeric_limits<uint64_t>::max();
+
+  //! Maximum recorded value [nsec]
+  uint64_t max_ns_ = 0;
+};
+} // namespace nmpc_ddp
@@ -0,0 +1,598 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <nmpc_ddp/DDPSolver.h>
+
+namespace nmpc_ddp
+{
+/** \brief Lock-free triple buffer to hand over the latest value from a single writer to a single reader.
+    \tparam T value type
+
+    The writer fills writeBuffer() and calls publish(), and the reader calls update() and reads readBuffer(). Neither
+    side waits for the other, and the reader always gets the latest published value. Old values are skipped.
+ */
+template<class T>
+class TripleBuffer
+{
+public:
+  /** \brief Constructor.
+      \param initial_value initial value of all buffers (e.g., with reserved memory)
+   */
+  TripleBuffer(const T & initial_value = T()) : buffer_list_{initial_value, initial_value, initial_value} {}
+
+  /** \brief Accessor to buffer to write (writer only). */
+  inline T & writeBuffer()
+  {
+    return buffer_list_[write_idx_];
+  }
+
+  /** \brief Publish the value in the write buffer (writer only). */
+  inline void publish()
+  {
+    write_idx_ = middle_.exchange(write_idx_ | dirty_flag, std::memory_order_acq_rel) & idx_mask;
+  }
+
+  /** \brief Get the latest published value into the read buffer (reader only).
+      \return whether a new value is published since the last update
+   */
+  inline bool update()
+  {
+    if(!(middle_.load(std::memory_order_relaxed) & dirty_flag))
+    {
+      return false;
+    }
+    read_idx_ = middle_.exchange(read_idx_, std::memory_order_acq_rel) & idx_mask;
+    return true;
+  }
+
+  /** \brief Accessor to buffer to read (reader only). */
+  inline T & readBuffer()
+  {
+    return buffer_list_[read_idx_];
+  }
+
+  /** \brief Const accessor to buffer to read (reader only). */
+  inline const T & readBuffer() const
+  {
+    return buffer_list_[read_idx_];
+  }
+
+protected:
+  //! Flag of middle buffer index meaning that the middle buffer has a value not yet read
+  static constexpr uint8_t dirty_flag = 4;
+
+  //! Mask of buffer index
+  static constexpr uint8_t idx_mask = 3;
+
+  //! Buffers
+  T buffer_list_[3];
+
+  //! Index of middle buffer (with dirty_flag)
+  std::atomic<uint8_t> middle_{1};
+
+  //! Index of buffer to write (accessed only by writer)
+  uint8_t write_idx_ = 0;
+
+  //! Index of buffer to read (accessed only by reader)
+  uint8_t read_idx_ = 2;
+};
+
+/** \brief Shift a sequence to the past by repeating the last element.
+    \param list sequence (e.g., of input)
+    \param steps number of steps to shift
+
+    Memory is not allocated because the elements are rotated in place.
+ */
+template<class T>
+void shiftList(std::vector<T> & list, int steps)
+{
+  if(list.empty() || steps <= 0)
+  {
+    return;
+  }
+  size_t shift_num = std::min(static_cast<size_t>(steps), list.size() - 1);
+  std::rotate(list.begin(), list.begin() + shift_num, list.end());
+  for(size_t i = list.size() - shift_num; i < list.size(); i++)
+  {
+    list[i] = list[list.size() - shift_num - 1];
+  }
+}
+
+/** \brief Resize a sequence by truncating the tail or repeating the last element.
+    \param list sequence (e.g., of input)
+    \param size new size
+ */
+template<class T>
+void resizeList(std::vector<T> & list, int size)
+{
+  if(list.empty() || size <= 0)
+  {
+    list.resize(std::max(size, 0));
+    return;
+  }
+  list.resize(size, T(list.back()));
+}
+
+/** \brief Append a sequence of vectors to serialized data.
+    \param list sequence of vectors (e.g., of input)
+    \param data serialized data, to which the list size followed by the size and elements of each vector is appended
+ */
+template<class VectorType, class Allocator>
+void serializeList(const std::vector<VectorType, Allocator> & list, std::vector<double> & data)
+{
+  data.push_back(static_cast<double>(list.size()));
+  for(const auto & v : list)
+  {
+    data.push_back(static_cast<double>(v.size()));
+    data.insert(data.end(), v.data(), v.data() + v.size());
+  }
+}
+
+/** \brief Read a size from serialized data.
+    \param data pointer to serialized data, which is advanced past the size
+    \param end end of serialized data
+    \param size size
+    \return whether the size is a non-negative integer not exceeding the number of the remaining data
+ */
+inline bool deserializeSize(const double *& data, const double * end, size_t & size)
+{
+  if(data >= end)
+  {
+    return false;
+  }
+  // Check before the conversion, which is undefined for non-finite and out-of-range values
+  double value = *data;
+  if(!std::isfinite(value) || value < 0 || value != std::floor(value) || value > static_cast<double>(end - data - 1))
+  {
+    return false;
+  }
+  size = static_cast<size_t>(value);
+  data++;
+  return true;
+}
+
+/** \brief Read a sequence of vectors from serialized data written by serializeList().
+    \param data pointer to serialized data, which is advanced to the end of the sequence
+    \param end end of serialized data
+    \param list sequence of vectors
+    \return whether the serialized data is valid
+ */
+template<class VectorType, class Allocator>
+bool deserializeList(const double *& data, const double * end, std::vector<VectorType, Allocator> & list)
+{
+  size_t list_size = 0;
+  if(!deserializeSize(data, end, list_size))
+  {
+    return false;
+  }
+  list.resize(list_size);
+  for(auto & v : list)
+  {
+    size_t size = 0;
+    if(!deserializeSize(data, end, size)
+       || (VectorType::SizeAtCompileTime != Eigen::Dynamic
+           && size != static_cast<size_t>(VectorType::SizeAtCompileTime)))
+    {
+      return false;
+    }
+    v = Eigen::Map<const VectorType>(data, static_cast<Eigen::Index>(size));
+    data += size;
+  }
+  return true;
+}
+
+/** \brief Adapter of solver for MpcRunner.
+    \tparam Solver solver type
+
+    A specialization defines StateDim, InputDim, the types of state, input, and warm-start data, and the following
+    static functions:
+      - double dt(const Solver & solver): discretization timestep [sec]
+      - bool solve(Solver & solver, double t, const StateDimVector & x, WarmStart & warm_start): solve with
+    warm_start as initial guess and overwrite warm_start with the solution
+      - void shift(WarmStart & warm_start, int steps): shift warm-start data to the past by steps
+      - void getSolution(const Solver & solver, std::vector<StateDimVector> & x_list, std::vector<InputDimVector> &
+    u_list): get state and input sequences of the solution
+      - std::shared_ptr<const FeedbackPolicy<StateDim, InputDim>> feedbackPolicy(const Solver & solver, double t):
+    snapshot of feedback policy of the solution
+      - void resize(WarmStart & warm_start, int horizon_steps): change the number of steps of warm-start data
+      - void serialize(const WarmStart & warm_start, std::vector<double> & data): append warm-start data to data
+      - bool deserialize(const double * data, size_t size, WarmStart & warm_start): restore warm-start data
+    serialized by serialize() and return whether the data is valid
+ */
+template<class Solver>
+struct MpcRunnerAdapter;
+
+/** \brief Adapter of DDPSolver for MpcRunner. */
+template<int _StateDim, int _InputDim, class Policy>
+struct MpcRunnerAdapter<DDPSolver<_StateDim, _InputDim, Policy>>
+{
+  /** \brief Solver type. */
+  using Solver = DDPSolver<_StateDim, _InputDim, Policy>;
+
+  /** \brief State dimension. */
+  static constexpr int StateDim = _StateDim;
+
+  /** \brief Input dimension. */
+  static constexpr int InputDim = _InputDim;
+
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename Solver::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename Solver::InputDimVector;
+
+  /** \brief Type of warm-start data (sequence of input). */
+  using WarmStart = std::vector<InputDimVector>;
+
+  /** \brief Get discretization timestep [sec]. */
+  static inline double dt(const Solver & solver)
+  {
+    return solver.problem()->dt();
+  }
+
+  /** \brief Solve and overwrite warm-start data with the solution. */
+  static inline bool solve(Solver & solver, double t, const StateDimVector & x, WarmStart & warm_start)
+  {
+    bool succeeded = solver.solve(t, x, warm_start);
+    warm_start = solver.controlData().u_list;
+    return succeeded;
+  }
+
+  /** \brief Shift warm-start data to the past. */
+  static inline void shift(WarmStart & warm_start, int steps)
+  {
+    shiftList(warm_start, steps);
+  }
+
+  /** \brief Change the number of steps of warm-start data. */
+  static inline void resize(WarmStart & warm_start, int horizon_steps)
+  {
+    resizeList(warm_start, horizon_steps);
+  }
+
+  /** \brief Append warm-start data to serialized data. */
+  static inline void serialize(const WarmStart & warm_start, std::vector<double> & data)
+  {
+    serializeList(warm_start, data);
+  }
+
+  /** \brief Restore warm-start data from serialized data. */
+  static inline bool deserialize(const double * data, size_t size, WarmStart & warm_start)
+  {
+    const double * end = data + size;
+    return deserializeList(data, end, warm_start) && data == end;
+  }
+
+  /** \brief Get state and input sequences of the solution. */
+  static inline void getSolution(const Solver & solver,
+                                 std::vector<StateDimVector> & x_list,
+                                 std::vector<InputDimVector> & u_list)
+  {
+    x_list = solver.controlData().x_list;
+    u_list = solver.controlData().u_list;
+  }
+
+  /** \brief Make snapshot of feedback policy of the solution.
+      \param solver solver
+      \param t time of the solve [sec] (unused because the solver holds it)
+   */
+  static inline std::shared_ptr<const FeedbackPolicy<StateDim, InputDim>> feedbackPolicy(const Solver & solver,
+                                                                                         double // t
+  )
+  {
+    return solver.feedbackPolicy();
+  }
+};
+
+/** \brief Calculate cost of the solution of solver.
+    \param solver solver (DDPSolver or nmpc_fmpc::FmpcSolver, see MpcRunnerAdapter)
+    \param t start time of horizon [sec]
+
+    The cost is the sum of the running costs and the terminal cost of the problem along the solution (NaN if the
+    solver has no solution).
+ */
+template<class Solver>
+double calcSolutionCost(const Solver & solver, double t)
+{
+  std::vector<typename MpcRunnerAdapter<Solver>::StateDimVector> x_list;
+  std::vector<typename MpcRunnerAdapter<Solver>::InputDimVector> u_list;
+  MpcRunnerAdapter<Solver>::getSolution(solver, x_list, u_list);
+  if(x_list.size() != u_list.size() + 1)
+  {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  const auto & problem = solver.problem();
+  double dt = problem->dt();
+  double cost = 0;
+  for(size_t i = 0; i < u_list.size(); i++)
+  {
+    cost += problem->runningCost(t + i * dt, x_list[i], u_list[i]);
+  }
+  cost += problem->terminalCost(t + u_list.size() * dt, x_list.back());
+  return cost;
+}
+
+/** \brief Runner of MPC solver in a dedicated thread.
+    \tparam Solver solver type (DDPSolver or nmpc_fmpc::FmpcSolver, see MpcRunnerAdapter)
+
+    Instead of calling solve() synchronously in the control loop, the control thread passes the current state with
+    setState() and gets the latest solution with updateSolution(), neither of which waits for the solver thread. The
+    solver thread always solves for the latest state and skips the older ones. Warm-start data is shifted by the elapsed
+    time since the previous solve.
+
+    \note The solver must not be accessed from other threads while the runner is running.
+ */
+template<class Solver>
+class MpcRunner
+{
+public:
+  /** \brief Type of solver adapter. */
+  using Adapter = MpcRunnerAdapter<Solver>;
+
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename Adapter::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename Adapter::InputDimVector;
+
+  /** \brief Type of warm-start data. */
+  using WarmStart = typename Adapter::WarmStart;
+
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Whether to shift warm-start data by the elapsed time since the previous solve
+    bool shift_warm_start = true;
+
+    //! Sleep duration of solver thread while waiting for a new state [sec]
+    double idle_sleep = 1e-4;
+  };
+
+  /*! \brief State passed from control thread. */
+  struct State
+  {
+    //! Time [sec]
+    double t = 0;
+
+    //! State (zero-initialized, or empty if the dimension is dynamic)
+    StateDimVector x = StateDimVector::Zero(std::max<int>(StateDimVector::SizeAtCompileTime, 0));
+  };
+
+  /*! \brief Solution published to control thread. */
+  struct Solution
+  {
+    //! Whether solution is available
+    bool valid = false;
+
+    //! Whether the solve is succeeded
+    bool succeeded = false;
+
+    //! Time of the state from which the solution is computed [sec]
+    double t = 0;
+
+    //! Discretization timestep [sec]
+    double dt = 0;
+
+    //! Number of solves so far (including this one)
+    int solve_count = 0;
+
+    //! Duration of solve [msec]
+    double solve_duration = 0;
+
+    //! Sequence of state (x[0], ..., x[N])
+    std::vector<StateDimVector> x_list;
+
+    //! Sequence of input (u[0], ..., u[N-1])
+    std::vector<InputDimVector> u_list;
+  };
+
+public:
+  /** \brief Constructor.
+      \param solver solver
+      \param initial_warm_start warm-start data for the first solve (e.g., initial sequence of input)
+   */
+  MpcRunner(const std::shared_ptr<Solver> & solver, const WarmStart & initial_warm_start)
+  : solver_(solver), warm_start_(initial_warm_start)
+  {
+  }
+
+  /** \brief Destructor. */
+  ~MpcRunner()
+  {
+    running_ = false;
+    if(thread_.joinable())
+    {
+      thread_.join();
+    }
+  }
+
+  /** \brief Accessor to configuration. */
+  inline Configuration & config()
+  {
+    return config_;
+  }
+
+  /** \brief Const accessor to configuration. */
+  inline const Configuration & config() const
+  {
+    return config_;
+  }
+
+  /** \brief Accessor to solver (must not be used while running). */
+  inline const std::shared_ptr<Solver> & solver() const
+  {
+    return solver_;
+  }
+
+  /** \brief Start solver thread. */
+  void start()
+  {
+    if(thread_.joinable())
+    {
+      throw std::runtime_error("[MpcRunner] Solver thread is already started.");
+    }
+    running_ = true;
+    thread_ = std::thread(&MpcRunner::run, this);
+  }
+
+  /** \brief Stop solver thread after the current solve.
+
+      If an exception is thrown in the solver thread, it is rethrown here.
+   */
+  void stop()
+  {
+    running_ = false;
+    if(thread_.joinable())
+    {
+      thread_.join();
+    }
+    if(exception_)
+    {
+      std::exception_ptr exception = exception_;
+      exception_ = nullptr;
+      std::rethrow_exception(exception);
+    }
+  }
+
+  /** \brief Whether solver thread is running. */
+  inline bool running() const
+  {
+    return running_.load(std::memory_order_relaxed);
+  }
+
+  /** \brief Set current state (called from control thread, does not wait).
+      \param t current time [sec]
+      \param x current state
+   */
+  inline void setState(double t, const StateDimVector & x)
+  {
+    State & state = state_buffer_.writeBuffer();
+    state.t = t;
+    state.x = x;
+    state_buffer_.publish();
+  }
+
+  /** \brief Update the solution to the latest one (called from control thread, does not wait).
+      \return whether a new solution is published since the last update
+   */
+  inline bool updateSolution()
+  {
+    return solution_buffer_.update();
+  }
+
+  /** \brief Const accessor to the solution got by the last updateSolution() (called from control thread). */
+  inline const Solution & solution() const
+  {
+    return solution_buffer_.readBuffer();
+  }
+
+  /** \brief Calculate input at the given time from the solution (called from control thread).
+      \param t time [sec]
+      \return input in the step of the solution including t (first or last input if t is out of horizon)
+
+      \note The solution must be valid.
+   */
+  inline InputDimVector calcInput(double t) const
+  {
+    const Solution & solution = solution_buffer_.readBuffer();
+    int idx = static_cast<int>(std::floor((t - solution.t) / solution.dt));
+    idx = std::clamp(idx, 0, static_cast<int>(solution.u_list.size()) - 1);
+    return solution.u_list[idx];
+  }
+
+protected:
+  /** \brief Process solver thread. */
+  void run()
+  {
+    bool first = true;
+    double last_t = 0;
+    try
+    {
+      while(running_.load(std::memory_order_relaxed))
+      {
+        if(!state_buffer_.update())
+        {
+          std::this_thread::sleep_for(std::chrono::duration<double>(config_.idle_sleep));
+          continue;
+        }
+        const State & state = state_buffer_.readBuffer();
+        double dt = Adapter::dt(*solver_);
+
+        // Shift warm-start data by elapsed time
+        if(!first && config_.shift_warm_start)
+        {
+          Adapter::shift(warm_start_, static_cast<int>(std::round((state.t - last_t) / dt)));
+        }
+        first = false;
+        last_t = state.t;
+
+        // Solve
+        auto start_time = std::chrono::steady_clock::now();
+        bool succeeded = Adapter::solve(*solver_, state.t, state.x, warm_start_);
+        double solve_duration =
+            1e3
+            * std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start_time)
+                  .count();
+
+        // Publish solution
+        solve_count_++;
+        Solution & solution = solution_buffer_.writeBuffer();
+        solution.valid = true;
+        solution.succeeded = succeeded;
+        solution.t = state.t;
+        solution.dt = dt;
+        solution.solve_count = solve_count_;
+        solution.solve_duration = solve_duration;
+        Adapter::getSolution(*solver_, solution.x_list, solution.u_list);
+        solution_buffer_.publish();
+      }
+    }
+    catch(...)
+    {
+      exception_ = std::current_exception();
+      running_ = false;
+    }
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! Solver
+  std::shared_ptr<Solver> solver_;
+
+  //! Warm-start data (accessed only by solver thread while running)
+  WarmStart warm_start_;
+
+  //! Buffer of state from control thread to solver thread
+  TripleBuffer<State> state_buffer_;
+
+  //! Buffer of solution from solver thread to control thread
+  TripleBuffer<Solution> solution_buffer_;
+
+  //! Number of solves
+  int solve_count_ = 0;
+
+  //! Solver thread
+  std::thread thread_;
+
+  //! Whether solver thread is running
+  std::atomic<bool> running_ = false;
+
+  //! Exception thrown in solver thread
+  std::exception_ptr exception_;
+};
+} // namespace nmpc_ddp
@@ -0,0 +1,103 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <nmpc_ddp/MpcRunner.h>
+#include <nmpc_ddp/MppiSolver.h>
+
+namespace nmpc_ddp
+{
+/** \brief Adapter of MppiSolver for MpcRunner. */
+template<int _StateDim, int _InputDim, class RefinementSolverType, class ObserverType>
+struct MpcRunnerAdapter<MppiSolver<_StateDim, _InputDim, RefinementSolverType, ObserverType>>
+{
+  /** \brief Solver type. */
+  using Solver = MppiSolver<_StateDim, _InputDim, RefinementSolverType, ObserverType>;
+
+  /** \brief State dimension. */
+  static constexpr int StateDim = _StateDim;
+
+  /** \brief Input dimension. */
+  static constexpr int InputDim = _InputDim;
+
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename Solver::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename Solver::InputDimVector;
+
+  /** \brief Type of warm-start data (input sequence, which can also be passed to DDPSolver). */
+  using WarmStart = std::vector<InputDimVector>;
+
+  /** \brief Get discretization timestep [sec]. */
+  static inline double dt(const Solver & solver)
+  {
+    return solver.problem()->dt();
+  }
+
+  /** \brief Solve and overwrite warm-start data with the solution. */
+  static inline bool solve(Solver & solver, double t, const StateDimVector & x, WarmStart & warm_start)
+  {
+    bool succeeded = solver.solve(t, x, warm_start);
+    warm_start = solver.controlData().u_list;
+    return succeeded;
+  }
+
+  /** \brief Shift warm-start data to the past. */
+  static inline void shift(WarmStart & warm_start, int steps)
+  {
+    shiftList(warm_start, steps);
+  }
+
+  /** \brief Change the number of steps of warm-start data. */
+  static inline void resize(WarmStart & warm_start, int horizon_steps)
+  {
+    resizeList(warm_start, horizon_steps);
+  }
+
+  /** \brief Append warm-start data to serialized data. */
+  static inline void serialize(const WarmStart & warm_start, std::vector<double> & data)
+  {
+    serializeList(warm_start, data);
+  }
+
+  /** \brief Restore warm-start data from serialized data. */
+  static inline bool deserialize(const double * data, size_t size, WarmStart & warm_start)
+  {
+    const double * end = data + size;
+    return deserializeList(data, end, warm_start) && data == end;
+  }
+
+  /** \brief Get state and input sequences of the solution. */
+  static inline void getSolution(const Solver & solver,
+                                 std::vector<StateDimVector> & x_list,
+                                 std::vector<InputDimVector> & u_list)
+  {
+    x_list = solver.controlData().x_list;
+    u_list = solver.controlData().u_list;
+  }
+
+  /** \brief Make snapshot of feedback policy of the solution.
+      \param solver solver
+      \param t time of the solve [sec]
+
+      Since MppiSolver does not provide feedback gains, the policy only interpolates the nominal input (i.e., the
+      gains are zero).
+   */
+  static inline std::shared_ptr<const FeedbackPolicy<StateDim, InputDim>> feedbackPolicy(const Solver & solver,
+                                                                                         double t)
+  {
+    using InputStateDimMatrix = typename FeedbackPolicy<StateDim, InputDim>::InputStateDimMatrix;
+
+    const auto & control_data = solver.controlData();
+    std::vector<InputStateDimMatrix> K_list;
+    K_list.reserve(control_data.u_list.size());
+    for(const auto & u : control_data.u_list)
+    {
+      K_list.push_back(InputStateDimMatrix::Zero(u.size(), control_data.x_list[0].size()));
+    }
+    return std::make_shared<const FeedbackPolicy<StateDim, InputDim>>(t, dt(solver), control_data.x_list,
+                                                                      control_data.u_list, K_list);
+  }
+};
+} // namespace nmpc_ddp
@@ -0,0 +1,347 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <nmpc_common/CounterRng.h>
+#include <nmpc_common/ThreadPool.h>
+#include <nmpc_ddp/DDPProblem.h>
+#include <nmpc_ddp/DDPSolver.h>
+#include <nmpc_ddp/SolverObserver.h>
+
+namespace nmpc_ddp
+{
+/** \brief Model predictive path integral (MPPI) solver.
+    \tparam StateDim state dimension
+    \tparam InputDim input dimension
+    \tparam RefinementSolverType type of DDP solver to refine solution (e.g., DDPSolver with a solver policy)
+    \tparam ObserverType type of observer notified of events (see SolverObserver.h)
+
+    The solver samples input sequences around the nominal one, simulates them (rollouts), and updates the nominal input
+    sequence by the average of the noises weighted by the exponentiated costs of the rollouts. Unlike DDPSolver, only
+    the state equation and the costs of DDPProblem are used (the derivatives are not), so non-smooth or highly
+    nonconvex problems can be solved with the same model definitions.
+
+    The rollouts are distributed over the thread pool, and the weighted average over all rollouts is calculated as a
+    matrix-vector product. The noise of each rollout is generated by the counter-based random number generator from
+    the seed and the indices of the iteration, rollout, and step, so that the result does not depend on the thread pool.
+
+    The result can be refined by DDPSolver warm-started from the sampled solution (see setRefinementSolver()), which
+    combines the global exploration of sampling with the fast local convergence of DDP.
+
+    See G. Williams et al., Information theoretic MPC for model-based reinforcement learning, ICRA 2017.
+
+    \note The input dimension must not vary along the horizon.
+ */
+template<int StateDim,
+         int InputDim,
+         class RefinementSolverType = DDPSolver<StateDim, InputDim>,
+         class ObserverType = PrintObserver>
+class MppiSolver
+{
+public:
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename DDPProblem<StateDim, InputDim>::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename DDPProblem<StateDim, InputDim>::InputDimVector;
+
+  /** \brief Type of DDP solver to refine solution. */
+  using RefinementSolver = RefinementSolverType;
+
+  /** \brief Type of observer. */
+  using Observer = ObserverType;
+
+  /** \brief Type of clock to measure computation duration. */
+  using Clock = std::chrono::steady_clock;
+
+public:
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Print level (0: no print, 1: print only important, 2: print verbose)
+    int print_level = 1;
+
+    //! Number of steps in horizon
+    int horizon_steps = 100;
+
+    //! Number of iterations (sampling and update) in each solve
+    int max_iter = 1;
+
+    //! Number of rollouts in each iteration
+    int rollout_num = 1000;
+
+    //! Temperature of weights of rollouts (smaller value makes the update greedier)
+    double temperature = 1.0;
+
+    //! Standard deviation of input noise (the same value is used for all elements if the size is one)
+    Eigen::VectorXd input_stddev = Eigen::VectorXd::Ones(1);
+
+    //! Seed of random number generator
+    uint64_t seed = 0;
+
+    //! Whether input has constraints (see setInputLimitsFunc())
+    bool with_input_constraint = false;
+  };
+
+  /*! \brief Control data. */
+  struct ControlData
+  {
+    //! Sequence of state (x[0], ..., x[N-1], x[N])
+    std::vector<StateDimVector> x_list;
+
+    //! Sequence of input (u[0], ..., u[N-1])
+    std::vector<InputDimVector> u_list;
+
+    //! Sequence of cost (L[0], ..., L[N-1], phi[N])
+    Eigen::VectorXd cost_list;
+  };
+
+  /*! \brief Data to trace optimization loop. */
+  struct TraceData
+  {
+    //! Iteration of optimization loop
+    int iter = 0;
+
+    //! Total cost of nominal input sequence after update
+    double cost = 0;
+
+    //! Minimum cost of rollouts
+    double min_rollout_cost = 0;
+
+    //! Effective number of rollouts (inverse of the sum of squared weights)
+    double effective_rollout_num = 0;
+
+    //! Duration to process rollouts [msec]
+    double duration_rollout = 0;
+
+    //! Duration to update nominal input sequence [msec]
+    double duration_update = 0;
+  };
+
+  /*! \brief Data of computation duration. */
+  struct ComputationDuration
+  {
+    //! Duration to solve [msec]
+    double solve = 0;
+
+    //! Duration to process rollouts (included in solve) [msec]
+    double rollout = 0;
+
+    //! Duration to update nominal input sequence (included in solve) [msec]
+    double update = 0;
+
+    //! Duration to refine solution by DDP (included in solve) [msec]
+    double refinement = 0;
+  };
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /** \brief Constructor.
+      \param problem DDP problem (only the state equation and the costs are used)
+   */
+  MppiSolver(const std::shared_ptr<DDPProblem<StateDim, InputDim>> & problem) : problem_(problem) {}
+
+  /** \brief Accessor to configuration. */
+  inline Configuration & config()
+  {
+    return config_;
+  }
+
+  /** \brief Const accessor to configuration. */
+  inline const Configuration & config() const
+  {
+    return config_;
+  }
+
+  /** \brief Const accessor to problem. */
+  inline const std::shared_ptr<DDPProblem<StateDim, InputDim>> & problem() const
+  {
+    return problem_;
+  }
+
+  /** \brief Set problem.
+      \param problem problem with the same dimensions
+   */
+  inline void setProblem(const std::shared_ptr<DDPProblem<StateDim, InputDim>> & problem)
+  {
+    problem_ = problem;
+  }
+
+  /** \brief Solve optimization.
+      \param current_t current time [sec]
+      \param current_x current state
+      \param initial_u_list initial sequence of input (nominal input sequence of the first iteration)
+      \return whether the nominal input sequence has a finite cost
+   */
+  bool solve(double current_t, const StateDimVector & current_x, const std::vector<InputDimVector> & initial_u_list);
+
+  /** \brief Set function to return input limits.
+      \param input_limits_func function to return input limits (in the order of lower, upper)
+
+      The sampled inputs are clamped to the limits when input has constraints (see
+      Configuration::with_input_constraint).
+   */
+  inline void setInputLimitsFunc(const std::function<std::array<InputDimVector, 2>(double)> & input_limits_func)
+  {
+    input_limits_func_ = input_limits_func;
+  }
+
+  /** \brief Set thread pool.
+      \param thread_pool thread pool shared with other solvers (nullptr to process rollouts serially)
+
+      When the thread pool is set, the rollouts are processed in parallel. The state equation and the costs of the
+      problem must be thread-safe.
+   */
+  inline void setThreadPool(const std::shared_ptr<nmpc_common::ThreadPool> & thread_pool)
+  {
+    thread_pool_ = thread_pool;
+  }
+
+  /** \brief Set DDP solver to refine solution.
+      \param refinement_solver DDP solver (nullptr to disable refinement)
+
+      When the solver is set, it is warm-started from the input sequence of MPPI at the end of each solve, and its
+      solution is adopted if the cost is lower. The DDP solver should have the same problem (or a problem with the same
+      costs), and must have the same horizon steps (solve() throws an exception otherwise).
+   */
+  inline void setRefinementSolver(const std::shared_ptr<RefinementSolver> & refinement_solver)
+  {
+    refinement_solver_ = refinement_solver;
+  }
+
+  /** \brief Accessor to observer.
+
+      Events of the levels up to Configuration::print_level (i.e., iteration ends, failures due to non-finite costs,
+      and the result of each solve) are notified to the observer in each solve.
+  */
+  inline Observer & observer()
+  {
+    return observer_;
+  }
+
+  /** \brief Whether the solution of the last solve is refined by DDP. */
+  inline bool refined() const
+  {
+    return refined_;
+  }
+
+  /** \brief Const accessor to control data calculated by solve(). */
+  inline const ControlData & controlData() const
+  {
+    return control_data_;
+  }
+
+  /** \brief Const accessor to trace data list. */
+  inline const std::vector<TraceData> & traceDataList() const
+  {
+    return trace_data_list_;
+  }
+
+  /** \brief Const accessor to computation duration. */
+  inline const ComputationDuration & computationDuration() const
+  {
+    return computation_duration_;
+  }
+
+protected:
+  /** \brief Process one iteration of sampling and update.
+      \param iter iteration
+   */
+  void processIteration(int iter);
+
+  /** \brief Process rollout.
+      \param rollout_idx rollout index (zero for the nominal input sequence without noise)
+      \return total cost
+   */
+  double processRollout(int rollout_idx);
+
+  /** \brief Simulate nominal input sequence and set control data.
+      \return total cost
+   */
+  double rolloutNominal();
+
+  /** \brief Clamp input to limits.
+      \param i step index
+      \param u input
+   */
+  inline void clampInput(int i, Eigen::Ref<InputDimVector> u) const
+  {
+    if(config_.with_input_constraint)
+    {
+      const auto & u_limits = u_limits_list_[i];
+      u = u.cwiseMax(u_limits[0]).cwiseMin(u_limits[1]);
+    }
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! DDP problem
+  std::shared_ptr<DDPProblem<StateDim, InputDim>> problem_;
+
+  //! Function to return input limits
+  std::function<std::array<InputDimVector, 2>(double)> input_limits_func_;
+
+  //! Thread pool
+  std::shared_ptr<nmpc_common::ThreadPool> thread_pool_;
+
+  //! DDP solver to refine solution
+  std::shared_ptr<RefinementSolver> refinement_solver_;
+
+  //! Whether the solution of the last solve is refined by DDP
+  bool refined_ = false;
+
+  //! Current time [sec]
+  double current_t_ = 0;
+
+  //! Current state
+  StateDimVector current_x_;
+
+  //! Input dimension
+  int input_dim_ = 0;
+
+  //! Standard deviation of input noise
+  Eigen::VectorXd input_stddev_;
+
+  //! Input limits of each step
+  std::vector<std::array<InputDimVector, 2>> u_limits_list_;
+
+  //! Nominal input sequence
+  std::vector<InputDimVector> u_list_;
+
+  //! Noises applied in rollouts (column for each rollout, rows of input sequence stacked in order of steps)
+  Eigen::MatrixXd noise_mat_;
+
+  //! Total costs of rollouts
+  Eigen::VectorXd rollout_cost_list_;
+
+  //! Weights of rollouts
+  Eigen::VectorXd weight_list_;
+
+  //! Number of iterations processed in all solves (used as counter of random number generator)
+  uint64_t total_iter_ = 0;
+
+  //! Control data
+  ControlData control_data_;
+
+  //! Sequence of trace data
+  std::vector<TraceData> trace_data_list_;
+
+  //! Computation duration data
+  ComputationDuration computation_duration_;
+
+  //! Observer notified of events
+  Observer observer_;
+};
+} // namespace nmpc_ddp
+
+#include <nmpc_ddp/MppiSolver.hpp>
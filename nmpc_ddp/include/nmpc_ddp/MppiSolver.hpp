@@ -0,0 +1,253 @@
+/* Author: Masaki Murooka */
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace nmpc_ddp
+{
+template<int StateDim, int InputDim, class RefinementSolverType, class ObserverType>
+bool MppiSolver<StateDim, InputDim, RefinementSolverType, ObserverType>::solve(
+    double current_t,
+    const StateDimVector & current_x,
+    const std::vector<InputDimVector> & initial_u_list)
+{
+  auto start_time = Clock::now();
+
+  // Check and set configuration
+  input_dim_ = problem_->inputDim();
+  if(static_cast<int>(initial_u_list.size()) != config_.horizon_steps)
+  {
+    throw std::invalid_argument("[MppiSolver] initial_u_list must have horizon_steps elements. size: "
+                                + std::to_string(initial_u_list.size())
+                                + ", horizon_steps: " + std::to_string(config_.horizon_steps));
+  }
+  if(refinement_solver_ && refinement_solver_->config().horizon_steps != config_.horizon_steps)
+  {
+    throw std::invalid_argument("[MppiSolver] Refinement solver must have the same horizon_steps. refinement: "
+                                + std::to_string(refinement_solver_->config().horizon_steps)
+                                + ", horizon_steps: " + std::to_string(config_.horizon_steps));
+  }
+  if(config_.rollout_num < 1 || config_.temperature <= 0)
+  {
+    throw std::invalid_argument("[MppiSolver] rollout_num and temperature must be positive.");
+  }
+  if(config_.input_stddev.size() == 1)
+  {
+    input_stddev_.setConstant(input_dim_, config_.input_stddev[0]);
+  }
+  else if(config_.input_stddev.size() == input_dim_)
+  {
+    input_stddev_ = config_.input_stddev;
+  }
+  else
+  {
+    throw std::invalid_argument("[MppiSolver] input_stddev must have one or input dimension elements. size: "
+                                + std::to_string(config_.input_stddev.size()));
+  }
+  if(config_.with_input_constraint)
+  {
+    if(!input_limits_func_)
+    {
+      throw std::runtime_error("[MppiSolver] Input limits function is not set.");
+    }
+    u_limits_list_.resize(config_.horizon_steps);
+    for(int i = 0; i < config_.horizon_steps; i++)
+    {
+      u_limits_list_[i] = input_limits_func_(current_t + i * problem_->dt());
+    }
+  }
+
+  // Initialize variables (the matrices are not reallocated if the sizes are the same as the previous solve)
+  current_t_ = current_t;
+  current_x_ = current_x;
+  u_list_ = initial_u_list;
+  if(config_.with_input_constraint)
+  {
+    for(int i = 0; i < config_.horizon_steps; i++)
+    {
+      clampInput(i, u_list_[i]);
+    }
+  }
+  noise_mat_.resize(config_.horizon_steps * input_dim_, config_.rollout_num);
+  rollout_cost_list_.resize(config_.rollout_num);
+  weight_list_.resize(config_.rollout_num);
+  refined_ = false;
+  computation_duration_ = ComputationDuration();
+  trace_data_list_.clear();
+  TraceData initial_trace_data;
+  initial_trace_data.iter = 0;
+  initial_trace_data.cost = rolloutNominal();
+  trace_data_list_.push_back(initial_trace_data);
+
+  // Optimization loop
+  for(int iter = 1; iter <= config_.max_iter; iter++)
+  {
+    processIteration(iter);
+  }
+
+  // Refine solution by DDP
+  if(refinement_solver_)
+  {
+    auto refinement_start_time = Clock::now();
+    refinement_solver_->solve(current_t_, current_x_, control_data_.u_list);
+    const auto & refined_control_data = refinement_solver_->controlData();
+    double refined_cost = refined_control_data.cost_list.sum();
+    if(std::isfinite(refined_cost) && refined_cost < control_data_.cost_list.sum())
+    {
+      control_data_.x_list = refined_control_data.x_list;
+      control_data_.u_list = refined_control_data.u_list;
+      control_data_.cost_list = refined_control_data.cost_list;
+      u_list_ = control_data_.u_list;
+      refined_ = true;
+    }
+    computation_duration_.refinement = calcDuration(refinement_start_time, Clock::now());
+  }
+
+  double cost = control_data_.cost_list.sum();
+  if(config_.print_level >= 2)
+  {
+    observer_.notify(SolverEvent(SolverEventType::Info, 2, "MPPI", "Solved.", trace_data_list_.back().iter,
+                                 {{"initial_cost", trace_data_list_.front().cost},
+                                  {"cost", cost},
+                                  {"refined", refined_ ? 1.0 : 0.0}}));
+  }
+
+  computation_duration_.solve = calcDuration(start_time, Clock::now());
+
+  observer_.flush();
+
+  return std::isfinite(cost);
+}
+
+template<int StateDim, int InputDim, class RefinementSolverType, class ObserverType>
+void MppiSolver<StateDim, InputDim, RefinementSolverType, ObserverType>::processIteration(int iter)
+{
+  TraceData trace_data;
+  trace_data.iter = iter;
+
+  // Process rollouts
+  auto rollout_start_time = Clock::now();
+  auto rollout = [&](int rollout_idx) { rollout_cost_list_[rollout_idx] = processRollout(rollout_idx); };
+  if(thread_pool_)
+  {
+    thread_pool_->parallelFor(0, config_.rollout_num, rollout);
+  }
+  else
+  {
+    for(int rollout_idx = 0; rollout_idx < config_.rollout_num; rollout_idx++)
+    {
+      rollout(rollout_idx);
+    }
+  }
+  total_iter_++;
+  auto update_start_time = Clock::now();
+  trace_data.duration_rollout = calcDuration(rollout_start_time, update_start_time);
+
+  // Calculate weights of rollouts
+  double min_cost = rollout_cost_list_.minCoeff();
+  trace_data.min_rollout_cost = min_cost;
+  if(!std::isfinite(min_cost))
+  {
+    if(config_.print_level >= 1)
+    {
+      observer_.notify(SolverEvent(SolverEventType::Failure, 1, "MPPI", "All rollouts have non-finite costs.", iter));
+    }
+    trace_data.cost = trace_data_list_.back().cost;
+    computation_duration_.rollout += trace_data.duration_rollout;
+    trace_data_list_.push_back(trace_data);
+    return;
+  }
+  for(int rollout_idx = 0; rollout_idx < config_.rollout_num; rollout_idx++)
+  {
+    // Rollouts with non-finite costs have zero weights
+    double cost = rollout_cost_list_[rollout_idx];
+    weight_list_[rollout_idx] = std::isfinite(cost) ? std::exp(-(cost - min_cost) / config_.temperature) : 0.0;
+  }
+  weight_list_ /= weight_list_.sum();
+  trace_data.effective_rollout_num = 1.0 / weight_list_.squaredNorm();
+
+  // Update nominal input sequence by weighted average of noises
+  // The input limits are satisfied without clamping because the noises are clamped in the rollouts
+  Eigen::VectorXd u_update = noise_mat_ * weight_list_;
+  for(int i = 0; i < config_.horizon_steps; i++)
+  {
+    u_list_[i] += u_update.segment(i * input_dim_, input_dim_);
+  }
+  trace_data.cost = rolloutNominal();
+  trace_data.duration_update = calcDuration(update_start_time, Clock::now());
+
+  computation_duration_.rollout += trace_data.duration_rollout;
+  computation_duration_.update += trace_data.duration_update;
+
+  if(config_.print_level >= 2)
+  {
+    observer_.notify(SolverEvent(SolverEventType::IterationEnd, 2, "MPPI", "End iteration.", iter,
+                                 {{"cost", trace_data.cost},
+                                  {"min_rollout_cost", trace_data.min_rollout_cost},
+                                  {"effective_rollout_num", trace_data.effective_rollout_num}}));
+  }
+
+  trace_data_list_.push_back(trace_data);
+}
+
+template<int StateDim, int InputDim, class RefinementSolverType, class ObserverType>
+double MppiSolver<StateDim, InputDim, RefinementSolverType, ObserverType>::processRollout(int rollout_idx)
+{
+  nmpc_common::CounterRng rng(config_.seed);
+  int group_num = (input_dim_ + 3) / 4;
+  StateDimVector x = current_x_;
+  InputDimVector u(input_dim_);
+  double cost = 0;
+  for(int i = 0; i < config_.horizon_steps; i++)
+  {
+    double t = current_t_ + i * problem_->dt();
+    auto noise = noise_mat_.col(rollout_idx).segment(i * input_dim_, input_dim_);
+    if(rollout_idx == 0)
+    {
+      noise.setZero();
+    }
+    else
+    {
+      // The noise depends only on the seed and the indices of iteration, rollout, and step
+      for(int group_idx = 0; group_idx < group_num; group_idx++)
+      {
+        auto normal = rng.normal({static_cast<uint32_t>(rollout_idx), static_cast<uint32_t>(i * group_num + group_idx),
+                                  static_cast<uint32_t>(total_iter_), static_cast<uint32_t>(total_iter_ >> 32)});
+        for(int j = 0; j < 4 && 4 * group_idx + j < input_dim_; j++)
+        {
+          noise[4 * group_idx + j] = input_stddev_[4 * group_idx + j] * normal[j];
+        }
+      }
+    }
+    u = u_list_[i] + noise;
+    clampInput(i, u);
+    noise = u - u_list_[i];
+
+    cost += problem_->runningCost(t, x, u);
+    x = problem_->stateEq(t, x, u);
+  }
+  cost += problem_->terminalCost(current_t_ + config_.horizon_steps * problem_->dt(), x);
+
+  return std::isfinite(cost) ? cost : std::numeric_limits<double>::infinity();
+}
+
+template<int StateDim, int InputDim, class RefinementSolverType, class ObserverType>
+double MppiSolver<StateDim, InputDim, RefinementSolverType, ObserverType>::rolloutNominal()
+{
+  control_data_.x_list.resize(config_.horizon_steps + 1);
+  control_data_.cost_list.resize(config_.horizon_steps + 1);
+  control_data_.u_list = u_list_;
+  control_data_.x_list[0] = current_x_;
+  for(int i = 0; i < config_.horizon_steps; i++)
+  {
+    double t = current_t_ + i * problem_->dt();
+    control_data_.cost_list[i] = problem_->runningCost(t, control_data_.x_list[i], u_list_[i]);
+    control_data_.x_list[i + 1] = problem_->stateEq(t, control_data_.x_list[i], u_list_[i]);
+  }
+  control_data_.cost_list[config_.horizon_steps] = problem_->terminalCost(
+      current_t_ + config_.horizon_steps * problem_->dt(), control_data_.x_list[config_.horizon_steps]);
+  return control_data_.cost_list.sum();
+}
+} // namespace nmpc_ddp
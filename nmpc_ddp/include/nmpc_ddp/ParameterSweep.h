@@ -0,0 +1,393 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <nmpc_common/ThreadPool.h>
+#include <nmpc_ddp/MpcRunner.h>
+
+namespace nmpc_ddp
+{
+/*! \brief Columnar table of results of parameter sweep. */
+struct SweepTable
+{
+  //! Column names
+  std::vector<std::string> name_list;
+
+  //! Columns (each has the same number of rows)
+  std::vector<std::vector<double>> column_list;
+
+  /** \brief Get number of rows. */
+  inline size_t rowNum() const
+  {
+    return column_list.empty() ? 0 : column_list.front().size();
+  }
+
+  /** \brief Add column filled with value.
+      \param name column name
+      \param row_num number of rows
+      \param value initial value
+   */
+  inline void addColumn(const std::string & name, size_t row_num, double value = 0)
+  {
+    name_list.push_back(name);
+    column_list.emplace_back(row_num, value);
+  }
+
+  /** \brief Get column index.
+      \param name column name
+   */
+  inline size_t columnIdx(const std::string & name) const
+  {
+    for(size_t i = 0; i < name_list.size(); i++)
+    {
+      if(name_list[i] == name)
+      {
+        return i;
+      }
+    }
+    throw std::invalid_argument("[SweepTable] Column " + name + " is not found.");
+  }
+
+  /** \brief Accessor to column.
+      \param name column name
+   */
+  inline const std::vector<double> & column(const std::string & name) const
+  {
+    return column_list[columnIdx(name)];
+  }
+
+  /** \brief Write table in CSV format.
+      \param os output stream
+   */
+  void writeCsv(std::ostream & os) const
+  {
+    for(size_t i = 0; i < name_list.size(); i++)
+    {
+      os << (i == 0 ? "" : ",") << name_list[i];
+    }
+    os << std::endl;
+    auto precision = os.precision(std::numeric_limits<double>::max_digits10);
+    for(size_t row = 0; row < rowNum(); row++)
+    {
+      for(size_t i = 0; i < column_list.size(); i++)
+      {
+        os << (i == 0 ? "" : ",") << column_list[i][row];
+      }
+      os << std::endl;
+    }
+    os.precision(precision);
+  }
+};
+
+/** \brief Parameter sweep with batched parallel solves.
+    \tparam Solver solver type (DDPSolver or nmpc_fmpc::FmpcSolver, see MpcRunnerAdapter)
+    \tparam Param parameter type (e.g., cost weight or model parameter of problem)
+
+    For each parameter point, a problem is created by the problem factory and solved from the same initial condition.
+    The points are divided into chunks of contiguous indices, which are distributed over the thread pool. The solvers
+    are reused by the chunks (one solver per concurrently executed chunk), and within a chunk, each point is
+    warm-started from the solution of the previous point. Therefore, the points should be ordered so that the
+    neighboring points have similar solutions (e.g., grid points in row-major order, see makeGrid()). Since the chunk
+    boundaries depend only on the number of points and Configuration::chunk_size, the solutions do not depend on the
+    thread timing.
+
+    The results are collected in a columnar table with the following columns followed by the metric columns added by
+    addMetric(). Each row corresponds to a parameter point.
+      - succeeded: 1 if the solve succeeded, 0 otherwise
+      - cost: cost of the solution
+      - iter: number of iterations of the (last) solve
+      - duration: wall-clock duration of the solve function [ms]
+      - warm_start_idx: index of the point whose solution is used as the initial guess (-1 for the initial one)
+ */
+template<class Solver, class Param>
+class ParameterSweep
+{
+public:
+  /** \brief Type of solver adapter. */
+  using Adapter = MpcRunnerAdapter<Solver>;
+
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename Adapter::StateDimVector;
+
+  /** \brief Type of warm-start data. */
+  using WarmStart = typename Adapter::WarmStart;
+
+  /** \brief Type of pointer to problem. */
+  using ProblemPtr = std::remove_cv_t<std::remove_reference_t<decltype(std::declval<const Solver &>().problem())>>;
+
+  /** \brief Type of function to create problem for parameter point. */
+  using ProblemFactory = std::function<ProblemPtr(const Param &)>;
+
+  /** \brief Type of function to create solver (called at most once per thread). */
+  using SolverFactory = std::function<std::shared_ptr<Solver>(const ProblemPtr &)>;
+
+  /** \brief Type of function to solve (arguments are solver, parameter, time, state, and warm-start data, which is
+      overwritten with the solution). */
+  using SolveFunc = std::function<bool(Solver &, const Param &, double, const StateDimVector &, WarmStart &)>;
+
+  /** \brief Type of function to calculate metric after solve (arguments are solver and parameter). */
+  using MetricFunc = std::function<double(const Solver &, const Param &)>;
+
+  /** \brief Type of clock to measure computation duration. */
+  using Clock = std::chrono::steady_clock;
+
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Print level (0: no print, 1: print summary)
+    int print_level = 1;
+
+    //! Number of points in each chunk (larger for more warm-starts, smaller for better load balancing)
+    int chunk_size = 16;
+
+    //! Whether to warm-start each point from the solution of the previous point in the chunk
+    bool warm_start_from_neighbor = true;
+  };
+
+public:
+  /** \brief Constructor.
+      \param problem_factory function to create problem for parameter point
+      \param solver_factory function to create solver
+   */
+  ParameterSweep(ProblemFactory problem_factory, SolverFactory solver_factory)
+  : problem_factory_(std::move(problem_factory)), solver_factory_(std::move(solver_factory)),
+    solve_func_([](Solver & solver, const Param &, // param
+                   double t, const StateDimVector & x, WarmStart & warm_start)
+                { return Adapter::solve(solver, t, x, warm_start); })
+  {
+  }
+
+  /** \brief Accessor to configuration. */
+  inline Configuration & config()
+  {
+    return config_;
+  }
+
+  /** \brief Set thread pool to solve points in parallel.
+      \param thread_pool thread pool (nullptr to solve serially)
+   */
+  inline void setThreadPool(const std::shared_ptr<nmpc_common::ThreadPool> & thread_pool)
+  {
+    thread_pool_ = thread_pool;
+  }
+
+  /** \brief Set function to solve.
+      \param solve_func function to solve
+
+      The default function solves once from the initial condition (open-loop solve). A closed-loop simulation with
+      the solver can be set instead.
+   */
+  inline void setSolveFunc(const SolveFunc & solve_func)
+  {
+    solve_func_ = solve_func;
+  }
+
+  /** \brief Add metric column.
+      \param name column name
+      \param metric_func function to calculate metric after solve
+   */
+  inline void addMetric(const std::string & name, const MetricFunc & metric_func)
+  {
+    metric_name_list_.push_back(name);
+    metric_func_list_.push_back(metric_func);
+  }
+
+  /** \brief Make grid points.
+      \param axis_list values of each axis
+      \return grid points in row-major order (i.e., the last axis changes fastest)
+   */
+  static std::vector<std::vector<double>> makeGrid(const std::vector<std::vector<double>> & axis_list)
+  {
+    std::vector<std::vector<double>> point_list(1);
+    for(const auto & axis : axis_list)
+    {
+      std::vector<std::vector<double>> new_point_list;
+      new_point_list.reserve(point_list.size() * axis.size());
+      for(const auto & point : point_list)
+      {
+        for(double value : axis)
+        {
+          new_point_list.push_back(point);
+          new_point_list.back().push_back(value);
+        }
+      }
+      point_list = std::move(new_point_list);
+    }
+    return point_list;
+  }
+
+  /** \brief Run parameter sweep.
+      \param param_list parameter points
+      \param t initial time [sec]
+      \param x initial state
+      \param initial_warm_start initial guess of the first point of each chunk
+      \return table of results (each row corresponds to a parameter point)
+   */
+  SweepTable run(const std::vector<Param> & param_list,
+                 double t,
+                 const StateDimVector & x,
+                 const WarmStart & initial_warm_start)
+  {
+    int point_num = static_cast<int>(param_list.size());
+    SweepTable table;
+    table.addColumn("succeeded", point_num);
+    table.addColumn("cost", point_num, std::numeric_limits<double>::quiet_NaN());
+    table.addColumn("iter", point_num);
+    table.addColumn("duration", point_num);
+    table.addColumn("warm_start_idx", point_num, -1);
+    for(const auto & name : metric_name_list_)
+    {
+      table.addColumn(name, point_num, std::numeric_limits<double>::quiet_NaN());
+    }
+
+    auto start_time = Clock::now();
+
+    auto solve_chunk = [&](int, // chunk_idx
+                           int chunk_begin, int chunk_end)
+    {
+      std::shared_ptr<Solver> solver;
+      WarmStart warm_start = initial_warm_start;
+      int warm_start_idx = -1;
+      for(int i = chunk_begin; i < chunk_end; i++)
+      {
+        if(!config_.warm_start_from_neighbor || warm_start_idx < 0)
+        {
+          warm_start = initial_warm_start;
+          warm_start_idx = -1;
+        }
+        ProblemPtr problem = problem_factory_(param_list[i]);
+        if(!solver)
+        {
+          // The problem of the first point is reused to create a solver
+          solver = acquireSolver(problem);
+        }
+        solver->setProblem(problem);
+
+        auto solve_start_time = Clock::now();
+        bool succeeded = solve_func_(*solver, param_list[i], t, x, warm_start);
+        double duration =
+            1e3 * std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - solve_start_time).count();
+
+        table.column_list[0][i] = succeeded ? 1 : 0;
+        table.column_list[1][i] = calcSolutionCost(*solver, t);
+        table.column_list[2][i] = solver->traceDataList().empty() ? 0 : solver->traceDataList().back().iter;
+        table.column_list[3][i] = duration;
+        table.column_list[4][i] = warm_start_idx;
+        for(size_t j = 0; j < metric_func_list_.size(); j++)
+        {
+          table.column_list[5 + j][i] = metric_func_list_[j](*solver, param_list[i]);
+        }
+
+        // The solution of a failed solve is not used as the initial guess
+        warm_start_idx = succeeded ? i : -1;
+      }
+      if(solver)
+      {
+        releaseSolver(solver);
+      }
+    };
+
+    int chunk_num = (point_num + std::max(config_.chunk_size, 1) - 1) / std::max(config_.chunk_size, 1);
+    if(thread_pool_)
+    {
+      thread_pool_->parallelForChunk(0, point_num, chunk_num, solve_chunk);
+    }
+    else
+    {
+      for(int chunk_idx = 0; chunk_idx < chunk_num; chunk_idx++)
+      {
+        auto range = nmpc_common::ThreadPool::chunkRange(0, point_num, chunk_num, chunk_idx);
+        solve_chunk(chunk_idx, range.first, range.second);
+      }
+    }
+
+    if(config_.print_level >= 1)
+    {
+      double total_duration =
+          1e3 * std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start_time).count();
+      int succeeded_num = 0;
+      for(double succeeded : table.column_list[0])
+      {
+        succeeded_num += static_cast<int>(succeeded);
+      }
+      std::cout << "[ParameterSweep] Solved " << point_num << " points (" << succeeded_num << " succeeded) in "
+                << chunk_num << " chunks with " << solver_list_.size() << " solvers in " << total_duration << " [ms]"
+                << std::endl;
+    }
+
+    return table;
+  }
+
+protected:
+  /** \brief Get idle solver or create new one.
+      \param problem problem passed to new solver
+   */
+  std::shared_ptr<Solver> acquireSolver(const ProblemPtr & problem)
+  {
+    {
+      std::lock_guard<std::mutex> lock(solver_mutex_);
+      if(!idle_solver_list_.empty())
+      {
+        auto solver = idle_solver_list_.back();
+        idle_solver_list_.pop_back();
+        return solver;
+      }
+    }
+
+    auto solver = solver_factory_(problem);
+    std::lock_guard<std::mutex> lock(solver_mutex_);
+    solver_list_.push_back(solver);
+    return solver;
+  }
+
+  /** \brief Return solver to be reused. */
+  void releaseSolver(const std::shared_ptr<Solver> & solver)
+  {
+    std::lock_guard<std::mutex> lock(solver_mutex_);
+    idle_solver_list_.push_back(solver);
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! Function to create problem
+  ProblemFactory problem_factory_;
+
+  //! Function to create solver
+  SolverFactory solver_factory_;
+
+  //! Function to solve
+  SolveFunc solve_func_;
+
+  //! Metric names
+  std::vector<std::string> metric_name_list_;
+
+  //! Functions to calculate metrics
+  std::vector<MetricFunc> metric_func_list_;
+
+  //! Thread pool
+  std::shared_ptr<nmpc_common::ThreadPool> thread_pool_;
+
+  //! All solvers
+  std::vector<std::shared_ptr<Solver>> solver_list_;
+
+  //! Solvers not used by any chunk
+  std::vector<std::shared_ptr<Solver>> idle_solver_list_;
+
+  //! Mutex to access solvers
+  std::mutex solver_mutex_;
+};
+} // namespace nmpc_ddp
@@ -0,0 +1,205 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+namespace nmpc_ddp
+{
+/** \brief Hardware performance counters of the calling thread (cycles, instructions, cache misses, and branch
+    misses).
+
+    The counters are opened by Linux perf_event_open(2) as one group so that all of them can be read by a single
+    system call. If the counters are not available (e.g., on other platforms, in containers without the permission,
+    or when /proc/sys/kernel/perf_event_paranoid is too strict), available() returns false and read() returns zeros.
+    Individual counters that are not supported by the hardware also read as zero.
+
+    \note The counters only count the events of the thread that constructed this object.
+ */
+class PerfCounter
+{
+public:
+  /*! \brief Counter values. */
+  struct Count
+  {
+    //! CPU cycles
+    uint64_t cycles = 0;
+
+    //! Retired instructions
+    uint64_t instructions = 0;
+
+    //! Last-level cache misses
+    uint64_t cache_misses = 0;
+
+    //! Mispredicted branches
+    uint64_t branch_misses = 0;
+
+    /** \brief Get instructions per cycle (0 if cycles are not counted). */
+    inline double ipc() const
+    {
+      return cycles > 0 ? static_cast<double>(instructions) / static_cast<double>(cycles) : 0.0;
+    }
+
+    /** \brief Add counter values. */
+    inline Count & operator+=(const Count & count)
+    {
+      cycles += count.cycles;
+      instructions += count.instructions;
+      cache_misses += count.cache_misses;
+      branch_misses += count.branch_misses;
+      return *this;
+    }
+
+    /** \brief Subtract counter values (e.g., end count - start count). */
+    inline Count operator-(const Count & count) const
+    {
+      Count ret;
+      ret.cycles = cycles - count.cycles;
+      ret.instructions = instructions - count.instructions;
+      ret.cache_misses = cache_misses - count.cache_misses;
+      ret.branch_misses = branch_misses - count.branch_misses;
+      return ret;
+    }
+  };
+
+public:
+  /** \brief Constructor.
+      \param print_level print level (0: no print, 1: print a warning if the counters are not available)
+   */
+  PerfCounter(int print_level = 1)
+  {
+#if defined(__linux__)
+    const uint64_t config_list[counter_num] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                               PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for(int i = 0; i < counter_num; i++)
+    {
+      struct perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = config_list[i];
+      attr.disabled = (leader_fd_ < 0 ? 1 : 0);
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader_fd_, 0));
+      if(fd < 0)
+      {
+        if(leader_fd_ < 0)
+        {
+          break;
+        }
+        continue;
+      }
+      if(leader_fd_ < 0)
+      {
+        leader_fd_ = fd;
+      }
+      fd_list_[i] = fd;
+      counter_idx_list_[i] = opened_num_++;
+    }
+
+    if(leader_fd_ >= 0)
+    {
+      ioctl(leader_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+
+    if(!available() && print_level >= 1)
+    {
+      std::cout << "[PerfCounter] Hardware performance counters are not available. Counter values are zero."
+                << std::endl;
+    }
+  }
+
+  /** \brief Destructor. */
+  ~PerfCounter()
+  {
+#if defined(__linux__)
+    for(int fd : fd_list_)
+    {
+      if(fd >= 0)
+      {
+        close(fd);
+      }
+    }
+#endif
+  }
+
+  // Not copyable because the file descriptors are owned
+  PerfCounter(const PerfCounter &) = delete;
+  PerfCounter & operator=(const PerfCounter &) = delete;
+
+  /** \brief Whether the calling thread is the thread counted by this object. */
+  inline bool isCountedThread() const
+  {
+    return std::this_thread::get_id() == thread_id_;
+  }
+
+  /** \brief Whether the counters are available. */
+  inline bool available() const
+  {
+    return leader_fd_ >= 0;
+  }
+
+  /** \brief Read current counter values (zeros if not available). */
+  inline Count read() const
+  {
+    Count count;
+#if defined(__linux__)
+    if(!available())
+    {
+      return count;
+    }
+
+    // Format of PERF_FORMAT_GROUP: number of counters followed by values
+    uint64_t buf[1 + counter_num] = {};
+    if(::read(leader_fd_, buf, sizeof(buf)) <= 0)
+    {
+      return count;
+    }
+    uint64_t * value_list[counter_num] = {&count.cycles, &count.instructions, &count.cache_misses,
+                                          &count.branch_misses};
+    for(int i = 0; i < counter_num; i++)
+    {
+      if(counter_idx_list_[i] >= 0 && static_cast<uint64_t>(counter_idx_list_[i]) < buf[0])
+      {
+        *value_list[i] = buf[1 + counter_idx_list_[i]];
+      }
+    }
+#endif
+    return count;
+  }
+
+protected:
+  //! Number of counters
+  static constexpr int counter_num = 4;
+
+  //! ID of counted thread
+  std::thread::id thread_id_ = std::this_thread::get_id();
+
+  //! File descriptor of group leader (-1 if not available)
+  int leader_fd_ = -1;
+
+  //! File descriptors of counters (-1 if not opened)
+  int fd_list_[counter_num] = {-1, -1, -1, -1};
+
+  //! Indices of counters in group read (-1 if not opened)
+  int counter_idx_list_[counter_num] = {-1, -1, -1, -1};
+
+  //! Number of opened counters
+  int opened_num_ = 0;
+};
+} // namespace nmpc_ddp
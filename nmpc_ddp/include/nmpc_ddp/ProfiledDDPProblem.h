@@ -0,0 +1,217 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <nmpc_common/ProblemProfile.h>
+#include <nmpc_ddp/DDPProblem.h>
+
+namespace nmpc_ddp
+{
+/** \brief Decorator of DDP problem to profile the calls of its callbacks.
+    \tparam StateDim state dimension
+    \tparam InputDim input dimension
+    \tparam BaseProblem type of decorated problem (DDPProblem or its subclass such as nmpc_fmpc::FmpcProblem)
+
+    Each callback is forwarded to the decorated problem, counting the calls and accumulating the duration in profile()
+    (see nmpc_common::ProblemProfile). By comparing the durations with the computation duration of the solver (e.g.,
+    DDPSolver::ComputationDuration::derivative), the time spent in the model code can be separated from the overhead
+    of the solver.
+ */
+template<int StateDim, int InputDim, class BaseProblem = DDPProblem<StateDim, InputDim>>
+class ProfiledDDPProblem : public BaseProblem
+{
+public:
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename DDPProblem<StateDim, InputDim>::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename DDPProblem<StateDim, InputDim>::InputDimVector;
+
+  /** \brief Type of matrix of state x state dimension. */
+  using StateStateDimMatrix = typename DDPProblem<StateDim, InputDim>::StateStateDimMatrix;
+
+  /** \brief Type of matrix of input x input dimension. */
+  using InputInputDimMatrix = typename DDPProblem<StateDim, InputDim>::InputInputDimMatrix;
+
+  /** \brief Type of matrix of state x input dimension. */
+  using StateInputDimMatrix = typename DDPProblem<StateDim, InputDim>::StateInputDimMatrix;
+
+  /*! \brief Index of callback in profile. */
+  enum Call : int
+  {
+    //! stateEq()
+    StateEq = 0,
+
+    //! runningCost()
+    RunningCost,
+
+    //! terminalCost()
+    TerminalCost,
+
+    //! calcStateEqDeriv() of first-order derivatives
+    StateEqDeriv,
+
+    //! calcStateEqDeriv() of first-order and second-order derivatives
+    StateEqDeriv2,
+
+    //! calcRunningCostDeriv() of first-order derivatives
+    RunningCostDeriv,
+
+    //! calcRunningCostDeriv() of first-order and second-order derivatives
+    RunningCostDeriv2,
+
+    //! calcTerminalCostDeriv() of first-order derivatives
+    TerminalCostDeriv,
+
+    //! calcTerminalCostDeriv() of first-order and second-order derivatives
+    TerminalCostDeriv2,
+
+    //! Number of callbacks
+    CallNum
+  };
+
+public:
+  /** \brief Constructor.
+      \param problem decorated problem
+   */
+  ProfiledDDPProblem(const std::shared_ptr<BaseProblem> & problem) : ProfiledDDPProblem(problem, {}) {}
+
+  /** \brief Const accessor to decorated problem. */
+  inline const std::shared_ptr<BaseProblem> & problem() const
+  {
+    return problem_;
+  }
+
+  /** \brief Accessor to profile. */
+  inline nmpc_common::ProblemProfile & profile() const
+  {
+    return *profile_;
+  }
+
+  inline virtual int inputDim() const override
+  {
+    return problem_->inputDim();
+  }
+
+  inline virtual int inputDim(double t) const override
+  {
+    return problem_->inputDim(t);
+  }
+
+  virtual StateDimVector stateEq(double t, const StateDimVector & x, const InputDimVector & u) const override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, StateEq);
+    return problem_->stateEq(t, x, u);
+  }
+
+  virtual double runningCost(double t, const StateDimVector & x, const InputDimVector & u) const override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, RunningCost);
+    return problem_->runningCost(t, x, u);
+  }
+
+  virtual double terminalCost(double t, const StateDimVector & x) const override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, TerminalCost);
+    return problem_->terminalCost(t, x);
+  }
+
+  virtual void calcStateEqDeriv(double t,
+                                const StateDimVector & x,
+                                const InputDimVector & u,
+                                Eigen::Ref<StateStateDimMatrix> state_eq_deriv_x,
+                                Eigen::Ref<StateInputDimMatrix> state_eq_deriv_u) const override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, StateEqDeriv);
+    problem_->calcStateEqDeriv(t, x, u, state_eq_deriv_x, state_eq_deriv_u);
+  }
+
+  virtual void calcStateEqDeriv(double t,
+                                const StateDimVector & x,
+                                const InputDimVector & u,
+                                Eigen::Ref<StateStateDimMatrix> state_eq_deriv_x,
+                                Eigen::Ref<StateInputDimMatrix> state_eq_deriv_u,
+                                std::vector<StateStateDimMatrix> & state_eq_deriv_xx,
+                                std::vector<InputInputDimMatrix> & state_eq_deriv_uu,
+                                std::vector<StateInputDimMatrix> & state_eq_deriv_xu) const override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, StateEqDeriv2);
+    // Called via DDPProblem because the subclass may hide this function
+    static_cast<const DDPProblem<StateDim, InputDim> &>(*problem_).calcStateEqDeriv(
+        t, x, u, state_eq_deriv_x, state_eq_deriv_u, state_eq_deriv_xx, state_eq_deriv_uu, state_eq_deriv_xu);
+  }
+
+  virtual void calcRunningCostDeriv(double t,
+                                    const StateDimVector & x,
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u) const override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, RunningCostDeriv);
+    problem_->calcRunningCostDeriv(t, x, u, running_cost_deriv_x, running_cost_deriv_u);
+  }
+
+  virtual void calcRunningCostDeriv(double t,
+                                    const StateDimVector & x,
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u,
+                                    Eigen::Ref<StateStateDimMatrix> running_cost_deriv_xx,
+                                    Eigen::Ref<InputInputDimMatrix> running_cost_deriv_uu,
+                                    Eigen::Ref<StateInputDimMatrix> running_cost_deriv_xu) const override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, RunningCostDeriv2);
+    problem_->calcRunningCostDeriv(t, x, u, running_cost_deriv_x, running_cost_deriv_u, running_cost_deriv_xx,
+                                   running_cost_deriv_uu, running_cost_deriv_xu);
+  }
+
+  virtual void calcTerminalCostDeriv(double t,
+                                     const StateDimVector & x,
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x) const override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, TerminalCostDeriv);
+    problem_->calcTerminalCostDeriv(t, x, terminal_cost_deriv_x);
+  }
+
+  virtual void calcTerminalCostDeriv(double t,
+                                     const StateDimVector & x,
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x,
+                                     Eigen::Ref<StateStateDimMatrix> terminal_cost_deriv_xx) const override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*profile_, TerminalCostDeriv2);
+    problem_->calcTerminalCostDeriv(t, x, terminal_cost_deriv_x, terminal_cost_deriv_xx);
+  }
+
+protected:
+  /** \brief Constructor.
+      \param problem decorated problem
+      \param extra_call_names names of callbacks added by subclass (indexed from CallNum)
+   */
+  ProfiledDDPProblem(const std::shared_ptr<BaseProblem> & problem, const std::vector<std::string> & extra_call_names)
+  : BaseProblem(problem->dt(), problem->runtimeStateDim()), problem_(problem)
+  {
+    std::vector<std::string> call_names = {"stateEq",
+                                           "runningCost",
+                                           "terminalCost",
+                                           "calcStateEqDeriv",
+                                           "calcStateEqDeriv (2nd)",
+                                           "calcRunningCostDeriv",
+                                           "calcRunningCostDeriv (2nd)",
+                                           "calcTerminalCostDeriv",
+                                           "calcTerminalCostDeriv (2nd)"};
+    call_names.insert(call_names.end(), extra_call_names.begin(), extra_call_names.end());
+    profile_ = std::make_shared<nmpc_common::ProblemProfile>(call_names);
+  }
+
+protected:
+  //! Decorated problem
+  std::shared_ptr<BaseProblem> problem_;
+
+  //! Profile of calls
+  std::shared_ptr<nmpc_common::ProblemProfile> profile_;
+};
+} // namespace nmpc_ddp
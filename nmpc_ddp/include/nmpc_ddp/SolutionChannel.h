@@ -0,0 +1,668 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <nmpc_ddp/FeedbackPolicy.h>
+
+namespace nmpc_ddp
+{
+/** \brief Header of shared memory of SolutionChannelWriter and SolutionChannelReader.
+
+    The shared memory consists of this header followed by two slots, each of which consists of SolutionChannelSlot
+    followed by the sequences of state (N+1 vectors), input (N vectors), and feedback gain (N column-major matrices) as
+    arrays of double. All offsets are aligned to 64 bytes. The layout does not depend on the compiler options because
+    all members have fixed sizes and are ordered from the largest. The contents of slots are written and read with
+    relaxed atomics (the arrays of double as 64-bit words) so that the seqlock does not involve data races.
+ */
+struct SolutionChannelHeader
+{
+  //! Magic number to identify the layout
+  static constexpr uint64_t magic_number = 0x4e4d5043534f4c31; // "NMPCSOL1"
+
+  //! Version of the layout (increment when the layout changes)
+  static constexpr uint32_t layout_version = 1;
+
+  //! Magic number (written last by the writer so that readers do not see a partially initialized header)
+  std::atomic<uint64_t> magic;
+
+  //! Number of publications (the latest solution is in slot (publish_count - 1) % 2)
+  std::atomic<uint64_t> publish_count;
+
+  //! Size of each slot [byte]
+  uint64_t slot_size;
+
+  //! Layout version
+  uint32_t version;
+
+  //! State dimension
+  uint32_t state_dim;
+
+  //! Input dimension
+  uint32_t input_dim;
+
+  //! Maximum number of steps of horizon
+  uint32_t max_horizon_steps;
+};
+
+/** \brief Header of each slot of SolutionChannelHeader. */
+struct SolutionChannelSlot
+{
+  //! Sequence number of seqlock (odd while the writer is writing to the slot)
+  std::atomic<uint64_t> seq;
+
+  //! Start time of horizon [sec]
+  std::atomic<double> t;
+
+  //! Discretization timestep [sec]
+  std::atomic<double> dt;
+
+  //! Publication count of the solution in the slot
+  std::atomic<uint64_t> publish_count;
+
+  //! Number of steps of horizon
+  std::atomic<uint32_t> horizon_steps;
+
+  //! Whether the slot has feedback gains (gains are zero otherwise)
+  std::atomic<uint32_t> with_gain;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free
+                  && std::atomic<double>::is_always_lock_free,
+              "SolutionChannel requires lock-free atomics.");
+static_assert(sizeof(std::atomic<double>) == sizeof(double) && sizeof(std::atomic<uint64_t>) == sizeof(uint64_t)
+                  && sizeof(double) == sizeof(uint64_t),
+              "SolutionChannel requires atomics of the same size as the underlying types.");
+
+/** \brief Shared memory region of solution channel (for internal use). */
+class SolutionChannelMemory
+{
+public:
+  /** \brief Alignment of header and slots [byte]. */
+  static constexpr size_t alignment = 64;
+
+  /** \brief Round up size to alignment. */
+  static constexpr size_t align(size_t size)
+  {
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  /** \brief Calculate slot size [byte]. */
+  static constexpr size_t slotSize(size_t state_dim, size_t input_dim, size_t max_horizon_steps)
+  {
+    return align(sizeof(SolutionChannelSlot))
+           + align(sizeof(double)
+                   * ((max_horizon_steps + 1) * state_dim + max_horizon_steps * input_dim
+                      + max_horizon_steps * input_dim * state_dim));
+  }
+
+  /** \brief Store values to words in shared memory with relaxed atomics.
+      \param word_list words in shared memory
+      \param value_list values
+      \param num number of values
+   */
+  static inline void store(std::atomic<uint64_t> * word_list, const double * value_list, size_t num)
+  {
+    for(size_t i = 0; i < num; i++)
+    {
+      uint64_t word;
+      std::memcpy(&word, value_list + i, sizeof(word));
+      word_list[i].store(word, std::memory_order_relaxed);
+    }
+  }
+
+  /** \brief Load values from words in shared memory with relaxed atomics (valid only if the seqlock is unchanged).
+      \param word_list words in shared memory
+      \param value_list values
+      \param num number of values
+   */
+  static inline void load(const std::atomic<uint64_t> * word_list, double * value_list, size_t num)
+  {
+    for(size_t i = 0; i < num; i++)
+    {
+      uint64_t word = word_list[i].load(std::memory_order_relaxed);
+      std::memcpy(value_list + i, &word, sizeof(word));
+    }
+  }
+
+  /** \brief Constructor. */
+  SolutionChannelMemory() = default;
+
+  SolutionChannelMemory(const SolutionChannelMemory &) = delete;
+  SolutionChannelMemory & operator=(const SolutionChannelMemory &) = delete;
+
+  /** \brief Destructor. */
+  ~SolutionChannelMemory()
+  {
+    if(addr_)
+    {
+      munmap(addr_, size_);
+    }
+    if(owner_)
+    {
+      shm_unlink(name_.c_str());
+    }
+  }
+
+  /** \brief Create and map shared memory.
+      \param name name of shared memory (e.g., "/nmpc_solution")
+      \param size size [byte]
+   */
+  void create(const std::string & name, size_t size)
+  {
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if(fd < 0)
+    {
+      throw std::runtime_error("[SolutionChannel] Failed to create shared memory " + name + ": "
+                               + std::strerror(errno));
+    }
+    name_ = name;
+    owner_ = true;
+    if(ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+      int err = errno;
+      close(fd);
+      throw std::runtime_error("[SolutionChannel] Failed to resize shared memory " + name + ": " + std::strerror(err));
+    }
+    map(fd, size, PROT_READ | PROT_WRITE);
+  }
+
+  /** \brief Open and map existing shared memory.
+      \param name name of shared memory
+   */
+  void open(const std::string & name)
+  {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(fd < 0)
+    {
+      throw std::runtime_error("[SolutionChannel] Failed to open shared memory " + name + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SolutionChannelHeader))
+    {
+      close(fd);
+      throw std::runtime_error("[SolutionChannel] Shared memory " + name + " is not initialized.");
+    }
+    name_ = name;
+    map(fd, static_cast<size_t>(st.st_size), PROT_READ);
+  }
+
+  /** \brief Get mapped address. */
+  inline void * addr() const
+  {
+    return addr_;
+  }
+
+  /** \brief Get mapped size [byte]. */
+  inline size_t size() const
+  {
+    return size_;
+  }
+
+protected:
+  /** \brief Map shared memory and close file descriptor. */
+  void map(int fd, size_t size, int prot)
+  {
+    void * addr = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if(addr == MAP_FAILED)
+    {
+      throw std::runtime_error("[SolutionChannel] Failed to map shared memory " + name_ + ": " + std::strerror(err));
+    }
+    addr_ = addr;
+    size_ = size;
+  }
+
+protected:
+  //! Name of shared memory
+  std::string name_;
+
+  //! Whether to unlink shared memory in destructor
+  bool owner_ = false;
+
+  //! Mapped address
+  void * addr_ = nullptr;
+
+  //! Mapped size [byte]
+  size_t size_ = 0;
+};
+
+/** \brief Writer of MPC solutions to shared memory.
+    \tparam StateDim state dimension
+    \tparam InputDim input dimension
+
+    Solutions are written alternately to two slots protected by seqlocks, so that readers in other processes can read
+    the latest solution in place while the next one is being written. The writer never waits for readers. There must be
+    only one writer per channel.
+ */
+template<int StateDim, int InputDim>
+class SolutionChannelWriter
+{
+public:
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename FeedbackPolicy<StateDim, InputDim>::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename FeedbackPolicy<StateDim, InputDim>::InputDimVector;
+
+  /** \brief Type of matrix of input x state dimension. */
+  using InputStateDimMatrix = typename FeedbackPolicy<StateDim, InputDim>::InputStateDimMatrix;
+
+public:
+  /** \brief Constructor.
+      \param name name of shared memory (e.g., "/nmpc_solution"), which is removed when the writer is destroyed
+      \param state_dim state dimension
+      \param input_dim input dimension
+      \param max_horizon_steps maximum number of steps of horizon
+   */
+  SolutionChannelWriter(const std::string & name,
+                        int state_dim = StateDim,
+                        int input_dim = InputDim,
+                        int max_horizon_steps = 1000)
+  : state_dim_(state_dim), input_dim_(input_dim), max_horizon_steps_(max_horizon_steps)
+  {
+    if(state_dim_ <= 0 || input_dim_ <= 0 || max_horizon_steps_ <= 0)
+    {
+      throw std::invalid_argument("[SolutionChannelWriter] Dimensions and max_horizon_steps must be positive.");
+    }
+    slot_size_ = SolutionChannelMemory::slotSize(state_dim_, input_dim_, max_horizon_steps_);
+    memory_.create(name, SolutionChannelMemory::align(sizeof(SolutionChannelHeader)) + 2 * slot_size_);
+
+    header_ = new(memory_.addr()) SolutionChannelHeader;
+    header_->publish_count.store(0, std::memory_order_relaxed);
+    header_->slot_size = slot_size_;
+    header_->version = SolutionChannelHeader::layout_version;
+    header_->state_dim = static_cast<uint32_t>(state_dim_);
+    header_->input_dim = static_cast<uint32_t>(input_dim_);
+    header_->max_horizon_steps = static_cast<uint32_t>(max_horizon_steps_);
+    for(int i = 0; i < 2; i++)
+    {
+      SolutionChannelSlot * slot = new(slotAddr(i)) SolutionChannelSlot;
+      slot->seq.store(0, std::memory_order_relaxed);
+      slot->publish_count.store(0, std::memory_order_relaxed);
+      slot->horizon_steps.store(0, std::memory_order_relaxed);
+    }
+    header_->magic.store(SolutionChannelHeader::magic_number, std::memory_order_release);
+  }
+
+  /** \brief Publish solution.
+      \param t start time of horizon [sec]
+      \param dt discretization timestep [sec]
+      \param x_list sequence of state (x[0], ..., x[N])
+      \param u_list sequence of input (u[0], ..., u[N-1])
+      \param K_list sequence of feedback gain (K[0], ..., K[N-1], or empty if not available)
+
+      All sizes are checked before writing, so that an exception for invalid sizes leaves the channel unchanged.
+   */
+  void publish(double t,
+               double dt,
+               const std::vector<StateDimVector> & x_list,
+               const std::vector<InputDimVector> & u_list,
+               const std::vector<InputStateDimMatrix> & K_list = {})
+  {
+    int horizon_steps = static_cast<int>(u_list.size());
+    if(horizon_steps > max_horizon_steps_ || static_cast<int>(x_list.size()) != horizon_steps + 1
+       || (!K_list.empty() && static_cast<int>(K_list.size()) != horizon_steps))
+    {
+      throw std::invalid_argument("[SolutionChannelWriter] Invalid list sizes. x_list: "
+                                  + std::to_string(x_list.size()) + ", u_list: " + std::to_string(u_list.size())
+                                  + ", K_list: " + std::to_string(K_list.size())
+                                  + ", max_horizon_steps: " + std::to_string(max_horizon_steps_));
+    }
+
+    for(const auto & x : x_list)
+    {
+      checkSize(x.size(), state_dim_);
+    }
+    for(const auto & u : u_list)
+    {
+      checkSize(u.size(), input_dim_);
+    }
+    for(const auto & K : K_list)
+    {
+      checkSize(K.size(), input_dim_ * state_dim_);
+    }
+
+    uint64_t publish_count = header_->publish_count.load(std::memory_order_relaxed) + 1;
+    char * slot_addr = slotAddr(static_cast<int>((publish_count - 1) % 2));
+    auto * slot = reinterpret_cast<SolutionChannelSlot *>(slot_addr);
+
+    // Mark the slot as being written
+    uint64_t seq = slot->seq.load(std::memory_order_relaxed);
+    slot->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->t.store(t, std::memory_order_relaxed);
+    slot->dt.store(dt, std::memory_order_relaxed);
+    slot->publish_count.store(publish_count, std::memory_order_relaxed);
+    slot->horizon_steps.store(static_cast<uint32_t>(horizon_steps), std::memory_order_relaxed);
+    slot->with_gain.store(K_list.empty() ? 0 : 1, std::memory_order_relaxed);
+    char * data_addr = slot_addr + SolutionChannelMemory::align(sizeof(SolutionChannelSlot));
+    auto * data = reinterpret_cast<std::atomic<uint64_t> *>(data_addr);
+    for(const auto & x : x_list)
+    {
+      SolutionChannelMemory::store(data, x.data(), state_dim_);
+      data += state_dim_;
+    }
+    for(const auto & u : u_list)
+    {
+      SolutionChannelMemory::store(data, u.data(), input_dim_);
+      data += input_dim_;
+    }
+    for(int i = 0; i < horizon_steps; i++)
+    {
+      if(K_list.empty())
+      {
+        for(int j = 0; j < input_dim_ * state_dim_; j++)
+        {
+          data[j].store(0, std::memory_order_relaxed);
+        }
+      }
+      else
+      {
+        SolutionChannelMemory::store(data, K_list[i].data(), input_dim_ * state_dim_);
+      }
+      data += input_dim_ * state_dim_;
+    }
+
+    // Mark the slot as written and make it the latest
+    slot->seq.store(seq + 2, std::memory_order_release);
+    header_->publish_count.store(publish_count, std::memory_order_release);
+  }
+
+  /** \brief Publish feedback policy.
+      \param policy feedback policy (e.g., obtained by DDPSolver::feedbackPolicy())
+   */
+  inline void publish(const FeedbackPolicy<StateDim, InputDim> & policy)
+  {
+    publish(policy.startTime(), policy.dt(), policy.xList(), policy.uList(), policy.KList());
+  }
+
+  /** \brief Get the number of publications. */
+  inline uint64_t publishCount() const
+  {
+    return header_->publish_count.load(std::memory_order_relaxed);
+  }
+
+protected:
+  /** \brief Get address of slot. */
+  inline char * slotAddr(int idx) const
+  {
+    return static_cast<char *>(memory_.addr()) + SolutionChannelMemory::align(sizeof(SolutionChannelHeader))
+           + idx * slot_size_;
+  }
+
+  /** \brief Check size of vector or matrix. */
+  static inline void checkSize(Eigen::Index size, int expected_size)
+  {
+    if(size != expected_size)
+    {
+      throw std::invalid_argument("[SolutionChannelWriter] Invalid dimension: " + std::to_string(size)
+                                  + " != " + std::to_string(expected_size));
+    }
+  }
+
+protected:
+  //! State dimension
+  int state_dim_;
+
+  //! Input dimension
+  int input_dim_;
+
+  //! Maximum number of steps of horizon
+  int max_horizon_steps_;
+
+  //! Size of each slot [byte]
+  size_t slot_size_ = 0;
+
+  //! Shared memory
+  SolutionChannelMemory memory_;
+
+  //! Header in shared memory
+  SolutionChannelHeader * header_ = nullptr;
+};
+
+/** \brief Reader of MPC solutions from shared memory written by SolutionChannelWriter.
+    \tparam StateDim state dimension
+    \tparam InputDim input dimension
+
+    The solution is accessed in place through View, which copies only the requested values from shared memory with
+    relaxed atomics. Since the writer may overwrite the slot during read, the values obtained from View must be used
+    only after read() confirms that they are consistent.
+ */
+template<int StateDim, int InputDim>
+class SolutionChannelReader
+{
+public:
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename FeedbackPolicy<StateDim, InputDim>::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename FeedbackPolicy<StateDim, InputDim>::InputDimVector;
+
+  /** \brief Type of matrix of input x state dimension. */
+  using InputStateDimMatrix = typename FeedbackPolicy<StateDim, InputDim>::InputStateDimMatrix;
+
+  /** \brief View of solution in shared memory. */
+  class View
+  {
+  public:
+    /** \brief Constructor.
+        \param slot slot in shared memory
+        \param state_dim state dimension
+        \param input_dim input dimension
+        \param horizon_steps number of steps of horizon (read once from the slot and checked by the caller)
+     */
+    View(const SolutionChannelSlot * slot, int state_dim, int input_dim, int horizon_steps)
+    : slot_(slot), state_dim_(state_dim), input_dim_(input_dim), horizon_steps_(horizon_steps)
+    {
+      data_ = reinterpret_cast<const std::atomic<uint64_t> *>(
+          reinterpret_cast<const char *>(slot) + SolutionChannelMemory::align(sizeof(SolutionChannelSlot)));
+    }
+
+    /** \brief Get start time of horizon [sec]. */
+    inline double t() const
+    {
+      return slot_->t.load(std::memory_order_relaxed);
+    }
+
+    /** \brief Get discretization timestep [sec]. */
+    inline double dt() const
+    {
+      return slot_->dt.load(std::memory_order_relaxed);
+    }
+
+    /** \brief Get publication count. */
+    inline uint64_t publishCount() const
+    {
+      return slot_->publish_count.load(std::memory_order_relaxed);
+    }
+
+    /** \brief Get number of steps of horizon. */
+    inline int horizonSteps() const
+    {
+      return horizon_steps_;
+    }
+
+    /** \brief Whether the solution has feedback gains. */
+    inline bool withGain() const
+    {
+      return slot_->with_gain.load(std::memory_order_relaxed) != 0;
+    }
+
+    /** \brief Get state of step i (0 <= i <= N). */
+    inline StateDimVector x(int i) const
+    {
+      StateDimVector x;
+      x.resize(state_dim_);
+      SolutionChannelMemory::load(data_ + i * state_dim_, x.data(), state_dim_);
+      return x;
+    }
+
+    /** \brief Get input of step i (0 <= i < N). */
+    inline InputDimVector u(int i) const
+    {
+      InputDimVector u;
+      u.resize(input_dim_);
+      SolutionChannelMemory::load(data_ + (horizon_steps_ + 1) * state_dim_ + i * input_dim_, u.data(), input_dim_);
+      return u;
+    }
+
+    /** \brief Get feedback gain of step i (0 <= i < N). */
+    inline InputStateDimMatrix K(int i) const
+    {
+      InputStateDimMatrix K;
+      K.resize(input_dim_, state_dim_);
+      SolutionChannelMemory::load(data_ + (horizon_steps_ + 1) * state_dim_ + horizon_steps_ * input_dim_
+                                      + i * input_dim_ * state_dim_,
+                                  K.data(), input_dim_ * state_dim_);
+      return K;
+    }
+
+    /** \brief Calculate input by feedback policy in the same manner as FeedbackPolicy::calcInput().
+        \param t time [sec] (clamped to the horizon)
+        \param x current state
+     */
+    inline InputDimVector calcInput(double t, const StateDimVector & x) const
+    {
+      double s = std::clamp((t - this->t()) / dt(), 0.0, static_cast<double>(horizon_steps_));
+      int i = std::min(static_cast<int>(s), horizon_steps_ - 1);
+      double r = s - i;
+      int next_i = std::min(i + 1, horizon_steps_ - 1);
+      return (1.0 - r) * u(i) + r * u(next_i) + K(i) * (x - (1.0 - r) * this->x(i) - r * this->x(i + 1));
+    }
+
+  protected:
+    //! Slot in shared memory
+    const SolutionChannelSlot * slot_;
+
+    //! State dimension
+    int state_dim_;
+
+    //! Input dimension
+    int input_dim_;
+
+    //! Number of steps of horizon
+    int horizon_steps_;
+
+    //! Data in shared memory
+    const std::atomic<uint64_t> * data_;
+  };
+
+public:
+  /** \brief Constructor.
+      \param name name of shared memory created by SolutionChannelWriter
+
+      An exception is thrown if the shared memory does not exist, or has a different layout version or dimensions.
+   */
+  SolutionChannelReader(const std::string & name)
+  {
+    memory_.open(name);
+    header_ = static_cast<const SolutionChannelHeader *>(memory_.addr());
+    if(header_->magic.load(std::memory_order_acquire) != SolutionChannelHeader::magic_number)
+    {
+      throw std::runtime_error("[SolutionChannelReader] Shared memory " + name + " is not initialized.");
+    }
+    if(header_->version != SolutionChannelHeader::layout_version)
+    {
+      throw std::runtime_error("[SolutionChannelReader] Layout version mismatch: " + std::to_string(header_->version)
+                               + " != " + std::to_string(SolutionChannelHeader::layout_version));
+    }
+    state_dim_ = static_cast<int>(header_->state_dim);
+    input_dim_ = static_cast<int>(header_->input_dim);
+    if((StateDim != Eigen::Dynamic && state_dim_ != StateDim) || (InputDim != Eigen::Dynamic && input_dim_ != InputDim))
+    {
+      throw std::runtime_error("[SolutionChannelReader] Dimension mismatch. state_dim: " + std::to_string(state_dim_)
+                               + ", input_dim: " + std::to_string(input_dim_));
+    }
+    slot_size_ = header_->slot_size;
+    if(slot_size_ != SolutionChannelMemory::slotSize(state_dim_, input_dim_, header_->max_horizon_steps)
+       || memory_.size() < SolutionChannelMemory::align(sizeof(SolutionChannelHeader)) + 2 * slot_size_)
+    {
+      throw std::runtime_error("[SolutionChannelReader] Invalid size of shared memory " + name);
+    }
+  }
+
+  /** \brief Get the number of publications. */
+  inline uint64_t publishCount() const
+  {
+    return header_->publish_count.load(std::memory_order_acquire);
+  }
+
+  /** \brief Read the latest solution in place.
+      \param func function called with View of the latest solution
+      \param max_retry maximum number of retries when the solution is overwritten during read
+      \return whether func is called with a consistent solution in the last call (false if nothing is published)
+
+      func may be called multiple times. Only the values obtained in the last call are consistent when true is
+      returned, so func should not have side effects other than storing the values.
+   */
+  template<class Func>
+  bool read(Func && func, int max_retry = 10) const
+  {
+    for(int retry = 0; retry <= max_retry; retry++)
+    {
+      uint64_t publish_count = header_->publish_count.load(std::memory_order_acquire);
+      if(publish_count == 0)
+      {
+        return false;
+      }
+      const auto * slot =
+          reinterpret_cast<const SolutionChannelSlot *>(slotAddr(static_cast<int>((publish_count - 1) % 2)));
+      uint64_t seq = slot->seq.load(std::memory_order_acquire);
+      uint32_t horizon_steps = slot->horizon_steps.load(std::memory_order_relaxed);
+      if(seq % 2 == 1 || horizon_steps == 0 || horizon_steps > header_->max_horizon_steps)
+      {
+        continue;
+      }
+      const View view(slot, state_dim_, input_dim_, static_cast<int>(horizon_steps));
+      func(view);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if(slot->seq.load(std::memory_order_relaxed) == seq)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+protected:
+  /** \brief Get address of slot. */
+  inline const char * slotAddr(int idx) const
+  {
+    return static_cast<const char *>(memory_.addr()) + SolutionChannelMemory::align(sizeof(SolutionChannelHeader))
+           + idx * slot_size_;
+  }
+
+protected:
+  //! Shared memory
+  SolutionChannelMemory memory_;
+
+  //! Header in shared memory
+  const SolutionChannelHeader * header_ = nullptr;
+
+  //! State dimension
+  int state_dim_ = 0;
+
+  //! Input dimension
+  int input_dim_ = 0;
+
+  //! Size of each slot [byte]
+  size_t slot_size_ = 0;
+};
+} // namespace nmpc_ddp
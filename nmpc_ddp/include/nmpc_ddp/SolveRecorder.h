@@ -0,0 +1,448 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace nmpc_ddp
+{
+/** \brief Binary recorder of solver inputs and outputs.
+
+    Records are appended to a memory-mapped file, which is extended as needed. The file consists of a header followed
+    by records:
+      - header: magic (8 bytes), version (uint32), and null-terminated tag to identify the solver type (64 bytes)
+      - record: payload size in bytes (uint64) followed by the payload
+
+    The payload size is written as zero when the record begins and is filled in when the record ends. Therefore, a
+    record interrupted by a crash has zero size (or extends beyond the end of file) and is ignored by
+    SolveRecordReader together with the following data. The payload is a sequence of native-endian values and
+    matrices (rows and columns as int32 followed by column-major elements), whose content is defined by the solver
+    (e.g., DDPSolver::SolveRecord).
+ */
+class SolveRecorder
+{
+public:
+  /** \brief Magic number at the beginning of file. */
+  static constexpr char magic[8] = {'N', 'M', 'P', 'C', 'R', 'E', 'C', '\0'};
+
+  /** \brief File format version. */
+  static constexpr uint32_t version = 1;
+
+  /** \brief Maximum length of tag. */
+  static constexpr size_t tag_size = 64;
+
+  /** \brief Size of file header. */
+  static constexpr size_t header_size = sizeof(magic) + sizeof(uint32_t) + tag_size;
+
+public:
+  /** \brief Constructor.
+      \param file_path path to output file (overwritten if exists)
+      \param initial_capacity initial size of file [byte]
+   */
+  SolveRecorder(const std::string & file_path, size_t initial_capacity = 1 << 20) : file_path_(file_path)
+  {
+    fd_ = ::open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd_ < 0)
+    {
+      throw std::runtime_error("[SolveRecorder] Failed to open file: " + file_path);
+    }
+    remap(std::max(initial_capacity, header_size));
+
+    std::memcpy(data_, magic, sizeof(magic));
+    std::memcpy(data_ + sizeof(magic), &version, sizeof(version));
+    size_ = header_size;
+  }
+
+  /** \brief Destructor. */
+  ~SolveRecorder()
+  {
+    if(data_)
+    {
+      ::munmap(data_, capacity_);
+    }
+    if(fd_ >= 0)
+    {
+      // Truncate unused area
+      if(::ftruncate(fd_, static_cast<off_t>(size_)) != 0)
+      {
+        // Nothing can be done here
+      }
+      ::close(fd_);
+    }
+  }
+
+  SolveRecorder(const SolveRecorder &) = delete;
+  SolveRecorder & operator=(const SolveRecorder &) = delete;
+
+  /** \brief Set tag to identify the solver type.
+      \param tag tag
+
+      \note This is called by the solver when the recorder is set.
+   */
+  void setTag(const std::string & tag)
+  {
+    if(tag.size() >= tag_size)
+    {
+      throw std::invalid_argument("[SolveRecorder] Tag is too long: " + tag);
+    }
+    char * tag_ptr = data_ + sizeof(magic) + sizeof(uint32_t);
+    if(record_num_ > 0 && tag != std::string(tag_ptr))
+    {
+      throw std::runtime_error("[SolveRecorder] Tag cannot be changed after recording: " + std::string(tag_ptr)
+                               + " -> " + tag);
+    }
+    std::memset(tag_ptr, 0, tag_size);
+    std::memcpy(tag_ptr, tag.data(), tag.size());
+  }
+
+  /** \brief Begin record. */
+  void beginRecord()
+  {
+    if(record_start_ != 0)
+    {
+      throw std::runtime_error("[SolveRecorder] beginRecord is called twice.");
+    }
+    record_start_ = size_;
+    uint64_t payload_size = 0;
+    write(payload_size);
+  }
+
+  /** \brief End record. */
+  void endRecord()
+  {
+    if(record_start_ == 0)
+    {
+      throw std::runtime_error("[SolveRecorder] endRecord is called without beginRecord.");
+    }
+    uint64_t payload_size = size_ - record_start_ - sizeof(uint64_t);
+    std::memcpy(data_ + record_start_, &payload_size, sizeof(payload_size));
+    record_start_ = 0;
+    record_num_++;
+  }
+
+  /** \brief Write raw data.
+      \param src pointer to data
+      \param size size of data [byte]
+   */
+  void writeRaw(const void * src, size_t size)
+  {
+    if(size_ + size > capacity_)
+    {
+      remap(std::max(2 * capacity_, size_ + size));
+    }
+    std::memcpy(data_ + size_, src, size);
+    size_ += size;
+  }
+
+  /** \brief Write trivially copyable value. */
+  template<class T>
+  void write(const T & value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable.");
+    writeRaw(&value, sizeof(T));
+  }
+
+  /** \brief Write matrix (dimensions followed by elements). */
+  template<class Derived>
+  void writeMatrix(const Eigen::MatrixBase<Derived> & mat)
+  {
+    using Scalar = typename Derived::Scalar;
+    int32_t rows = static_cast<int32_t>(mat.rows());
+    int32_t cols = static_cast<int32_t>(mat.cols());
+    write(rows);
+    write(cols);
+    for(int32_t j = 0; j < cols; j++)
+    {
+      for(int32_t i = 0; i < rows; i++)
+      {
+        write<Scalar>(mat(i, j));
+      }
+    }
+  }
+
+  /** \brief Write list of matrix (list size followed by matrices). */
+  template<class MatrixType, class Allocator>
+  void writeMatrixList(const std::vector<MatrixType, Allocator> & mat_list)
+  {
+    write(static_cast<uint64_t>(mat_list.size()));
+    for(const auto & mat : mat_list)
+    {
+      writeMatrix(mat);
+    }
+  }
+
+  /** \brief Flush mapped memory to file asynchronously. */
+  void flush()
+  {
+    ::msync(data_, size_, MS_ASYNC);
+  }
+
+  /** \brief Get number of records. */
+  inline size_t recordNum() const
+  {
+    return record_num_;
+  }
+
+  /** \brief Get file path. */
+  inline const std::string & filePath() const
+  {
+    return file_path_;
+  }
+
+protected:
+  /** \brief Extend file and map it again.
+      \param capacity new size of file [byte]
+   */
+  void remap(size_t capacity)
+  {
+    if(data_)
+    {
+      ::munmap(data_, capacity_);
+      data_ = nullptr;
+    }
+    if(::ftruncate(fd_, static_cast<off_t>(capacity)) != 0)
+    {
+      throw std::runtime_error("[SolveRecorder] Failed to extend file: " + file_path_);
+    }
+    void * addr = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if(addr == MAP_FAILED)
+    {
+      throw std::runtime_error("[SolveRecorder] Failed to map file: " + file_path_);
+    }
+    data_ = static_cast<char *>(addr);
+    capacity_ = capacity;
+  }
+
+protected:
+  //! File path
+  std::string file_path_;
+
+  //! File descriptor
+  int fd_ = -1;
+
+  //! Mapped memory
+  char * data_ = nullptr;
+
+  //! Size of mapped memory [byte]
+  size_t capacity_ = 0;
+
+  //! Size of written data [byte]
+  size_t size_ = 0;
+
+  //! Start position of record being written (0 if no record is being written)
+  size_t record_start_ = 0;
+
+  //! Number of records
+  size_t record_num_ = 0;
+};
+
+/** \brief Reader of file written by SolveRecorder. */
+class SolveRecordReader
+{
+public:
+  /** \brief Constructor.
+      \param file_path path to input file
+   */
+  SolveRecordReader(const std::string & file_path) : file_path_(file_path)
+  {
+    fd_ = ::open(file_path.c_str(), O_RDONLY);
+    if(fd_ < 0)
+    {
+      throw std::runtime_error("[SolveRecordReader] Failed to open file: " + file_path);
+    }
+    struct stat st;
+    if(::fstat(fd_, &st) != 0 || static_cast<size_t>(st.st_size) < SolveRecorder::header_size)
+    {
+      ::close(fd_);
+      throw std::runtime_error("[SolveRecordReader] Invalid file: " + file_path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    void * addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if(addr == MAP_FAILED)
+    {
+      ::close(fd_);
+      throw std::runtime_error("[SolveRecordReader] Failed to map file: " + file_path);
+    }
+    data_ = static_cast<const char *>(addr);
+
+    // Check header
+    uint32_t file_version;
+    std::memcpy(&file_version, data_ + sizeof(SolveRecorder::magic), sizeof(file_version));
+    if(std::memcmp(data_, SolveRecorder::magic, sizeof(SolveRecorder::magic)) != 0
+       || file_version != SolveRecorder::version)
+    {
+      ::munmap(const_cast<char *>(data_), size_);
+      ::close(fd_);
+      throw std::runtime_error("[SolveRecordReader] Unsupported file format: " + file_path);
+    }
+    const char * tag_ptr = data_ + sizeof(SolveRecorder::magic) + sizeof(uint32_t);
+    tag_ = std::string(tag_ptr, strnlen(tag_ptr, SolveRecorder::tag_size));
+
+    // Index records
+    size_t pos = SolveRecorder::header_size;
+    while(pos + sizeof(uint64_t) <= size_)
+    {
+      uint64_t payload_size;
+      std::memcpy(&payload_size, data_ + pos, sizeof(payload_size));
+      if(payload_size == 0 || pos + sizeof(uint64_t) + payload_size > size_)
+      {
+        // Incomplete record
+        break;
+      }
+      record_pos_list_.push_back(pos + sizeof(uint64_t));
+      pos += sizeof(uint64_t) + payload_size;
+    }
+  }
+
+  /** \brief Destructor. */
+  ~SolveRecordReader()
+  {
+    ::munmap(const_cast<char *>(data_), size_);
+    ::close(fd_);
+  }
+
+  SolveRecordReader(const SolveRecordReader &) = delete;
+  SolveRecordReader & operator=(const SolveRecordReader &) = delete;
+
+  /** \brief Get tag to identify the solver type. */
+  inline const std::string & tag() const
+  {
+    return tag_;
+  }
+
+  /** \brief Get number of records. */
+  inline size_t recordNum() const
+  {
+    return record_pos_list_.size();
+  }
+
+  /** \brief Seek to the beginning of record.
+      \param idx record index
+   */
+  void seek(size_t idx)
+  {
+    if(idx >= record_pos_list_.size())
+    {
+      throw std::out_of_range("[SolveRecordReader] Record index " + std::to_string(idx) + " is out of range.");
+    }
+    uint64_t payload_size;
+    std::memcpy(&payload_size, data_ + record_pos_list_[idx] - sizeof(uint64_t), sizeof(payload_size));
+    pos_ = record_pos_list_[idx];
+    end_pos_ = pos_ + static_cast<size_t>(payload_size);
+  }
+
+  /** \brief Read raw data.
+      \param dst pointer to data
+      \param size size of data [byte]
+   */
+  void readRaw(void * dst, size_t size)
+  {
+    if(pos_ + size > end_pos_)
+    {
+      throw std::runtime_error("[SolveRecordReader] Read beyond the end of record.");
+    }
+    std::memcpy(dst, data_ + pos_, size);
+    pos_ += size;
+  }
+
+  /** \brief Get size of unread data in current record [byte]. */
+  inline size_t remainingSize() const
+  {
+    return end_pos_ - pos_;
+  }
+
+  /** \brief Read trivially copyable value. */
+  template<class T>
+  T read()
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable.");
+    T value;
+    readRaw(&value, sizeof(T));
+    return value;
+  }
+
+  /** \brief Read matrix written by SolveRecorder::writeMatrix. */
+  template<class MatrixType>
+  void readMatrix(MatrixType & mat)
+  {
+    using Scalar = typename MatrixType::Scalar;
+    int32_t rows = read<int32_t>();
+    int32_t cols = read<int32_t>();
+    if((MatrixType::RowsAtCompileTime != Eigen::Dynamic && rows != MatrixType::RowsAtCompileTime)
+       || (MatrixType::ColsAtCompileTime != Eigen::Dynamic && cols != MatrixType::ColsAtCompileTime))
+    {
+      throw std::runtime_error("[SolveRecordReader] Matrix dimension mismatch: " + std::to_string(rows) + "x"
+                               + std::to_string(cols));
+    }
+    if(rows < 0 || cols < 0
+       || static_cast<uint64_t>(rows) * static_cast<uint64_t>(cols) > remainingSize() / sizeof(Scalar))
+    {
+      throw std::runtime_error("[SolveRecordReader] Invalid matrix dimension: " + std::to_string(rows) + "x"
+                               + std::to_string(cols));
+    }
+    mat.resize(rows, cols);
+    for(int32_t j = 0; j < cols; j++)
+    {
+      for(int32_t i = 0; i < rows; i++)
+      {
+        mat(i, j) = read<Scalar>();
+      }
+    }
+  }
+
+  /** \brief Read list of matrix written by SolveRecorder::writeMatrixList. */
+  template<class MatrixType, class Allocator>
+  void readMatrixList(std::vector<MatrixType, Allocator> & mat_list)
+  {
+    // Each matrix has at least its dimensions
+    uint64_t mat_num = read<uint64_t>();
+    if(mat_num > remainingSize() / (2 * sizeof(int32_t)))
+    {
+      throw std::runtime_error("[SolveRecordReader] Invalid number of matrices: " + std::to_string(mat_num));
+    }
+    mat_list.resize(static_cast<size_t>(mat_num));
+    for(auto & mat : mat_list)
+    {
+      readMatrix(mat);
+    }
+  }
+
+protected:
+  //! File path
+  std::string file_path_;
+
+  //! File descriptor
+  int fd_ = -1;
+
+  //! Mapped memory
+  const char * data_ = nullptr;
+
+  //! Size of mapped memory [byte]
+  size_t size_ = 0;
+
+  //! Tag to identify the solver type
+  std::string tag_;
+
+  //! List of start position of record payload
+  std::vector<size_t> record_pos_list_;
+
+  //! Current read position
+  size_t pos_ = 0;
+
+  //! End position of current record
+  size_t end_pos_ = 0;
+};
+} // namespace nmpc_ddp
@@ -0,0 +1,309 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nmpc_ddp/SolveRecorder.h>
+
+namespace nmpc_ddp
+{
+/** \brief Replayer of solves recorded by SolveRecorder.
+    \tparam SolverType solver type (DDPSolver or nmpc_fmpc::FmpcSolver)
+
+    Each record (SolverType::SolveRecord) contains the configuration, the current time and state, the initial guess,
+    the input limits evaluated along the horizon (if any), and the outputs and computation duration of the solve. Each
+    recorded solve is processed again with the same inputs and configuration so that slow cycles can be profiled
+    offline, and the replayed output is compared with the recorded one. Since the problem is not recorded, the solver
+    must be constructed with the same problem as the recorded one. See replayMain() for the command-line entry point.
+ */
+template<class SolverType>
+class SolveReplayer
+{
+public:
+  /** \brief Type of solve record. */
+  using SolveRecord = typename SolverType::SolveRecord;
+
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Print level (0: no print, 1: print only important, 2: print verbose, 3: print very verbose)
+    int print_level = 1;
+
+    //! Number of repeated solves for each record
+    int repeat_num = 1;
+
+    //! Number of slowest records to print
+    int print_slowest_num = 5;
+  };
+
+  /*! \brief Result of replay. */
+  struct ReplayResult
+  {
+    //! Record index
+    size_t idx = 0;
+
+    //! Current time [sec]
+    double current_t = 0;
+
+    //! Recorded duration to solve [msec]
+    double recorded_duration = 0;
+
+    //! Median of replayed duration to solve [msec]
+    double replayed_duration = 0;
+
+    //! Recorded number of iterations
+    int recorded_iter = 0;
+
+    //! Replayed number of iterations
+    int replayed_iter = 0;
+
+    //! Maximum absolute difference of sequence of input between recorded and replayed output
+    double output_error = 0;
+  };
+
+public:
+  /** \brief Constructor.
+      \param solver solver used for replay
+   */
+  SolveReplayer(const std::shared_ptr<SolverType> & solver) : solver_(solver) {}
+
+  /** \brief Accessor to configuration. */
+  inline Configuration & config()
+  {
+    return config_;
+  }
+
+  /** \brief Const accessor to configuration. */
+  inline const Configuration & config() const
+  {
+    return config_;
+  }
+
+  /** \brief Replay all records in file.
+      \param file_path path to record file
+      \return list of replay result
+   */
+  std::vector<ReplayResult> replay(const std::string & file_path)
+  {
+    SolveRecordReader reader(file_path);
+    checkTag(reader);
+
+    std::vector<ReplayResult> result_list;
+    SolveRecord record;
+    for(size_t idx = 0; idx < reader.recordNum(); idx++)
+    {
+      reader.seek(idx);
+      record.read(reader);
+      result_list.push_back(replayRecord(record));
+      result_list.back().idx = idx;
+    }
+
+    if(config_.print_level >= 1)
+    {
+      printSlowest(result_list);
+    }
+
+    return result_list;
+  }
+
+  /** \brief Replay one record in file.
+      \param file_path path to record file
+      \param idx record index
+      \return replay result
+   */
+  ReplayResult replay(const std::string & file_path, size_t idx)
+  {
+    SolveRecordReader reader(file_path);
+    checkTag(reader);
+
+    SolveRecord record;
+    reader.seek(idx);
+    record.read(reader);
+    ReplayResult result = replayRecord(record);
+    result.idx = idx;
+    return result;
+  }
+
+  /** \brief Replay record.
+      \param record solve record
+      \return replay result
+   */
+  ReplayResult replayRecord(const SolveRecord & record)
+  {
+    std::vector<double> duration_list;
+    for(int i = 0; i < std::max(config_.repeat_num, 1); i++)
+    {
+      solver_->replay(record);
+      duration_list.push_back(solver_->computationDuration().solve);
+    }
+    std::sort(duration_list.begin(), duration_list.end());
+
+    ReplayResult result;
+    result.current_t = record.current_t;
+    result.recorded_duration = record.computation_duration.solve;
+    result.replayed_duration = duration_list[duration_list.size() / 2];
+    result.recorded_iter = record.iter;
+    result.replayed_iter = solver_->traceDataList().empty() ? 0 : solver_->traceDataList().back().iter;
+    result.output_error = record.calcOutputError(*solver_);
+
+    if(config_.print_level >= 2)
+    {
+      std::cout << "[SolveReplayer] time: " << result.current_t << ", duration [ms] recorded: "
+                << result.recorded_duration << ", replayed: " << result.replayed_duration
+                << ", iter recorded: " << result.recorded_iter << ", replayed: " << result.replayed_iter
+                << ", output error: " << result.output_error << std::endl;
+    }
+
+    return result;
+  }
+
+protected:
+  /** \brief Check that the record file is written by the same solver type. */
+  void checkTag(const SolveRecordReader & reader) const
+  {
+    if(reader.tag() != SolverType::recordTag())
+    {
+      throw std::runtime_error("[SolveReplayer] Record file is written by " + reader.tag() + " but replayed by "
+                               + SolverType::recordTag() + ".");
+    }
+  }
+
+  /** \brief Print the slowest records. */
+  void printSlowest(const std::vector<ReplayResult> & result_list) const
+  {
+    std::vector<ReplayResult> sorted_result_list = result_list;
+    std::sort(sorted_result_list.begin(), sorted_result_list.end(),
+              [](const ReplayResult & r1, const ReplayResult & r2)
+              { return r1.recorded_duration > r2.recorded_duration; });
+    size_t print_num = std::min(sorted_result_list.size(), static_cast<size_t>(std::max(config_.print_slowest_num, 0)));
+
+    std::cout << "[SolveReplayer] Replayed " << result_list.size() << " records. The slowest records are:" << std::endl;
+    for(size_t i = 0; i < print_num; i++)
+    {
+      const auto & result = sorted_result_list[i];
+      std::cout << "  idx: " << result.idx << ", time: " << result.current_t
+                << ", duration [ms] recorded: " << result.recorded_duration
+                << ", replayed: " << result.replayed_duration << ", iter recorded: " << result.recorded_iter
+                << ", replayed: " << result.replayed_iter << std::endl;
+    }
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! Solver used for replay
+  std::shared_ptr<SolverType> solver_;
+};
+
+/** \brief Command-line entry point of replayer.
+    \tparam SolverType solver type (DDPSolver or nmpc_fmpc::FmpcSolver)
+    \param solver solver constructed with the same problem as the recorded one
+    \param argc number of command-line arguments
+    \param argv command-line arguments
+    \return exit status
+
+    This is intended to be called from the main function of a small executable that constructs the problem and
+    solver. The arguments are as follows:
+    \code
+    <record file> [--idx <record index>] [--repeat <number>] [--slowest <number>] [--print-level <level>]
+    \endcode
+    All records are replayed and the slowest ones are printed unless --idx is given.
+ */
+template<class SolverType>
+int replayMain(const std::shared_ptr<SolverType> & solver, int argc, const char * const * argv)
+{
+  std::string usage = std::string("Usage: ") + (argc > 0 ? argv[0] : "replay")
+                      + " <record file> [--idx <record index>] [--repeat <number>] [--slowest <number>]"
+                      + " [--print-level <level>]";
+
+  SolveReplayer<SolverType> replayer(solver);
+  std::string file_path;
+  int idx = -1;
+  for(int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if(arg == "-h" || arg == "--help")
+    {
+      std::cout << usage << std::endl;
+      return EXIT_SUCCESS;
+    }
+    else if(arg.rfind("--", 0) == 0)
+    {
+      char * end = nullptr;
+      long value = i + 1 < argc ? std::strtol(argv[i + 1], &end, 10) : 0;
+      if(i + 1 >= argc || end == argv[i + 1] || *end != '\0' || value < 0)
+      {
+        std::cerr << "[SolveReplayer] Invalid value of " << arg << ".\n" << usage << std::endl;
+        return EXIT_FAILURE;
+      }
+      i++;
+      if(arg == "--idx")
+      {
+        idx = static_cast<int>(value);
+      }
+      else if(arg == "--repeat")
+      {
+        replayer.config().repeat_num = static_cast<int>(value);
+      }
+      else if(arg == "--slowest")
+      {
+        replayer.config().print_slowest_num = static_cast<int>(value);
+      }
+      else if(arg == "--print-level")
+      {
+        replayer.config().print_level = static_cast<int>(value);
+      }
+      else
+      {
+        std::cerr << "[SolveReplayer] Unknown option " << arg << ".\n" << usage << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    else if(file_path.empty())
+    {
+      file_path = arg;
+    }
+    else
+    {
+      std::cerr << "[SolveReplayer] Too many arguments.\n" << usage << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if(file_path.empty())
+  {
+    std::cerr << usage << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    if(idx >= 0)
+    {
+      const auto & result = replayer.replay(file_path, static_cast<size_t>(idx));
+      std::cout << "[SolveReplayer] idx: " << result.idx << ", time: " << result.current_t
+                << ", duration [ms] recorded: " << result.recorded_duration
+                << ", replayed: " << result.replayed_duration << ", iter recorded: " << result.recorded_iter
+                << ", replayed: " << result.replayed_iter << ", output error: " << result.output_error << std::endl;
+    }
+    else
+    {
+      replayer.replay(file_path);
+    }
+  }
+  catch(const std::exception & e)
+  {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+} // namespace nmpc_ddp
@@ -0,0 +1,422 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace nmpc_ddp
+{
+/** \brief Type of solver event. */
+enum class SolverEventType : uint8_t
+{
+  //! Informative event (e.g., initial cost and computation duration)
+  Info = 0,
+
+  //! Start of iteration
+  IterationStart = 1,
+
+  //! End of iteration
+  IterationEnd = 2,
+
+  //! Increase of regularization coefficient
+  LambdaIncrease = 3,
+
+  //! Decrease of regularization coefficient
+  LambdaDecrease = 4,
+
+  //! Result of line search
+  LineSearch = 5,
+
+  //! Termination of optimization loop
+  Termination = 6,
+
+  //! Failure (e.g., non-positive-definite matrix and NaN)
+  Failure = 7
+};
+
+/** \brief Event notified by solvers to observers.
+
+    The event has a fixed size and holds only pointers to strings with static storage duration, so it can be created and
+    copied in the middle of solves without allocation.
+ */
+struct SolverEvent
+{
+  //! Maximum number of values
+  static constexpr int max_value_num = 6;
+
+  //! Event type
+  SolverEventType type = SolverEventType::Info;
+
+  //! Print level from which the event is notified (0: always, 1: important, 2: verbose, 3: very verbose)
+  int level = 0;
+
+  //! Source name such as "DDP/Backward" (must have static storage duration, e.g., string literal)
+  const char * source = "";
+
+  //! Message (must have static storage duration, e.g., string literal)
+  const char * message = "";
+
+  //! Iteration of optimization loop (-1 if not applicable)
+  int iter = -1;
+
+  //! Number of values
+  int value_num = 0;
+
+  //! Value names (must have static storage duration, e.g., string literal)
+  std::array<const char *, max_value_num> value_names = {};
+
+  //! Values
+  std::array<double, max_value_num> values = {};
+
+  /** \brief Constructor. */
+  SolverEvent() = default;
+
+  /** \brief Constructor.
+      \param _type event type
+      \param _level print level from which the event is notified
+      \param _source source name (must have static storage duration)
+      \param _message message (must have static storage duration)
+      \param _iter iteration of optimization loop (-1 if not applicable)
+      \param value_list list of pairs of value name and value (up to max_value_num, the rest are ignored)
+   */
+  SolverEvent(SolverEventType _type,
+              int _level,
+              const char * _source,
+              const char * _message,
+              int _iter = -1,
+              std::initializer_list<std::pair<const char *, double>> value_list = {})
+  : type(_type), level(_level), source(_source), message(_message), iter(_iter)
+  {
+    for(const auto & name_value : value_list)
+    {
+      if(value_num == max_value_num)
+      {
+        break;
+      }
+      value_names[value_num] = name_value.first;
+      values[value_num] = name_value.second;
+      value_num++;
+    }
+  }
+
+  /** \brief Get value.
+      \param name value name
+      \return value (NaN if not found)
+   */
+  inline double value(const char * name) const
+  {
+    for(int i = 0; i < value_num; i++)
+    {
+      if(std::strcmp(value_names[i], name) == 0)
+      {
+        return values[i];
+      }
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+};
+
+/** \brief Print solver event (e.g., "[DDP/Forward] Increase lambda. (iter: 3, lambda: 0.01)"). */
+inline std::ostream & operator<<(std::ostream & os, const SolverEvent & event)
+{
+  os << "[" << event.source << "] " << event.message;
+  if(event.iter >= 0 || event.value_num > 0)
+  {
+    os << " (";
+    bool first = true;
+    if(event.iter >= 0)
+    {
+      os << "iter: " << event.iter;
+      first = false;
+    }
+    for(int i = 0; i < event.value_num; i++)
+    {
+      os << (first ? "" : ", ") << event.value_names[i] << ": " << event.values[i];
+      first = false;
+    }
+    os << ")";
+  }
+  return os;
+}
+
+/** \brief Fixed-capacity non-blocking queue of solver events.
+
+    Multiple threads can push events without allocation or locking; events are dropped if the queue is full. Events are
+    drained by a single consumer (e.g., at the end of each solve or in a logging thread).
+ */
+class EventSink
+{
+public:
+  /** \brief Constructor.
+      \param capacity maximum number of events (rounded up to power of two)
+   */
+  EventSink(size_t capacity = 1 << 8)
+  {
+    size_t rounded_capacity = 1;
+    while(rounded_capacity < capacity)
+    {
+      rounded_capacity <<= 1;
+    }
+    mask_ = rounded_capacity - 1;
+    slot_list_ = std::make_unique<Slot[]>(rounded_capacity);
+    for(size_t i = 0; i < rounded_capacity; i++)
+    {
+      slot_list_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /** \brief Get capacity. */
+  inline size_t capacity() const
+  {
+    return mask_ + 1;
+  }
+
+  /** \brief Get the number of events dropped because the queue was full. */
+  inline uint64_t droppedNum() const
+  {
+    return dropped_num_.load(std::memory_order_relaxed);
+  }
+
+  /** \brief Push event.
+      \param event solver event
+      \return whether the event is pushed (false if dropped)
+   */
+  bool push(const SolverEvent & event)
+  {
+    uint64_t pos = head_.load(std::memory_order_relaxed);
+    Slot * slot;
+    while(true)
+    {
+      slot = &slot_list_[pos & mask_];
+      uint64_t seq = slot->seq.load(std::memory_order_acquire);
+      int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+      if(diff == 0)
+      {
+        if(head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if(diff < 0)
+      {
+        dropped_num_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      else
+      {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->event = event;
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** \brief Pop all events in the queue in the order of push.
+      \param func function called with each event
+      \return number of popped events
+
+      \note This must not be called concurrently with itself or flush().
+   */
+  template<class Func>
+  size_t drain(Func && func)
+  {
+    size_t num = 0;
+    while(true)
+    {
+      Slot & slot = slot_list_[tail_ & mask_];
+      if(slot.seq.load(std::memory_order_acquire) != tail_ + 1)
+      {
+        break;
+      }
+      func(static_cast<const SolverEvent &>(slot.event));
+      slot.seq.store(tail_ + mask_ + 1, std::memory_order_release);
+      tail_++;
+      num++;
+    }
+    return num;
+  }
+
+  /** \brief Print all events in the queue.
+      \param os output stream
+      \return number of printed events
+
+      If events have been dropped since the previous flush, their number is printed after the events. The stream is
+      flushed only once after all events are printed.
+
+      \note This must not be called concurrently with itself or drain().
+   */
+  size_t flush(std::ostream & os = std::cout)
+  {
+    size_t num = drain([&os](const SolverEvent & event) { os << event << "\n"; });
+    uint64_t dropped_num = droppedNum();
+    if(dropped_num > flushed_dropped_num_)
+    {
+      os << "[EventSink] " << dropped_num - flushed_dropped_num_
+         << " events are dropped because the queue is full (capacity: " << capacity() << ").\n";
+      flushed_dropped_num_ = dropped_num;
+    }
+    else if(num == 0)
+    {
+      return num;
+    }
+    os.flush();
+    return num;
+  }
+
+protected:
+  /*! \brief Slot of queue. */
+  struct Slot
+  {
+    //! Sequence number (pos + 1 after writing event at position pos)
+    std::atomic<uint64_t> seq{0};
+
+    //! Solver event
+    SolverEvent event;
+  };
+
+protected:
+  //! Slots
+  std::unique_ptr<Slot[]> slot_list_;
+
+  //! Mask of slot index (capacity - 1)
+  size_t mask_ = 0;
+
+  //! Position of next push
+  std::atomic<uint64_t> head_{0};
+
+  //! Position of next pop (accessed only by consumer)
+  uint64_t tail_ = 0;
+
+  //! Number of dropped events
+  std::atomic<uint64_t> dropped_num_{0};
+
+  //! Number of dropped events printed by flush() (accessed only by consumer)
+  uint64_t flushed_dropped_num_ = 0;
+};
+
+/** \brief Observer that ignores all events.
+
+    An observer is a class with notify(const SolverEvent &), called when an event occurs, and flush(), called at the end
+    of each solve outside the measured duration. Since solvers call them through the observer type given by the solver
+    policy, the calls are statically dispatched and the events are removed at compile time with this observer.
+ */
+class NullObserver
+{
+public:
+  /** \brief Notify event. */
+  inline void notify(const SolverEvent &) {}
+
+  /** \brief Flush events. */
+  inline void flush() {}
+};
+
+/** \brief Observer that prints events to std::cout.
+
+    Events are pushed to a non-blocking EventSink during solves and printed at once at the end of each solve, so the
+    output is delayed until the solve returns (or throws before flush, in which case the events are printed at the end
+    of the next solve). If more events than the capacity of the sink are notified in one solve (e.g., with a high
+    print_level and a large max_iter), the rest are dropped and only their number is printed; give a sink with a larger
+    capacity to the constructor in that case. If auto_flush is false, events are left in the sink, which can be drained
+    by another thread instead.
+ */
+class PrintObserver
+{
+public:
+  /** \brief Constructor.
+      \param sink event sink (shared with copies of this observer)
+   */
+  PrintObserver(const std::shared_ptr<EventSink> & sink = std::make_shared<EventSink>()) : sink_(sink) {}
+
+  /** \brief Notify event. */
+  inline void notify(const SolverEvent & event)
+  {
+    sink_->push(event);
+  }
+
+  /** \brief Flush events. */
+  inline void flush()
+  {
+    if(auto_flush)
+    {
+      sink_->flush(std::cout);
+    }
+  }
+
+  /** \brief Get event sink. */
+  inline const std::shared_ptr<EventSink> & sink() const
+  {
+    return sink_;
+  }
+
+public:
+  //! Whether to print events in flush()
+  bool auto_flush = true;
+
+protected:
+  //! Event sink
+  std::shared_ptr<EventSink> sink_;
+};
+
+/** \brief Observer that calls a function for each event (dynamically dispatched). */
+class CallbackObserver
+{
+public:
+  /** \brief Notify event. */
+  inline void notify(const SolverEvent & event)
+  {
+    if(callback)
+    {
+      callback(event);
+    }
+  }
+
+  /** \brief Flush events. */
+  inline void flush() {}
+
+public:
+  //! Function called for each event (called in the middle of solves)
+  std::function<void(const SolverEvent &)> callback;
+};
+
+/** \brief Observer that forwards events to another observer (e.g., from BoxQP to the DDP solver that owns it).
+    \tparam Observer type of observer to forward events to
+
+    flush() is not forwarded because it is called by the owner of the forwarded observer.
+ */
+template<class Observer>
+class ObserverRef
+{
+public:
+  /** \brief Constructor.
+      \param observer observer to forward events to (nullptr to ignore events)
+   */
+  ObserverRef(Observer * observer = nullptr) : observer_(observer) {}
+
+  /** \brief Notify event. */
+  inline void notify(const SolverEvent & event)
+  {
+    if(observer_)
+    {
+      observer_->notify(event);
+    }
+  }
+
+  /** \brief Flush events. */
+  inline void flush() {}
+
+protected:
+  //! Observer to forward events to
+  Observer * observer_ = nullptr;
+};
+} // namespace nmpc_ddp
@@ -0,0 +1,38 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+namespace nmpc_ddp
+{
+/** \brief Value of policy option meaning that the runtime configuration is used. */
+constexpr int PolicyRuntime = -1;
+
+/** \brief Resolve option of solver policy.
+    \param policy_value option value of policy (PolicyRuntime to use the runtime value)
+    \param runtime_value option value of runtime configuration
+
+    Since policy_value is a compile-time constant, the branches that depend on the returned value are removed by the
+    compiler when the option is fixed by the policy.
+ */
+template<class T>
+constexpr T resolvePolicy(int policy_value, T runtime_value)
+{
+  return policy_value == PolicyRuntime ? runtime_value : static_cast<T>(policy_value);
+}
+
+/** \brief Instrumentation level of solvers.
+
+    Measurements below the level of the solver policy are removed at compile time.
+ */
+enum class Instrumentation : int
+{
+  //! No measurement (computation duration, performance counters, latency histograms, and trace events are disabled)
+  None = 0,
+
+  //! Measurement of each phase (e.g., derivative, backward, and forward passes)
+  Phase = 1,
+
+  //! Measurement of each phase and of each step of horizon in it (e.g., Q, reg, and gain in backward pass)
+  Step = 2
+};
+} // namespace nmpc_ddp
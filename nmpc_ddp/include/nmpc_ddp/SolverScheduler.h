@@ -0,0 +1,538 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nmpc_ddp
+{
+/** \brief Earliest-deadline-first scheduler of periodic solves of multiple solvers on a fixed pool of worker threads.
+
+    Each task is a solver with the step-wise solve API (begin(), step(), and done() of DDPSolver and FmpcSolver). A job
+    of each task is released every period. The worker threads repeatedly process one unit of work (begin() or one
+    step()) of the released job with the earliest absolute deadline, so jobs are preempted at iteration boundaries. When
+    the solve of a job is finished, the end function of the task is called with completed = true (even if the last step
+    overran the deadline, which is counted as a late finish). When the deadline is reached before that, the job is
+    aborted and the end function is called with completed = false, so that the best solution available in the solver
+    (e.g., DDPSolver::controlData() after the last iteration) can be used. If the begin or step function throws an
+    exception, the job is ended in the same manner as an abort, and the exception is stored in the task (see
+    lastException()) so that the worker threads keep running the other tasks.
+
+    \note Each solver must be accessed only in the begin and end functions while the scheduler is running.
+ */
+class SolverScheduler
+{
+public:
+  /** \brief Type of clock. */
+  using Clock = std::chrono::steady_clock;
+
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Number of worker threads
+    int thread_num = 1;
+  };
+
+  /*! \brief Statistics of task. */
+  struct Statistics
+  {
+    //! Number of released jobs
+    int release_num = 0;
+
+    //! Number of jobs finished before deadline
+    int complete_num = 0;
+
+    //! Number of jobs finished after deadline (because the last step overran the deadline)
+    int late_num = 0;
+
+    //! Number of jobs aborted at deadline
+    int abort_num = 0;
+
+    //! Number of jobs aborted before begin() is called
+    int unstarted_abort_num = 0;
+
+    //! Number of jobs ended by exceptions thrown in the begin, step, or end function
+    int error_num = 0;
+
+    //! Number of steps (iterations)
+    int step_num = 0;
+
+    //! Mean response time of finished jobs (from release to finish) [ms]
+    double mean_response_time = 0;
+
+    //! Maximum response time of finished jobs (from release to finish) [ms]
+    double max_response_time = 0;
+
+    /** \brief Number of jobs that missed deadline (finished late or aborted). */
+    inline int missNum() const
+    {
+      return late_num + abort_num;
+    }
+
+    /** \brief Ratio of jobs that missed deadline among ended jobs. */
+    inline double missRatio() const
+    {
+      int end_num = complete_num + late_num + abort_num;
+      return end_num > 0 ? static_cast<double>(missNum()) / end_num : 0.0;
+    }
+  };
+
+  /** \brief Type of function to begin solve.
+      \param t release time of job from start of scheduler [sec]
+   */
+  using BeginFunc = std::function<void(double t)>;
+
+  /** \brief Type of function to process one step of solve.
+      \return whether the solve is finished
+   */
+  using StepFunc = std::function<bool()>;
+
+  /** \brief Type of function called at the end of job.
+      \param t release time of job from start of scheduler [sec]
+      \param completed whether the solve is finished (false if aborted at deadline)
+   */
+  using EndFunc = std::function<void(double t, bool completed)>;
+
+public:
+  /** \brief Constructor. */
+  SolverScheduler() {}
+
+  /** \brief Constructor.
+      \param config configuration
+   */
+  SolverScheduler(const Configuration & config) : config_(config) {}
+
+  /** \brief Destructor. */
+  ~SolverScheduler()
+  {
+    stop();
+  }
+
+  /** \brief Const accessor to configuration. */
+  inline const Configuration & config() const
+  {
+    return config_;
+  }
+
+  /** \brief Add task of solver.
+      \tparam Solver solver type with begin(), step(), and done() (e.g., DDPSolver and FmpcSolver)
+      \param name task name
+      \param solver solver
+      \param period period of job release [sec]
+      \param deadline relative deadline from release (0 < deadline <= period) [sec]
+      \param begin_func function called with the solver and release time to begin solve (e.g., set current state and
+      call Solver::begin())
+      \param end_func function called with the solver, release time, and whether the solve is finished
+      \return task index
+
+      If the job is aborted or ended by an exception, Solver::abort() is called before the end function so that the
+      step-wise solve is finished (e.g., the observer is flushed and the solve is recorded).
+   */
+  template<class Solver>
+  int addTask(const std::string & name,
+              const std::shared_ptr<Solver> & solver,
+              double period,
+              double deadline,
+              const std::function<void(Solver &, double)> & begin_func,
+              const std::function<void(Solver &, double, bool)> & end_func)
+  {
+    return addTask(
+        name, period, deadline, [solver, begin_func](double t) { begin_func(*solver, t); },
+        [solver]() { return solver->step(); },
+        [solver, end_func](double t, bool completed)
+        {
+          solver->abort();
+          end_func(*solver, t, completed);
+        });
+  }
+
+  /** \brief Add task.
+      \param name task name
+      \param period period of job release [sec]
+      \param deadline relative deadline from release (0 < deadline <= period) [sec]
+      \param begin_func function to begin solve
+      \param step_func function to process one step of solve
+      \param end_func function called at the end of job
+      \return task index
+   */
+  int addTask(const std::string & name,
+              double period,
+              double deadline,
+              const BeginFunc & begin_func,
+              const StepFunc & step_func,
+              const EndFunc & end_func)
+  {
+    if(period <= 0 || deadline <= 0 || deadline > period)
+    {
+      throw std::invalid_argument("[SolverScheduler] Period and deadline must satisfy 0 < deadline <= period. period: "
+                                  + std::to_string(period) + ", deadline: " + std::to_string(deadline));
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(!thread_list_.empty())
+    {
+      throw std::runtime_error("[SolverScheduler] Tasks cannot be added while running.");
+    }
+    auto task = std::make_unique<Task>();
+    task->name = name;
+    task->period = toDuration(period);
+    task->deadline = toDuration(deadline);
+    task->begin_func = begin_func;
+    task->step_func = step_func;
+    task->end_func = end_func;
+    task_list_.push_back(std::move(task));
+    return static_cast<int>(task_list_.size()) - 1;
+  }
+
+  /** \brief Start worker threads.
+
+      The first jobs of all tasks are released at start. Statistics are reset.
+   */
+  void start()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(!thread_list_.empty())
+    {
+      throw std::runtime_error("[SolverScheduler] Already started.");
+    }
+    start_time_ = Clock::now();
+    for(auto & task : task_list_)
+    {
+      task->state = JobState::Idle;
+      task->next_release_time = start_time_;
+      task->statistics = Statistics();
+      task->exception = nullptr;
+    }
+    running_ = true;
+    for(int i = 0; i < std::max(config_.thread_num, 1); i++)
+    {
+      thread_list_.emplace_back(&SolverScheduler::run, this);
+    }
+  }
+
+  /** \brief Stop worker threads after the current units of work.
+
+      Jobs in progress are left as they are, and their end functions are not called.
+   */
+  void stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_ = false;
+    }
+    cond_.notify_all();
+    for(auto & thread : thread_list_)
+    {
+      thread.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_list_.clear();
+  }
+
+  /** \brief Get the number of tasks. */
+  inline int taskNum() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(task_list_.size());
+  }
+
+  /** \brief Get task name. */
+  inline std::string taskName(int task_idx) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return task_list_.at(task_idx)->name;
+  }
+
+  /** \brief Get statistics of task (copied under lock). */
+  inline Statistics statistics(int task_idx) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return task_list_.at(task_idx)->statistics;
+  }
+
+  /** \brief Get the last exception thrown in the functions of task (nullptr if none).
+
+      The exception can be rethrown by std::rethrow_exception(). It is reset at start().
+   */
+  inline std::exception_ptr lastException(int task_idx) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return task_list_.at(task_idx)->exception;
+  }
+
+protected:
+  /*! \brief State of job of task. */
+  enum class JobState
+  {
+    //! Not released
+    Idle = 0,
+
+    //! Released and not begun
+    Released,
+
+    //! Begun and not finished
+    Begun
+  };
+
+  /*! \brief Task. */
+  struct Task
+  {
+    //! Task name
+    std::string name;
+
+    //! Period of job release
+    Clock::duration period;
+
+    //! Relative deadline from release
+    Clock::duration deadline;
+
+    //! Function to begin solve
+    BeginFunc begin_func;
+
+    //! Function to process one step of solve
+    StepFunc step_func;
+
+    //! Function called at the end of job
+    EndFunc end_func;
+
+    //! State of current job
+    JobState state = JobState::Idle;
+
+    //! Whether a worker thread is processing the current job
+    bool busy = false;
+
+    //! Release time of current job
+    Clock::time_point release_time;
+
+    //! Absolute deadline of current job
+    Clock::time_point deadline_time;
+
+    //! Release time of next job
+    Clock::time_point next_release_time;
+
+    //! Statistics
+    Statistics statistics;
+
+    //! Last exception thrown in functions
+    std::exception_ptr exception;
+  };
+
+  /*! \brief Type of unit of work. */
+  enum class WorkType
+  {
+    //! Call begin function
+    Begin = 0,
+
+    //! Call step function
+    Step,
+
+    //! Abort job at deadline
+    Abort
+  };
+
+protected:
+  /** \brief Convert seconds to clock duration. */
+  static inline Clock::duration toDuration(double duration)
+  {
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration));
+  }
+
+  /** \brief Calculate duration in seconds. */
+  static inline double toSec(Clock::duration duration)
+  {
+    return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+  }
+
+  /** \brief Release jobs whose release time has come (called under lock).
+
+      If the previous job is still in progress, the release is postponed until the job ends.
+   */
+  void releaseJobs(Clock::time_point now)
+  {
+    for(auto & task : task_list_)
+    {
+      if(task->state == JobState::Idle && now >= task->next_release_time)
+      {
+        task->state = JobState::Released;
+        task->release_time = task->next_release_time;
+        task->deadline_time = task->release_time + task->deadline;
+        task->statistics.release_num++;
+        // Skip release times that have already passed so that missed periods are not released in a burst
+        do
+        {
+          task->next_release_time += task->period;
+        } while(task->next_release_time <= now);
+      }
+    }
+  }
+
+  /** \brief Worker thread loop. */
+  void run()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(running_)
+    {
+      auto now = Clock::now();
+      releaseJobs(now);
+
+      // Select job: expired jobs first, then the job with the earliest deadline
+      Task * selected_task = nullptr;
+      WorkType work_type = WorkType::Step;
+      Clock::time_point wakeup_time = Clock::time_point::max();
+      for(auto & task : task_list_)
+      {
+        if(task->state == JobState::Idle)
+        {
+          wakeup_time = std::min(wakeup_time, task->next_release_time);
+          continue;
+        }
+        if(task->busy)
+        {
+          continue;
+        }
+        if(now >= task->deadline_time)
+        {
+          selected_task = task.get();
+          work_type = WorkType::Abort;
+          break;
+        }
+        if(!selected_task || task->deadline_time < selected_task->deadline_time)
+        {
+          selected_task = task.get();
+          work_type = task->state == JobState::Released ? WorkType::Begin : WorkType::Step;
+        }
+      }
+      if(!selected_task)
+      {
+        if(wakeup_time == Clock::time_point::max())
+        {
+          cond_.wait(lock);
+        }
+        else
+        {
+          cond_.wait_until(lock, wakeup_time);
+        }
+        continue;
+      }
+
+      // Process unit of work without lock
+      selected_task->busy = true;
+      double release_t = toSec(selected_task->release_time - start_time_);
+      lock.unlock();
+      bool finished = false;
+      std::exception_ptr exception;
+      try
+      {
+        if(work_type == WorkType::Begin)
+        {
+          selected_task->begin_func(release_t);
+        }
+        else if(work_type == WorkType::Step)
+        {
+          finished = selected_task->step_func();
+        }
+      }
+      catch(...)
+      {
+        exception = std::current_exception();
+      }
+      auto end_time = Clock::now();
+
+      // Call end function under the busy flag so that no other worker accesses the solver
+      bool ended = exception || work_type == WorkType::Abort || finished;
+      if(ended)
+      {
+        try
+        {
+          selected_task->end_func(release_t, !exception && finished);
+        }
+        catch(...)
+        {
+          if(!exception)
+          {
+            exception = std::current_exception();
+          }
+        }
+      }
+      lock.lock();
+      selected_task->busy = false;
+
+      // Update job state
+      auto & statistics = selected_task->statistics;
+      if(work_type == WorkType::Begin)
+      {
+        selected_task->state = JobState::Begun;
+      }
+      else if(work_type == WorkType::Step)
+      {
+        statistics.step_num++;
+      }
+      if(exception)
+      {
+        selected_task->exception = exception;
+        statistics.error_num++;
+      }
+      else if(work_type == WorkType::Abort)
+      {
+        statistics.abort_num++;
+        if(selected_task->state == JobState::Released)
+        {
+          statistics.unstarted_abort_num++;
+        }
+      }
+      else if(finished)
+      {
+        double response_time = 1e3 * toSec(end_time - selected_task->release_time);
+        if(end_time <= selected_task->deadline_time)
+        {
+          statistics.complete_num++;
+        }
+        else
+        {
+          statistics.late_num++;
+        }
+        int finish_num = statistics.complete_num + statistics.late_num;
+        statistics.mean_response_time += (response_time - statistics.mean_response_time) / finish_num;
+        statistics.max_response_time = std::max(statistics.max_response_time, response_time);
+      }
+      if(ended)
+      {
+        selected_task->state = JobState::Idle;
+      }
+      cond_.notify_all();
+    }
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! Tasks
+  std::vector<std::unique_ptr<Task>> task_list_;
+
+  //! Worker threads
+  std::vector<std::thread> thread_list_;
+
+  //! Mutex of tasks
+  mutable std::mutex mutex_;
+
+  //! Condition variable to wake up workers
+  std::condition_variable cond_;
+
+  //! Whether workers are running
+  bool running_ = false;
+
+  //! Start time of scheduler
+  Clock::time_point start_time_;
+};
+} // namespace nmpc_ddp
@@ -0,0 +1,371 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace nmpc_ddp
+{
+/** \brief Fixed-capacity lock-free ring buffer of timestamped trace events.
+
+    Events (e.g., durations of derivative, backward, and forward passes) are pushed by solvers without allocation or
+    locking, and persist across solves until they are overwritten by newer events. The buffer can be exported in the
+    Chrome trace-event JSON format, which can be opened by chrome://tracing or Perfetto (https://ui.perfetto.dev).
+
+    Multiple threads can push events concurrently. snapshot() skips the events being overwritten. Each slot is a
+    seqlock whose payload is copied word by word with relaxed atomics, so that reading a slot being overwritten is not
+    a data race.
+ */
+class TraceRing
+{
+public:
+  /*! \brief Event type. */
+  enum class EventType : uint8_t
+  {
+    //! Event with duration
+    Complete = 0,
+
+    //! Event without duration
+    Instant = 1,
+
+    //! Counter value
+    Counter = 2
+  };
+
+  /*! \brief Trace event. */
+  struct Event
+  {
+    //! Category name (must have static storage duration, e.g., string literal)
+    const char * category = nullptr;
+
+    //! Event name (must have static storage duration, e.g., string literal)
+    const char * name = nullptr;
+
+    //! Event type
+    EventType type = EventType::Complete;
+
+    //! Thread index
+    uint32_t tid = 0;
+
+    //! Start time [nsec]
+    int64_t start_ns = 0;
+
+    //! Duration [nsec]
+    int64_t duration_ns = 0;
+
+    //! Index such as iteration or time step (-1 if not applicable)
+    int32_t index = -1;
+
+    //! Value such as KKT error (NaN if not applicable)
+    double value = std::numeric_limits<double>::quiet_NaN();
+  };
+
+public:
+  /** \brief Constructor.
+      \param capacity maximum number of events (rounded up to power of two)
+   */
+  TraceRing(size_t capacity = 1 << 16)
+  {
+    size_t rounded_capacity = 1;
+    while(rounded_capacity < capacity)
+    {
+      rounded_capacity <<= 1;
+    }
+    mask_ = rounded_capacity - 1;
+    slot_list_ = std::make_unique<Slot[]>(rounded_capacity);
+  }
+
+  /** \brief Get capacity. */
+  inline size_t capacity() const
+  {
+    return mask_ + 1;
+  }
+
+  /** \brief Get the total number of pushed events (including overwritten ones). */
+  inline uint64_t pushedNum() const
+  {
+    return head_.load(std::memory_order_acquire);
+  }
+
+  /** \brief Push event.
+      \param event trace event
+   */
+  void push(const Event & event)
+  {
+    uint64_t idx = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot & slot = slot_list_[idx & mask_];
+    slot.seq.store(2 * idx + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    Event event_with_tid = event;
+    event_with_tid.tid = threadIndex();
+    slot.store(event_with_tid);
+    slot.seq.store(2 * idx + 2, std::memory_order_release);
+  }
+
+  /** \brief Push event with duration.
+      \param category category name (must have static storage duration)
+      \param name event name (must have static storage duration)
+      \param start_time start time
+      \param end_time end time
+      \param index index such as iteration or time step
+      \param value value such as KKT error
+   */
+  template<class Clock, class Duration>
+  inline void pushComplete(const char * category,
+                           const char * name,
+                           const std::chrono::time_point<Clock, Duration> & start_time,
+                           const std::chrono::time_point<Clock, Duration> & end_time,
+                           int index = -1,
+                           double value = std::numeric_limits<double>::quiet_NaN())
+  {
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.type = EventType::Complete;
+    event.start_ns = toNsec(start_time);
+    event.duration_ns = toNsec(end_time) - event.start_ns;
+    event.index = index;
+    event.value = value;
+    push(event);
+  }
+
+  /** \brief Push event without duration.
+      \param category category name (must have static storage duration)
+      \param name event name (must have static storage duration)
+      \param time time
+      \param index index such as iteration or time step
+      \param value value such as residual
+   */
+  template<class Clock, class Duration>
+  inline void pushInstant(const char * category,
+                          const char * name,
+                          const std::chrono::time_point<Clock, Duration> & time,
+                          int index = -1,
+                          double value = std::numeric_limits<double>::quiet_NaN())
+  {
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.type = EventType::Instant;
+    event.start_ns = toNsec(time);
+    event.index = index;
+    event.value = value;
+    push(event);
+  }
+
+  /** \brief Push counter value.
+      \param category category name (must have static storage duration)
+      \param name counter name (must have static storage duration)
+      \param time time
+      \param value counter value
+   */
+  template<class Clock, class Duration>
+  inline void pushCounter(const char * category,
+                          const char * name,
+                          const std::chrono::time_point<Clock, Duration> & time,
+                          double value)
+  {
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.type = EventType::Counter;
+    event.start_ns = toNsec(time);
+    event.value = value;
+    push(event);
+  }
+
+  /** \brief Get events in the buffer in the order of push. */
+  std::vector<Event> snapshot() const
+  {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = (head > capacity() ? head - capacity() : 0);
+
+    std::vector<Event> event_list;
+    event_list.reserve(static_cast<size_t>(head - tail));
+    for(uint64_t idx = tail; idx < head; idx++)
+    {
+      const Slot & slot = slot_list_[idx & mask_];
+      uint64_t seq = slot.seq.load(std::memory_order_acquire);
+      if(seq != 2 * idx + 2)
+      {
+        continue;
+      }
+      Event event = slot.load();
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if(slot.seq.load(std::memory_order_relaxed) != seq)
+      {
+        continue;
+      }
+      event_list.push_back(event);
+    }
+    return event_list;
+  }
+
+  /** \brief Clear events.
+
+      \note This must not be called concurrently with push().
+   */
+  void clear()
+  {
+    for(size_t i = 0; i < capacity(); i++)
+    {
+      slot_list_[i].seq.store(0, std::memory_order_relaxed);
+    }
+    head_.store(0, std::memory_order_release);
+  }
+
+  /** \brief Export events in Chrome trace-event JSON format.
+      \param file_path path to output file
+
+      The file can be opened by chrome://tracing or Perfetto (https://ui.perfetto.dev).
+   */
+  void exportChromeTrace(const std::string & file_path) const
+  {
+    std::ofstream ofs(file_path);
+    if(!ofs)
+    {
+      throw std::runtime_error("[TraceRing] Failed to open file: " + file_path);
+    }
+
+    ofs << std::fixed << std::setprecision(3);
+    ofs << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for(const auto & event : snapshot())
+    {
+      ofs << (first ? "\n" : ",\n");
+      first = false;
+
+      // Time in Chrome trace-event format is in microseconds
+      ofs << "{\"cat\": \"" << (event.category ? event.category : "") << "\", \"name\": \""
+          << (event.name ? event.name : "") << "\", \"pid\": 0, \"tid\": " << event.tid
+          << ", \"ts\": " << 1e-3 * static_cast<double>(event.start_ns);
+      switch(event.type)
+      {
+        case EventType::Complete:
+          ofs << ", \"ph\": \"X\", \"dur\": " << 1e-3 * static_cast<double>(event.duration_ns);
+          break;
+        case EventType::Instant:
+          ofs << ", \"ph\": \"i\", \"s\": \"t\"";
+          break;
+        case EventType::Counter:
+          ofs << ", \"ph\": \"C\"";
+          break;
+      }
+
+      ofs << ", \"args\": {";
+      bool first_arg = true;
+      if(event.type == EventType::Counter)
+      {
+        ofs << "\"" << (event.name ? event.name : "value") << "\": " << jsonNumber(event.value);
+        first_arg = false;
+      }
+      else
+      {
+        if(event.index >= 0)
+        {
+          ofs << "\"index\": " << event.index;
+          first_arg = false;
+        }
+        if(!std::isnan(event.value))
+        {
+          ofs << (first_arg ? "" : ", ") << "\"value\": " << jsonNumber(event.value);
+        }
+      }
+      ofs << "}}";
+    }
+    ofs << "\n]}\n";
+  }
+
+protected:
+  /*! \brief Slot of ring buffer. */
+  struct Slot
+  {
+    static_assert(std::is_trivially_copyable<Event>::value, "Event must be trivially copyable.");
+
+    //! Number of words to store event
+    static constexpr size_t word_num = (sizeof(Event) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    /** \brief Store event with relaxed atomics. */
+    inline void store(const Event & event)
+    {
+      std::array<uint64_t, word_num> word_list = {};
+      std::memcpy(word_list.data(), &event, sizeof(Event));
+      for(size_t i = 0; i < word_num; i++)
+      {
+        event_word_list[i].store(word_list[i], std::memory_order_relaxed);
+      }
+    }
+
+    /** \brief Load event with relaxed atomics (the result is valid only if the sequence number is unchanged). */
+    inline Event load() const
+    {
+      std::array<uint64_t, word_num> word_list;
+      for(size_t i = 0; i < word_num; i++)
+      {
+        word_list[i] = event_word_list[i].load(std::memory_order_relaxed);
+      }
+      Event event;
+      std::memcpy(static_cast<void *>(&event), word_list.data(), sizeof(Event));
+      return event;
+    }
+
+    //! Sequence number (odd while writing, 2 * idx + 2 after writing event of index idx)
+    std::atomic<uint64_t> seq{0};
+
+    //! Trace event stored in words
+    std::array<std::atomic<uint64_t>, word_num> event_word_list = {};
+  };
+
+protected:
+  /** \brief Convert time point to nanoseconds since epoch of clock. */
+  template<class Clock, class Duration>
+  static inline int64_t toNsec(const std::chrono::time_point<Clock, Duration> & time)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+  }
+
+  /** \brief Get sequential index of calling thread. */
+  static inline uint32_t threadIndex()
+  {
+    static std::atomic<uint32_t> thread_num{0};
+    thread_local uint32_t thread_idx = thread_num.fetch_add(1, std::memory_order_relaxed);
+    return thread_idx;
+  }
+
+  /** \brief Convert value to JSON number (JSON does not support NaN and infinity). */
+  static inline std::string jsonNumber(double value)
+  {
+    if(!std::isfinite(value))
+    {
+      return "null";
+    }
+    std::ostringstream ss;
+    ss << std::setprecision(9) << value;
+    return ss.str();
+  }
+
+protected:
+  //! Ring buffer
+  std::unique_ptr<Slot[]> slot_list_;
+
+  //! Mask to calculate slot index (capacity - 1)
+  size_t mask_ = 0;
+
+  //! Index of next event
+  std::atomic<uint64_t> head_{0};
+};
+} // namespace nmpc_ddp
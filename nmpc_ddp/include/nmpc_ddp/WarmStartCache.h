@@ -0,0 +1,540 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nmpc_ddp/MpcRunner.h>
+
+namespace nmpc_ddp
+{
+/** \brief Header of file of WarmStartCache.
+
+    The file consists of this header followed by the features of all entries (capacity column-major vectors of
+    feature_dim), WarmStartCacheEntry of all entries, and the serialized warm-start data of all entries (capacity arrays
+    of max_data_size) as arrays of double. All offsets are aligned to 64 bytes.
+ */
+struct WarmStartCacheHeader
+{
+  //! Magic number to identify the layout
+  static constexpr uint64_t magic_number = 0x4e4d504357534331; // "NMPCWSC1"
+
+  //! Version of the layout (increment when the layout changes)
+  static constexpr uint32_t layout_version = 2;
+
+  //! Magic number (written last so that a partially initialized file is not loaded)
+  uint64_t magic;
+
+  //! Number of valid entries
+  uint64_t entry_num;
+
+  //! Number of uses (insertions and hits), which is used as the timestamp of entries
+  uint64_t use_count;
+
+  //! Layout version
+  uint32_t version;
+
+  //! Feature dimension
+  uint32_t feature_dim;
+
+  //! Maximum size of serialized warm-start data of each entry [number of double]
+  uint32_t max_data_size;
+
+  //! Maximum number of entries
+  uint32_t capacity;
+};
+
+/** \brief Metadata of each entry of WarmStartCache. */
+struct WarmStartCacheEntry
+{
+  //! Use count of the last insertion or hit (see WarmStartCacheHeader::use_count)
+  uint64_t last_use;
+
+  //! Size of serialized warm-start data [number of double]
+  uint64_t data_size;
+
+  //! Checksum of features and serialized warm-start data
+  uint64_t checksum;
+
+  //! Whether the entry is valid (cleared before the entry is written and set last)
+  uint64_t valid;
+};
+
+/** \brief Library of converged solutions to warm-start solver, persisted in a memory-mapped file.
+    \tparam Solver solver type (DDPSolver or nmpc_fmpc::FmpcSolver, see MpcRunnerAdapter)
+
+    Each entry stores the warm-start data of a converged solve (the input sequence for DDPSolver and all optimization
+    variables for nmpc_fmpc::FmpcSolver) keyed by a feature vector, which consists of the initial state followed by the
+    features of reference (e.g., target position). lookup() returns the warm-start data of the nearest entry in the
+    weighted Euclidean distance of features. Since the features of all entries are stored contiguously, the nearest
+    neighbor is searched exactly by a linear scan without any index to be rebuilt on insertion.
+
+    The entries are stored in the file given to the constructor, which is created if it does not exist. Since the file
+    is memory-mapped, the entries are persisted without explicit saving, and a new process opening the same file starts
+    with the entries of the previous processes. When the library is full, the least recently used entry is replaced.
+
+    Each entry is invalidated before it is written and validated after its checksum is written, so that an entry
+    partially written by a crashed process is ignored. An entry whose checksum or data turns out to be corrupted is
+    invalidated by lookup() and replaced first by insert().
+
+    \note The cache is not thread-safe, and the file must not be opened by multiple processes at the same time.
+ */
+template<class Solver>
+class WarmStartCache
+{
+public:
+  /** \brief Type of solver adapter. */
+  using Adapter = MpcRunnerAdapter<Solver>;
+
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename Adapter::StateDimVector;
+
+  /** \brief Type of warm-start data. */
+  using WarmStart = typename Adapter::WarmStart;
+
+  /** \brief Alignment of blocks in file [byte]. */
+  static constexpr size_t alignment = 64;
+
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Maximum distance of features for lookup() to return the nearest entry
+    double max_distance = std::numeric_limits<double>::infinity();
+
+    //! Distance of features within which insert() overwrites the nearest entry instead of adding a new one
+    double merge_distance = 0.0;
+
+    //! Weight of each element of features (all ones if empty)
+    Eigen::VectorXd feature_weight;
+  };
+
+public:
+  /** \brief Constructor.
+      \param file_path path to file of library (created if not exists)
+      \param feature_dim dimension of features (state dimension plus dimension of reference features)
+      \param max_data_size maximum size of serialized warm-start data of each entry [number of double]
+      \param capacity maximum number of entries
+
+      If the file exists, an exception is thrown when its layout version, dimension, or capacity is different.
+   */
+  WarmStartCache(const std::string & file_path, int feature_dim, int max_data_size, int capacity = 1000)
+  : file_path_(file_path)
+  {
+    if(feature_dim <= 0 || max_data_size <= 0 || capacity <= 0)
+    {
+      throw std::invalid_argument("[WarmStartCache] feature_dim, max_data_size, and capacity must be positive.");
+    }
+    feature_dim_ = feature_dim;
+    max_data_size_ = max_data_size;
+    capacity_ = capacity;
+    size_ = fileSize(feature_dim_, max_data_size_, capacity_);
+
+    fd_ = ::open(file_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if(fd_ < 0)
+    {
+      throw std::runtime_error("[WarmStartCache] Failed to open file " + file_path + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if(::fstat(fd_, &st) != 0)
+    {
+      closeWithError("Failed to stat file " + file_path + ": " + std::strerror(errno));
+    }
+    bool initialize = (st.st_size == 0);
+    if(initialize)
+    {
+      if(::ftruncate(fd_, static_cast<off_t>(size_)) != 0)
+      {
+        closeWithError("Failed to resize file " + file_path + ": " + std::strerror(errno));
+      }
+    }
+    else if(static_cast<size_t>(st.st_size) != size_)
+    {
+      closeWithError("Size of file " + file_path + " is " + std::to_string(st.st_size) + " while "
+                     + std::to_string(size_) + " is expected.");
+    }
+
+    void * addr = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if(addr == MAP_FAILED)
+    {
+      closeWithError("Failed to map file " + file_path + ": " + std::strerror(errno));
+    }
+    data_ = static_cast<char *>(addr);
+
+    if(initialize)
+    {
+      header_ = new(data_) WarmStartCacheHeader;
+      header_->entry_num = 0;
+      header_->use_count = 0;
+      header_->version = WarmStartCacheHeader::layout_version;
+      header_->feature_dim = static_cast<uint32_t>(feature_dim_);
+      header_->max_data_size = static_cast<uint32_t>(max_data_size_);
+      header_->capacity = static_cast<uint32_t>(capacity_);
+      header_->magic = WarmStartCacheHeader::magic_number;
+    }
+    else
+    {
+      header_ = reinterpret_cast<WarmStartCacheHeader *>(data_);
+      if(header_->magic != WarmStartCacheHeader::magic_number)
+      {
+        closeWithError("File " + file_path + " is not a warm-start cache.");
+      }
+      if(header_->version != WarmStartCacheHeader::layout_version)
+      {
+        closeWithError("Layout version mismatch: " + std::to_string(header_->version)
+                       + " != " + std::to_string(WarmStartCacheHeader::layout_version));
+      }
+      if(static_cast<int>(header_->feature_dim) != feature_dim_
+         || static_cast<int>(header_->max_data_size) != max_data_size_
+         || static_cast<int>(header_->capacity) != capacity_ || header_->entry_num > header_->capacity)
+      {
+        closeWithError("Dimension mismatch. feature_dim: " + std::to_string(header_->feature_dim) + ", max_data_size: "
+                       + std::to_string(header_->max_data_size) + ", capacity: " + std::to_string(header_->capacity));
+      }
+    }
+
+    feature_ptr_ = reinterpret_cast<double *>(data_ + align(sizeof(WarmStartCacheHeader)));
+    entry_ptr_ = reinterpret_cast<WarmStartCacheEntry *>(reinterpret_cast<char *>(feature_ptr_)
+                                                         + align(sizeof(double) * feature_dim_ * capacity_));
+    warm_start_data_ptr_ = reinterpret_cast<double *>(reinterpret_cast<char *>(entry_ptr_)
+                                                      + align(sizeof(WarmStartCacheEntry) * capacity_));
+
+    feature_ = Eigen::VectorXd::Zero(feature_dim_);
+    serialized_data_.reserve(max_data_size_);
+  }
+
+  /** \brief Destructor. */
+  ~WarmStartCache()
+  {
+    if(data_)
+    {
+      ::munmap(data_, size_);
+    }
+    if(fd_ >= 0)
+    {
+      ::close(fd_);
+    }
+  }
+
+  WarmStartCache(const WarmStartCache &) = delete;
+  WarmStartCache & operator=(const WarmStartCache &) = delete;
+
+  /** \brief Calculate file size [byte]. */
+  static constexpr size_t fileSize(size_t feature_dim, size_t max_data_size, size_t capacity)
+  {
+    return align(sizeof(WarmStartCacheHeader)) + align(sizeof(double) * feature_dim * capacity)
+           + align(sizeof(WarmStartCacheEntry) * capacity) + sizeof(double) * max_data_size * capacity;
+  }
+
+  /** \brief Accessor to configuration. */
+  inline Configuration & config()
+  {
+    return config_;
+  }
+
+  /** \brief Look up warm-start data of the nearest entry.
+      \param x initial state
+      \param ref_features features of reference
+      \param warm_start warm-start data overwritten if found (unchanged otherwise)
+      \return whether an entry within Configuration::max_distance is found
+
+      If the nearest entry is corrupted, it is invalidated and false is returned.
+   */
+  bool lookup(const StateDimVector & x, const Eigen::VectorXd & ref_features, WarmStart & warm_start)
+  {
+    setFeature(x, ref_features);
+    double distance = 0;
+    int idx = findNearest(distance);
+    if(idx < 0 || distance > config_.max_distance)
+    {
+      miss_num_++;
+      return false;
+    }
+
+    WarmStartCacheEntry & entry = entry_ptr_[idx];
+    const double * data = warm_start_data_ptr_ + static_cast<size_t>(idx) * max_data_size_;
+    if(entry.data_size > static_cast<uint64_t>(max_data_size_) || entry.checksum != checksum(idx, entry.data_size)
+       || !Adapter::deserialize(data, static_cast<size_t>(entry.data_size), scratch_warm_start_))
+    {
+      entry.valid = 0;
+      corrupted_num_++;
+      miss_num_++;
+      return false;
+    }
+    // Swap instead of copy so that the memory of both is reused in the next lookup
+    std::swap(warm_start, scratch_warm_start_);
+    entry.last_use = ++header_->use_count;
+    hit_num_++;
+    return true;
+  }
+
+  /** \brief Insert warm-start data (e.g., converged solution).
+      \param x initial state
+      \param ref_features features of reference
+      \param warm_start warm-start data
+
+      If an entry exists within Configuration::merge_distance, it is overwritten. Otherwise, a new entry is added, or
+      the least recently used entry is replaced if the library is full.
+   */
+  void insert(const StateDimVector & x, const Eigen::VectorXd & ref_features, const WarmStart & warm_start)
+  {
+    serialized_data_.clear();
+    Adapter::serialize(warm_start, serialized_data_);
+    if(static_cast<int>(serialized_data_.size()) > max_data_size_)
+    {
+      throw std::invalid_argument("[WarmStartCache] Size of serialized warm-start data exceeds max_data_size: "
+                                  + std::to_string(serialized_data_.size()) + " > " + std::to_string(max_data_size_));
+    }
+
+    setFeature(x, ref_features);
+    double distance = 0;
+    int idx = findNearest(distance);
+    if(idx < 0 || distance > config_.merge_distance)
+    {
+      if(static_cast<int>(header_->entry_num) < capacity_)
+      {
+        idx = static_cast<int>(header_->entry_num);
+      }
+      else
+      {
+        idx = 0;
+        for(int i = 0; i < capacity_; i++)
+        {
+          // Invalid entries are replaced first
+          if(!entry_ptr_[i].valid)
+          {
+            idx = i;
+            break;
+          }
+          if(entry_ptr_[i].last_use < entry_ptr_[idx].last_use)
+          {
+            idx = i;
+          }
+        }
+      }
+    }
+
+    // The order of writes is kept by the fences so that an interrupted write leaves the entry invalid
+    WarmStartCacheEntry & entry = entry_ptr_[idx];
+    entry.valid = 0;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    Eigen::Map<Eigen::VectorXd>(feature_ptr_ + static_cast<size_t>(idx) * feature_dim_, feature_dim_) = feature_;
+    std::memcpy(warm_start_data_ptr_ + static_cast<size_t>(idx) * max_data_size_, serialized_data_.data(),
+                sizeof(double) * serialized_data_.size());
+    entry.data_size = serialized_data_.size();
+    entry.checksum = checksum(idx, entry.data_size);
+    entry.last_use = ++header_->use_count;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    entry.valid = 1;
+    if(idx == static_cast<int>(header_->entry_num))
+    {
+      // Count the entry after it is written
+      header_->entry_num++;
+    }
+  }
+
+  /** \brief Remove all entries. */
+  inline void clear()
+  {
+    header_->entry_num = 0;
+  }
+
+  /** \brief Flush mapped memory to file asynchronously. */
+  inline void flush()
+  {
+    ::msync(data_, size_, MS_ASYNC);
+  }
+
+  /** \brief Get number of entries. */
+  inline int size() const
+  {
+    return static_cast<int>(header_->entry_num);
+  }
+
+  /** \brief Get maximum number of entries. */
+  inline int capacity() const
+  {
+    return capacity_;
+  }
+
+  /** \brief Get number of lookups that found an entry since construction. */
+  inline int hitNum() const
+  {
+    return hit_num_;
+  }
+
+  /** \brief Get number of lookups that found no entry since construction. */
+  inline int missNum() const
+  {
+    return miss_num_;
+  }
+
+  /** \brief Get number of entries found corrupted (and invalidated) by lookup() since construction. */
+  inline int corruptedNum() const
+  {
+    return corrupted_num_;
+  }
+
+  /** \brief Get file path. */
+  inline const std::string & filePath() const
+  {
+    return file_path_;
+  }
+
+protected:
+  /** \brief Round up size to alignment. */
+  static constexpr size_t align(size_t size)
+  {
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  /** \brief Unmap and close file, and throw exception. */
+  [[noreturn]] void closeWithError(const std::string & message)
+  {
+    if(data_)
+    {
+      ::munmap(data_, size_);
+      data_ = nullptr;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    throw std::runtime_error("[WarmStartCache] " + message);
+  }
+
+  /** \brief Set features from state and features of reference. */
+  void setFeature(const StateDimVector & x, const Eigen::VectorXd & ref_features)
+  {
+    if(x.size() + ref_features.size() != feature_dim_)
+    {
+      throw std::invalid_argument("[WarmStartCache] Invalid dimension of features: " + std::to_string(x.size()) + " + "
+                                  + std::to_string(ref_features.size()) + " != " + std::to_string(feature_dim_));
+    }
+    if(config_.feature_weight.size() > 0 && config_.feature_weight.size() != feature_dim_)
+    {
+      throw std::invalid_argument("[WarmStartCache] Invalid dimension of feature_weight: "
+                                  + std::to_string(config_.feature_weight.size()));
+    }
+    feature_.head(x.size()) = x;
+    feature_.tail(ref_features.size()) = ref_features;
+  }
+
+  /** \brief Find the entry nearest to the current features.
+      \param distance weighted distance to the nearest entry
+      \return index of the nearest entry (-1 if no entry exists)
+   */
+  int findNearest(double & distance) const
+  {
+    int nearest_idx = -1;
+    double min_squared_distance = std::numeric_limits<double>::infinity();
+    int entry_num = static_cast<int>(header_->entry_num);
+    bool weighted = (config_.feature_weight.size() > 0);
+    for(int i = 0; i < entry_num; i++)
+    {
+      if(!entry_ptr_[i].valid)
+      {
+        continue;
+      }
+      Eigen::Map<const Eigen::VectorXd> feature(feature_ptr_ + static_cast<size_t>(i) * feature_dim_, feature_dim_);
+      double squared_distance = weighted ? (feature - feature_).cwiseProduct(config_.feature_weight).squaredNorm()
+                                         : (feature - feature_).squaredNorm();
+      if(squared_distance < min_squared_distance)
+      {
+        min_squared_distance = squared_distance;
+        nearest_idx = i;
+      }
+    }
+    distance = std::sqrt(min_squared_distance);
+    return nearest_idx;
+  }
+
+  /** \brief Calculate checksum (64-bit FNV-1a) of features and serialized warm-start data of entry.
+      \param idx entry index
+      \param data_size size of serialized warm-start data [number of double]
+   */
+  uint64_t checksum(int idx, uint64_t data_size) const
+  {
+    uint64_t hash = 0xcbf29ce484222325;
+    auto update = [&hash](const void * ptr, size_t size)
+    {
+      const unsigned char * bytes = static_cast<const unsigned char *>(ptr);
+      for(size_t i = 0; i < size; i++)
+      {
+        hash = (hash ^ bytes[i]) * 0x100000001b3;
+      }
+    };
+    update(&data_size, sizeof(data_size));
+    update(feature_ptr_ + static_cast<size_t>(idx) * feature_dim_, sizeof(double) * feature_dim_);
+    update(warm_start_data_ptr_ + static_cast<size_t>(idx) * max_data_size_, sizeof(double) * data_size);
+    return hash;
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! File path
+  std::string file_path_;
+
+  //! Feature dimension
+  int feature_dim_ = 0;
+
+  //! Maximum size of serialized warm-start data of each entry [number of double]
+  int max_data_size_ = 0;
+
+  //! Maximum number of entries
+  int capacity_ = 0;
+
+  //! File descriptor
+  int fd_ = -1;
+
+  //! Mapped memory
+  char * data_ = nullptr;
+
+  //! Size of mapped memory [byte]
+  size_t size_ = 0;
+
+  //! Header in mapped memory
+  WarmStartCacheHeader * header_ = nullptr;
+
+  //! Features of entries in mapped memory
+  double * feature_ptr_ = nullptr;
+
+  //! Metadata of entries in mapped memory
+  WarmStartCacheEntry * entry_ptr_ = nullptr;
+
+  //! Serialized warm-start data of entries in mapped memory
+  double * warm_start_data_ptr_ = nullptr;
+
+  //! Features of the current lookup or insertion
+  Eigen::VectorXd feature_;
+
+  //! Buffer of serialized warm-start data
+  std::vector<double> serialized_data_;
+
+  //! Warm-start data deserialized by lookup() (swapped into the output only if deserialization succeeds)
+  WarmStart scratch_warm_start_;
+
+  //! Number of lookups that found an entry
+  int hit_num_ = 0;
+
+  //! Number of lookups that found no entry
+  int miss_num_ = 0;
+
+  //! Number of entries found corrupted by lookup()
+  int corrupted_num_ = 0;
+};
+} // namespace nmpc_ddp
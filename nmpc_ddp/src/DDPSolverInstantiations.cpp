@@ -0,0 +1,15 @@
+/* Author: Masaki Murooka */
+
+#include <nmpc_ddp/DDPSolver.h>
+
+// The instantiations must be consistent with the extern template declarations in DDPSolver.hpp
+namespace nmpc_ddp
+{
+template class DDPSolver<2, 1>;
+template class DDPSolver<4, 1>;
+template class DDPSolver<6, 3>;
+template class DDPSolver<2, Eigen::Dynamic>;
+template class DDPSolver<4, Eigen::Dynamic>;
+template class DDPSolver<9, Eigen::Dynamic>;
+template class DDPSolver<Eigen::Dynamic, Eigen::Dynamic>;
+} // namespace nmpc_ddp
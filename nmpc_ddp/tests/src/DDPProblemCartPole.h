@@ -0,0 +1,227 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <cmath>
+#include <functional>
+
+#include <nmpc_ddp/DDPProblem.h>
+
+namespace Eigen
+{
+using Vector1d = Eigen::Matrix<double, 1, 1>;
+}
+
+/** \brief DDP problem for cart-pole.
+
+    State is [pos, theta, vel, omega]. Input is [force].
+    Running cost is sum of the respective quadratic terms of state and input.
+    Terminal cost is quadratic term of state.
+ */
+class DDPProblemCartPole : public nmpc_ddp::DDPProblem<4, 1>
+{
+public:
+  struct Param
+  {
+    Param() {}
+
+    double cart_mass = 1.0; // [kg]
+    double pole_mass = 0.5; // [kg]
+    double pole_length = 2.0; // [m]
+  };
+
+  struct CostWeight
+  {
+    CostWeight()
+    {
+      running_x << 0.1, 1.0, 0.01, 0.1;
+      running_u << 0.001;
+      terminal_x << 0.1, 1.0, 0.01, 0.1;
+    }
+
+    StateDimVector running_x;
+    InputDimVector running_u;
+    StateDimVector terminal_x;
+  };
+
+public:
+  DDPProblemCartPole(double dt,
+                     const std::function<double(double)> & ref_pos_func,
+                     const Param & param = Param(),
+                     const CostWeight & cost_weight = CostWeight())
+  : DDPProblem(dt), ref_pos_func_(ref_pos_func), param_(param), cost_weight_(cost_weight)
+  {
+  }
+
+  virtual StateDimVector stateEq(double t, const StateDimVector & x, const InputDimVector & u) const override
+  {
+    return stateEq(t, x, u, dt_);
+  }
+
+  virtual StateDimVector stateEq(double, // t
+                                 const StateDimVector & x,
+                                 const InputDimVector & u,
+                                 double dt) const
+  {
+    // double pos = x[0];
+    double theta = x[1];
+    double vel = x[2];
+    double omega = x[3];
+    double f = u[0];
+
+    double m1 = param_.cart_mass;
+    double m2 = param_.pole_mass;
+    double l = param_.pole_length;
+
+    double sin_theta = std::sin(theta);
+    double cos_theta = std::cos(theta);
+    double omega2 = std::pow(omega, 2);
+    double denom = m1 + m2 * std::pow(sin_theta, 2);
+
+    StateDimVector x_dot;
+    // clang-format off
+    x_dot[0] = vel;
+    x_dot[1] = omega;
+    x_dot[2] = (f - m2 * l * omega2 * sin_theta + m2 * g_ * sin_theta * cos_theta) / denom;
+    x_dot[3] = (f * cos_theta - m2 * l * omega2 * sin_theta * cos_theta
+                + g_ * (m1 + m2) * sin_theta) / (l * denom);
+    // clang-format on
+
+    return x + dt * x_dot;
+  }
+
+  virtual double runningCost(double t, const StateDimVector & x, const InputDimVector & u) const override
+  {
+    StateDimVector ref_x;
+    ref_x << ref_pos_func_(t), 0, 0, 0;
+    return 0.5 * cost_weight_.running_x.dot((x - ref_x).cwiseAbs2()) + 0.5 * cost_weight_.running_u.dot(u.cwiseAbs2());
+  }
+
+  virtual double terminalCost(double t, const StateDimVector & x) const override
+  {
+    StateDimVector ref_x;
+    ref_x << ref_pos_func_(t), 0, 0, 0;
+    return 0.5 * cost_weight_.terminal_x.dot((x - ref_x).cwiseAbs2());
+  }
+
+  virtual void calcStateEqDeriv(double, // t
+                                const StateDimVector & x,
+                                const InputDimVector & u,
+                                Eigen::Ref<StateStateDimMatrix> state_eq_deriv_x,
+                                Eigen::Ref<StateInputDimMatrix> state_eq_deriv_u) const override
+  {
+    // double pos = x[0];
+    double theta = x[1];
+    // double vel = x[2];
+    double omega = x[3];
+    double f = u[0];
+
+    double m1 = param_.cart_mass;
+    double m2 = param_.pole_mass;
+    double l = param_.pole_length;
+
+    double sin_theta = std::sin(theta);
+    double cos_theta = std::cos(theta);
+    double omega2 = std::pow(omega, 2);
+    double denom = m1 + m2 * std::pow(sin_theta, 2);
+
+    state_eq_deriv_x.setZero();
+    // clang-format off
+    state_eq_deriv_x(0, 2) = 1;
+    state_eq_deriv_x(1, 3) = 1;
+    state_eq_deriv_x(2, 1) = ((-1 * m2 * l * omega2 * cos_theta
+                               + m2 * g_ * (1 - 2 * std::pow(sin_theta, 2))) * denom
+                              + -1 * (f - m2 * l * omega2 * sin_theta + m2 * g_ * sin_theta * cos_theta)
+                              * (2 * m2 * sin_theta * cos_theta))
+        / std::pow(denom, 2);
+    state_eq_deriv_x(2, 3) = (-2 * m2 * l * omega * sin_theta) / denom;
+    state_eq_deriv_x(3, 1) = ((-1 * f * sin_theta + -1 * m2 * l * omega2 * (1 - 2 * std::pow(sin_theta, 2))
+                               + g_ * (m1 + m2) * cos_theta) * denom
+                              + -1 * (f * cos_theta - m2 * l * omega2 * sin_theta * cos_theta
+                                      + g_ * (m1 + m2) * sin_theta) * (2 * m2 * sin_theta * cos_theta))
+        / (l * std::pow(denom, 2));
+    state_eq_deriv_x(3, 3) = (-2 * m2 * l * omega * sin_theta * cos_theta) / (l * denom);
+    // clang-format on
+    state_eq_deriv_x *= dt_;
+    state_eq_deriv_x.diagonal().array() += 1.0;
+
+    state_eq_deriv_u.setZero();
+    state_eq_deriv_u[2] = 1 / denom;
+    state_eq_deriv_u[3] = cos_theta / (l * denom);
+    state_eq_deriv_u *= dt_;
+  }
+
+  virtual void calcStateEqDeriv(double, // t
+                                const StateDimVector &, // x
+                                const InputDimVector &, // u
+                                Eigen::Ref<StateStateDimMatrix>, // state_eq_deriv_x
+                                Eigen::Ref<StateInputDimMatrix>, // state_eq_deriv_u
+                                std::vector<StateStateDimMatrix> &, // state_eq_deriv_xx
+                                std::vector<InputInputDimMatrix> &, // state_eq_deriv_uu
+                                std::vector<StateInputDimMatrix> & // state_eq_deriv_xu
+  ) const override
+  {
+    throw std::runtime_error("Second-order derivatives of state equation are not implemented.");
+  }
+
+  virtual void calcRunningCostDeriv(double t,
+                                    const StateDimVector & x,
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u) const override
+  {
+    StateDimVector ref_x;
+    ref_x << ref_pos_func_(t), 0, 0, 0;
+
+    running_cost_deriv_x = cost_weight_.running_x.cwiseProduct(x - ref_x);
+    running_cost_deriv_u = cost_weight_.running_u.cwiseProduct(u);
+  }
+
+  virtual void calcRunningCostDeriv(double t,
+                                    const StateDimVector & x,
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u,
+                                    Eigen::Ref<StateStateDimMatrix> running_cost_deriv_xx,
+                                    Eigen::Ref<InputInputDimMatrix> running_cost_deriv_uu,
+                                    Eigen::Ref<StateInputDimMatrix> running_cost_deriv_xu) const override
+  {
+    StateDimVector ref_x;
+    ref_x << ref_pos_func_(t), 0, 0, 0;
+
+    running_cost_deriv_x = cost_weight_.running_x.cwiseProduct(x - ref_x);
+    running_cost_deriv_u = cost_weight_.running_u.cwiseProduct(u);
+
+    running_cost_deriv_xx = cost_weight_.running_x.asDiagonal();
+    running_cost_deriv_uu = cost_weight_.running_u.asDiagonal();
+    running_cost_deriv_xu.setZero();
+  }
+
+  virtual void calcTerminalCostDeriv(double t,
+                                     const StateDimVector & x,
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x) const override
+  {
+    StateDimVector ref_x;
+    ref_x << ref_pos_func_(t), 0, 0, 0;
+
+    terminal_cost_deriv_x = cost_weight_.terminal_x.cwiseProduct(x - ref_x);
+  }
+
+  virtual void calcTerminalCostDeriv(double t,
+                                     const StateDimVector & x,
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x,
+                                     Eigen::Ref<StateStateDimMatrix> terminal_cost_deriv_xx) const override
+  {
+    StateDimVector ref_x;
+    ref_x << ref_pos_func_(t), 0, 0, 0;
+
+    terminal_cost_deriv_x = cost_weight_.terminal_x.cwiseProduct(x - ref_x);
+    terminal_cost_deriv_xx = cost_weight_.terminal_x.asDiagonal();
+  }
+
+public:
+  static constexpr double g_ = 9.80665; // [m/s^2]
+  std::function<double(double)> ref_pos_func_;
+  Param param_;
+  CostWeight cost_weight_;
+};
@@ -0,0 +1,496 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nmpc_ddp
+{
+/** \brief Performance regression checker.
+
+    This is a helper of the performance regression tests (it is not installed). It is also used by the tests of
+    nmpc_fmpc.
+
+    Benchmark results (per-phase durations and iteration counts) are collected over repeated runs, and their medians
+    are compared with a baseline JSON file stored in the repository. The result is written in the same JSON format as
+    the baseline so that it can be compared across commits or copied over the baseline.
+
+    The following environment variables override the configuration:
+      - NMPC_PERF_BASELINE_DIR: directory of baseline files
+      - NMPC_PERF_RESULT_DIR: directory of result files
+      - NMPC_PERF_REPEAT: number of repeated runs
+      - NMPC_PERF_DURATION_REL_TOL: relative tolerance of duration
+      - NMPC_PERF_UPDATE_BASELINE: overwrite the baseline file with the result if set to 1
+ */
+class PerfRegression
+{
+public:
+  /*! \brief Metric type. */
+  enum class MetricType
+  {
+    //! Duration [msec] (regression if larger than baseline)
+    Duration = 0,
+
+    //! Count such as iteration number (regression if larger than baseline)
+    Count = 1
+  };
+
+  /*! \brief Configuration. */
+  struct Configuration
+  {
+    //! Print level (0: no print, 1: print only important, 2: print verbose, 3: print very verbose)
+    int print_level = 1;
+
+    //! Number of repeated runs (a warm-up run is processed in addition)
+    int repeat_num = 7;
+
+    //! Relative tolerance of duration (e.g., 1.0 allows the median to be twice the baseline)
+    double duration_rel_tol = 1.0;
+
+    //! Absolute tolerance of duration [msec] (to ignore noise of short phases)
+    double duration_abs_tol = 0.1;
+
+    //! Relative tolerance of count
+    double count_rel_tol = 0.1;
+
+    //! Absolute tolerance of count
+    double count_abs_tol = 1.0;
+
+    //! Directory of baseline files
+    std::string baseline_dir;
+
+    //! Directory of result files
+    std::string result_dir = "/tmp";
+
+    //! Whether to overwrite the baseline file with the result
+    bool update_baseline = false;
+  };
+
+  /*! \brief Metric. */
+  struct Metric
+  {
+    //! Metric type
+    MetricType type = MetricType::Duration;
+
+    //! List of sampled value
+    std::vector<double> sample_list;
+
+    /** \brief Calculate median of samples. */
+    double median() const
+    {
+      if(sample_list.empty())
+      {
+        return 0;
+      }
+      std::vector<double> sorted_sample_list = sample_list;
+      std::sort(sorted_sample_list.begin(), sorted_sample_list.end());
+      size_t n = sorted_sample_list.size();
+      if(n % 2 == 1)
+      {
+        return sorted_sample_list[n / 2];
+      }
+      return 0.5 * (sorted_sample_list[n / 2 - 1] + sorted_sample_list[n / 2]);
+    }
+
+    /** \brief Calculate minimum of samples. */
+    double min() const
+    {
+      return sample_list.empty() ? 0 : *std::min_element(sample_list.begin(), sample_list.end());
+    }
+
+    /** \brief Calculate maximum of samples. */
+    double max() const
+    {
+      return sample_list.empty() ? 0 : *std::max_element(sample_list.begin(), sample_list.end());
+    }
+  };
+
+public:
+  /** \brief Constructor.
+      \param name benchmark name (used for the file names of baseline and result)
+      \param baseline_dir directory of baseline files
+   */
+  PerfRegression(const std::string & name, const std::string & baseline_dir) : name_(name)
+  {
+    config_.baseline_dir = baseline_dir;
+
+    // Override configuration by environment variables
+    if(const char * env = std::getenv("NMPC_PERF_BASELINE_DIR"))
+    {
+      config_.baseline_dir = env;
+    }
+    if(const char * env = std::getenv("NMPC_PERF_RESULT_DIR"))
+    {
+      config_.result_dir = env;
+    }
+    if(const char * env = std::getenv("NMPC_PERF_REPEAT"))
+    {
+      config_.repeat_num = std::max(std::atoi(env), 1);
+    }
+    if(const char * env = std::getenv("NMPC_PERF_DURATION_REL_TOL"))
+    {
+      config_.duration_rel_tol = std::atof(env);
+    }
+    if(const char * env = std::getenv("NMPC_PERF_UPDATE_BASELINE"))
+    {
+      config_.update_baseline = (std::string(env) == "1");
+    }
+  }
+
+  /** \brief Accessor to configuration. */
+  inline Configuration & config()
+  {
+    return config_;
+  }
+
+  /** \brief Const accessor to configuration. */
+  inline const Configuration & config() const
+  {
+    return config_;
+  }
+
+  /** \brief Const accessor to metrics. */
+  inline const std::map<std::string, Metric> & metrics() const
+  {
+    return metric_map_;
+  }
+
+  /** \brief Path to baseline file. */
+  inline std::string baselinePath() const
+  {
+    return config_.baseline_dir + "/" + name_ + ".json";
+  }
+
+  /** \brief Path to result file. */
+  inline std::string resultPath() const
+  {
+    return config_.result_dir + "/" + name_ + ".json";
+  }
+
+  /** \brief Run benchmark repeatedly.
+      \param func benchmark function, which is expected to call addDuration and addCount
+
+      The first run is regarded as warm-up, and the values added in it are discarded.
+   */
+  void run(const std::function<void()> & func)
+  {
+    metric_map_.clear();
+
+    recording_ = false;
+    func();
+
+    recording_ = true;
+    for(int i = 0; i < config_.repeat_num; i++)
+    {
+      func();
+    }
+    recording_ = false;
+  }
+
+  /** \brief Add duration sample.
+      \param key metric key
+      \param duration duration [msec]
+   */
+  inline void addDuration(const std::string & key, double duration)
+  {
+    addSample(key, MetricType::Duration, duration);
+  }
+
+  /** \brief Add count sample.
+      \param key metric key
+      \param count count
+   */
+  inline void addCount(const std::string & key, double count)
+  {
+    addSample(key, MetricType::Count, count);
+  }
+
+  /** \brief Compare medians with baseline and write result.
+      \return list of failure messages (empty if no regression is detected)
+
+      If the baseline file or a metric in it does not exist, the metric is not checked.
+   */
+  std::vector<std::string> check() const
+  {
+    std::vector<std::string> failure_list;
+
+    // Load baseline
+    std::map<std::string, double> baseline_map;
+    std::ifstream ifs(baselinePath());
+    if(ifs)
+    {
+      std::stringstream ss;
+      ss << ifs.rdbuf();
+      baseline_map = parseJson(ss.str());
+    }
+    else if(config_.print_level >= 1)
+    {
+      std::cout << "[PerfRegression] Baseline file not found: " << baselinePath() << std::endl;
+    }
+
+    // Compare with baseline
+    for(const auto & metric_kv : metric_map_)
+    {
+      const std::string & key = metric_kv.first;
+      const Metric & metric = metric_kv.second;
+      double median = metric.median();
+
+      auto baseline_it = baseline_map.find("metrics." + key + ".median");
+      if(baseline_it == baseline_map.end())
+      {
+        if(config_.print_level >= 2)
+        {
+          std::cout << "[PerfRegression] " << key << ": " << median << " (no baseline)" << std::endl;
+        }
+        continue;
+      }
+      double baseline = baseline_it->second;
+
+      double thre;
+      if(metric.type == MetricType::Duration)
+      {
+        thre = (1.0 + config_.duration_rel_tol) * baseline + config_.duration_abs_tol;
+      }
+      else
+      {
+        thre = (1.0 + config_.count_rel_tol) * baseline + config_.count_abs_tol;
+      }
+
+      bool failed = median > thre;
+      if(failed)
+      {
+        std::stringstream ss;
+        ss << name_ << ": " << key << " regressed (median: " << median << ", baseline: " << baseline
+           << ", threshold: " << thre << ")";
+        failure_list.push_back(ss.str());
+      }
+      if(config_.print_level >= 1)
+      {
+        std::cout << "[PerfRegression] " << key << ": " << median << " (baseline: " << baseline
+                  << ", ratio: " << median / std::max(baseline, 1e-10) << ")" << (failed ? " [REGRESSED]" : "")
+                  << std::endl;
+      }
+    }
+
+    // Write result
+    writeJson(resultPath());
+    if(config_.print_level >= 1)
+    {
+      std::cout << "[PerfRegression] Result is written to " << resultPath() << std::endl;
+    }
+    if(config_.update_baseline)
+    {
+      writeJson(baselinePath());
+      if(config_.print_level >= 1)
+      {
+        std::cout << "[PerfRegression] Baseline is updated: " << baselinePath() << std::endl;
+      }
+    }
+
+    return failure_list;
+  }
+
+  /** \brief Write result in JSON.
+      \param file_path path to output file
+   */
+  void writeJson(const std::string & file_path) const
+  {
+    std::ofstream ofs(file_path);
+    if(!ofs)
+    {
+      throw std::runtime_error("[PerfRegression] Failed to open file: " + file_path);
+    }
+
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    char time_str[32];
+    std::strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    ofs << std::setprecision(6);
+    ofs << "{\n";
+    ofs << "  \"name\": \"" << name_ << "\",\n";
+    ofs << "  \"time\": \"" << time_str << "\",\n";
+    ofs << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+    ofs << "  \"repeat_num\": " << config_.repeat_num << ",\n";
+    ofs << "  \"metrics\": {";
+    bool first = true;
+    for(const auto & metric_kv : metric_map_)
+    {
+      const Metric & metric = metric_kv.second;
+      ofs << (first ? "\n" : ",\n");
+      first = false;
+      ofs << "    \"" << metric_kv.first << "\": {\"type\": \""
+          << (metric.type == MetricType::Duration ? "duration" : "count") << "\", \"median\": " << metric.median()
+          << ", \"min\": " << metric.min() << ", \"max\": " << metric.max() << ", \"samples\": [";
+      for(size_t i = 0; i < metric.sample_list.size(); i++)
+      {
+        ofs << (i == 0 ? "" : ", ") << metric.sample_list[i];
+      }
+      ofs << "]}";
+    }
+    ofs << "\n  }\n";
+    ofs << "}\n";
+  }
+
+  /** \brief Parse JSON and flatten numeric values.
+      \param str JSON string
+      \return map from dot-separated key (e.g., "metrics.solve.median") to numeric value
+
+      Only the subset of JSON written by writeJson is supported. Strings and booleans are skipped, and array elements
+      are keyed by their indices.
+   */
+  static std::map<std::string, double> parseJson(const std::string & str)
+  {
+    std::map<std::string, double> value_map;
+    size_t pos = 0;
+    parseJsonValue(str, pos, "", value_map);
+    return value_map;
+  }
+
+protected:
+  /** \brief Add sample. */
+  void addSample(const std::string & key, MetricType type, double value)
+  {
+    if(!recording_)
+    {
+      return;
+    }
+    Metric & metric = metric_map_[key];
+    metric.type = type;
+    metric.sample_list.push_back(value);
+  }
+
+  /** \brief Skip whitespaces in JSON. */
+  static void skipJsonSpace(const std::string & str, size_t & pos)
+  {
+    while(pos < str.size() && std::isspace(static_cast<unsigned char>(str[pos])))
+    {
+      pos++;
+    }
+  }
+
+  /** \brief Parse JSON string. */
+  static std::string parseJsonString(const std::string & str, size_t & pos)
+  {
+    std::string ret;
+    pos++; // Skip opening quote
+    while(pos < str.size() && str[pos] != '"')
+    {
+      if(str[pos] == '\\' && pos + 1 < str.size())
+      {
+        pos++;
+      }
+      ret += str[pos];
+      pos++;
+    }
+    if(pos >= str.size())
+    {
+      throw std::runtime_error("[PerfRegression] Unterminated string in JSON.");
+    }
+    pos++; // Skip closing quote
+    return ret;
+  }
+
+  /** \brief Parse JSON value recursively. */
+  static void parseJsonValue(const std::string & str,
+                             size_t & pos,
+                             const std::string & prefix,
+                             std::map<std::string, double> & value_map)
+  {
+    skipJsonSpace(str, pos);
+    if(pos >= str.size())
+    {
+      throw std::runtime_error("[PerfRegression] Unexpected end of JSON.");
+    }
+
+    char c = str[pos];
+    if(c == '{' || c == '[')
+    {
+      bool is_object = (c == '{');
+      char close_c = is_object ? '}' : ']';
+      pos++;
+      skipJsonSpace(str, pos);
+      int idx = 0;
+      while(pos < str.size() && str[pos] != close_c)
+      {
+        std::string key;
+        if(is_object)
+        {
+          key = parseJsonString(str, pos);
+          skipJsonSpace(str, pos);
+          if(pos >= str.size() || str[pos] != ':')
+          {
+            throw std::runtime_error("[PerfRegression] Expected ':' in JSON.");
+          }
+          pos++;
+        }
+        else
+        {
+          key = std::to_string(idx);
+        }
+        parseJsonValue(str, pos, prefix.empty() ? key : prefix + "." + key, value_map);
+        skipJsonSpace(str, pos);
+        if(pos < str.size() && str[pos] == ',')
+        {
+          pos++;
+          skipJsonSpace(str, pos);
+        }
+        idx++;
+      }
+      if(pos >= str.size())
+      {
+        throw std::runtime_error("[PerfRegression] Unterminated object or array in JSON.");
+      }
+      pos++;
+    }
+    else if(c == '"')
+    {
+      parseJsonString(str, pos);
+    }
+    else if(c == 't' || c == 'f' || c == 'n')
+    {
+      while(pos < str.size() && std::isalpha(static_cast<unsigned char>(str[pos])))
+      {
+        pos++;
+      }
+    }
+    else
+    {
+      char * end = nullptr;
+      double value = std::strtod(str.c_str() + pos, &end);
+      if(end == str.c_str() + pos)
+      {
+        throw std::runtime_error("[PerfRegression] Invalid value in JSON at position " + std::to_string(pos) + ".");
+      }
+      pos = static_cast<size_t>(end - str.c_str());
+      value_map[prefix] = value;
+    }
+  }
+
+protected:
+  //! Configuration
+  Configuration config_;
+
+  //! Benchmark name
+  std::string name_;
+
+  //! Map from key to metric
+  std::map<std::string, Metric> metric_map_;
+
+  //! Whether to record added samples
+  bool recording_ = false;
+};
+} // namespace nmpc_ddp
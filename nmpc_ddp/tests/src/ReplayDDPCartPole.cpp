@@ -0,0 +1,18 @@
+/* Author: Masaki Murooka */
+
+#include <nmpc_ddp/DDPSolver.h>
+#include <nmpc_ddp/SolveReplayer.h>
+
+#include "DDPProblemCartPole.h"
+
+/** \brief Replay solves of cart-pole recorded by TestSolveRecorder.
+
+    Example: ReplayDDPCartPole /tmp/TestSolveRecorder.bin --repeat 10
+ */
+int main(int argc, char ** argv)
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1>>(ddp_problem);
+  return nmpc_ddp::replayMain(ddp_solver, argc, argv);
+}
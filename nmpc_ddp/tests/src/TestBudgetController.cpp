@@ -0,0 +1,112 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <map>
+
+#include <nmpc_ddp/BudgetController.h>
+
+#include "DDPProblemCartPole.h"
+
+using Policy = nmpc_ddp::DDPStaticPolicy<true, 1, 1, nmpc_ddp::Instrumentation::Phase, nmpc_ddp::CallbackObserver>;
+using DDPSolverCartPole = nmpc_ddp::DDPSolver<4, 1, Policy>;
+using Controller = nmpc_ddp::BudgetController<DDPSolverCartPole>;
+
+TEST(TestBudgetController, ResizeList)
+{
+  std::vector<int> list = {0, 1, 2};
+  nmpc_ddp::resizeList(list, 5);
+  EXPECT_EQ(list, std::vector<int>({0, 1, 2, 2, 2}));
+  nmpc_ddp::resizeList(list, 2);
+  EXPECT_EQ(list, std::vector<int>({0, 1}));
+}
+
+TEST(TestBudgetController, CartPole)
+{
+  // Instantiate problem and solver
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  auto ddp_solver = std::make_shared<DDPSolverCartPole>(ddp_problem);
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<DDPProblemCartPole::InputDimVector, 2>
+      {
+        return {DDPProblemCartPole::InputDimVector(-15.0), DDPProblemCartPole::InputDimVector(15.0)};
+      });
+  ddp_solver->config().print_level = 1;
+  ddp_solver->config().horizon_steps = 200;
+  ddp_solver->config().max_iter = 3;
+  int event_num = 0;
+  ddp_solver->observer().callback = [&event_num](const nmpc_ddp::SolverEvent & event)
+  {
+    if(std::string(event.source) == "BudgetController")
+    {
+      event_num++;
+    }
+  };
+
+  // Instantiate controller
+  Controller controller(ddp_solver);
+  controller.config().window_size = 10;
+  controller.config().min_horizon_steps = 20;
+  controller.config().max_horizon_steps = 200;
+  controller.config().min_max_iter = 1;
+  controller.config().max_max_iter = 5;
+
+  // Use a model of latency proportional to the horizon steps and the number of rollouts (one in setup and one in each
+  // iteration), so that the decisions do not depend on the timing of the machine
+  controller.setLatencyFunc(
+      [](const DDPSolverCartPole & solver)
+      { return 1e-3 * solver.config().horizon_steps * (solver.traceDataList().back().iter + 1); });
+
+  // Run closed-loop simulation
+  double mpc_dt = 0.01; // [sec]
+  DDPProblemCartPole::StateDimVector x(0.0, 0.5, 0.0, 0.0);
+  std::vector<DDPProblemCartPole::InputDimVector> u_list(200, DDPProblemCartPole::InputDimVector::Zero());
+  double t = 0;
+  auto run = [&](int solve_num)
+  {
+    for(int i = 0; i < solve_num; i++)
+    {
+      controller.solve(t, x, u_list);
+      EXPECT_EQ(u_list.size(), ddp_solver->controlData().u_list.size());
+      x = ddp_problem->stateEq(t, x, u_list[0].cwiseMax(-15.0).cwiseMin(15.0), mpc_dt);
+      nmpc_ddp::shiftList(u_list, 1);
+      t += mpc_dt;
+    }
+  };
+
+  // Check that the budget is decreased for a tight target latency
+  run(20);
+  double initial_latency = controller.decisionList().back().latency;
+  controller.config().target_latency = 0.3 * initial_latency;
+  run(200);
+  EXPECT_LT(ddp_solver->config().horizon_steps, 200);
+  std::map<Controller::DecisionType, int> decision_num_map;
+  for(const auto & decision : controller.decisionList())
+  {
+    decision_num_map[decision.type]++;
+  }
+  EXPECT_GT(decision_num_map[Controller::DecisionType::DecreaseHorizon]
+                + decision_num_map[Controller::DecisionType::DecreaseIter],
+            0);
+
+  // Check that the budget is increased to the limits for a loose target latency
+  controller.config().target_latency = 1e3;
+  run(400);
+  EXPECT_EQ(ddp_solver->config().horizon_steps, 200);
+  EXPECT_EQ(controller.decisionList().back().horizon_steps, 200);
+  EXPECT_EQ(static_cast<int>(u_list.size()), 200);
+
+  // Check that all decisions are logged
+  EXPECT_EQ(static_cast<int>(controller.decisionList().size()), (20 + 200 + 400) / 10);
+  EXPECT_EQ(event_num, static_cast<int>(controller.decisionList().size()));
+  EXPECT_LT(std::abs(x[1]), 0.05);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
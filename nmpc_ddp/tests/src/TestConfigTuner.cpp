@@ -0,0 +1,170 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include <nmpc_ddp/ConfigTuner.h>
+
+#include "DDPProblemCartPole.h"
+
+using DDPSolverCartPole = nmpc_ddp::DDPSolver<4, 1>;
+using ConfigTunerCartPole = nmpc_ddp::ConfigTuner<DDPSolverCartPole>;
+
+void testConfigTuner(const std::shared_ptr<nmpc_common::ThreadPool> & thread_pool)
+{
+  constexpr int horizon_steps = 100;
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                   ) { return 0.0; });
+  DDPSolverCartPole::Configuration baseline_config;
+  baseline_config.print_level = 0;
+  baseline_config.horizon_steps = horizon_steps;
+  baseline_config.max_iter = 100;
+  baseline_config.k_rel_norm_thre = 1e-6;
+
+  // The problem is shared by the solvers because it is not modified in the solve
+  ConfigTunerCartPole tuner([&]() { return std::make_shared<DDPSolverCartPole>(ddp_problem); }, baseline_config);
+  tuner.config().print_level = 2;
+  tuner.config().cost_tolerance = 1e-2;
+  tuner.config().candidate_num = 18;
+  tuner.setThreadPool(thread_pool);
+
+  // Sample initial states around the upright posture
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> dist(-0.5, 0.5);
+  std::vector<ConfigTunerCartPole::Sample> sample_list(9);
+  for(auto & sample : sample_list)
+  {
+    sample.x << dist(engine), dist(engine), dist(engine), dist(engine);
+    sample.warm_start.assign(horizon_steps, DDPProblemCartPole::InputDimVector::Zero());
+  }
+
+  std::vector<ConfigTunerCartPole::Knob> knob_list = {
+      ConfigTunerCartPole::makeKnob("k_rel_norm_thre", &DDPSolverCartPole::Configuration::k_rel_norm_thre,
+                                    std::vector<double>{1e-6, 1e-4, 1e-2, 1e0}),
+      ConfigTunerCartPole::makeKnob("max_iter", &DDPSolverCartPole::Configuration::max_iter, std::vector<int>{1, 100}),
+      ConfigTunerCartPole::makeKnob("lambda_factor", &DDPSolverCartPole::Configuration::lambda_factor,
+                                    std::vector<double>{1.2, 1.6, 2.0})};
+  // Knob of non-scalar entry
+  ConfigTunerCartPole::Knob alpha_knob;
+  alpha_knob.name = "alpha_num";
+  alpha_knob.value_list = {1, 4, 11};
+  alpha_knob.apply = [](DDPSolverCartPole::Configuration & config, double value)
+  {
+    Eigen::VectorXd alpha_exponent_list = Eigen::VectorXd::LinSpaced(static_cast<int>(value), 0, -3);
+    config.alpha_list = alpha_exponent_list.unaryExpr([](double exponent) { return std::pow(10, exponent); });
+  };
+  knob_list.push_back(alpha_knob);
+
+  auto result = tuner.tune(knob_list, sample_list);
+
+  // Check that the tuned configuration is not slower than the baseline and satisfies the cost tolerance
+  EXPECT_FALSE(result.best.rejected);
+  EXPECT_EQ(result.best.sample_num, static_cast<int>(sample_list.size()));
+  EXPECT_LE(result.best.duration, result.baseline.duration);
+  EXPECT_EQ(result.candidate_list.size(), 19);
+  EXPECT_GT(result.best.config.k_rel_norm_thre, 0.0);
+  EXPECT_EQ(result.best.config.horizon_steps, horizon_steps);
+
+  auto solver = std::make_shared<DDPSolverCartPole>(ddp_problem);
+  auto solve = [&](const DDPSolverCartPole::Configuration & config, const ConfigTunerCartPole::Sample & sample)
+  {
+    // DDPSolver::solve() returns false when it stops at max_iter, which is not a failure for the tuner
+    solver->config() = config;
+    auto u_list = sample.warm_start;
+    solver->solve(sample.t, sample.x, u_list);
+    return nmpc_ddp::calcSolutionCost(*solver, sample.t);
+  };
+  auto exceeds_tolerance = [&](double cost, double baseline_cost)
+  { return !std::isfinite(cost) || cost > baseline_cost + tuner.config().cost_tolerance * std::abs(baseline_cost); };
+
+  // Check that the candidates are rejected only because of increased costs
+  int rejected_num = 0;
+  for(const auto & candidate : result.candidate_list)
+  {
+    bool exceeded = false;
+    for(int i = 0; i < candidate.sample_num && !exceeded; i++)
+    {
+      exceeded = exceeds_tolerance(solve(candidate.config, sample_list[i]), solve(baseline_config, sample_list[i]));
+    }
+    EXPECT_EQ(candidate.rejected, exceeded);
+    if(candidate.rejected)
+    {
+      rejected_num++;
+      EXPECT_EQ(candidate.config.max_iter, 1);
+    }
+  }
+  EXPECT_GT(rejected_num, 0);
+
+  for(const auto & sample : sample_list)
+  {
+    EXPECT_FALSE(exceeds_tolerance(solve(result.best.config, sample), solve(result.baseline.config, sample)));
+  }
+}
+
+TEST(TestConfigTuner, Serial)
+{
+  testConfigTuner(nullptr);
+}
+
+TEST(TestConfigTuner, Parallel)
+{
+  nmpc_common::ThreadPool::Configuration config;
+  config.thread_num = 2;
+  testConfigTuner(std::make_shared<nmpc_common::ThreadPool>(config));
+}
+
+TEST(TestConfigTuner, MaxIteration)
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                   ) { return 0.0; });
+  DDPSolverCartPole::Configuration baseline_config;
+  baseline_config.print_level = 0;
+  baseline_config.horizon_steps = 100;
+  baseline_config.max_iter = 2;
+  baseline_config.k_rel_norm_thre = 0;
+  ConfigTunerCartPole tuner([&]() { return std::make_shared<DDPSolverCartPole>(ddp_problem); }, baseline_config);
+  tuner.config().print_level = 0;
+
+  ConfigTunerCartPole::Sample sample;
+  sample.x << 0.2, 0.2, 0, 0;
+  sample.warm_start.assign(100, DDPProblemCartPole::InputDimVector::Zero());
+
+  // DDPSolver::solve() returns false because it stops at max_iter
+  auto solver = std::make_shared<DDPSolverCartPole>(ddp_problem);
+  solver->config() = baseline_config;
+  auto u_list = sample.warm_start;
+  EXPECT_FALSE(solver->solve(sample.t, sample.x, u_list));
+
+  // Check that the solves stopped at max_iter are valid results for both the baseline and the candidates
+  auto result = tuner.tune({ConfigTunerCartPole::makeKnob("lambda_factor",
+                                                          &DDPSolverCartPole::Configuration::lambda_factor,
+                                                          std::vector<double>{1.2, 1.6, 2.0})},
+                           {sample});
+  EXPECT_EQ(result.candidate_list.size(), 4);
+  for(const auto & candidate : result.candidate_list)
+  {
+    EXPECT_TRUE(std::isfinite(candidate.duration));
+  }
+}
+
+TEST(TestConfigTuner, InvalidArguments)
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                   ) { return 0.0; });
+  ConfigTunerCartPole tuner([&]() { return std::make_shared<DDPSolverCartPole>(ddp_problem); },
+                            DDPSolverCartPole::Configuration());
+  EXPECT_THROW(tuner.tune({}, {}), std::invalid_argument);
+
+  ConfigTunerCartPole::Sample sample;
+  sample.x.setZero();
+  sample.warm_start.assign(100, DDPProblemCartPole::InputDimVector::Zero());
+  EXPECT_THROW(tuner.tune({ConfigTunerCartPole::Knob()}, {sample}), std::invalid_argument);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include <nmpc_ddp/ClosedLoopHarness.h>
+#include <nmpc_ddp/DDPSolver.h>
+
+#include "DDPProblemCartPole.h"
+
+using Harness = nmpc_ddp::ClosedLoopHarness<4, 1>;
+
+void test(Harness::TimeMode time_mode, double end_t)
+{
+  // Instantiate problem
+  double horizon_dt = 0.01; // [sec]
+  double horizon_duration = 2.0; // [sec]
+  double target_pos = 0.0; // [m]
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(horizon_dt, [&](double // t
+                                                                         ) { return target_pos; });
+
+  // Instantiate solver
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1>>(ddp_problem);
+  auto input_limits_func = [&](double // t
+                               ) -> std::array<Eigen::Vector1d, 2>
+  {
+    std::array<Eigen::Vector1d, 2> limits;
+    limits[0].setConstant(-15.0);
+    limits[1].setConstant(15.0);
+    return limits;
+  };
+  ddp_solver->setInputLimitsFunc(input_limits_func);
+  ddp_solver->config().with_input_constraint = true;
+  ddp_solver->config().horizon_steps = static_cast<int>(horizon_duration / horizon_dt);
+  ddp_solver->config().max_iter = 3;
+
+  // Instantiate harness
+  // In the wall-clock mode, a simulated clock is used, where each solve takes solve_duration
+  constexpr double solve_duration = 1e-3; // [sec]
+  double clock_time = 0.0; // [sec]
+  DDPProblemCartPole::InputDimVector current_u = DDPProblemCartPole::InputDimVector::Zero();
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(ddp_solver->config().horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+  Harness harness(
+      [&](double t, const DDPProblemCartPole::StateDimVector & x, const DDPProblemCartPole::InputDimVector & u,
+          double dt) { return ddp_problem->stateEq(t, x, u, dt); },
+      [&](double t, const DDPProblemCartPole::StateDimVector & x)
+      {
+        ddp_solver->solve(t, x, initial_u_list);
+        clock_time += solve_duration;
+        const auto & input_limits = input_limits_func(t);
+        current_u = ddp_solver->controlData().u_list[0].cwiseMax(input_limits[0]).cwiseMin(input_limits[1]);
+        initial_u_list = ddp_solver->controlData().u_list;
+      },
+      [&](double, // t
+          const DDPProblemCartPole::StateDimVector & // x
+      ) { return current_u; });
+  harness.config().time_mode = time_mode;
+  harness.config().sim_dt = 0.002;
+  harness.config().mpc_dt = 0.004;
+  harness.config().end_t = end_t;
+  if(time_mode == Harness::TimeMode::WallClock)
+  {
+    harness.setClock([&]() { return clock_time; }, [&](double time) { clock_time = std::max(clock_time, time); });
+  }
+  harness.setRefFunc([&](double // t
+                     ) { return DDPProblemCartPole::StateDimVector(target_pos, 0, 0, 0); });
+
+  // Schedule the same disturbances and target changes as the GUI of TestDDPCartPole
+  constexpr double dist_force_small = 10; // [N]
+  constexpr double dist_force_large = 30; // [N]
+  harness.addDisturbance(3.0, Eigen::Vector1d(dist_force_small));
+  harness.addDisturbance(4.0, Eigen::Vector1d(-1 * dist_force_large));
+  harness.addEvent(5.0, [&]() { target_pos = 2.0; });
+  harness.addEvent(7.0, [&]() { target_pos = 0.0; });
+
+  // Run closed-loop simulation
+  std::string file_path = "/tmp/TestDDPCartPoleHeadlessResult.txt";
+  std::ofstream ofs(file_path);
+  ofs << "time pos theta vel omega force ref_pos disturbance" << std::endl;
+  harness.setStepFunc(
+      [&](double t, const DDPProblemCartPole::StateDimVector & x, const DDPProblemCartPole::InputDimVector & u,
+          const DDPProblemCartPole::InputDimVector & dist_u)
+      {
+        EXPECT_LT(std::abs(x[0] - target_pos), 1e2);
+        ofs << t << " " << x.transpose() << " " << u.transpose() << " " << target_pos << " " << dist_u.transpose()
+            << std::endl;
+      });
+  DDPProblemCartPole::StateDimVector initial_x;
+  initial_x << 0, M_PI, 0, 0;
+  const auto & result = harness.run(initial_x);
+
+  // Check result
+  EXPECT_EQ(result.latency.num, static_cast<int>(std::round(end_t / harness.config().mpc_dt)));
+  EXPECT_LE(result.latency.min, result.latency.p50);
+  EXPECT_LE(result.latency.p50, result.latency.p99);
+  EXPECT_LE(result.latency.p99, result.latency.max);
+  if(time_mode == Harness::TimeMode::WallClock)
+  {
+    EXPECT_NEAR(result.latency.mean, 1e3 * solve_duration, 1e-6);
+    EXPECT_EQ(result.latency.deadline_miss_num, 0);
+    EXPECT_EQ(result.sim_overrun_num, 0);
+    EXPECT_NEAR(result.wall_duration, end_t, 1e-6);
+    EXPECT_NEAR(result.real_time_factor, 1.0, 1e-6);
+  }
+  EXPECT_LT(std::abs(result.final_x[0] - target_pos), 1.0);
+  EXPECT_LT(std::abs(result.final_x[1]), 1e-1);
+  EXPECT_LT(std::abs(result.final_x[2]), 1.0);
+  EXPECT_LT(std::abs(result.final_x[3]), 1e-1);
+
+  std::cout << "Tracking error (RMS): " << result.tracking_error_rms.transpose() << std::endl;
+  std::cout << "Run the following commands in gnuplot:\n"
+            << "  set key autotitle columnhead\n"
+            << "  set key noenhanced\n"
+            << "  plot \"" << file_path << "\" u 1:2 w lp, \"\" u 1:3 w lp, \"\" u 1:7 w l lw 3 # State\n"
+            << "  plot \"" << file_path << "\" u 1:6 w l lw 3 # Input\n";
+}
+
+TEST(TestDDPCartPoleHeadless, SimulatedTime)
+{
+  test(Harness::TimeMode::Simulated, 10.0);
+}
+
+TEST(TestDDPCartPoleHeadless, WallClockTime)
+{
+  test(Harness::TimeMode::WallClock, 10.0);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
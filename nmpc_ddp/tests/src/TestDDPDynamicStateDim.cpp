@@ -0,0 +1,260 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <nmpc_ddp/DDPSolver.h>
+
+/** \brief DDP problem for a chain of masses connected by springs and dampers between two walls.
+
+    State is [pos_1, ..., pos_N, vel_1, ..., vel_N]. Input is [force_1, ..., force_N].
+    Running cost is sum of the respective quadratic terms of state and input.
+    Terminal cost is quadratic term of state.
+ */
+template<int StateDim, int InputDim>
+class DDPProblemMassChain : public nmpc_ddp::DDPProblem<StateDim, InputDim>
+{
+public:
+  using typename nmpc_ddp::DDPProblem<StateDim, InputDim>::StateDimVector;
+  using typename nmpc_ddp::DDPProblem<StateDim, InputDim>::InputDimVector;
+  using typename nmpc_ddp::DDPProblem<StateDim, InputDim>::StateStateDimMatrix;
+  using typename nmpc_ddp::DDPProblem<StateDim, InputDim>::InputInputDimMatrix;
+  using typename nmpc_ddp::DDPProblem<StateDim, InputDim>::StateInputDimMatrix;
+
+public:
+  DDPProblemMassChain(double dt, int mass_num)
+  : nmpc_ddp::DDPProblem<StateDim, InputDim>(dt, 2 * mass_num), mass_num_(mass_num)
+  {
+    constexpr double stiffness = 10.0;
+    constexpr double damping = 0.5;
+    Eigen::MatrixXd Ac = Eigen::MatrixXd::Zero(2 * mass_num_, 2 * mass_num_);
+    Ac.topRightCorner(mass_num_, mass_num_).setIdentity();
+    for(int i = 0; i < mass_num_; i++)
+    {
+      Ac(mass_num_ + i, i) = -2 * stiffness;
+      if(i > 0)
+      {
+        Ac(mass_num_ + i, i - 1) = stiffness;
+      }
+      if(i < mass_num_ - 1)
+      {
+        Ac(mass_num_ + i, i + 1) = stiffness;
+      }
+      Ac(mass_num_ + i, mass_num_ + i) = -damping;
+    }
+    Eigen::MatrixXd Bc = Eigen::MatrixXd::Zero(2 * mass_num_, mass_num_);
+    Bc.bottomRows(mass_num_).setIdentity();
+
+    A_ = Eigen::MatrixXd::Identity(2 * mass_num_, 2 * mass_num_) + this->dt_ * Ac;
+    B_ = this->dt_ * Bc;
+    ref_x_ = Eigen::VectorXd::Zero(2 * mass_num_);
+    ref_x_.head(mass_num_).setConstant(0.1);
+  }
+
+  using nmpc_ddp::DDPProblem<StateDim, InputDim>::inputDim;
+
+  virtual int inputDim() const override
+  {
+    return mass_num_;
+  }
+
+  virtual int inputDim(double // t
+  ) const override
+  {
+    return mass_num_;
+  }
+
+  virtual StateDimVector stateEq(double, // t
+                                 const StateDimVector & x,
+                                 const InputDimVector & u) const override
+  {
+    return A_ * x + B_ * u;
+  }
+
+  virtual double runningCost(double, // t
+                             const StateDimVector & x,
+                             const InputDimVector & u) const override
+  {
+    return 0.5 * running_x_weight_ * (x - ref_x_).squaredNorm() + 0.5 * running_u_weight_ * u.squaredNorm();
+  }
+
+  virtual double terminalCost(double, // t
+                              const StateDimVector & x) const override
+  {
+    return 0.5 * terminal_x_weight_ * (x - ref_x_).squaredNorm();
+  }
+
+  virtual void calcStateEqDeriv(double, // t
+                                const StateDimVector &, // x
+                                const InputDimVector &, // u
+                                Eigen::Ref<StateStateDimMatrix> state_eq_deriv_x,
+                                Eigen::Ref<StateInputDimMatrix> state_eq_deriv_u) const override
+  {
+    state_eq_deriv_x = A_;
+    state_eq_deriv_u = B_;
+  }
+
+  virtual void calcStateEqDeriv(double, // t
+                                const StateDimVector &, // x
+                                const InputDimVector &, // u
+                                Eigen::Ref<StateStateDimMatrix>, // state_eq_deriv_x
+                                Eigen::Ref<StateInputDimMatrix>, // state_eq_deriv_u
+                                std::vector<StateStateDimMatrix> &, // state_eq_deriv_xx
+                                std::vector<InputInputDimMatrix> &, // state_eq_deriv_uu
+                                std::vector<StateInputDimMatrix> & // state_eq_deriv_xu
+  ) const override
+  {
+    throw std::runtime_error("Second-order derivatives of state equation are not implemented.");
+  }
+
+  virtual void calcRunningCostDeriv(double, // t
+                                    const StateDimVector & x,
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u) const override
+  {
+    running_cost_deriv_x = running_x_weight_ * (x - ref_x_);
+    running_cost_deriv_u = running_u_weight_ * u;
+  }
+
+  virtual void calcRunningCostDeriv(double t,
+                                    const StateDimVector & x,
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u,
+                                    Eigen::Ref<StateStateDimMatrix> running_cost_deriv_xx,
+                                    Eigen::Ref<InputInputDimMatrix> running_cost_deriv_uu,
+                                    Eigen::Ref<StateInputDimMatrix> running_cost_deriv_xu) const override
+  {
+    calcRunningCostDeriv(t, x, u, running_cost_deriv_x, running_cost_deriv_u);
+    running_cost_deriv_xx.setIdentity();
+    running_cost_deriv_xx *= running_x_weight_;
+    running_cost_deriv_uu.setIdentity();
+    running_cost_deriv_uu *= running_u_weight_;
+    running_cost_deriv_xu.setZero();
+  }
+
+  virtual void calcTerminalCostDeriv(double, // t
+                                     const StateDimVector & x,
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x) const override
+  {
+    terminal_cost_deriv_x = terminal_x_weight_ * (x - ref_x_);
+  }
+
+  virtual void calcTerminalCostDeriv(double t,
+                                     const StateDimVector & x,
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x,
+                                     Eigen::Ref<StateStateDimMatrix> terminal_cost_deriv_xx) const override
+  {
+    calcTerminalCostDeriv(t, x, terminal_cost_deriv_x);
+    terminal_cost_deriv_xx.setIdentity();
+    terminal_cost_deriv_xx *= terminal_x_weight_;
+  }
+
+protected:
+  int mass_num_;
+
+  Eigen::MatrixXd A_;
+  Eigen::MatrixXd B_;
+  Eigen::VectorXd ref_x_;
+
+  double running_x_weight_ = 1.0;
+  double running_u_weight_ = 1e-2;
+  double terminal_x_weight_ = 10.0;
+};
+
+template<int StateDim, int InputDim>
+std::shared_ptr<nmpc_ddp::DDPSolver<StateDim, InputDim>> solveMassChain(int mass_num,
+                                                                       int horizon_steps,
+                                                                       bool with_input_constraint)
+{
+  using Problem = DDPProblemMassChain<StateDim, InputDim>;
+  auto ddp_problem = std::make_shared<Problem>(0.01, mass_num);
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<StateDim, InputDim>>(ddp_problem);
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().horizon_steps = horizon_steps;
+  ddp_solver->config().max_iter = 10;
+  ddp_solver->config().with_input_constraint = with_input_constraint;
+  if(with_input_constraint)
+  {
+    ddp_solver->setInputLimitsFunc(
+        [mass_num](double // t
+                   ) -> std::array<typename Problem::InputDimVector, 2>
+        {
+          return {Problem::InputDimVector::Constant(mass_num, -1.0), Problem::InputDimVector::Constant(mass_num, 1.0)};
+        });
+  }
+
+  typename Problem::StateDimVector current_x = Problem::StateDimVector::Zero(2 * mass_num);
+  std::vector<typename Problem::InputDimVector> initial_u_list(horizon_steps,
+                                                               Problem::InputDimVector::Zero(mass_num));
+  EXPECT_TRUE(ddp_solver->solve(0.0, current_x, initial_u_list));
+  return ddp_solver;
+}
+
+TEST(TestDDPDynamicStateDim, FixedVsDynamic)
+{
+  constexpr int mass_num = 3;
+  constexpr int horizon_steps = 100;
+  for(bool with_input_constraint : {false, true})
+  {
+    auto fixed_solver = solveMassChain<2 * mass_num, mass_num>(mass_num, horizon_steps, with_input_constraint);
+    auto dynamic_solver =
+        solveMassChain<Eigen::Dynamic, Eigen::Dynamic>(mass_num, horizon_steps, with_input_constraint);
+    auto dynamic_state_solver =
+        solveMassChain<Eigen::Dynamic, mass_num>(mass_num, horizon_steps, with_input_constraint);
+
+    static_assert(DDPProblemMassChain<2 * mass_num, mass_num>::stateDim() == 2 * mass_num);
+    EXPECT_EQ(fixed_solver->problem()->runtimeStateDim(), 2 * mass_num);
+    EXPECT_EQ(dynamic_solver->problem()->runtimeStateDim(), 2 * mass_num);
+    EXPECT_THROW(dynamic_solver->problem()->stateDim(), std::runtime_error);
+    EXPECT_EQ(dynamic_solver->traceDataList().size(), fixed_solver->traceDataList().size());
+    EXPECT_EQ(dynamic_state_solver->traceDataList().size(), fixed_solver->traceDataList().size());
+    for(int i = 0; i < horizon_steps; i++)
+    {
+      EXPECT_LT((dynamic_solver->controlData().u_list[i] - fixed_solver->controlData().u_list[i]).norm(), 1e-8)
+          << "i: " << i;
+      EXPECT_LT((dynamic_state_solver->controlData().u_list[i] - fixed_solver->controlData().u_list[i]).norm(), 1e-8)
+          << "i: " << i;
+    }
+    EXPECT_LT((dynamic_solver->controlData().x_list.back() - fixed_solver->controlData().x_list.back()).norm(), 1e-8);
+  }
+}
+
+TEST(TestDDPDynamicStateDim, LargeModel)
+{
+  // 200 states, 100 inputs
+  constexpr int mass_num = 100;
+  constexpr int horizon_steps = 50;
+  auto ddp_solver = solveMassChain<Eigen::Dynamic, Eigen::Dynamic>(mass_num, horizon_steps, false);
+
+  // Since the problem is linear-quadratic, the cost is decreased in the first iteration and converged soon
+  const auto & trace_data_list = ddp_solver->traceDataList();
+  ASSERT_GE(trace_data_list.size(), 2);
+  EXPECT_LT(trace_data_list[1].cost, trace_data_list[0].cost);
+  EXPECT_LE(trace_data_list.size(), 5);
+
+  // Check that the masses are moved toward the reference position
+  const Eigen::VectorXd & terminal_x = ddp_solver->controlData().x_list.back();
+  EXPECT_EQ(terminal_x.size(), 2 * mass_num);
+  EXPECT_TRUE(terminal_x.allFinite());
+  EXPECT_GT(terminal_x.head(mass_num).minCoeff(), 0.0);
+  EXPECT_LT((terminal_x.head(mass_num).array() - 0.1).abs().maxCoeff(), 0.1);
+
+  // Check feedback policy
+  auto policy = ddp_solver->feedbackPolicy();
+  EXPECT_EQ(policy->KList().front().rows(), mass_num);
+  EXPECT_EQ(policy->KList().front().cols(), 2 * mass_num);
+  EXPECT_EQ(policy->calcInput(0.0, Eigen::VectorXd::Zero(2 * mass_num)).size(), mass_num);
+}
+
+TEST(TestDDPDynamicStateDim, InvalidStateDim)
+{
+  EXPECT_THROW((DDPProblemMassChain<4, 2>(0.01, 3)), std::invalid_argument);
+  EXPECT_THROW((DDPProblemMassChain<Eigen::Dynamic, Eigen::Dynamic>(0.01, 0)), std::invalid_argument);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
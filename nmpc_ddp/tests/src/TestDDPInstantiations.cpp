@@ -0,0 +1,50 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/DDPSolver.h>
+
+#include "DDPProblemCartPole.h"
+
+#ifndef NMPC_DDP_EXTERN_TEMPLATES
+#  error "NMPC_DDP_EXTERN_TEMPLATES must be defined by linking nmpc_ddp_instantiations."
+#endif
+
+TEST(TestDDPInstantiations, CartPole)
+{
+  // DDPSolver<4, 1> is not instantiated in this translation unit but linked from nmpc_ddp_instantiations
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1>>(ddp_problem);
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<DDPProblemCartPole::InputDimVector, 2>
+      {
+        return {DDPProblemCartPole::InputDimVector(-15.0), DDPProblemCartPole::InputDimVector(15.0)};
+      });
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().with_input_constraint = true;
+  ddp_solver->config().horizon_steps = 200;
+  ddp_solver->config().max_iter = 100;
+
+  DDPProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(200, DDPProblemCartPole::InputDimVector::Zero());
+  EXPECT_TRUE(ddp_solver->solve(0.0, current_x, initial_u_list));
+
+  const auto & u_list = ddp_solver->controlData().u_list;
+  EXPECT_EQ(u_list.size(), 200);
+  for(const auto & u : u_list)
+  {
+    EXPECT_TRUE(u.allFinite());
+    EXPECT_LE(std::abs(u[0]), 15.0 + 1e-6);
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,75 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/DDPSolver.h>
+
+#include "DDPProblemCartPole.h"
+#include "PerfRegression.h"
+
+// The steps of horizon are also measured to record the durations of the Q, regularization, and gain calculation
+using DDPSolverPerf = nmpc_ddp::DDPSolver<4, 1, nmpc_ddp::DDPStepInstrumentedPolicy>;
+
+TEST(TestDDPPerf, CartPoleSwingUp)
+{
+  nmpc_ddp::PerfRegression perf("TestDDPPerf.CartPoleSwingUp", NMPC_PERF_BASELINE_DIR);
+
+  // Instantiate problem
+  double horizon_dt = 0.01; // [sec]
+  double horizon_duration = 2.0; // [sec]
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(horizon_dt, [](double // t
+                                                                      ) { return 0.0; });
+
+  perf.run(
+      [&]()
+      {
+        // Instantiate solver
+        auto ddp_solver = std::make_shared<DDPSolverPerf>(ddp_problem);
+        ddp_solver->setInputLimitsFunc(
+            [&](double // t
+                ) -> std::array<Eigen::Vector1d, 2>
+            {
+              std::array<Eigen::Vector1d, 2> limits;
+              limits[0].setConstant(-15.0);
+              limits[1].setConstant(15.0);
+              return limits;
+            });
+        ddp_solver->config().print_level = 0;
+        ddp_solver->config().with_input_constraint = true;
+        ddp_solver->config().horizon_steps = static_cast<int>(horizon_duration / horizon_dt);
+        ddp_solver->config().max_iter = 50;
+
+        // Solve from cold start
+        DDPProblemCartPole::StateDimVector initial_x;
+        initial_x << 0, M_PI, 0, 0;
+        std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(ddp_solver->config().horizon_steps,
+                                                                       DDPProblemCartPole::InputDimVector::Zero());
+        ddp_solver->solve(0, initial_x, initial_u_list);
+
+        // Add samples
+        const auto & duration = ddp_solver->computationDuration();
+        perf.addDuration("solve", duration.solve);
+        perf.addDuration("setup", duration.setup);
+        perf.addDuration("opt", duration.opt);
+        perf.addDuration("derivative", duration.derivative);
+        perf.addDuration("backward", duration.backward);
+        perf.addDuration("forward", duration.forward);
+        perf.addDuration("Q", duration.Q);
+        perf.addDuration("reg", duration.reg);
+        perf.addDuration("gain", duration.gain);
+        perf.addCount("iter", ddp_solver->traceDataList().back().iter);
+      });
+
+  for(const auto & failure : perf.check())
+  {
+    ADD_FAILURE() << failure;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/DDPSolver.h>
+
+#include "DDPProblemCartPole.h"
+
+template<class Policy>
+std::shared_ptr<nmpc_ddp::DDPSolver<4, 1, Policy>> solve(bool with_input_constraint,
+                                                         bool use_state_eq_second_derivative = false)
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1, Policy>>(ddp_problem);
+  ddp_solver->config().print_level = 1;
+  ddp_solver->config().horizon_steps = 100;
+  ddp_solver->config().max_iter = 10;
+  ddp_solver->config().with_input_constraint = with_input_constraint;
+  ddp_solver->config().use_state_eq_second_derivative = use_state_eq_second_derivative;
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<DDPProblemCartPole::InputDimVector, 2>
+      {
+        return {DDPProblemCartPole::InputDimVector(-15.0), DDPProblemCartPole::InputDimVector(15.0)};
+      });
+
+  DDPProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(ddp_solver->config().horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+  ddp_solver->solve(0.0, current_x, initial_u_list);
+
+  return ddp_solver;
+}
+
+template<class StaticPolicy>
+void testStaticPolicy(bool with_input_constraint)
+{
+  auto runtime_solver = solve<nmpc_ddp::DDPRuntimePolicy>(with_input_constraint);
+  // Set the opposite configuration to check that it is ignored
+  auto static_solver = solve<StaticPolicy>(!with_input_constraint);
+
+  const auto & runtime_u_list = runtime_solver->controlData().u_list;
+  const auto & static_u_list = static_solver->controlData().u_list;
+  ASSERT_EQ(runtime_u_list.size(), static_u_list.size());
+  for(size_t i = 0; i < runtime_u_list.size(); i++)
+  {
+    EXPECT_LT((runtime_u_list[i] - static_u_list[i]).norm(), 1e-10) << "i: " << i;
+  }
+  EXPECT_EQ(runtime_solver->traceDataList().size(), static_solver->traceDataList().size());
+}
+
+TEST(TestDDPSolverPolicy, StaticPolicy)
+{
+  testStaticPolicy<nmpc_ddp::DDPStaticPolicy<false>>(false);
+}
+
+TEST(TestDDPSolverPolicy, StaticPolicyWithConstraint)
+{
+  testStaticPolicy<nmpc_ddp::DDPStaticPolicy<true>>(true);
+}
+
+TEST(TestDDPSolverPolicy, StaticPolicyWithStateEqSecondDerivative)
+{
+  // DDPProblemCartPole throws if second-order derivatives of state equation are calculated
+  EXPECT_THROW(solve<nmpc_ddp::DDPRuntimePolicy>(true, true), std::runtime_error);
+  EXPECT_NO_THROW(solve<nmpc_ddp::DDPStaticPolicy<true>>(true, true));
+  EXPECT_THROW(
+      (solve<nmpc_ddp::DDPStaticPolicy<true, 1, 0, nmpc_ddp::Instrumentation::Phase, nmpc_ddp::PrintObserver, true>>(
+          true, false)),
+      std::runtime_error);
+}
+
+TEST(TestDDPSolverPolicy, Instrumentation)
+{
+  {
+    auto ddp_solver = solve<nmpc_ddp::DDPStepInstrumentedPolicy>(true);
+    const auto & computation_duration = ddp_solver->computationDuration();
+    EXPECT_GT(computation_duration.solve, 0.0);
+    EXPECT_GT(computation_duration.backward, 0.0);
+    EXPECT_GT(computation_duration.gain, 0.0);
+  }
+  {
+    auto ddp_solver = solve<nmpc_ddp::DDPRuntimePolicy>(true);
+    const auto & computation_duration = ddp_solver->computationDuration();
+    EXPECT_GT(computation_duration.solve, 0.0);
+    EXPECT_GT(computation_duration.backward, 0.0);
+    EXPECT_EQ(computation_duration.gain, 0.0);
+  }
+  {
+    auto ddp_solver = solve<nmpc_ddp::DDPStaticPolicy<true, 1, 0, nmpc_ddp::Instrumentation::Phase>>(true);
+    const auto & computation_duration = ddp_solver->computationDuration();
+    EXPECT_GT(computation_duration.solve, 0.0);
+    EXPECT_GT(computation_duration.backward, 0.0);
+    EXPECT_EQ(computation_duration.gain, 0.0);
+  }
+  {
+    auto ddp_solver = solve<nmpc_ddp::DDPStaticPolicy<true, 1, 0, nmpc_ddp::Instrumentation::None>>(true);
+    const auto & computation_duration = ddp_solver->computationDuration();
+    EXPECT_EQ(computation_duration.solve, 0.0);
+    EXPECT_EQ(computation_duration.backward, 0.0);
+    EXPECT_EQ(computation_duration.gain, 0.0);
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,97 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/DDPSolver.h>
+
+#include "DDPProblemCartPole.h"
+
+std::shared_ptr<nmpc_ddp::DDPSolver<4, 1>> makeSolver(double target_pos)
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [target_pos](double // t
+                                                                             ) { return target_pos; });
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1>>(ddp_problem);
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<DDPProblemCartPole::InputDimVector, 2>
+      {
+        return {DDPProblemCartPole::InputDimVector(-15.0), DDPProblemCartPole::InputDimVector(15.0)};
+      });
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().with_input_constraint = true;
+  ddp_solver->config().horizon_steps = 100;
+  ddp_solver->config().max_iter = 10;
+  return ddp_solver;
+}
+
+TEST(TestDDPStepwise, Interleave)
+{
+  constexpr int solver_num = 3;
+  DDPProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(100, DDPProblemCartPole::InputDimVector::Zero());
+
+  // Solve by solve()
+  std::vector<std::shared_ptr<nmpc_ddp::DDPSolver<4, 1>>> ref_solver_list;
+  std::vector<bool> ref_result_list;
+  for(int i = 0; i < solver_num; i++)
+  {
+    ref_solver_list.push_back(makeSolver(0.5 * i));
+    ref_result_list.push_back(ref_solver_list[i]->solve(0.0, current_x, initial_u_list));
+  }
+
+  // Solve by interleaving steps of solvers
+  std::vector<std::shared_ptr<nmpc_ddp::DDPSolver<4, 1>>> solver_list;
+  std::vector<int> step_num_list(solver_num, 0);
+  for(int i = 0; i < solver_num; i++)
+  {
+    solver_list.push_back(makeSolver(0.5 * i));
+    EXPECT_TRUE(solver_list[i]->done());
+    solver_list[i]->begin(0.0, current_x, initial_u_list);
+    EXPECT_FALSE(solver_list[i]->done());
+  }
+  bool all_done = false;
+  while(!all_done)
+  {
+    all_done = true;
+    for(int i = 0; i < solver_num; i++)
+    {
+      if(!solver_list[i]->done())
+      {
+        solver_list[i]->step();
+        step_num_list[i]++;
+      }
+      all_done = all_done && solver_list[i]->done();
+    }
+  }
+
+  // Check that the results are identical
+  for(int i = 0; i < solver_num; i++)
+  {
+    EXPECT_EQ(solver_list[i]->result(), ref_result_list[i]);
+    EXPECT_EQ(step_num_list[i], static_cast<int>(solver_list[i]->traceDataList().size()) - 1);
+    EXPECT_EQ(solver_list[i]->traceDataList().size(), ref_solver_list[i]->traceDataList().size());
+    const auto & u_list = solver_list[i]->controlData().u_list;
+    const auto & ref_u_list = ref_solver_list[i]->controlData().u_list;
+    ASSERT_EQ(u_list.size(), ref_u_list.size());
+    for(size_t j = 0; j < u_list.size(); j++)
+    {
+      EXPECT_EQ(u_list[j], ref_u_list[j]) << "i: " << i << ", j: " << j;
+    }
+    EXPECT_GT(solver_list[i]->computationDuration().opt, 0.0);
+    EXPECT_DOUBLE_EQ(solver_list[i]->computationDuration().solve,
+                     solver_list[i]->computationDuration().setup + solver_list[i]->computationDuration().opt);
+
+    // Check that step() does nothing after finished
+    EXPECT_TRUE(solver_list[i]->step());
+    EXPECT_EQ(solver_list[i]->traceDataList().size(), ref_solver_list[i]->traceDataList().size());
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,62 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/DDPSolver.h>
+
+#include "DDPProblemCartPole.h"
+
+std::shared_ptr<nmpc_ddp::DDPSolver<4, 1>> makeSolver()
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1>>(ddp_problem);
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<DDPProblemCartPole::InputDimVector, 2>
+      {
+        return {DDPProblemCartPole::InputDimVector(-15.0), DDPProblemCartPole::InputDimVector(15.0)};
+      });
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().with_input_constraint = true;
+  ddp_solver->config().horizon_steps = 200;
+  ddp_solver->config().max_iter = 10;
+  return ddp_solver;
+}
+
+TEST(TestDDPThreadPool, CartPole)
+{
+  DDPProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(200, DDPProblemCartPole::InputDimVector::Zero());
+
+  // Solve serially
+  auto ref_solver = makeSolver();
+  bool ref_result = ref_solver->solve(0.0, current_x, initial_u_list);
+
+  // Solve with thread pool
+  for(bool caller_participates : {true, false})
+  {
+    nmpc_common::ThreadPool::Configuration config;
+    config.thread_num = 3;
+    config.caller_participates = caller_participates;
+    auto thread_pool = std::make_shared<nmpc_common::ThreadPool>(config);
+    auto solver = makeSolver();
+    solver->setThreadPool(thread_pool);
+    EXPECT_EQ(solver->solve(0.0, current_x, initial_u_list), ref_result);
+
+    // Check that the results are identical
+    EXPECT_EQ(solver->traceDataList().size(), ref_solver->traceDataList().size());
+    EXPECT_EQ(solver->controlData().x_list, ref_solver->controlData().x_list);
+    EXPECT_EQ(solver->controlData().u_list, ref_solver->controlData().u_list);
+    EXPECT_EQ(solver->feedbackPolicy()->KList(), ref_solver->feedbackPolicy()->KList());
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,241 @@
+/* Author: Masaki Murooka */
+
+// AllocationCounter.h must be included before any Eigen header
+#include <nmpc_common/AllocationCounter.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/BoxQP.h>
+#include <nmpc_ddp/DDPSolver.h>
+
+#include "DDPProblemCartPole.h"
+
+NMPC_DEFINE_ALLOCATION_COUNTER()
+
+/** \brief DDP problem for cart-pole with dynamic input dimension.
+
+    The problem is the same as DDPProblemCartPole except that the input dimension is dynamic.
+ */
+class DDPProblemCartPoleDynamicInput : public nmpc_ddp::DDPProblem<4, Eigen::Dynamic>
+{
+public:
+  using FixedProblem = DDPProblemCartPole;
+
+public:
+  DDPProblemCartPoleDynamicInput(double dt) : DDPProblem(dt), problem_(dt, [](double // t
+                                                                             ) { return 0.0; })
+  {
+  }
+
+  using DDPProblem::inputDim;
+
+  virtual int inputDim(double // t
+  ) const override
+  {
+    return 1;
+  }
+
+  virtual StateDimVector stateEq(double t, const StateDimVector & x, const InputDimVector & u) const override
+  {
+    return problem_.stateEq(t, x, Eigen::Vector1d(u[0]));
+  }
+
+  virtual double runningCost(double t, const StateDimVector & x, const InputDimVector & u) const override
+  {
+    return problem_.runningCost(t, x, Eigen::Vector1d(u[0]));
+  }
+
+  virtual double terminalCost(double t, const StateDimVector & x) const override
+  {
+    return problem_.terminalCost(t, x);
+  }
+
+  virtual void calcStateEqDeriv(double t,
+                                const StateDimVector & x,
+                                const InputDimVector & u,
+                                Eigen::Ref<StateStateDimMatrix> state_eq_deriv_x,
+                                Eigen::Ref<StateInputDimMatrix> state_eq_deriv_u) const override
+  {
+    FixedProblem::StateInputDimMatrix fixed_state_eq_deriv_u;
+    problem_.calcStateEqDeriv(t, x, Eigen::Vector1d(u[0]), state_eq_deriv_x, fixed_state_eq_deriv_u);
+    state_eq_deriv_u = fixed_state_eq_deriv_u;
+  }
+
+  virtual void calcStateEqDeriv(double, // t
+                                const StateDimVector &, // x
+                                const InputDimVector &, // u
+                                Eigen::Ref<StateStateDimMatrix>, // state_eq_deriv_x
+                                Eigen::Ref<StateInputDimMatrix>, // state_eq_deriv_u
+                                std::vector<StateStateDimMatrix> &, // state_eq_deriv_xx
+                                std::vector<InputInputDimMatrix> &, // state_eq_deriv_uu
+                                std::vector<StateInputDimMatrix> & // state_eq_deriv_xu
+  ) const override
+  {
+    throw std::runtime_error("Second-order derivatives of state equation are not implemented.");
+  }
+
+  virtual void calcRunningCostDeriv(double t,
+                                    const StateDimVector & x,
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u) const override
+  {
+    Eigen::Vector1d fixed_running_cost_deriv_u;
+    problem_.calcRunningCostDeriv(t, x, Eigen::Vector1d(u[0]), running_cost_deriv_x, fixed_running_cost_deriv_u);
+    running_cost_deriv_u = fixed_running_cost_deriv_u;
+  }
+
+  virtual void calcRunningCostDeriv(double t,
+                                    const StateDimVector & x,
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u,
+                                    Eigen::Ref<StateStateDimMatrix> running_cost_deriv_xx,
+                                    Eigen::Ref<InputInputDimMatrix> running_cost_deriv_uu,
+                                    Eigen::Ref<StateInputDimMatrix> running_cost_deriv_xu) const override
+  {
+    Eigen::Vector1d fixed_running_cost_deriv_u;
+    Eigen::Matrix<double, 1, 1> fixed_running_cost_deriv_uu;
+    FixedProblem::StateInputDimMatrix fixed_running_cost_deriv_xu;
+    problem_.calcRunningCostDeriv(t, x, Eigen::Vector1d(u[0]), running_cost_deriv_x, fixed_running_cost_deriv_u,
+                                  running_cost_deriv_xx, fixed_running_cost_deriv_uu, fixed_running_cost_deriv_xu);
+    running_cost_deriv_u = fixed_running_cost_deriv_u;
+    running_cost_deriv_uu = fixed_running_cost_deriv_uu;
+    running_cost_deriv_xu = fixed_running_cost_deriv_xu;
+  }
+
+  virtual void calcTerminalCostDeriv(double t,
+                                     const StateDimVector & x,
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x) const override
+  {
+    problem_.calcTerminalCostDeriv(t, x, terminal_cost_deriv_x);
+  }
+
+  virtual void calcTerminalCostDeriv(double t,
+                                     const StateDimVector & x,
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x,
+                                     Eigen::Ref<StateStateDimMatrix> terminal_cost_deriv_xx) const override
+  {
+    problem_.calcTerminalCostDeriv(t, x, terminal_cost_deriv_x, terminal_cost_deriv_xx);
+  }
+
+protected:
+  DDPProblemCartPole problem_;
+};
+
+TEST(TestDDPZeroAllocation, AllocationCounter)
+{
+  {
+    std::vector<double> vec;
+    nmpc_common::AllocationCounter counter;
+    vec.resize(10);
+    EXPECT_EQ(counter.stop(), 1);
+    EXPECT_EQ(vec.size(), 10);
+  }
+  {
+    Eigen::VectorXd vec1 = Eigen::VectorXd::Zero(10);
+    nmpc_common::AllocationCounter counter;
+    vec1.setOnes(); // no allocation
+    Eigen::VectorXd vec2 = 2 * vec1; // allocation
+    EXPECT_EQ(counter.stop(), 1);
+    EXPECT_EQ(vec2[0], 2.0);
+  }
+}
+
+TEST(TestDDPZeroAllocation, BoxQP)
+{
+  Eigen::Matrix3d H;
+  H << 4, 1, 0, 1, 3, 0, 0, 0, 2;
+  Eigen::Vector3d g(1, -2, 3);
+  Eigen::Vector3d lower = Eigen::Vector3d::Constant(-0.5);
+  Eigen::Vector3d upper = Eigen::Vector3d::Constant(0.5);
+
+  nmpc_ddp::BoxQP<3> qp;
+  qp.config().print_level = 0;
+  Eigen::Vector3d x = qp.solve(H, g, lower, upper);
+
+  nmpc_common::AllocationCounter counter;
+  x = qp.solve(H, g, lower, upper);
+  EXPECT_EQ(counter.stop(), 0);
+}
+
+template<class ProblemType>
+std::shared_ptr<ProblemType> makeProblem();
+
+template<>
+std::shared_ptr<DDPProblemCartPole> makeProblem()
+{
+  return std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                    ) { return 0.0; });
+}
+
+template<>
+std::shared_ptr<DDPProblemCartPoleDynamicInput> makeProblem()
+{
+  return std::make_shared<DDPProblemCartPoleDynamicInput>(0.01);
+}
+
+template<class ProblemType>
+void testDDP(bool with_constraint)
+{
+  using InputDimVector = typename ProblemType::InputDimVector;
+
+  auto ddp_problem = makeProblem<ProblemType>();
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, InputDimVector::RowsAtCompileTime>>(ddp_problem);
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().horizon_steps = 100;
+  ddp_solver->config().max_iter = 5;
+  ddp_solver->config().with_input_constraint = with_constraint;
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<InputDimVector, 2>
+      { return {InputDimVector::Constant(1, -15.0), InputDimVector::Constant(1, 15.0)}; });
+
+  DDPProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  std::vector<InputDimVector> current_u_list(ddp_solver->config().horizon_steps, InputDimVector::Zero(1));
+
+  // Warm up (the buffers are allocated in the first solve)
+  double current_t = 0;
+  {
+    nmpc_common::AllocationCounter counter;
+    ddp_solver->solve(current_t, current_x, current_u_list);
+    EXPECT_GT(counter.stop(), 0);
+  }
+
+  // Check that no memory is allocated in steady state
+  for(int i = 0; i < 10; i++)
+  {
+    current_t += 0.01;
+    current_u_list = ddp_solver->controlData().u_list;
+    current_x = ddp_problem->stateEq(current_t, current_x, current_u_list[0]);
+
+    nmpc_common::AllocationCounter counter;
+    ddp_solver->solve(current_t, current_x, current_u_list);
+    EXPECT_EQ(counter.stop(), 0) << "solve: " << i;
+  }
+}
+
+TEST(TestDDPZeroAllocation, DDPSolver)
+{
+  testDDP<DDPProblemCartPole>(false);
+}
+
+TEST(TestDDPZeroAllocation, DDPSolverWithConstraint)
+{
+  testDDP<DDPProblemCartPole>(true);
+}
+
+TEST(TestDDPZeroAllocation, DDPSolverDynamicInput)
+{
+  // With input constraints, memory is allocated by BoxQP of dynamic size, so only the unconstrained case is checked
+  testDDP<DDPProblemCartPoleDynamicInput>(false);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,92 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/ClosedLoopHarness.h>
+#include <nmpc_ddp/EventTriggeredMpc.h>
+
+#include "DDPProblemCartPole.h"
+
+using DDPSolverCartPole = nmpc_ddp::DDPSolver<4, 1>;
+using Harness = nmpc_ddp::ClosedLoopHarness<4, 1>;
+
+Harness::Result run(double partial_error_thre, nmpc_ddp::EventTriggeredMpc<DDPSolverCartPole>::Statistics & statistics)
+{
+  // Instantiate problem and solver
+  double horizon_dt = 0.01; // [sec]
+  double horizon_duration = 2.0; // [sec]
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(horizon_dt, [](double // t
+                                                                         ) { return 0.0; });
+  auto ddp_solver = std::make_shared<DDPSolverCartPole>(ddp_problem);
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<DDPProblemCartPole::InputDimVector, 2>
+      {
+        return {DDPProblemCartPole::InputDimVector(-15.0), DDPProblemCartPole::InputDimVector(15.0)};
+      });
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().with_input_constraint = true;
+  ddp_solver->config().horizon_steps = static_cast<int>(horizon_duration / horizon_dt);
+  ddp_solver->config().max_iter = 3;
+
+  // Instantiate event-triggered MPC
+  nmpc_ddp::EventTriggeredMpc<DDPSolverCartPole> mpc(
+      ddp_solver, std::vector<DDPProblemCartPole::InputDimVector>(ddp_solver->config().horizon_steps,
+                                                                  DDPProblemCartPole::InputDimVector::Zero()));
+  mpc.config().partial_error_thre = partial_error_thre;
+  mpc.config().full_error_thre = 10 * partial_error_thre;
+
+  // Run closed-loop simulation with input calculation in every simulation step
+  Harness harness([&](double t, const DDPProblemCartPole::StateDimVector & x,
+                      const DDPProblemCartPole::InputDimVector & u,
+                      double dt) { return ddp_problem->stateEq(t, x, u, dt); },
+                  [](double, // t
+                     const DDPProblemCartPole::StateDimVector & // x
+                  ) {},
+                  [&](double t, const DDPProblemCartPole::StateDimVector & x) { return mpc.calcInput(t, x); });
+  harness.config().print_level = 0;
+  harness.config().sim_dt = 0.002;
+  harness.config().mpc_dt = 0.002;
+  harness.config().end_t = 6.0;
+  harness.setRefFunc([](double // t
+                     ) { return DDPProblemCartPole::StateDimVector::Zero(); });
+  harness.addDisturbance(3.0, DDPProblemCartPole::InputDimVector(20.0), 0.2);
+  auto result = harness.run(DDPProblemCartPole::StateDimVector(0.0, 0.5, 0.0, 0.0));
+
+  statistics = mpc.statistics();
+  statistics.print();
+  return result;
+}
+
+TEST(TestEventTriggeredMpc, CartPole)
+{
+  // Solve in every step
+  nmpc_ddp::EventTriggeredMpc<DDPSolverCartPole>::Statistics always_statistics;
+  auto always_result = run(0.0, always_statistics);
+  EXPECT_EQ(always_statistics.solveNum(), always_statistics.step_num);
+  EXPECT_EQ(always_statistics.full_solve_num, always_statistics.step_num);
+  EXPECT_NEAR(always_statistics.savingRate(), 0.0, 1e-10);
+
+  // Solve only when triggered
+  nmpc_ddp::EventTriggeredMpc<DDPSolverCartPole>::Statistics triggered_statistics;
+  auto triggered_result = run(1e-3, triggered_statistics);
+  EXPECT_EQ(triggered_statistics.step_num, always_statistics.step_num);
+  EXPECT_LT(triggered_statistics.triggerRate(), 0.5);
+  EXPECT_GT(triggered_statistics.partial_solve_num, 0);
+  EXPECT_GT(triggered_statistics.full_solve_num, 0);
+  EXPECT_GT(triggered_statistics.savedDuration(), 0.0);
+  EXPECT_LT(triggered_statistics.solve_duration, always_statistics.solve_duration);
+
+  // Check that the control performance is maintained
+  EXPECT_LT(std::abs(triggered_result.final_x[0]), 0.5);
+  EXPECT_LT(std::abs(triggered_result.final_x[1]), 0.05);
+  EXPECT_LT(triggered_result.tracking_error_rms[1], 1.5 * always_result.tracking_error_rms[1]);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
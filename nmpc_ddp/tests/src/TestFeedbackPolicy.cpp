@@ -0,0 +1,138 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include <nmpc_ddp/ClosedLoopHarness.h>
+#include <nmpc_ddp/DDPSolver.h>
+#include <nmpc_ddp/FeedbackPolicy.h>
+
+#include "DDPProblemCartPole.h"
+
+TEST(TestFeedbackPolicy, Interpolation)
+{
+  using Policy = nmpc_ddp::FeedbackPolicy<2, 1>;
+  std::vector<Eigen::Vector2d> x_list = {Eigen::Vector2d(0.0, 0.0), Eigen::Vector2d(1.0, 2.0),
+                                         Eigen::Vector2d(2.0, 4.0)};
+  std::vector<Eigen::Vector1d> u_list = {Eigen::Vector1d(1.0), Eigen::Vector1d(3.0)};
+  std::vector<Eigen::Matrix<double, 1, 2>> K_list = {Eigen::Matrix<double, 1, 2>(-1.0, 0.0),
+                                                     Eigen::Matrix<double, 1, 2>(0.0, -2.0)};
+  Policy policy(10.0, 0.1, x_list, u_list, K_list);
+  EXPECT_DOUBLE_EQ(policy.startTime(), 10.0);
+  EXPECT_DOUBLE_EQ(policy.endTime(), 10.2);
+
+  // Nominal input on nominal state
+  EXPECT_NEAR(policy.calcInput(10.0, x_list[0])[0], 1.0, 1e-10);
+  EXPECT_NEAR(policy.calcInput(10.1, x_list[1])[0], 3.0, 1e-10);
+  EXPECT_NEAR(policy.calcInput(10.05, Eigen::Vector2d(0.5, 1.0))[0], 2.0, 1e-10);
+
+  // Feedback of the stage containing the time
+  EXPECT_NEAR(policy.calcInput(10.05, Eigen::Vector2d(1.5, 1.0))[0], 2.0 - 1.0, 1e-10);
+  EXPECT_NEAR(policy.calcInput(10.15, Eigen::Vector2d(1.5, 4.0))[0], 3.0 - 2.0, 1e-10);
+
+  // Time outside the horizon
+  EXPECT_NEAR(policy.calcInput(9.0, x_list[0])[0], 1.0, 1e-10);
+  EXPECT_NEAR(policy.calcInput(11.0, x_list[2])[0], 3.0, 1e-10);
+
+  // Input limits
+  std::vector<Eigen::Vector1d> u_lower_list(2, Eigen::Vector1d(-0.5));
+  std::vector<Eigen::Vector1d> u_upper_list(2, Eigen::Vector1d(2.5));
+  Policy limited_policy(10.0, 0.1, x_list, u_list, K_list, u_lower_list, u_upper_list);
+  EXPECT_NEAR(limited_policy.calcInput(10.1, x_list[1])[0], 2.5, 1e-10);
+  EXPECT_NEAR(limited_policy.calcInput(10.0, Eigen::Vector2d(2.0, 0.0))[0], -0.5, 1e-10);
+
+  // Inconsistent sizes
+  EXPECT_THROW(Policy(0.0, 0.1, x_list, u_list, {K_list[0]}), std::invalid_argument);
+  EXPECT_THROW(Policy(0.0, 0.1, x_list, u_list, K_list, u_lower_list), std::invalid_argument);
+}
+
+TEST(TestFeedbackPolicy, CartPole)
+{
+  // Instantiate problem
+  double horizon_dt = 0.01; // [sec]
+  double horizon_duration = 2.0; // [sec]
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(horizon_dt, [](double // t
+                                                                         ) { return 0.0; });
+
+  // Instantiate solver
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1>>(ddp_problem);
+  auto input_limits_func = [](double // t
+                              ) -> std::array<DDPProblemCartPole::InputDimVector, 2>
+  { return {DDPProblemCartPole::InputDimVector(-15.0), DDPProblemCartPole::InputDimVector(15.0)}; };
+  ddp_solver->setInputLimitsFunc(input_limits_func);
+  ddp_solver->config().with_input_constraint = true;
+  ddp_solver->config().horizon_steps = static_cast<int>(horizon_duration / horizon_dt);
+  ddp_solver->config().max_iter = 3;
+  ddp_solver->config().print_level = 0;
+
+  // Check that the policy reproduces the nominal input on the nominal state
+  DDPProblemCartPole::StateDimVector initial_x(0.0, 0.5, 0.0, 0.0);
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(ddp_solver->config().horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+  ddp_solver->solve(0.0, initial_x, initial_u_list);
+  auto policy = ddp_solver->feedbackPolicy();
+  const auto & control_data = ddp_solver->controlData();
+  for(int i = 0; i < ddp_solver->config().horizon_steps; i++)
+  {
+    DDPProblemCartPole::InputDimVector u = control_data.u_list[i].cwiseMax(-15.0).cwiseMin(15.0);
+    EXPECT_LT((policy->calcInput(i * horizon_dt, control_data.x_list[i]) - u).norm(), 1e-10) << "i: " << i;
+  }
+
+  // Measure evaluation duration
+  constexpr int eval_num = 100000;
+  DDPProblemCartPole::InputDimVector u_sum = DDPProblemCartPole::InputDimVector::Zero();
+  auto start_time = std::chrono::steady_clock::now();
+  for(int i = 0; i < eval_num; i++)
+  {
+    u_sum += policy->calcInput(i * horizon_duration / eval_num, initial_x);
+  }
+  double duration =
+      1e6 * std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() / eval_num;
+  EXPECT_TRUE(u_sum.allFinite());
+  std::cout << "Duration of feedback policy evaluation: " << duration << " [usec]" << std::endl;
+
+  // Compare closed-loop tracking error of slow MPC with and without the feedback policy
+  auto run = [&](bool use_policy)
+  {
+    using Harness = nmpc_ddp::ClosedLoopHarness<4, 1>;
+    std::vector<DDPProblemCartPole::InputDimVector> u_list = initial_u_list;
+    std::shared_ptr<const nmpc_ddp::FeedbackPolicy<4, 1>> current_policy;
+    DDPProblemCartPole::InputDimVector current_u = DDPProblemCartPole::InputDimVector::Zero();
+    Harness harness(
+        [&](double t, const DDPProblemCartPole::StateDimVector & x, const DDPProblemCartPole::InputDimVector & u,
+            double dt) { return ddp_problem->stateEq(t, x, u, dt); },
+        [&](double t, const DDPProblemCartPole::StateDimVector & x)
+        {
+          ddp_solver->solve(t, x, u_list);
+          u_list = ddp_solver->controlData().u_list;
+          current_policy = ddp_solver->feedbackPolicy();
+          current_u = current_policy->calcInput(t, x);
+        },
+        [&](double t, const DDPProblemCartPole::StateDimVector & x)
+        { return use_policy ? current_policy->calcInput(t, x) : current_u; });
+    harness.config().print_level = 0;
+    harness.config().sim_dt = 0.002;
+    harness.config().mpc_dt = 0.05;
+    harness.config().end_t = 5.0;
+    harness.setRefFunc([](double // t
+                       ) { return DDPProblemCartPole::StateDimVector::Zero(); });
+    harness.addDisturbance(1.0, DDPProblemCartPole::InputDimVector(20.0), 0.2);
+    return harness.run(initial_x);
+  };
+  auto stale_result = run(false);
+  auto policy_result = run(true);
+  std::cout << "Tracking error (RMS) with stale input: " << stale_result.tracking_error_rms.transpose() << std::endl;
+  std::cout << "Tracking error (RMS) with feedback policy: " << policy_result.tracking_error_rms.transpose()
+            << std::endl;
+  EXPECT_LT(std::abs(policy_result.final_x[1]), 1e-1);
+  EXPECT_LT(policy_result.tracking_error_rms[1], stale_result.tracking_error_rms[1]);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
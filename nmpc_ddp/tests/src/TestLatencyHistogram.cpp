@@ -0,0 +1,109 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <nmpc_ddp/DDPSolver.h>
+#include <nmpc_ddp/LatencyHistogram.h>
+
+#include "DDPProblemCartPole.h"
+
+TEST(TestLatencyHistogram, Percentile)
+{
+  nmpc_ddp::LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.percentile(50), 0.0);
+
+  // Record log-normally distributed durations
+  std::mt19937 engine(42);
+  std::lognormal_distribution<double> dist(0.0, 1.0);
+  std::vector<double> duration_list;
+  for(int i = 0; i < 10000; i++)
+  {
+    double duration = dist(engine); // [msec]
+    duration_list.push_back(duration);
+    histogram.record(duration);
+  }
+  std::sort(duration_list.begin(), duration_list.end());
+
+  EXPECT_EQ(histogram.count(), duration_list.size());
+  EXPECT_NEAR(histogram.min(), duration_list.front(), 1e-6);
+  EXPECT_NEAR(histogram.max(), duration_list.back(), 1e-6);
+  for(double percentile : {1.0, 50.0, 90.0, 99.0, 99.9})
+  {
+    double expected = duration_list[static_cast<size_t>(std::ceil(percentile / 100.0 * duration_list.size())) - 1];
+    double actual = histogram.percentile(percentile);
+    EXPECT_GE(actual, expected - 1e-6) << "percentile: " << percentile;
+    EXPECT_LE(actual, expected * (1.0 + 1.0 / 32.0) + 1e-6) << "percentile: " << percentile;
+  }
+  EXPECT_EQ(histogram.percentile(100), histogram.max());
+
+  histogram.reset();
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.max(), 0.0);
+}
+
+TEST(TestLatencyHistogram, Merge)
+{
+  nmpc_ddp::LatencyHistogram histogram1;
+  nmpc_ddp::LatencyHistogram histogram2;
+  nmpc_ddp::LatencyHistogram histogram_all;
+  for(int i = 1; i <= 1000; i++)
+  {
+    uint64_t duration_ns = static_cast<uint64_t>(i) * 1000;
+    (i % 3 == 0 ? histogram1 : histogram2).recordNsec(duration_ns);
+    histogram_all.recordNsec(duration_ns);
+  }
+
+  histogram1.merge(histogram2);
+  EXPECT_EQ(histogram1.count(), histogram_all.count());
+  EXPECT_EQ(histogram1.mean(), histogram_all.mean());
+  EXPECT_EQ(histogram1.min(), histogram_all.min());
+  EXPECT_EQ(histogram1.max(), histogram_all.max());
+  for(double percentile : {10.0, 50.0, 99.0})
+  {
+    EXPECT_EQ(histogram1.percentile(percentile), histogram_all.percentile(percentile));
+  }
+}
+
+TEST(TestLatencyHistogram, DDPSolver)
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1>>(ddp_problem);
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().horizon_steps = 100;
+  ddp_solver->config().max_iter = 3;
+  ddp_solver->config().use_latency_histogram = true;
+
+  constexpr int solve_num = 20;
+  DDPProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(ddp_solver->config().horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+  double max_duration = 0;
+  for(int i = 0; i < solve_num; i++)
+  {
+    ddp_solver->solve(0, current_x, initial_u_list);
+    max_duration = std::max(max_duration, ddp_solver->computationDuration().solve);
+  }
+
+  const auto & data = ddp_solver->latencyHistogramData();
+  EXPECT_EQ(data.solve.count(), solve_num);
+  EXPECT_EQ(data.gain.count(), solve_num);
+  EXPECT_NEAR(data.solve.max(), max_duration, 1e-6);
+  EXPECT_LE(data.solve.percentile(50), data.solve.percentile(99));
+  data.print();
+
+  ddp_solver->latencyHistogramData().reset();
+  EXPECT_EQ(ddp_solver->latencyHistogramData().solve.count(), 0);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
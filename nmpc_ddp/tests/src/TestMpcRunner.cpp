@@ -0,0 +1,134 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <thread>
+
+#include <nmpc_ddp/MpcRunner.h>
+
+#include "DDPProblemCartPole.h"
+
+TEST(TestMpcRunner, TripleBuffer)
+{
+  constexpr int value_num = 100000;
+  nmpc_ddp::TripleBuffer<std::vector<int>> buffer(std::vector<int>(2, -1));
+
+  // The reader gets the values in the order of publication with skips
+  std::thread writer_thread(
+      [&buffer]()
+      {
+        for(int i = 0; i < value_num; i++)
+        {
+          auto & value = buffer.writeBuffer();
+          value[0] = i;
+          value[1] = 2 * i;
+          buffer.publish();
+        }
+      });
+  int last_value = -1;
+  while(last_value < value_num - 1)
+  {
+    if(buffer.update())
+    {
+      const auto & value = buffer.readBuffer();
+      EXPECT_GT(value[0], last_value);
+      EXPECT_EQ(value[1], 2 * value[0]);
+      last_value = value[0];
+    }
+  }
+  writer_thread.join();
+  EXPECT_FALSE(buffer.update());
+}
+
+TEST(TestMpcRunner, ShiftList)
+{
+  std::vector<int> list = {0, 1, 2, 3, 4};
+  nmpc_ddp::shiftList(list, 0);
+  EXPECT_EQ(list, std::vector<int>({0, 1, 2, 3, 4}));
+  nmpc_ddp::shiftList(list, 2);
+  EXPECT_EQ(list, std::vector<int>({2, 3, 4, 4, 4}));
+  nmpc_ddp::shiftList(list, 10);
+  EXPECT_EQ(list, std::vector<int>({4, 4, 4, 4, 4}));
+}
+
+TEST(TestMpcRunner, DDPCartPole)
+{
+  // Instantiate problem
+  double horizon_dt = 0.01; // [sec]
+  double horizon_duration = 2.0; // [sec]
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(horizon_dt, [](double // t
+                                                                         ) { return 0.0; });
+
+  // Instantiate solver
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1>>(ddp_problem);
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<DDPProblemCartPole::InputDimVector, 2>
+      {
+        return {DDPProblemCartPole::InputDimVector(-15.0), DDPProblemCartPole::InputDimVector(15.0)};
+      });
+  ddp_solver->config().with_input_constraint = true;
+  ddp_solver->config().horizon_steps = static_cast<int>(horizon_duration / horizon_dt);
+  ddp_solver->config().max_iter = 3;
+
+  // Instantiate runner
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(ddp_solver->config().horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+  nmpc_ddp::MpcRunner<nmpc_ddp::DDPSolver<4, 1>> runner(ddp_solver, initial_u_list);
+  runner.start();
+  EXPECT_TRUE(runner.running());
+  EXPECT_FALSE(runner.updateSolution());
+  EXPECT_FALSE(runner.solution().valid);
+
+  // Run closed-loop simulation in which the control thread waits for the solution of each state
+  double sim_dt = 0.002; // [sec]
+  double mpc_dt = 0.02; // [sec]
+  double end_t = 5.0; // [sec]
+  DDPProblemCartPole::StateDimVector x(0.0, 0.5, 0.0, 0.0);
+  int mpc_count = 0;
+  for(double t = 0; t < end_t; t += mpc_dt)
+  {
+    runner.setState(t, x);
+    mpc_count++;
+    while(!runner.updateSolution() || runner.solution().solve_count < mpc_count)
+    {
+      std::this_thread::yield();
+    }
+    const auto & solution = runner.solution();
+    EXPECT_TRUE(solution.valid);
+    EXPECT_EQ(solution.t, t);
+    EXPECT_EQ(solution.dt, horizon_dt);
+    EXPECT_EQ(solution.u_list.size(), ddp_solver->config().horizon_steps);
+    EXPECT_EQ(solution.x_list.size(), ddp_solver->config().horizon_steps + 1);
+    EXPECT_LT((solution.x_list[0] - x).norm(), 1e-10);
+
+    for(double sim_t = t; sim_t < t + mpc_dt - 1e-10; sim_t += sim_dt)
+    {
+      x = ddp_problem->stateEq(sim_t, x, runner.calcInput(sim_t), sim_dt);
+    }
+  }
+  EXPECT_LT(std::abs(x[0]), 0.5);
+  EXPECT_LT(std::abs(x[1]), 0.05);
+
+  // Check that the latest state is solved when states are set faster than solves
+  for(int i = 0; i < 10; i++)
+  {
+    runner.setState(end_t + i * mpc_dt, x);
+  }
+  double last_t = end_t + 9 * mpc_dt;
+  while(!runner.updateSolution() || runner.solution().t != last_t)
+  {
+    std::this_thread::yield();
+  }
+  EXPECT_LE(runner.solution().solve_count, mpc_count + 10);
+
+  runner.stop();
+  EXPECT_FALSE(runner.running());
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,334 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <nmpc_ddp/MppiMpcRunner.h>
+
+#include "DDPProblemCartPole.h"
+
+/** \brief DDP problem to move a point mass into the target region.
+
+    State is [pos, vel]. Input is [acc].
+    Running cost is quadratic term of input.
+    Terminal cost is constant outside the target region and zero inside it, so its gradient is zero everywhere.
+ */
+class DDPProblemTargetRegion : public nmpc_ddp::DDPProblem<2, 1>
+{
+public:
+  DDPProblemTargetRegion(double dt) : DDPProblem(dt) {}
+
+  virtual StateDimVector stateEq(double, // t
+                                 const StateDimVector & x,
+                                 const InputDimVector & u) const override
+  {
+    return StateDimVector(x[0] + dt_ * x[1], x[1] + dt_ * u[0]);
+  }
+
+  virtual double runningCost(double, // t
+                             const StateDimVector &, // x
+                             const InputDimVector & u) const override
+  {
+    return 0.5 * input_weight_ * u.squaredNorm();
+  }
+
+  virtual double terminalCost(double, // t
+                              const StateDimVector & x) const override
+  {
+    return std::abs(x[0] - target_pos_) < 0.3 ? 0.0 : 10.0;
+  }
+
+  virtual void calcStateEqDeriv(double, // t
+                                const StateDimVector &, // x
+                                const InputDimVector &, // u
+                                Eigen::Ref<StateStateDimMatrix> state_eq_deriv_x,
+                                Eigen::Ref<StateInputDimMatrix> state_eq_deriv_u) const override
+  {
+    state_eq_deriv_x << 1, dt_, 0, 1;
+    state_eq_deriv_u << 0, dt_;
+  }
+
+  virtual void calcStateEqDeriv(double, // t
+                                const StateDimVector &, // x
+                                const InputDimVector &, // u
+                                Eigen::Ref<StateStateDimMatrix>, // state_eq_deriv_x
+                                Eigen::Ref<StateInputDimMatrix>, // state_eq_deriv_u
+                                std::vector<StateStateDimMatrix> &, // state_eq_deriv_xx
+                                std::vector<InputInputDimMatrix> &, // state_eq_deriv_uu
+                                std::vector<StateInputDimMatrix> & // state_eq_deriv_xu
+  ) const override
+  {
+    throw std::runtime_error("Second-order derivatives of state equation are not implemented.");
+  }
+
+  virtual void calcRunningCostDeriv(double, // t
+                                    const StateDimVector &, // x
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u) const override
+  {
+    running_cost_deriv_x.setZero();
+    running_cost_deriv_u = input_weight_ * u;
+  }
+
+  virtual void calcRunningCostDeriv(double t,
+                                    const StateDimVector & x,
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u,
+                                    Eigen::Ref<StateStateDimMatrix> running_cost_deriv_xx,
+                                    Eigen::Ref<InputInputDimMatrix> running_cost_deriv_uu,
+                                    Eigen::Ref<StateInputDimMatrix> running_cost_deriv_xu) const override
+  {
+    calcRunningCostDeriv(t, x, u, running_cost_deriv_x, running_cost_deriv_u);
+    running_cost_deriv_xx.setZero();
+    running_cost_deriv_uu.setConstant(input_weight_);
+    running_cost_deriv_xu.setZero();
+  }
+
+  virtual void calcTerminalCostDeriv(double, // t
+                                     const StateDimVector &, // x
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x) const override
+  {
+    terminal_cost_deriv_x.setZero();
+  }
+
+  virtual void calcTerminalCostDeriv(double, // t
+                                     const StateDimVector &, // x
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x,
+                                     Eigen::Ref<StateStateDimMatrix> terminal_cost_deriv_xx) const override
+  {
+    terminal_cost_deriv_x.setZero();
+    terminal_cost_deriv_xx.setZero();
+  }
+
+protected:
+  double input_weight_ = 1e-5;
+  double target_pos_ = 1.0;
+};
+
+template<class MppiSolverType = nmpc_ddp::MppiSolver<2, 1>>
+std::shared_ptr<MppiSolverType> makeMppiSolverTargetRegion()
+{
+  auto mppi_solver = std::make_shared<MppiSolverType>(std::make_shared<DDPProblemTargetRegion>(0.02));
+  mppi_solver->config().print_level = 0;
+  mppi_solver->config().horizon_steps = 50;
+  mppi_solver->config().max_iter = 5;
+  mppi_solver->config().input_stddev = Eigen::VectorXd::Constant(1, 10.0);
+  return mppi_solver;
+}
+
+TEST(TestMppiSolver, NonSmoothCost)
+{
+  constexpr int horizon_steps = 50;
+  DDPProblemTargetRegion::StateDimVector x = DDPProblemTargetRegion::StateDimVector::Zero();
+  std::vector<DDPProblemTargetRegion::InputDimVector> initial_u_list(horizon_steps,
+                                                                     DDPProblemTargetRegion::InputDimVector::Zero());
+
+  // Check that DDP gets stuck because the gradient of the terminal cost is zero
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<2, 1>>(std::make_shared<DDPProblemTargetRegion>(0.02));
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().horizon_steps = horizon_steps;
+  ddp_solver->solve(0.0, x, initial_u_list);
+  EXPECT_GE(ddp_solver->controlData().cost_list.sum(), 10.0);
+
+  // Check that MPPI reaches the target region
+  auto mppi_solver = makeMppiSolverTargetRegion();
+  EXPECT_TRUE(mppi_solver->solve(0.0, x, initial_u_list));
+  const auto & control_data = mppi_solver->controlData();
+  EXPECT_LT(control_data.cost_list.sum(), 1.0);
+  EXPECT_LT(std::abs(control_data.x_list.back()[0] - 1.0), 0.3);
+  EXPECT_EQ(mppi_solver->traceDataList().size(), 6);
+  EXPECT_EQ(mppi_solver->traceDataList().front().cost, 10.0);
+  EXPECT_GT(mppi_solver->traceDataList().back().effective_rollout_num, 1.0);
+
+  // Check that the result of MPPI is refined by DDP
+  auto refinement_solver = std::make_shared<nmpc_ddp::DDPSolver<2, 1>>(mppi_solver->problem());
+  refinement_solver->config().print_level = 0;
+  refinement_solver->config().horizon_steps = horizon_steps + 1;
+  mppi_solver->setRefinementSolver(refinement_solver);
+  EXPECT_THROW(mppi_solver->solve(0.0, x, initial_u_list), std::invalid_argument);
+  refinement_solver->config().horizon_steps = horizon_steps;
+  EXPECT_TRUE(mppi_solver->solve(0.0, x, initial_u_list));
+  EXPECT_TRUE(mppi_solver->refined());
+  EXPECT_LT(mppi_solver->controlData().cost_list.sum(), 1.0);
+  EXPECT_LT(mppi_solver->controlData().cost_list.sum(), mppi_solver->traceDataList().back().cost);
+  EXPECT_EQ(refinement_solver->config().horizon_steps, horizon_steps);
+}
+
+TEST(TestMppiSolver, RefinementSolverPolicy)
+{
+  constexpr int horizon_steps = 50;
+  DDPProblemTargetRegion::StateDimVector x = DDPProblemTargetRegion::StateDimVector::Zero();
+  std::vector<DDPProblemTargetRegion::InputDimVector> initial_u_list(horizon_steps,
+                                                                     DDPProblemTargetRegion::InputDimVector::Zero());
+
+  // Check that the solution is refined by the policy-specialized DDP solver in the same way
+  auto ref_solver = makeMppiSolverTargetRegion();
+  auto ref_refinement_solver = std::make_shared<nmpc_ddp::DDPSolver<2, 1>>(ref_solver->problem());
+  ref_refinement_solver->config().print_level = 0;
+  ref_refinement_solver->config().horizon_steps = horizon_steps;
+  ref_solver->setRefinementSolver(ref_refinement_solver);
+  EXPECT_TRUE(ref_solver->solve(0.0, x, initial_u_list));
+
+  using RefinementSolver = nmpc_ddp::DDPSolver<2, 1, nmpc_ddp::DDPStepInstrumentedPolicy>;
+  auto mppi_solver = makeMppiSolverTargetRegion<nmpc_ddp::MppiSolver<2, 1, RefinementSolver>>();
+  auto refinement_solver = std::make_shared<RefinementSolver>(mppi_solver->problem());
+  refinement_solver->config().print_level = 0;
+  refinement_solver->config().horizon_steps = horizon_steps;
+  mppi_solver->setRefinementSolver(refinement_solver);
+  EXPECT_TRUE(mppi_solver->solve(0.0, x, initial_u_list));
+  EXPECT_TRUE(mppi_solver->refined());
+  EXPECT_EQ(ref_solver->controlData().u_list, mppi_solver->controlData().u_list);
+  EXPECT_GT(mppi_solver->computationDuration().refinement, 0.0);
+}
+
+TEST(TestMppiSolver, Reproducibility)
+{
+  constexpr int horizon_steps = 50;
+  DDPProblemTargetRegion::StateDimVector x = DDPProblemTargetRegion::StateDimVector::Zero();
+  std::vector<DDPProblemTargetRegion::InputDimVector> initial_u_list(horizon_steps,
+                                                                     DDPProblemTargetRegion::InputDimVector::Zero());
+
+  auto serial_solver = makeMppiSolverTargetRegion();
+  serial_solver->solve(0.0, x, initial_u_list);
+
+  // Check that the result does not depend on the thread pool
+  nmpc_common::ThreadPool::Configuration thread_pool_config;
+  thread_pool_config.thread_num = 3;
+  auto parallel_solver = makeMppiSolverTargetRegion();
+  parallel_solver->setThreadPool(std::make_shared<nmpc_common::ThreadPool>(thread_pool_config));
+  parallel_solver->solve(0.0, x, initial_u_list);
+  EXPECT_EQ(serial_solver->controlData().u_list, parallel_solver->controlData().u_list);
+
+  // Check that the result depends on the seed
+  auto other_seed_solver = makeMppiSolverTargetRegion();
+  other_seed_solver->config().seed = 1;
+  other_seed_solver->solve(0.0, x, initial_u_list);
+  EXPECT_NE(serial_solver->controlData().u_list, other_seed_solver->controlData().u_list);
+}
+
+TEST(TestMppiSolver, Observer)
+{
+  constexpr int horizon_steps = 50;
+  DDPProblemTargetRegion::StateDimVector x = DDPProblemTargetRegion::StateDimVector::Zero();
+  std::vector<DDPProblemTargetRegion::InputDimVector> initial_u_list(horizon_steps,
+                                                                     DDPProblemTargetRegion::InputDimVector::Zero());
+
+  using MppiSolverCallback = nmpc_ddp::MppiSolver<2, 1, nmpc_ddp::DDPSolver<2, 1>, nmpc_ddp::CallbackObserver>;
+  auto mppi_solver = makeMppiSolverTargetRegion<MppiSolverCallback>();
+  std::vector<nmpc_ddp::SolverEvent> event_list;
+  mppi_solver->observer().callback = [&event_list](const nmpc_ddp::SolverEvent & event)
+  { event_list.push_back(event); };
+
+  // Check that the end of each iteration and the result are notified
+  mppi_solver->config().print_level = 2;
+  EXPECT_TRUE(mppi_solver->solve(0.0, x, initial_u_list));
+  ASSERT_EQ(static_cast<int>(event_list.size()), mppi_solver->config().max_iter + 1);
+  for(int iter = 1; iter <= mppi_solver->config().max_iter; iter++)
+  {
+    const auto & event = event_list[iter - 1];
+    EXPECT_EQ(event.type, nmpc_ddp::SolverEventType::IterationEnd);
+    EXPECT_EQ(event.iter, iter);
+    EXPECT_EQ(event.value("cost"), mppi_solver->traceDataList()[iter].cost);
+    EXPECT_EQ(event.value("effective_rollout_num"), mppi_solver->traceDataList()[iter].effective_rollout_num);
+  }
+  EXPECT_EQ(event_list.back().type, nmpc_ddp::SolverEventType::Info);
+  EXPECT_EQ(event_list.back().value("cost"), mppi_solver->controlData().cost_list.sum());
+
+  // Check that the failure is notified when all rollouts have non-finite costs
+  event_list.clear();
+  mppi_solver->config().print_level = 1;
+  std::vector<DDPProblemTargetRegion::InputDimVector> nan_u_list(
+      horizon_steps, DDPProblemTargetRegion::InputDimVector::Constant(std::numeric_limits<double>::quiet_NaN()));
+  EXPECT_FALSE(mppi_solver->solve(0.0, x, nan_u_list));
+  ASSERT_EQ(static_cast<int>(event_list.size()), mppi_solver->config().max_iter);
+  for(const auto & event : event_list)
+  {
+    EXPECT_EQ(event.type, nmpc_ddp::SolverEventType::Failure);
+    EXPECT_LE(event.level, 1);
+  }
+
+  // Check that events above print level are not notified
+  event_list.clear();
+  mppi_solver->config().print_level = 0;
+  EXPECT_TRUE(mppi_solver->solve(0.0, x, initial_u_list));
+  EXPECT_TRUE(event_list.empty());
+}
+
+TEST(TestMppiSolver, InputLimits)
+{
+  constexpr int horizon_steps = 50;
+  constexpr double u_max = 5.0;
+  DDPProblemTargetRegion::StateDimVector x = DDPProblemTargetRegion::StateDimVector::Zero();
+  std::vector<DDPProblemTargetRegion::InputDimVector> initial_u_list(horizon_steps,
+                                                                     DDPProblemTargetRegion::InputDimVector::Zero());
+
+  auto mppi_solver = makeMppiSolverTargetRegion();
+  mppi_solver->config().with_input_constraint = true;
+  EXPECT_THROW(mppi_solver->solve(0.0, x, initial_u_list), std::runtime_error);
+  mppi_solver->setInputLimitsFunc(
+      [=](double // t
+      )
+      {
+        std::array<DDPProblemTargetRegion::InputDimVector, 2> limits;
+        limits[0].setConstant(-u_max);
+        limits[1].setConstant(u_max);
+        return limits;
+      });
+  EXPECT_TRUE(mppi_solver->solve(0.0, x, initial_u_list));
+  EXPECT_LT(std::abs(mppi_solver->controlData().x_list.back()[0] - 1.0), 0.3);
+  for(const auto & u : mppi_solver->controlData().u_list)
+  {
+    EXPECT_LE(std::abs(u[0]), u_max + 1e-10);
+  }
+
+  // Check invalid arguments
+  EXPECT_THROW(mppi_solver->solve(0.0, x, {}), std::invalid_argument);
+  mppi_solver->config().input_stddev = Eigen::VectorXd::Ones(2);
+  EXPECT_THROW(mppi_solver->solve(0.0, x, initial_u_list), std::invalid_argument);
+}
+
+TEST(TestMppiSolver, CartPole)
+{
+  // Swing up the pole by MPPI and refine the solution by DDP
+  constexpr int horizon_steps = 200;
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                   ) { return 0.0; });
+  using MppiSolverCartPole = nmpc_ddp::MppiSolver<4, 1>;
+  auto mppi_solver = std::make_shared<MppiSolverCartPole>(ddp_problem);
+  mppi_solver->config().print_level = 0;
+  mppi_solver->config().horizon_steps = horizon_steps;
+  mppi_solver->config().max_iter = 10;
+  mppi_solver->config().input_stddev = Eigen::VectorXd::Constant(1, 20.0);
+  mppi_solver->config().temperature = 10.0;
+  nmpc_common::ThreadPool::Configuration thread_pool_config;
+  thread_pool_config.thread_num = 3;
+  mppi_solver->setThreadPool(std::make_shared<nmpc_common::ThreadPool>(thread_pool_config));
+
+  DDPProblemCartPole::StateDimVector x(0, M_PI, 0, 0);
+  std::vector<DDPProblemCartPole::InputDimVector> u_list(horizon_steps, DDPProblemCartPole::InputDimVector::Zero());
+  EXPECT_TRUE(nmpc_ddp::MpcRunnerAdapter<MppiSolverCartPole>::solve(*mppi_solver, 0.0, x, u_list));
+  double mppi_cost = mppi_solver->controlData().cost_list.sum();
+  EXPECT_LT(mppi_cost, mppi_solver->traceDataList().front().cost);
+
+  // Check that DDP warm-started from the MPPI solution converges in fewer iterations than the cold start
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1>>(ddp_problem);
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().horizon_steps = horizon_steps;
+  ddp_solver->solve(0.0, x,
+                    std::vector<DDPProblemCartPole::InputDimVector>(horizon_steps,
+                                                                    DDPProblemCartPole::InputDimVector::Zero()));
+  int cold_iter = ddp_solver->traceDataList().back().iter;
+  double cold_cost = ddp_solver->controlData().cost_list.sum();
+  EXPECT_TRUE(ddp_solver->solve(0.0, x, u_list));
+  int warm_iter = ddp_solver->traceDataList().back().iter;
+  EXPECT_LT(warm_iter, cold_iter);
+  EXPECT_LT(ddp_solver->controlData().cost_list.sum(), mppi_cost);
+  EXPECT_NEAR(ddp_solver->controlData().cost_list.sum(), cold_cost, 1e-2 * cold_cost);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
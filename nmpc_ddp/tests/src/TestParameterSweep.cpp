@@ -0,0 +1,200 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <sstream>
+
+#include <nmpc_ddp/ParameterSweep.h>
+
+#include "DDPProblemCartPole.h"
+
+using DDPSolverCartPole = nmpc_ddp::DDPSolver<4, 1>;
+using ParameterSweepCartPole = nmpc_ddp::ParameterSweep<DDPSolverCartPole, DDPProblemCartPole::CostWeight>;
+
+std::shared_ptr<ParameterSweepCartPole> makeParameterSweep(int horizon_steps)
+{
+  auto sweep = std::make_shared<ParameterSweepCartPole>(
+      [](const DDPProblemCartPole::CostWeight & cost_weight)
+      {
+        return std::make_shared<DDPProblemCartPole>(
+            0.01, [](double // t
+                  ) { return 0.0; }, DDPProblemCartPole::Param(), cost_weight);
+      },
+      [horizon_steps](const std::shared_ptr<nmpc_ddp::DDPProblem<4, 1>> & problem)
+      {
+        auto solver = std::make_shared<DDPSolverCartPole>(problem);
+        solver->config().print_level = 0;
+        solver->config().horizon_steps = horizon_steps;
+        solver->config().max_iter = 100;
+        return solver;
+      });
+  sweep->config().chunk_size = 8;
+  sweep->addMetric("terminal_theta", [](const DDPSolverCartPole & solver, const DDPProblemCartPole::CostWeight &)
+                   { return solver.controlData().x_list.back()[1]; });
+  return sweep;
+}
+
+std::vector<DDPProblemCartPole::CostWeight> makeCostWeightList(const std::vector<double> & u_weight_list,
+                                                               const std::vector<double> & theta_weight_list)
+{
+  // Sweep the running weights of input and theta
+  std::vector<DDPProblemCartPole::CostWeight> cost_weight_list;
+  for(const auto & point : ParameterSweepCartPole::makeGrid({u_weight_list, theta_weight_list}))
+  {
+    DDPProblemCartPole::CostWeight cost_weight;
+    cost_weight.running_u[0] = point[0];
+    cost_weight.running_x[1] = point[1];
+    cost_weight_list.push_back(cost_weight);
+  }
+  return cost_weight_list;
+}
+
+TEST(TestParameterSweep, MakeGrid)
+{
+  auto point_list = ParameterSweepCartPole::makeGrid({{1, 2}, {3, 4, 5}});
+  std::vector<std::vector<double>> ref_point_list = {{1, 3}, {1, 4}, {1, 5}, {2, 3}, {2, 4}, {2, 5}};
+  EXPECT_EQ(point_list, ref_point_list);
+}
+
+TEST(TestParameterSweep, CartPole)
+{
+  constexpr int horizon_steps = 200;
+  auto cost_weight_list =
+      makeCostWeightList({1e-3, 2e-3}, {1.0, 1.25, 1.5, 1.75, 2.0, 2.25, 2.5, 2.75, 3.0, 3.25, 3.5, 3.75});
+  DDPProblemCartPole::StateDimVector x(0.0, M_PI, 0.0, 0.0);
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+
+  auto serial_sweep = makeParameterSweep(horizon_steps);
+  auto serial_table = serial_sweep->run(cost_weight_list, 0.0, x, initial_u_list);
+
+  nmpc_common::ThreadPool::Configuration thread_pool_config;
+  thread_pool_config.thread_num = 2;
+  auto parallel_sweep = makeParameterSweep(horizon_steps);
+  parallel_sweep->setThreadPool(std::make_shared<nmpc_common::ThreadPool>(thread_pool_config));
+  auto parallel_table = parallel_sweep->run(cost_weight_list, 0.0, x, initial_u_list);
+
+  auto cold_sweep = makeParameterSweep(horizon_steps);
+  cold_sweep->config().warm_start_from_neighbor = false;
+  auto cold_table = cold_sweep->run(cost_weight_list, 0.0, x, initial_u_list);
+
+  ASSERT_EQ(serial_table.rowNum(), cost_weight_list.size());
+  for(size_t i = 0; i < cost_weight_list.size(); i++)
+  {
+    EXPECT_EQ(serial_table.column("succeeded")[i], 1) << "i: " << i;
+
+    // Check that each point is warm-started from the previous point in the chunk
+    EXPECT_EQ(serial_table.column("warm_start_idx")[i], i % 8 == 0 ? -1 : static_cast<int>(i) - 1) << "i: " << i;
+    EXPECT_EQ(cold_table.column("warm_start_idx")[i], -1) << "i: " << i;
+
+    // Check that the results do not depend on the thread pool
+    EXPECT_EQ(serial_table.column("cost")[i], parallel_table.column("cost")[i]) << "i: " << i;
+    EXPECT_EQ(serial_table.column("iter")[i], parallel_table.column("iter")[i]) << "i: " << i;
+
+    // Check that the warm-start does not change the solution
+    EXPECT_NEAR(serial_table.column("cost")[i], cold_table.column("cost")[i],
+                1e-3 * std::abs(cold_table.column("cost")[i]))
+        << "i: " << i;
+  }
+
+  // Check that the warm-start reduces the iterations
+  auto sum = [](const std::vector<double> & column) { return std::accumulate(column.begin(), column.end(), 0.0); };
+  EXPECT_LT(sum(serial_table.column("iter")), sum(cold_table.column("iter")));
+
+  // Check that the pole is swung up for all points
+  for(double terminal_theta : serial_table.column("terminal_theta"))
+  {
+    EXPECT_LT(std::abs(terminal_theta), 0.1);
+  }
+
+  // Check the columns
+  std::stringstream ss;
+  serial_table.writeCsv(ss);
+  std::string header;
+  std::getline(ss, header);
+  EXPECT_EQ(header, "succeeded,cost,iter,duration,warm_start_idx,terminal_theta");
+  EXPECT_THROW(serial_table.column("unknown"), std::invalid_argument);
+}
+
+TEST(TestParameterSweep, SkippedSolve)
+{
+  constexpr int horizon_steps = 50;
+  int problem_num = 0;
+  ParameterSweepCartPole sweep(
+      [&](const DDPProblemCartPole::CostWeight & cost_weight)
+      {
+        problem_num++;
+        return std::make_shared<DDPProblemCartPole>(
+            0.01, [](double // t
+                  ) { return 0.0; }, DDPProblemCartPole::Param(), cost_weight);
+      },
+      [](const std::shared_ptr<nmpc_ddp::DDPProblem<4, 1>> & problem)
+      { return std::make_shared<DDPSolverCartPole>(problem); });
+  sweep.config().chunk_size = 4;
+  sweep.config().print_level = 0;
+  // Solve function that returns without solving, which leaves the trace data of new solvers empty
+  sweep.setSolveFunc([](DDPSolverCartPole &, const DDPProblemCartPole::CostWeight &, double,
+                        const DDPProblemCartPole::StateDimVector &,
+                        std::vector<DDPProblemCartPole::InputDimVector> &) { return false; });
+
+  auto cost_weight_list = makeCostWeightList({1e-3}, {1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0, 4.5, 5.0, 5.5});
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+  auto table = sweep.run(cost_weight_list, 0.0, DDPProblemCartPole::StateDimVector::Zero(), initial_u_list);
+
+  // Check that the problem is created once for each point
+  EXPECT_EQ(problem_num, static_cast<int>(cost_weight_list.size()));
+  for(size_t i = 0; i < cost_weight_list.size(); i++)
+  {
+    EXPECT_EQ(table.column("succeeded")[i], 0) << "i: " << i;
+    EXPECT_EQ(table.column("iter")[i], 0) << "i: " << i;
+  }
+}
+
+TEST(TestParameterSweep, ClosedLoop)
+{
+  constexpr int horizon_steps = 200;
+  auto cost_weight_list = makeCostWeightList({1e-3, 1e-2}, {1.0, 2.0, 4.0});
+  DDPProblemCartPole::StateDimVector x(0.0, 0.5, 0.0, 0.0);
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+
+  // Run closed-loop simulation with the solver for each point
+  auto sweep = makeParameterSweep(horizon_steps);
+  sweep->config().chunk_size = 2;
+  sweep->setSolveFunc(
+      [](DDPSolverCartPole & solver, const DDPProblemCartPole::CostWeight &, // cost_weight
+         double t, const DDPProblemCartPole::StateDimVector & x,
+         std::vector<DDPProblemCartPole::InputDimVector> & u_list)
+      {
+        constexpr double mpc_dt = 0.01;
+        DDPProblemCartPole::StateDimVector current_x = x;
+        for(int i = 0; i < 200; i++)
+        {
+          double current_t = t + i * mpc_dt;
+          if(!nmpc_ddp::MpcRunnerAdapter<DDPSolverCartPole>::solve(solver, current_t, current_x, u_list))
+          {
+            return false;
+          }
+          current_x = solver.problem()->stateEq(current_t, current_x, u_list.front());
+          nmpc_ddp::MpcRunnerAdapter<DDPSolverCartPole>::shift(u_list, 1);
+        }
+        return std::abs(current_x[1]) < 0.2;
+      });
+  nmpc_common::ThreadPool::Configuration thread_pool_config;
+  thread_pool_config.thread_num = 2;
+  sweep->setThreadPool(std::make_shared<nmpc_common::ThreadPool>(thread_pool_config));
+  auto table = sweep->run(cost_weight_list, 0.0, x, initial_u_list);
+
+  for(size_t i = 0; i < cost_weight_list.size(); i++)
+  {
+    EXPECT_EQ(table.column("succeeded")[i], 1) << "i: " << i;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/DDPSolver.h>
+#include <nmpc_ddp/PerfCounter.h>
+
+#include "DDPProblemCartPole.h"
+
+TEST(TestPerfCounter, Count)
+{
+  nmpc_ddp::PerfCounter::Count count1;
+  count1.cycles = 100;
+  count1.instructions = 250;
+  count1.cache_misses = 3;
+  count1.branch_misses = 4;
+  EXPECT_EQ(count1.ipc(), 2.5);
+
+  nmpc_ddp::PerfCounter::Count count2 = count1;
+  count2 += count1;
+  EXPECT_EQ(count2.cycles, 200);
+  EXPECT_EQ(count2.branch_misses, 8);
+
+  const auto & count3 = count2 - count1;
+  EXPECT_EQ(count3.instructions, count1.instructions);
+  EXPECT_EQ(count3.cache_misses, count1.cache_misses);
+
+  EXPECT_EQ(nmpc_ddp::PerfCounter::Count().ipc(), 0.0);
+}
+
+TEST(TestPerfCounter, Read)
+{
+  nmpc_ddp::PerfCounter perf_counter;
+  std::cout << "Hardware performance counters are " << (perf_counter.available() ? "" : "not ") << "available."
+            << std::endl;
+
+  const auto & start_count = perf_counter.read();
+  volatile double sum = 0;
+  for(int i = 0; i < 1000000; i++)
+  {
+    sum = sum + std::sqrt(static_cast<double>(i));
+  }
+  const auto & count = perf_counter.read() - start_count;
+
+  if(perf_counter.available())
+  {
+    EXPECT_GT(count.instructions, 1000000);
+  }
+  else
+  {
+    EXPECT_EQ(count.cycles, 0);
+    EXPECT_EQ(count.instructions, 0);
+  }
+}
+
+TEST(TestPerfCounter, DDPSolver)
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1>>(ddp_problem);
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().horizon_steps = 100;
+  ddp_solver->config().max_iter = 3;
+  DDPProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(ddp_solver->config().horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+
+  // Counters are not measured by default
+  ddp_solver->solve(0, current_x, initial_u_list);
+  EXPECT_EQ(ddp_solver->perfCounterData().solve.instructions, 0);
+
+  // Measure counters
+  ddp_solver->config().use_perf_counter = true;
+  ddp_solver->solve(0, current_x, initial_u_list);
+  const auto & data = ddp_solver->perfCounterData();
+  bool available = nmpc_ddp::PerfCounter(0).available();
+  if(available)
+  {
+    EXPECT_GT(data.derivative.instructions, 0);
+    EXPECT_GT(data.backward.instructions, 0);
+    EXPECT_GT(data.Q.instructions, 0);
+    EXPECT_GT(data.gain.instructions, 0);
+    EXPECT_GE(data.solve.instructions,
+              data.derivative.instructions + data.backward.instructions + data.forward.instructions);
+    EXPECT_GE(data.backward.instructions, data.Q.instructions + data.reg.instructions + data.gain.instructions);
+  }
+  else
+  {
+    EXPECT_EQ(data.solve.instructions, 0);
+    EXPECT_EQ(data.backward.cycles, 0);
+  }
+
+  std::cout << "solve: " << data.solve.cycles << " cycles, IPC " << data.solve.ipc() << ", "
+            << data.solve.cache_misses << " cache misses, " << data.solve.branch_misses << " branch misses"
+            << std::endl;
+  std::cout << "backward: " << data.backward.cycles << " cycles, IPC " << data.backward.ipc() << ", "
+            << data.backward.cache_misses << " cache misses, " << data.backward.branch_misses << " branch misses"
+            << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
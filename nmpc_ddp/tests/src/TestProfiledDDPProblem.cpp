@@ -0,0 +1,82 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/DDPSolver.h>
+#include <nmpc_ddp/ProfiledDDPProblem.h>
+
+#include "DDPProblemCartPole.h"
+
+std::shared_ptr<nmpc_ddp::DDPSolver<4, 1>> makeSolver(const std::shared_ptr<nmpc_ddp::DDPProblem<4, 1>> & problem)
+{
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1>>(problem);
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<DDPProblemCartPole::InputDimVector, 2>
+      {
+        return {DDPProblemCartPole::InputDimVector(-15.0), DDPProblemCartPole::InputDimVector(15.0)};
+      });
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().with_input_constraint = true;
+  ddp_solver->config().horizon_steps = 200;
+  ddp_solver->config().max_iter = 10;
+  return ddp_solver;
+}
+
+TEST(TestProfiledDDPProblem, CartPole)
+{
+  constexpr int horizon_steps = 200;
+  DDPProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+  auto make_problem = []()
+  {
+    return std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                      ) { return 0.0; });
+  };
+
+  // Solve without profile
+  auto ref_solver = makeSolver(make_problem());
+  bool ref_result = ref_solver->solve(0.0, current_x, initial_u_list);
+
+  // Solve with profile
+  auto profiled_problem = std::make_shared<nmpc_ddp::ProfiledDDPProblem<4, 1>>(make_problem());
+  auto solver = makeSolver(profiled_problem);
+  for(int i = 0; i < 2; i++)
+  {
+    EXPECT_EQ(solver->solve(0.0, current_x, initial_u_list), ref_result);
+
+    // Check that the results are identical
+    EXPECT_EQ(solver->traceDataList().size(), ref_solver->traceDataList().size());
+    EXPECT_EQ(solver->controlData().u_list, ref_solver->controlData().u_list);
+
+    // Check the number of calls in the solve
+    auto report = profiled_problem->profile().takeReport();
+    report.print();
+    int derivative_num = static_cast<int>(report.find("calcTerminalCostDeriv (2nd)")->count);
+    EXPECT_GE(derivative_num, 1);
+    EXPECT_LE(derivative_num, solver->config().max_iter);
+    EXPECT_EQ(report.find("calcStateEqDeriv")->count, derivative_num * horizon_steps);
+    EXPECT_EQ(report.find("calcRunningCostDeriv (2nd)")->count, derivative_num * horizon_steps);
+    EXPECT_EQ(report.find("calcStateEqDeriv (2nd)")->count, 0);
+    EXPECT_GE(report.find("stateEq")->count, horizon_steps);
+    EXPECT_EQ(report.find("stateEq")->count % horizon_steps, 0);
+    EXPECT_EQ(report.find("runningCost")->count, report.find("stateEq")->count);
+
+    // Check that the duration of the model code is included in that of the solver
+    double derivative_duration = report.find("calcStateEqDeriv")->duration
+                                 + report.find("calcRunningCostDeriv (2nd)")->duration
+                                 + report.find("calcTerminalCostDeriv (2nd)")->duration;
+    EXPECT_LE(derivative_duration, solver->computationDuration().derivative);
+    EXPECT_LE(report.totalDuration(), solver->computationDuration().solve);
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,216 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <nmpc_ddp/SolutionChannel.h>
+
+namespace Eigen
+{
+using Vector1d = Eigen::Matrix<double, 1, 1>;
+}
+
+using Writer = nmpc_ddp::SolutionChannelWriter<2, 1>;
+using Reader = nmpc_ddp::SolutionChannelReader<2, 1>;
+
+std::string channelName(const std::string & suffix)
+{
+  return "/nmpc_test_" + std::to_string(getpid()) + "_" + suffix;
+}
+
+/** \brief Publish solution in which all values are determined by the publication count. */
+void publish(Writer & writer, int count, int horizon_steps)
+{
+  std::vector<Eigen::Vector2d> x_list(horizon_steps + 1);
+  std::vector<Eigen::Vector1d> u_list(horizon_steps);
+  std::vector<Eigen::Matrix<double, 1, 2>> K_list(horizon_steps);
+  for(int i = 0; i < horizon_steps; i++)
+  {
+    x_list[i] << count, i;
+    u_list[i] << count + i;
+    K_list[i] << -count, -i;
+  }
+  x_list[horizon_steps] << count, horizon_steps;
+  writer.publish(0.1 * count, 0.01, x_list, u_list, K_list);
+}
+
+/** \brief Check that the solution is the one published by publish(). */
+bool checkView(const Reader::View & view, int horizon_steps)
+{
+  double count = static_cast<double>(view.publishCount());
+  if(view.horizonSteps() != horizon_steps || view.t() != 0.1 * count || view.dt() != 0.01 || !view.withGain())
+  {
+    return false;
+  }
+  for(int i = 0; i < horizon_steps; i++)
+  {
+    if(view.x(i) != Eigen::Vector2d(count, i) || view.u(i)[0] != count + i
+       || view.K(i) != Eigen::Matrix<double, 1, 2>(-count, -i))
+    {
+      return false;
+    }
+  }
+  return view.x(horizon_steps) == Eigen::Vector2d(count, horizon_steps);
+}
+
+TEST(TestSolutionChannel, SingleProcess)
+{
+  std::string name = channelName("single");
+  EXPECT_THROW(Reader reader(name), std::runtime_error);
+
+  Writer writer(name, 2, 1, 100);
+  Reader reader(name);
+  EXPECT_EQ(reader.publishCount(), 0);
+  EXPECT_FALSE(reader.read([](const Reader::View &) {}));
+  EXPECT_THROW((nmpc_ddp::SolutionChannelReader<3, 1>(name)), std::runtime_error);
+
+  // Read published solutions in place
+  for(int count = 1; count <= 3; count++)
+  {
+    publish(writer, count, 50 + count);
+    EXPECT_EQ(reader.publishCount(), static_cast<uint64_t>(count));
+    bool valid = false;
+    EXPECT_TRUE(reader.read(
+        [&](const Reader::View & view)
+        { valid = checkView(view, 50 + count) && view.publishCount() == static_cast<uint64_t>(count); }));
+    EXPECT_TRUE(valid);
+  }
+  EXPECT_THROW(publish(writer, 4, 101), std::invalid_argument);
+
+  // Check that the input is the same as the feedback policy
+  std::vector<Eigen::Vector2d> x_list = {Eigen::Vector2d(0.0, 0.0), Eigen::Vector2d(1.0, 2.0),
+                                         Eigen::Vector2d(2.0, 4.0)};
+  std::vector<Eigen::Vector1d> u_list = {Eigen::Vector1d(1.0), Eigen::Vector1d(3.0)};
+  std::vector<Eigen::Matrix<double, 1, 2>> K_list = {Eigen::Matrix<double, 1, 2>(-1.0, 0.0),
+                                                     Eigen::Matrix<double, 1, 2>(0.0, -2.0)};
+  nmpc_ddp::FeedbackPolicy<2, 1> policy(1.0, 0.1, x_list, u_list, K_list);
+  writer.publish(policy);
+  for(double t : {0.9, 1.0, 1.05, 1.15, 1.3})
+  {
+    Eigen::Vector2d x(0.3, -0.2);
+    Eigen::Vector1d u;
+    EXPECT_TRUE(reader.read([&](const Reader::View & view) { u = view.calcInput(t, x); }));
+    EXPECT_NEAR(u[0], policy.calcInput(t, x)[0], 1e-10) << "t: " << t;
+  }
+}
+
+TEST(TestSolutionChannel, InvalidPublish)
+{
+  using DynamicWriter = nmpc_ddp::SolutionChannelWriter<Eigen::Dynamic, Eigen::Dynamic>;
+  using DynamicReader = nmpc_ddp::SolutionChannelReader<Eigen::Dynamic, Eigen::Dynamic>;
+  std::string name = channelName("invalid");
+  DynamicWriter writer(name, 2, 1, 10);
+  DynamicReader reader(name);
+
+  std::vector<Eigen::VectorXd> x_list(3, Eigen::VectorXd::Constant(2, 1.0));
+  std::vector<Eigen::VectorXd> u_list(2, Eigen::VectorXd::Constant(1, 2.0));
+  std::vector<Eigen::MatrixXd> K_list(2, Eigen::MatrixXd::Constant(1, 2, 3.0));
+
+  // Check that a publication with invalid sizes does not break the channel
+  for(int i = 0; i < 3; i++)
+  {
+    if(i % 2 == 0)
+    {
+      auto invalid_x_list = x_list;
+      invalid_x_list.back().setZero(3);
+      EXPECT_THROW(writer.publish(0.0, 0.1, invalid_x_list, u_list, K_list), std::invalid_argument);
+    }
+    else
+    {
+      auto invalid_K_list = K_list;
+      invalid_K_list.back().setZero(2, 2);
+      EXPECT_THROW(writer.publish(0.0, 0.1, x_list, u_list, invalid_K_list), std::invalid_argument);
+    }
+    EXPECT_EQ(writer.publishCount(), i);
+
+    writer.publish(0.1 * i, 0.1, x_list, u_list, K_list);
+    EXPECT_EQ(reader.publishCount(), i + 1);
+    double t = -1.0;
+    Eigen::VectorXd x_last;
+    Eigen::MatrixXd K_last;
+    EXPECT_TRUE(reader.read(
+        [&](const DynamicReader::View & view)
+        {
+          t = view.t();
+          x_last = view.x(view.horizonSteps());
+          K_last = view.K(view.horizonSteps() - 1);
+        },
+        0));
+    EXPECT_EQ(t, 0.1 * i);
+    EXPECT_EQ(x_last, x_list.back());
+    EXPECT_EQ(K_last, K_list.back());
+  }
+}
+
+TEST(TestSolutionChannel, TwoProcesses)
+{
+  constexpr int publish_num = 20000;
+  constexpr int horizon_steps = 100;
+  std::string name = channelName("two");
+  Writer writer(name, 2, 1, horizon_steps);
+
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if(pid == 0)
+  {
+    // Reader process: read the latest solutions while the writer is publishing
+    int exit_code = 0;
+    Reader reader(name);
+    int read_num = 0;
+    uint64_t last_count = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    while(last_count < publish_num)
+    {
+      if(std::chrono::steady_clock::now() - start_time > std::chrono::seconds(30))
+      {
+        exit_code = 2;
+        break;
+      }
+      bool valid = false;
+      uint64_t count = 0;
+      if(reader.read(
+             [&](const Reader::View & view)
+             {
+               count = view.publishCount();
+               valid = checkView(view, horizon_steps);
+             }))
+      {
+        if(!valid || count < last_count)
+        {
+          exit_code = 1;
+          break;
+        }
+        last_count = count;
+        read_num++;
+      }
+    }
+    if(exit_code == 0 && read_num == 0)
+    {
+      exit_code = 3;
+    }
+    _exit(exit_code);
+  }
+
+  // Writer process
+  for(int count = 1; count <= publish_num; count++)
+  {
+    publish(writer, count, horizon_steps);
+  }
+
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
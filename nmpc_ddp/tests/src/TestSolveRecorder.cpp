@@ -0,0 +1,215 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+
+#include <nmpc_ddp/DDPSolver.h>
+#include <nmpc_ddp/SolveRecorder.h>
+#include <nmpc_ddp/SolveReplayer.h>
+
+#include "DDPProblemCartPole.h"
+
+using DDPSolverCartPole = nmpc_ddp::DDPSolver<4, 1>;
+
+std::shared_ptr<DDPSolverCartPole> makeSolver(const std::shared_ptr<DDPProblemCartPole> & ddp_problem)
+{
+  auto ddp_solver = std::make_shared<DDPSolverCartPole>(ddp_problem);
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<Eigen::Vector1d, 2>
+      {
+        std::array<Eigen::Vector1d, 2> limits;
+        limits[0].setConstant(-15.0);
+        limits[1].setConstant(15.0);
+        return limits;
+      });
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().with_input_constraint = true;
+  ddp_solver->config().horizon_steps = 100;
+  ddp_solver->config().max_iter = 3;
+  return ddp_solver;
+}
+
+TEST(TestSolveRecorder, RecordAndReplay)
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  std::string file_path = "/tmp/TestSolveRecorder.bin";
+
+  // Record closed-loop solves
+  constexpr int record_num = 50;
+  std::vector<DDPProblemCartPole::InputDimVector> u_list;
+  {
+    auto ddp_solver = makeSolver(ddp_problem);
+    auto recorder = std::make_shared<nmpc_ddp::SolveRecorder>(file_path, 1024); // Small capacity to test extension
+    ddp_solver->setRecorder(recorder);
+
+    double sim_dt = 0.01; // [sec]
+    double current_t = 0;
+    DDPProblemCartPole::StateDimVector current_x;
+    current_x << 0, M_PI, 0, 0;
+    std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(ddp_solver->config().horizon_steps,
+                                                                   DDPProblemCartPole::InputDimVector::Zero());
+    for(int i = 0; i < record_num; i++)
+    {
+      ddp_solver->solve(current_t, current_x, initial_u_list);
+      initial_u_list = ddp_solver->controlData().u_list;
+      u_list.push_back(initial_u_list[0]);
+      current_x = ddp_problem->stateEq(current_t, current_x, initial_u_list[0], sim_dt);
+      current_t += sim_dt;
+    }
+    EXPECT_EQ(recorder->recordNum(), record_num);
+  }
+
+  // Read records
+  {
+    nmpc_ddp::SolveRecordReader reader(file_path);
+    EXPECT_EQ(reader.tag(), DDPSolverCartPole::recordTag());
+    ASSERT_EQ(reader.recordNum(), record_num);
+
+    DDPSolverCartPole::SolveRecord record;
+    reader.seek(record_num - 1);
+    record.read(reader);
+    EXPECT_EQ(record.config.horizon_steps, 100);
+    EXPECT_EQ(record.config.max_iter, 3);
+    EXPECT_EQ(record.initial_u_list.size(), 100);
+    EXPECT_EQ(record.u_lower_list.size(), 100);
+    EXPECT_EQ(record.control_data.u_list[0], u_list.back());
+    EXPECT_GT(record.computation_duration.solve, 0);
+  }
+
+  // Replay records with another solver
+  {
+    auto ddp_solver = makeSolver(ddp_problem);
+    ddp_solver->setInputLimitsFunc(nullptr); // Recorded input limits should be used
+    nmpc_ddp::SolveReplayer<DDPSolverCartPole> replayer(ddp_solver);
+    replayer.config().repeat_num = 2;
+    const auto & result_list = replayer.replay(file_path);
+    ASSERT_EQ(result_list.size(), record_num);
+    for(const auto & result : result_list)
+    {
+      EXPECT_EQ(result.recorded_iter, result.replayed_iter);
+      EXPECT_LT(result.output_error, 1e-10);
+      EXPECT_GT(result.replayed_duration, 0);
+    }
+
+    const auto & result = replayer.replay(file_path, 10);
+    EXPECT_EQ(result.idx, 10);
+    EXPECT_LT(result.output_error, 1e-10);
+  }
+}
+
+TEST(TestSolveRecorder, CommandLine)
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  std::string file_path = "/tmp/TestSolveRecorderCommandLine.bin";
+  {
+    auto ddp_solver = makeSolver(ddp_problem);
+    ddp_solver->setRecorder(std::make_shared<nmpc_ddp::SolveRecorder>(file_path));
+    DDPProblemCartPole::StateDimVector current_x(0, M_PI, 0, 0);
+    std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(ddp_solver->config().horizon_steps,
+                                                                   DDPProblemCartPole::InputDimVector::Zero());
+    for(int i = 0; i < 3; i++)
+    {
+      ddp_solver->solve(0.01 * i, current_x, initial_u_list);
+    }
+  }
+
+  auto ddp_solver = std::make_shared<DDPSolverCartPole>(ddp_problem);
+  auto replayMain = [&](const std::vector<const char *> & argv)
+  { return nmpc_ddp::replayMain(ddp_solver, static_cast<int>(argv.size()), argv.data()); };
+  EXPECT_EQ(replayMain({"replay", file_path.c_str()}), EXIT_SUCCESS);
+  EXPECT_EQ(replayMain({"replay", file_path.c_str(), "--idx", "2", "--repeat", "3", "--print-level", "0"}),
+            EXIT_SUCCESS);
+  EXPECT_EQ(replayMain({"replay", "--help"}), EXIT_SUCCESS);
+  EXPECT_EQ(replayMain({"replay"}), EXIT_FAILURE);
+  EXPECT_EQ(replayMain({"replay", file_path.c_str(), "--idx", "3"}), EXIT_FAILURE);
+  EXPECT_EQ(replayMain({"replay", file_path.c_str(), "--repeat"}), EXIT_FAILURE);
+  EXPECT_EQ(replayMain({"replay", file_path.c_str(), "--repeat", "x"}), EXIT_FAILURE);
+  EXPECT_EQ(replayMain({"replay", file_path.c_str(), "--unknown", "1"}), EXIT_FAILURE);
+  EXPECT_EQ(replayMain({"replay", "/tmp/TestSolveRecorderNotFound.bin"}), EXIT_FAILURE);
+}
+
+TEST(TestSolveRecorder, IncompleteRecord)
+{
+  std::string file_path = "/tmp/TestSolveRecorderIncomplete.bin";
+  {
+    nmpc_ddp::SolveRecorder recorder(file_path);
+    recorder.setTag("Test");
+    for(int i = 0; i < 3; i++)
+    {
+      recorder.beginRecord();
+      recorder.write<double>(i);
+      recorder.writeMatrix(Eigen::Vector3d::Constant(i));
+      recorder.endRecord();
+    }
+    // Simulate a record interrupted by a crash
+    recorder.beginRecord();
+    recorder.write<double>(3);
+    recorder.flush();
+
+    // Read while the file is being written
+    nmpc_ddp::SolveRecordReader reader(file_path);
+    EXPECT_EQ(reader.tag(), "Test");
+    ASSERT_EQ(reader.recordNum(), 3);
+    for(size_t i = 0; i < reader.recordNum(); i++)
+    {
+      reader.seek(i);
+      EXPECT_EQ(reader.read<double>(), i);
+      Eigen::Vector3d vec;
+      reader.readMatrix(vec);
+      EXPECT_EQ(vec, Eigen::Vector3d::Constant(i));
+      EXPECT_THROW(reader.read<double>(), std::runtime_error);
+    }
+  }
+
+  // Check mismatch of solver type
+  nmpc_ddp::SolveReplayer<DDPSolverCartPole> replayer(nullptr);
+  EXPECT_THROW(replayer.replay(file_path), std::runtime_error);
+}
+
+TEST(TestSolveRecorder, CorruptedRecord)
+{
+  std::string file_path = "/tmp/TestSolveRecorderCorrupted.bin";
+  {
+    nmpc_ddp::SolveRecorder recorder(file_path);
+    recorder.setTag("Test");
+    // Negative dimension
+    recorder.beginRecord();
+    recorder.write<int32_t>(-1);
+    recorder.write<int32_t>(1);
+    recorder.endRecord();
+    // Dimension exceeding the record
+    recorder.beginRecord();
+    recorder.write<int32_t>(1 << 30);
+    recorder.write<int32_t>(1 << 30);
+    recorder.write<double>(0);
+    recorder.endRecord();
+    // Number of matrices exceeding the record
+    recorder.beginRecord();
+    recorder.write<uint64_t>(static_cast<uint64_t>(1) << 62);
+    recorder.writeMatrix(Eigen::Vector3d::Zero());
+    recorder.endRecord();
+  }
+
+  nmpc_ddp::SolveRecordReader reader(file_path);
+  ASSERT_EQ(reader.recordNum(), 3);
+  Eigen::VectorXd vec;
+  std::vector<Eigen::VectorXd> vec_list;
+  reader.seek(0);
+  EXPECT_THROW(reader.readMatrix(vec), std::runtime_error);
+  reader.seek(1);
+  EXPECT_THROW(reader.readMatrix(vec), std::runtime_error);
+  reader.seek(2);
+  EXPECT_THROW(reader.readMatrixList(vec_list), std::runtime_error);
+  EXPECT_TRUE(vec_list.empty());
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
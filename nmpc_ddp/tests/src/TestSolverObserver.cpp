@@ -0,0 +1,198 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include <nmpc_ddp/DDPSolver.h>
+#include <nmpc_ddp/SolverObserver.h>
+
+#include "DDPProblemCartPole.h"
+
+TEST(TestSolverObserver, EventSink)
+{
+  nmpc_ddp::EventSink sink(100);
+  EXPECT_EQ(sink.capacity(), 128);
+
+  // Push events more than capacity
+  for(int i = 0; i < 200; i++)
+  {
+    EXPECT_EQ(sink.push(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::Info, 0, "Test", "event", i, {{"value", i}})),
+              i < 128);
+  }
+  EXPECT_EQ(sink.droppedNum(), 200 - 128);
+
+  // Check that the newest events are dropped
+  int idx = 0;
+  size_t num = sink.drain(
+      [&idx](const nmpc_ddp::SolverEvent & event)
+      {
+        EXPECT_EQ(event.iter, idx);
+        EXPECT_EQ(event.value("value"), idx);
+        EXPECT_TRUE(std::isnan(event.value("unknown")));
+        idx++;
+      });
+  EXPECT_EQ(num, 128);
+  EXPECT_EQ(sink.drain([](const nmpc_ddp::SolverEvent &) {}), 0);
+
+  // Check print format
+  std::ostringstream oss;
+  sink.push(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::LambdaIncrease, 3, "DDP/Forward", "Increase lambda.", 3,
+                                  {{"lambda", 0.5}}));
+  sink.push(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::Failure, 1, "BoxQP", "Failure."));
+  EXPECT_EQ(sink.flush(oss), 2);
+  EXPECT_EQ(oss.str(), "[DDP/Forward] Increase lambda. (iter: 3, lambda: 0.5)\n[BoxQP] Failure.\n"
+                       "[EventSink] 72 events are dropped because the queue is full (capacity: 128).\n");
+
+  // Check that the number of dropped events is printed only once
+  oss.str("");
+  EXPECT_EQ(sink.flush(oss), 0);
+  EXPECT_EQ(oss.str(), "");
+  for(int i = 0; i < 130; i++)
+  {
+    sink.push(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::Info, 0, "Test", "event"));
+  }
+  EXPECT_EQ(sink.flush(oss), 128);
+  EXPECT_NE(oss.str().find("[EventSink] 2 events are dropped"), std::string::npos);
+  EXPECT_EQ(sink.droppedNum(), 200 - 128 + 2);
+}
+
+TEST(TestSolverObserver, MultiThread)
+{
+  constexpr int thread_num = 4;
+  constexpr int push_num = 10000;
+  nmpc_ddp::EventSink sink(1024);
+
+  // Drain events concurrently with push
+  std::map<int, int> event_num_map;
+  std::atomic<bool> finished = false;
+  std::thread consumer_thread(
+      [&]()
+      {
+        auto func = [&event_num_map](const nmpc_ddp::SolverEvent & event) { event_num_map[event.iter]++; };
+        while(!finished.load())
+        {
+          sink.drain(func);
+        }
+        sink.drain(func);
+      });
+
+  std::vector<std::thread> thread_list;
+  for(int i = 0; i < thread_num; i++)
+  {
+    thread_list.emplace_back(
+        [&sink, i]()
+        {
+          for(int j = 0; j < push_num; j++)
+          {
+            sink.push(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::Info, 0, "Test", "event", i));
+          }
+        });
+  }
+  for(auto & thread : thread_list)
+  {
+    thread.join();
+  }
+  finished = true;
+  consumer_thread.join();
+
+  int total_num = 0;
+  for(const auto & [iter, event_num] : event_num_map)
+  {
+    EXPECT_GE(iter, 0);
+    EXPECT_LT(iter, thread_num);
+    total_num += event_num;
+  }
+  EXPECT_EQ(total_num + sink.droppedNum(), thread_num * push_num);
+}
+
+template<class Policy>
+std::shared_ptr<nmpc_ddp::DDPSolver<4, 1, Policy>> makeSolver()
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1, Policy>>(ddp_problem);
+  ddp_solver->config().horizon_steps = 100;
+  ddp_solver->config().max_iter = 10;
+  ddp_solver->config().with_input_constraint = true;
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<DDPProblemCartPole::InputDimVector, 2>
+      {
+        return {DDPProblemCartPole::InputDimVector(-15.0), DDPProblemCartPole::InputDimVector(15.0)};
+      });
+  return ddp_solver;
+}
+
+template<class Solver>
+void solve(Solver & ddp_solver)
+{
+  DDPProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(ddp_solver.config().horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+  ddp_solver.solve(0.0, current_x, initial_u_list);
+}
+
+TEST(TestSolverObserver, DDPCallback)
+{
+  using Policy = nmpc_ddp::DDPStaticPolicy<true, 1, 3, nmpc_ddp::Instrumentation::Phase, nmpc_ddp::CallbackObserver>;
+  auto ddp_solver = makeSolver<Policy>();
+  ddp_solver->config().print_level = 3;
+
+  std::map<nmpc_ddp::SolverEventType, int> event_num_map;
+  ddp_solver->observer().callback = [&event_num_map](const nmpc_ddp::SolverEvent & event)
+  {
+    EXPECT_LE(event.level, 3);
+    event_num_map[event.type]++;
+  };
+  solve(*ddp_solver);
+
+  int iter_num = static_cast<int>(ddp_solver->traceDataList().size()) - 1;
+  EXPECT_GT(iter_num, 0);
+  EXPECT_EQ(event_num_map[nmpc_ddp::SolverEventType::IterationStart], iter_num);
+  EXPECT_GT(event_num_map[nmpc_ddp::SolverEventType::IterationEnd], 0);
+  EXPECT_GT(event_num_map[nmpc_ddp::SolverEventType::LineSearch], 0);
+
+  // Check that events above print level are not notified
+  event_num_map.clear();
+  ddp_solver->config().print_level = 0;
+  solve(*ddp_solver);
+  EXPECT_EQ(event_num_map[nmpc_ddp::SolverEventType::IterationStart], 0);
+  EXPECT_EQ(event_num_map[nmpc_ddp::SolverEventType::IterationEnd], 0);
+}
+
+TEST(TestSolverObserver, DDPPrint)
+{
+  auto ddp_solver = makeSolver<nmpc_ddp::DDPRuntimePolicy>();
+  ddp_solver->config().print_level = 3;
+
+  // Check that events are left in sink without auto flush
+  ddp_solver->observer().auto_flush = false;
+  solve(*ddp_solver);
+  std::ostringstream oss;
+  EXPECT_GT(ddp_solver->observer().sink()->flush(oss), 0);
+  EXPECT_NE(oss.str().find("[DDP] Start iteration. (iter: 1)"), std::string::npos);
+
+  // Check that the solution does not depend on observer
+  using Policy = nmpc_ddp::DDPStaticPolicy<true, 1, 3, nmpc_ddp::Instrumentation::Step, nmpc_ddp::NullObserver>;
+  auto null_ddp_solver = makeSolver<Policy>();
+  null_ddp_solver->config().print_level = 3;
+  solve(*null_ddp_solver);
+  const auto & u_list = ddp_solver->controlData().u_list;
+  const auto & null_u_list = null_ddp_solver->controlData().u_list;
+  ASSERT_EQ(u_list.size(), null_u_list.size());
+  for(size_t i = 0; i < u_list.size(); i++)
+  {
+    EXPECT_LT((u_list[i] - null_u_list[i]).norm(), 1e-10) << "i: " << i;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
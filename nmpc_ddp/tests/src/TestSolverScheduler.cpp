@@ -0,0 +1,208 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#include <nmpc_ddp/DDPSolver.h>
+#include <nmpc_ddp/SolverScheduler.h>
+
+#include "DDPProblemCartPole.h"
+
+using DDPSolverCartPole = nmpc_ddp::DDPSolver<4, 1>;
+
+std::shared_ptr<DDPSolverCartPole> makeSolver(int horizon_steps, int max_iter)
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  auto ddp_solver = std::make_shared<DDPSolverCartPole>(ddp_problem);
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().horizon_steps = horizon_steps;
+  ddp_solver->config().max_iter = max_iter;
+  return ddp_solver;
+}
+
+struct TaskData
+{
+  std::shared_ptr<DDPSolverCartPole> solver;
+
+  std::vector<DDPProblemCartPole::InputDimVector> u_list;
+
+  std::atomic<int> completed_num = 0;
+
+  std::atomic<int> aborted_num = 0;
+
+  std::atomic<bool> valid = true;
+};
+
+int addTask(nmpc_ddp::SolverScheduler & scheduler,
+            TaskData & task_data,
+            const std::string & name,
+            int horizon_steps,
+            int max_iter,
+            double period,
+            double deadline)
+{
+  task_data.solver = makeSolver(horizon_steps, max_iter);
+  task_data.u_list.assign(horizon_steps, DDPProblemCartPole::InputDimVector::Zero());
+  return scheduler.addTask<DDPSolverCartPole>(
+      name, task_data.solver, period, deadline,
+      [&task_data](DDPSolverCartPole & solver, double t)
+      { solver.begin(t, DDPProblemCartPole::StateDimVector(0.0, 0.5, 0.0, 0.0), task_data.u_list); },
+      [&task_data](DDPSolverCartPole & solver, double, // t
+                   bool completed)
+      {
+        // The best solution is available and the step-wise solve is finished even if aborted (nothing is available
+        // if the first job is aborted before begin)
+        const auto & u_list = solver.controlData().u_list;
+        if(!solver.done() || (!u_list.empty() && (u_list.size() != task_data.u_list.size() || !u_list[0].allFinite())))
+        {
+          task_data.valid = false;
+        }
+        if(!u_list.empty())
+        {
+          task_data.u_list = u_list;
+        }
+        (completed ? task_data.completed_num : task_data.aborted_num)++;
+      });
+}
+
+TEST(TestSolverScheduler, Feasible)
+{
+  nmpc_ddp::SolverScheduler::Configuration config;
+  config.thread_num = 2;
+  nmpc_ddp::SolverScheduler scheduler(config);
+
+  // Tasks with different rates that are feasible with enough margin
+  std::array<TaskData, 3> task_data_list;
+  std::array<double, 3> period_list = {0.01, 0.02, 0.05};
+  for(int i = 0; i < 3; i++)
+  {
+    addTask(scheduler, task_data_list[i], "task" + std::to_string(i), 50, 3, period_list[i], period_list[i]);
+  }
+  EXPECT_THROW(scheduler.addTask("invalid", 0.01, 0.02, nullptr, nullptr, nullptr), std::invalid_argument);
+  EXPECT_EQ(scheduler.taskNum(), 3);
+
+  double duration = 0.5; // [sec]
+  scheduler.start();
+  EXPECT_THROW(scheduler.start(), std::runtime_error);
+  std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+  scheduler.stop();
+
+  for(int i = 0; i < 3; i++)
+  {
+    const auto & statistics = scheduler.statistics(i);
+    std::cout << scheduler.taskName(i) << ": release " << statistics.release_num << ", complete "
+              << statistics.complete_num << ", miss " << statistics.missNum() << ", response time (mean/max) "
+              << statistics.mean_response_time << " / " << statistics.max_response_time << " [ms]" << std::endl;
+    EXPECT_NEAR(statistics.release_num, duration / period_list[i], 0.3 * duration / period_list[i] + 1);
+    EXPECT_GE(statistics.complete_num + statistics.missNum() + 1, statistics.release_num);
+    EXPECT_GT(statistics.complete_num, 0);
+    EXPECT_GE(statistics.step_num, statistics.complete_num);
+    EXPECT_EQ(task_data_list[i].completed_num + task_data_list[i].aborted_num,
+              statistics.complete_num + statistics.late_num + statistics.abort_num);
+    EXPECT_TRUE(task_data_list[i].valid);
+  }
+}
+
+TEST(TestSolverScheduler, Overload)
+{
+  nmpc_ddp::SolverScheduler scheduler;
+
+  // Short-period task with feasible deadline and long task with infeasible deadline
+  TaskData short_task_data;
+  TaskData long_task_data;
+  int short_task_idx = addTask(scheduler, short_task_data, "short", 20, 1, 0.01, 0.01);
+  int long_task_idx = addTask(scheduler, long_task_data, "long", 2000, 1000, 0.02, 0.005);
+
+  scheduler.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  scheduler.stop();
+
+  // Check that the long task is aborted and the solution is available
+  const auto & long_statistics = scheduler.statistics(long_task_idx);
+  EXPECT_GT(long_statistics.abort_num, 0);
+  EXPECT_GT(long_task_data.aborted_num, 0);
+  EXPECT_TRUE(long_task_data.valid);
+
+  // Check that the short task with earlier deadlines is not starved by the long task
+  const auto & short_statistics = scheduler.statistics(short_task_idx);
+  EXPECT_GT(short_statistics.complete_num, 0);
+  EXPECT_TRUE(short_task_data.valid);
+}
+
+TEST(TestSolverScheduler, Exception)
+{
+  nmpc_ddp::SolverScheduler scheduler;
+
+  // Task whose begin or step function throws in some jobs, and normal task
+  TaskData normal_task_data;
+  int normal_task_idx = addTask(scheduler, normal_task_data, "normal", 20, 3, 0.01, 0.01);
+  auto solver = makeSolver(20, 3);
+  std::vector<DDPProblemCartPole::InputDimVector> u_list(20, DDPProblemCartPole::InputDimVector::Zero());
+  int job_idx = 0;
+  int end_num = 0;
+  int aborted_end_num = 0;
+  bool done = true;
+  int error_task_idx = scheduler.addTask(
+      "error", 0.01, 0.01,
+      [&](double t)
+      {
+        job_idx++;
+        if(job_idx % 3 == 0)
+        {
+          throw std::runtime_error("Error in begin.");
+        }
+        solver->begin(t, DDPProblemCartPole::StateDimVector(0.0, 0.5, 0.0, 0.0), u_list);
+      },
+      [&]()
+      {
+        if(job_idx % 3 == 1)
+        {
+          throw std::runtime_error("Error in step.");
+        }
+        return solver->step();
+      },
+      [&](double, // t
+          bool completed)
+      {
+        solver->abort();
+        done = done && solver->done();
+        end_num++;
+        if(!completed)
+        {
+          aborted_end_num++;
+        }
+      });
+
+  scheduler.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  scheduler.stop();
+
+  // Check that the jobs with exceptions are ended and the scheduler keeps running
+  const auto & error_statistics = scheduler.statistics(error_task_idx);
+  EXPECT_GT(error_statistics.error_num, 1);
+  EXPECT_GT(error_statistics.complete_num + error_statistics.late_num, 0);
+  EXPECT_EQ(end_num, error_statistics.complete_num + error_statistics.late_num + error_statistics.abort_num
+                         + error_statistics.error_num);
+  EXPECT_GE(aborted_end_num, error_statistics.error_num);
+  EXPECT_TRUE(done);
+  ASSERT_TRUE(scheduler.lastException(error_task_idx));
+  EXPECT_THROW(std::rethrow_exception(scheduler.lastException(error_task_idx)), std::runtime_error);
+
+  const auto & normal_statistics = scheduler.statistics(normal_task_idx);
+  EXPECT_EQ(normal_statistics.error_num, 0);
+  EXPECT_GT(normal_statistics.complete_num, 0);
+  EXPECT_FALSE(scheduler.lastException(normal_task_idx));
+  EXPECT_TRUE(normal_task_data.valid);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,159 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include <nmpc_ddp/DDPSolver.h>
+#include <nmpc_ddp/TraceRing.h>
+
+#include "DDPProblemCartPole.h"
+#include "PerfRegression.h"
+
+TEST(TestTraceRing, Overwrite)
+{
+  nmpc_ddp::TraceRing trace_ring(100);
+  EXPECT_EQ(trace_ring.capacity(), 128);
+  EXPECT_TRUE(trace_ring.snapshot().empty());
+
+  // Push events more than capacity
+  auto start_time = std::chrono::steady_clock::now();
+  for(int i = 0; i < 200; i++)
+  {
+    trace_ring.pushComplete("Test", "event", start_time, start_time + std::chrono::microseconds(i), i);
+  }
+  EXPECT_EQ(trace_ring.pushedNum(), 200);
+
+  // Check that the oldest events are overwritten
+  const auto & event_list = trace_ring.snapshot();
+  ASSERT_EQ(event_list.size(), 128);
+  for(size_t i = 0; i < event_list.size(); i++)
+  {
+    int idx = 200 - 128 + static_cast<int>(i);
+    EXPECT_EQ(event_list[i].index, idx);
+    EXPECT_EQ(event_list[i].duration_ns, 1000 * idx);
+    EXPECT_EQ(event_list[i].type, nmpc_ddp::TraceRing::EventType::Complete);
+    EXPECT_TRUE(std::isnan(event_list[i].value));
+  }
+
+  trace_ring.clear();
+  EXPECT_EQ(trace_ring.pushedNum(), 0);
+  EXPECT_TRUE(trace_ring.snapshot().empty());
+}
+
+TEST(TestTraceRing, MultiThread)
+{
+  constexpr int thread_num = 4;
+  constexpr int push_num = 10000;
+  nmpc_ddp::TraceRing trace_ring(thread_num * push_num);
+
+  std::vector<std::thread> thread_list;
+  for(int i = 0; i < thread_num; i++)
+  {
+    thread_list.emplace_back(
+        [&trace_ring, i]()
+        {
+          for(int j = 0; j < push_num; j++)
+          {
+            trace_ring.pushCounter("Test", "counter", std::chrono::steady_clock::now(), i);
+          }
+        });
+  }
+  for(auto & thread : thread_list)
+  {
+    thread.join();
+  }
+
+  // Check that events from each thread have the same thread index
+  const auto & event_list = trace_ring.snapshot();
+  ASSERT_EQ(event_list.size(), thread_num * push_num);
+  std::map<int, std::set<uint32_t>> tid_map;
+  for(const auto & event : event_list)
+  {
+    tid_map[static_cast<int>(event.value)].insert(event.tid);
+  }
+  ASSERT_EQ(tid_map.size(), thread_num);
+  std::set<uint32_t> tid_set;
+  for(const auto & tid_kv : tid_map)
+  {
+    EXPECT_EQ(tid_kv.second.size(), 1);
+    tid_set.insert(*tid_kv.second.begin());
+  }
+  EXPECT_EQ(tid_set.size(), thread_num);
+}
+
+TEST(TestTraceRing, DDPSolver)
+{
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [](double // t
+                                                                 ) { return 0.0; });
+  // Trace events of each step of horizon are recorded only with Instrumentation::Step
+  auto ddp_solver = std::make_shared<nmpc_ddp::DDPSolver<4, 1, nmpc_ddp::DDPStepInstrumentedPolicy>>(ddp_problem);
+  ddp_solver->setInputLimitsFunc(
+      [](double // t
+         ) -> std::array<Eigen::Vector1d, 2>
+      {
+        std::array<Eigen::Vector1d, 2> limits;
+        limits[0].setConstant(-15.0);
+        limits[1].setConstant(15.0);
+        return limits;
+      });
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().with_input_constraint = true;
+  ddp_solver->config().horizon_steps = 100;
+  ddp_solver->config().max_iter = 3;
+
+  auto trace_ring = std::make_shared<nmpc_ddp::TraceRing>();
+  ddp_solver->setTraceRing(trace_ring);
+
+  // Solve several times (events persist across solves)
+  constexpr int solve_num = 3;
+  DDPProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  std::vector<DDPProblemCartPole::InputDimVector> initial_u_list(ddp_solver->config().horizon_steps,
+                                                                 DDPProblemCartPole::InputDimVector::Zero());
+  for(int i = 0; i < solve_num; i++)
+  {
+    ddp_solver->solve(0.01 * i, current_x, initial_u_list);
+    initial_u_list = ddp_solver->controlData().u_list;
+  }
+
+  // Check events
+  std::map<std::string, int> event_num_map;
+  for(const auto & event : trace_ring->snapshot())
+  {
+    EXPECT_GE(event.duration_ns, 0);
+    event_num_map[std::string(event.category) + "/" + event.name]++;
+  }
+  EXPECT_EQ(event_num_map["DDP/solve"], solve_num);
+  EXPECT_EQ(event_num_map["DDP/setup"], solve_num);
+  EXPECT_GE(event_num_map["DDP/derivative"], solve_num);
+  EXPECT_GE(event_num_map["DDP/backward"], solve_num);
+  EXPECT_EQ(event_num_map["DDP/Q"], event_num_map["DDP/gain"]);
+  EXPECT_GE(event_num_map["DDP/Q"], solve_num * ddp_solver->config().horizon_steps);
+  EXPECT_EQ(event_num_map["BoxQP/solve"], event_num_map["DDP/Q"]);
+
+  // Export and parse trace file
+  std::string file_path = "/tmp/TestTraceRing.json";
+  trace_ring->exportChromeTrace(file_path);
+  std::ifstream ifs(file_path);
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  const auto & value_map = nmpc_ddp::PerfRegression::parseJson(ss.str());
+  size_t event_num = trace_ring->snapshot().size();
+  EXPECT_EQ(value_map.count("traceEvents." + std::to_string(event_num - 1) + ".ts"), 1);
+  EXPECT_EQ(value_map.count("traceEvents." + std::to_string(event_num) + ".ts"), 0);
+
+  std::cout << "Open the following file with chrome://tracing or https://ui.perfetto.dev:\n"
+            << "  " << file_path << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
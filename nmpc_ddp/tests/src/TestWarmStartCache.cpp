@@ -0,0 +1,207 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+#include <nmpc_ddp/WarmStartCache.h>
+
+#include "DDPProblemCartPole.h"
+
+using DDPSolverCartPole = nmpc_ddp::DDPSolver<4, 1>;
+using WarmStartCacheCartPole = nmpc_ddp::WarmStartCache<DDPSolverCartPole>;
+
+TEST(TestWarmStartCache, Library)
+{
+  std::string file_path = "/tmp/TestWarmStartCacheLibrary.bin";
+  std::remove(file_path.c_str());
+
+  constexpr int horizon_steps = 10;
+  constexpr int max_data_size = 1 + 2 * horizon_steps;
+  auto make_u_list = [](double value)
+  { return WarmStartCacheCartPole::WarmStart(horizon_steps, DDPProblemCartPole::InputDimVector(value)); };
+  auto make_x = [](double value) { return DDPProblemCartPole::StateDimVector::Constant(value); };
+  Eigen::VectorXd ref_features = Eigen::VectorXd::Zero(1);
+
+  {
+    WarmStartCacheCartPole cache(file_path, 5, max_data_size, 3);
+    WarmStartCacheCartPole::WarmStart u_list;
+    EXPECT_FALSE(cache.lookup(make_x(0.0), ref_features, u_list));
+    EXPECT_EQ(cache.missNum(), 1);
+
+    for(int i = 0; i < 3; i++)
+    {
+      cache.insert(make_x(i), ref_features, make_u_list(i));
+    }
+    EXPECT_EQ(cache.size(), 3);
+
+    // Check that the nearest entry is returned
+    EXPECT_TRUE(cache.lookup(make_x(0.9), ref_features, u_list));
+    EXPECT_EQ(u_list, make_u_list(1.0));
+    EXPECT_TRUE(cache.lookup(make_x(-1.0), ref_features, u_list));
+    EXPECT_EQ(u_list, make_u_list(0.0));
+    EXPECT_EQ(cache.hitNum(), 2);
+
+    // Check that the maximum distance is respected
+    cache.config().max_distance = 1.0;
+    EXPECT_FALSE(cache.lookup(make_x(10.0), ref_features, u_list));
+    cache.config().max_distance = std::numeric_limits<double>::infinity();
+
+    // Check that the nearby entry is overwritten
+    cache.config().merge_distance = 0.5;
+    cache.insert(make_x(2.1), ref_features, make_u_list(2.1));
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_TRUE(cache.lookup(make_x(2.0), ref_features, u_list));
+    EXPECT_EQ(u_list, make_u_list(2.1));
+
+    // Check that the least recently used entry (x = 1) is replaced when full
+    cache.insert(make_x(5.0), ref_features, make_u_list(5.0));
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_TRUE(cache.lookup(make_x(1.0), ref_features, u_list));
+    EXPECT_NE(u_list, make_u_list(1.0));
+
+    // Check invalid arguments
+    WarmStartCacheCartPole::WarmStart long_u_list(horizon_steps + 1, DDPProblemCartPole::InputDimVector::Zero());
+    EXPECT_THROW(cache.insert(make_x(0.0), ref_features, long_u_list), std::invalid_argument);
+    EXPECT_THROW(cache.lookup(make_x(0.0), Eigen::VectorXd::Zero(2), u_list), std::invalid_argument);
+  }
+
+  // Check that the entries are persisted
+  {
+    WarmStartCacheCartPole cache(file_path, 5, max_data_size, 3);
+    EXPECT_EQ(cache.size(), 3);
+    WarmStartCacheCartPole::WarmStart u_list;
+    EXPECT_TRUE(cache.lookup(make_x(5.0), ref_features, u_list));
+    EXPECT_EQ(u_list, make_u_list(5.0));
+    EXPECT_TRUE(cache.lookup(make_x(0.0), ref_features, u_list));
+    EXPECT_EQ(u_list, make_u_list(0.0));
+  }
+
+  // Check that the file with different dimensions is rejected
+  EXPECT_THROW(WarmStartCacheCartPole(file_path, 6, max_data_size, 3), std::runtime_error);
+
+  std::remove(file_path.c_str());
+}
+
+TEST(TestWarmStartCache, Corrupted)
+{
+  std::string file_path = "/tmp/TestWarmStartCacheCorrupted.bin";
+  std::remove(file_path.c_str());
+
+  constexpr int horizon_steps = 10;
+  constexpr int max_data_size = 1 + 2 * horizon_steps;
+  constexpr int capacity = 3;
+  auto make_u_list = [](double value)
+  { return WarmStartCacheCartPole::WarmStart(horizon_steps, DDPProblemCartPole::InputDimVector(value)); };
+  auto make_x = [](double value) { return DDPProblemCartPole::StateDimVector::Constant(value); };
+  Eigen::VectorXd ref_features = Eigen::VectorXd::Zero(1);
+
+  {
+    WarmStartCacheCartPole cache(file_path, 5, max_data_size, capacity);
+    for(int i = 0; i < capacity; i++)
+    {
+      cache.insert(make_x(i), ref_features, make_u_list(i));
+    }
+  }
+
+  // Overwrite the list size in the serialized data of the first entry with NaN
+  {
+    size_t offset =
+        WarmStartCacheCartPole::fileSize(5, max_data_size, capacity) - sizeof(double) * max_data_size * capacity;
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    std::FILE * file = std::fopen(file_path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    std::fseek(file, static_cast<long>(offset), SEEK_SET);
+    std::fwrite(&nan, sizeof(double), 1, file);
+    std::fclose(file);
+  }
+
+  // Check that the corrupted entry is invalidated instead of throwing, and the output is unchanged
+  WarmStartCacheCartPole cache(file_path, 5, max_data_size, capacity);
+  WarmStartCacheCartPole::WarmStart u_list = make_u_list(-1.0);
+  EXPECT_FALSE(cache.lookup(make_x(0.0), ref_features, u_list));
+  EXPECT_EQ(u_list, make_u_list(-1.0));
+  EXPECT_EQ(cache.corruptedNum(), 1);
+  EXPECT_TRUE(cache.lookup(make_x(0.0), ref_features, u_list));
+  EXPECT_EQ(u_list, make_u_list(1.0));
+  EXPECT_EQ(cache.corruptedNum(), 1);
+
+  // Check that the invalidated entry is replaced first
+  cache.insert(make_x(5.0), ref_features, make_u_list(5.0));
+  EXPECT_EQ(cache.size(), capacity);
+  EXPECT_TRUE(cache.lookup(make_x(2.0), ref_features, u_list));
+  EXPECT_EQ(u_list, make_u_list(2.0));
+  EXPECT_TRUE(cache.lookup(make_x(5.0), ref_features, u_list));
+  EXPECT_EQ(u_list, make_u_list(5.0));
+
+  // Check that invalid sizes in serialized data are rejected
+  for(double size : {std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity(), -1.0, 0.5,
+                     1e300})
+  {
+    std::vector<double> data = {1.0, size, 0.0};
+    const double * ptr = data.data();
+    EXPECT_FALSE(nmpc_ddp::deserializeList(ptr, data.data() + data.size(), u_list)) << "size: " << size;
+  }
+  std::vector<double> data = {1.0, 1.0, 0.0};
+  const double * ptr = data.data();
+  EXPECT_TRUE(nmpc_ddp::deserializeList(ptr, data.data() + data.size(), u_list));
+
+  std::remove(file_path.c_str());
+}
+
+TEST(TestWarmStartCache, CartPole)
+{
+  std::string file_path = "/tmp/TestWarmStartCacheCartPole.bin";
+  std::remove(file_path.c_str());
+
+  constexpr int horizon_steps = 200;
+  constexpr int max_data_size = 1 + 2 * horizon_steps;
+  double target_pos = 0.0;
+  auto ddp_problem = std::make_shared<DDPProblemCartPole>(0.01, [&](double // t
+                                                                    ) { return target_pos; });
+  auto ddp_solver = std::make_shared<DDPSolverCartPole>(ddp_problem);
+  ddp_solver->config().print_level = 0;
+  ddp_solver->config().horizon_steps = horizon_steps;
+  ddp_solver->config().max_iter = 100;
+
+  DDPProblemCartPole::StateDimVector current_x(0, M_PI, 0, 0);
+  WarmStartCacheCartPole::WarmStart cold_u_list(horizon_steps, DDPProblemCartPole::InputDimVector::Zero());
+  auto solve = [&](WarmStartCacheCartPole::WarmStart & u_list)
+  {
+    EXPECT_TRUE(nmpc_ddp::MpcRunnerAdapter<DDPSolverCartPole>::solve(*ddp_solver, 0.0, current_x, u_list));
+    return ddp_solver->traceDataList().back().iter;
+  };
+
+  // Fill library with the solutions of swing-up to various target positions
+  {
+    WarmStartCacheCartPole cache(file_path, 5, max_data_size);
+    for(double pos : {-4.0, -2.0, 0.0, 2.0, 4.0})
+    {
+      target_pos = pos;
+      WarmStartCacheCartPole::WarmStart u_list = cold_u_list;
+      solve(u_list);
+      cache.insert(current_x, Eigen::VectorXd::Constant(1, target_pos), u_list);
+    }
+  }
+
+  // Check that a new library opened from the file warm-starts a swing-up to a similar target position
+  WarmStartCacheCartPole cache(file_path, 5, max_data_size);
+  EXPECT_EQ(cache.size(), 5);
+  target_pos = 3.8;
+  WarmStartCacheCartPole::WarmStart u_list = cold_u_list;
+  int cold_iter = solve(u_list);
+  ASSERT_TRUE(cache.lookup(current_x, Eigen::VectorXd::Constant(1, target_pos), u_list));
+  int warm_iter = solve(u_list);
+  EXPECT_LT(warm_iter, cold_iter);
+
+  std::remove(file_path.c_str());
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
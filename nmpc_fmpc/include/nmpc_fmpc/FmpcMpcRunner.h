@@ -0,0 +1,123 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <nmpc_ddp/MpcRunner.h>
+#include <nmpc_fmpc/FmpcSolver.h>
+
+namespace nmpc_ddp
+{
+/** \brief Adapter of FmpcSolver for MpcRunner. */
+template<int _StateDim, int _InputDim, int IneqDim, class Policy>
+struct MpcRunnerAdapter<nmpc_fmpc::FmpcSolver<_StateDim, _InputDim, IneqDim, Policy>>
+{
+  /** \brief Solver type. */
+  using Solver = nmpc_fmpc::FmpcSolver<_StateDim, _InputDim, IneqDim, Policy>;
+
+  /** \brief State dimension. */
+  static constexpr int StateDim = _StateDim;
+
+  /** \brief Input dimension. */
+  static constexpr int InputDim = _InputDim;
+
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename Solver::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename Solver::InputDimVector;
+
+  /** \brief Type of warm-start data (all optimization variables). */
+  using WarmStart = typename Solver::Variable;
+
+  /** \brief Get discretization timestep [sec]. */
+  static inline double dt(const Solver & solver)
+  {
+    return solver.problem()->dt();
+  }
+
+  /** \brief Solve and overwrite warm-start data with the solution. */
+  static inline bool solve(Solver & solver, double t, const StateDimVector & x, WarmStart & warm_start)
+  {
+    auto status = solver.solve(t, x, warm_start);
+    warm_start = solver.variable();
+    return status == Solver::Status::Succeeded || status == Solver::Status::MaxIterationReached;
+  }
+
+  /** \brief Shift warm-start data to the past. */
+  static inline void shift(WarmStart & warm_start, int steps)
+  {
+    shiftList(warm_start.x_list, steps);
+    shiftList(warm_start.u_list, steps);
+    shiftList(warm_start.lambda_list, steps);
+    shiftList(warm_start.s_list, steps);
+    shiftList(warm_start.nu_list, steps);
+  }
+
+  /** \brief Change the number of steps of warm-start data. */
+  static inline void resize(WarmStart & warm_start, int horizon_steps)
+  {
+    warm_start.horizon_steps = horizon_steps;
+    resizeList(warm_start.x_list, horizon_steps + 1);
+    resizeList(warm_start.u_list, horizon_steps);
+    resizeList(warm_start.lambda_list, horizon_steps + 1);
+    resizeList(warm_start.s_list, horizon_steps);
+    resizeList(warm_start.nu_list, horizon_steps);
+  }
+
+  /** \brief Append warm-start data to serialized data. */
+  static inline void serialize(const WarmStart & warm_start, std::vector<double> & data)
+  {
+    serializeList(warm_start.x_list, data);
+    serializeList(warm_start.u_list, data);
+    serializeList(warm_start.lambda_list, data);
+    serializeList(warm_start.s_list, data);
+    serializeList(warm_start.nu_list, data);
+  }
+
+  /** \brief Restore warm-start data from serialized data. */
+  static inline bool deserialize(const double * data, size_t size, WarmStart & warm_start)
+  {
+    const double * end = data + size;
+    if(!(deserializeList(data, end, warm_start.x_list) && deserializeList(data, end, warm_start.u_list)
+         && deserializeList(data, end, warm_start.lambda_list) && deserializeList(data, end, warm_start.s_list)
+         && deserializeList(data, end, warm_start.nu_list) && data == end))
+    {
+      return false;
+    }
+    warm_start.horizon_steps = static_cast<int>(warm_start.u_list.size());
+    return true;
+  }
+
+  /** \brief Get state and input sequences of the solution. */
+  static inline void getSolution(const Solver & solver,
+                                 std::vector<StateDimVector> & x_list,
+                                 std::vector<InputDimVector> & u_list)
+  {
+    x_list = solver.variable().x_list;
+    u_list = solver.variable().u_list;
+  }
+
+  /** \brief Make snapshot of feedback policy of the solution.
+      \param solver solver
+      \param t time of the solve [sec]
+
+      Since FmpcSolver does not provide feedback gains, the policy only interpolates the nominal input (i.e., the
+      gains are zero).
+   */
+  static inline std::shared_ptr<const FeedbackPolicy<StateDim, InputDim>> feedbackPolicy(const Solver & solver,
+                                                                                         double t)
+  {
+    using InputStateDimMatrix = typename FeedbackPolicy<StateDim, InputDim>::InputStateDimMatrix;
+
+    const auto & variable = solver.variable();
+    std::vector<InputStateDimMatrix> K_list;
+    K_list.reserve(variable.u_list.size());
+    for(const auto & u : variable.u_list)
+    {
+      K_list.push_back(InputStateDimMatrix::Zero(u.size(), variable.x_list[0].size()));
+    }
+    return std::make_shared<const FeedbackPolicy<StateDim, InputDim>>(t, dt(solver), variable.x_list, variable.u_list,
+                                                                      K_list);
+  }
+};
+} // namespace nmpc_ddp
@@ -7,7 +7,7 @@
 namespace nmpc_fmpc
 {
 /** \brief Fast MPC problem.
-    \tparam StateDim state dimension (fixed only)
+    \tparam StateDim state dimension (fixed or dynamic (i.e., Eigen::Dynamic))
     \tparam InputDim input dimension (fixed or dynamic (i.e., Eigen::Dynamic))
     \tparam IneqDim inequality dimension (fixed or dynamic (i.e., Eigen::Dynamic))
  */
@@ -47,8 +47,9 @@ public:
 
   /** \brief Constructor.
       \param dt discretization timestep [sec]
+      \param state_dim state dimension (must be passed if StateDim is dynamic)
    */
-  FmpcProblem(double dt) : nmpc_ddp::DDPProblem<StateDim, InputDim>(dt)
+  FmpcProblem(double dt, int state_dim = StateDim) : nmpc_ddp::DDPProblem<StateDim, InputDim>(dt, state_dim)
   {
     // Check dimension
     static_assert(IneqDim >= 0 || IneqDim == Eigen::Dynamic,
@@ -2,24 +2,94 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <functional>
 #include <memory>
 
+#include <nmpc_common/ThreadPool.h>
+#include <nmpc_ddp/LatencyHistogram.h>
+#include <nmpc_ddp/PerfCounter.h>
+#include <nmpc_ddp/SolveRecorder.h>
+#include <nmpc_ddp/SolverObserver.h>
+#include <nmpc_ddp/SolverPolicy.h>
+#include <nmpc_ddp/TraceRing.h>
 #include <nmpc_fmpc/FmpcProblem.h>
 
 namespace nmpc_fmpc
 {
+/** \brief Policy of FmpcSolver in which all choices are made at runtime by FmpcSolver::Configuration.
+
+    Only the phases are measured. Use FmpcStepInstrumentedPolicy to also measure each step of horizon.
+ */
+struct FmpcRuntimePolicy
+{
+  //! Whether to check NaN (0, 1, or nmpc_ddp::PolicyRuntime)
+  static constexpr int check_nan = nmpc_ddp::PolicyRuntime;
+
+  //! Maximum print level (prints of higher levels are removed at compile time)
+  static constexpr int max_print_level = 3;
+
+  //! Instrumentation level
+  static constexpr nmpc_ddp::Instrumentation instrumentation = nmpc_ddp::Instrumentation::Phase;
+
+  //! Clock to measure computation duration
+  using Clock = std::chrono::steady_clock;
+
+  //! Observer notified of events
+  using Observer = nmpc_ddp::PrintObserver;
+};
+
+/** \brief Policy of FmpcSolver same as FmpcRuntimePolicy except that each step of horizon is also measured. */
+struct FmpcStepInstrumentedPolicy : public FmpcRuntimePolicy
+{
+  //! Instrumentation level
+  static constexpr nmpc_ddp::Instrumentation instrumentation = nmpc_ddp::Instrumentation::Step;
+};
+
+/** \brief Policy of FmpcSolver in which the choices are fixed at compile time.
+    \tparam CheckNan whether to check NaN
+    \tparam MaxPrintLevel maximum print level
+    \tparam InstrumentationLevel instrumentation level
+    \tparam ObserverType observer notified of events (nmpc_ddp::NullObserver to remove events at compile time)
+
+    The corresponding entries of FmpcSolver::Configuration are ignored.
+ */
+template<bool CheckNan = false,
+         int MaxPrintLevel = 0,
+         nmpc_ddp::Instrumentation InstrumentationLevel = nmpc_ddp::Instrumentation::Phase,
+         class ObserverType = nmpc_ddp::PrintObserver>
+struct FmpcStaticPolicy
+{
+  //! Whether to check NaN
+  static constexpr int check_nan = CheckNan;
+
+  //! Maximum print level
+  static constexpr int max_print_level = MaxPrintLevel;
+
+  //! Instrumentation level
+  static constexpr nmpc_ddp::Instrumentation instrumentation = InstrumentationLevel;
+
+  //! Clock to measure computation duration
+  using Clock = std::chrono::steady_clock;
+
+  //! Observer notified of events
+  using Observer = ObserverType;
+};
+
 /** \brief FMPC solver.
     \tparam StateDim state dimension
     \tparam InputDim input dimension
     \tparam IneqDim inequality dimension
+    \tparam Policy policy to fix the choices of configuration and the instrumentation level at compile time (see
+    FmpcRuntimePolicy and FmpcStaticPolicy)
 
     See the following for a detailed algorithm.
       - S Katayama. Fast model predictive control of robotic systems with rigid contacts. Ph.D. thesis (section 2.2),
    Kyoto University, 2022.
  */
-template<int StateDim, int InputDim, int IneqDim>
+template<int StateDim, int InputDim, int IneqDim, class Policy = FmpcRuntimePolicy>
 class FmpcSolver
 {
 public:
@@ -53,8 +123,17 @@ public:
   /** \brief Type of matrix of inequality x inequality dimension. */
   using IneqIneqDimMatrix = Eigen::Matrix<double, IneqDim, IneqDim>;
 
+  /** \brief Type of clock to measure computation duration. */
+  using Clock = typename Policy::Clock;
+
+  /** \brief Type of observer notified of events. */
+  using Observer = typename Policy::Observer;
+
 public:
-  /*! \brief Configuration. */
+  /*! \brief Configuration.
+
+      The entries fixed by the solver policy (check_nan and the upper bound of print_level) are ignored.
+  */
   struct Configuration
   {
     //! Print level (0: no print, 1: print only important, 2: print verbose, 3: print very verbose)
@@ -86,6 +165,12 @@ public:
 
     //! Whether to calculate the scale of constraint errors in the merit function from Lagrange multipliers
     bool merit_const_scale_from_lagrange_multipliers = false;
+
+    //! Whether to measure hardware performance counters of each phase (see nmpc_ddp::PerfCounter)
+    bool use_perf_counter = false;
+
+    //! Whether to record computation duration of each solve in histograms (see nmpc_ddp::LatencyHistogram)
+    bool use_latency_histogram = false;
   };
 
   /*! \brief Result status. */
@@ -131,9 +216,10 @@ public:
     void reset(double _x, double _u, double _lambda, double _s, double _nu);
 
     /** \brief Check whether NaN or infinity is containd.
+        \param message if not nullptr, set to the message that names the variable containing NaN or infinity
         \return whether NaN or infinity is containd
     */
-    bool containsNaN() const;
+    bool containsNaN(const char ** message = nullptr) const;
 
     //! Number of steps in horizon
     int horizon_steps;
@@ -152,9 +238,6 @@ public:
 
     //! Sequence of Lagrange multipliers of inequality constraints (nu[0], ..., nu[N-1])
     std::vector<IneqDimVector> nu_list;
-
-    //! Print level (0: no print, 1: print only important, 2: print verbose, 3: print very verbose)
-    int print_level = 1;
   };
 
   /*! \brief Coefficients of linearized KKT condition. */
@@ -173,9 +256,10 @@ public:
     Coefficient(int state_dim);
 
     /** \brief Check whether NaN or infinity is containd.
+        \param message if not nullptr, set to the message that names the variable containing NaN or infinity
         \return whether NaN or infinity is containd
     */
-    bool containsNaN() const;
+    bool containsNaN(const char ** message = nullptr) const;
 
     //! First-order derivative of state equation w.r.t. state
     StateStateDimMatrix A;
@@ -223,9 +307,75 @@ public:
 
     //! Coefficient matrix for lambda calculation
     StateStateDimMatrix P;
+  };
 
-    //! Print level (0: no print, 1: print only important, 2: print verbose, 3: print very verbose)
-    int print_level = 1;
+  /*! \brief Workspace of backward pass.
+
+      The variables are preallocated once per solve so that the backward pass does not allocate memory even if the
+      state dimension is dynamic. The products with P are computed once per step and reused for F, H, and G, so that
+      they are computed by the cache-blocked matrix products of Eigen for large dimensions.
+   */
+  struct BackwardWorkspace
+  {
+    /** \brief Resize variables of state dimension.
+        \param state_dim state dimension
+
+        The variables of input dimension are resized on the first assignment of each solve.
+    */
+    inline void resize(int state_dim)
+    {
+      Qxx_tilde.resize(state_dim, state_dim);
+      Lx_tilde.resize(state_dim);
+      F.resize(state_dim, state_dim);
+      PA.resize(state_dim, state_dim);
+      Pxs.resize(state_dim);
+      s.resize(state_dim);
+      P.resize(state_dim, state_dim);
+      P_symmetric.resize(state_dim, state_dim);
+    }
+
+    //! Modified coefficients (2.28)
+    //! @{
+    StateStateDimMatrix Qxx_tilde;
+    InputInputDimMatrix Quu_tilde;
+    StateInputDimMatrix Qxu_tilde;
+    StateDimVector Lx_tilde;
+    InputDimVector Lu_tilde;
+    //! @}
+
+    //! Coefficients of gain calculation (2.35)
+    //! @{
+    StateStateDimMatrix F;
+    StateInputDimMatrix H;
+    InputInputDimMatrix G;
+    //! @}
+
+    //! Product of P and A
+    StateStateDimMatrix PA;
+
+    //! Product of P and B
+    StateInputDimMatrix PB;
+
+    //! P x_bar - s
+    StateDimVector Pxs;
+
+    //! Product of G and K
+    InputStateDimMatrix GK;
+
+    //! Feedforward term for input
+    InputDimVector k;
+
+    //! Feedback gain for input w.r.t. state error
+    InputStateDimMatrix K;
+
+    //! Offset vector for lambda calculation
+    StateDimVector s;
+
+    //! Coefficient matrix for lambda calculation
+    StateStateDimMatrix P;
+
+    //! Symmetrized coefficient matrix for lambda calculation
+    StateStateDimMatrix P_symmetric;
   };
 
   /*! \brief Data to trace optimization loop. */
@@ -250,7 +400,10 @@ public:
     double duration_update = 0;
   };
 
-  /*! \brief Data of computation duration. */
+  /*! \brief Data of computation duration.
+
+      The durations of gain_pre, gain_solve, gain_post, and fraction are measured only with Instrumentation::Step.
+   */
   struct ComputationDuration
   {
     //! Duration to solve [msec]
@@ -287,6 +440,168 @@ public:
     double fraction = 0;
   };
 
+  /*! \brief Histograms of computation duration across solves (same fields as ComputationDuration). */
+  struct LatencyHistogramData
+  {
+    //! Histogram of duration of solve
+    nmpc_ddp::LatencyHistogram solve;
+
+    //! Histogram of duration of setup
+    nmpc_ddp::LatencyHistogram setup;
+
+    //! Histogram of duration of opt
+    nmpc_ddp::LatencyHistogram opt;
+
+    //! Histogram of duration of coeff
+    nmpc_ddp::LatencyHistogram coeff;
+
+    //! Histogram of duration of backward
+    nmpc_ddp::LatencyHistogram backward;
+
+    //! Histogram of duration of forward
+    nmpc_ddp::LatencyHistogram forward;
+
+    //! Histogram of duration of update
+    nmpc_ddp::LatencyHistogram update;
+
+    //! Histogram of duration of gain_pre
+    nmpc_ddp::LatencyHistogram gain_pre;
+
+    //! Histogram of duration of gain_solve
+    nmpc_ddp::LatencyHistogram gain_solve;
+
+    //! Histogram of duration of gain_post
+    nmpc_ddp::LatencyHistogram gain_post;
+
+    //! Histogram of duration of fraction
+    nmpc_ddp::LatencyHistogram fraction;
+
+    /** \brief Record computation duration of one solve. */
+    inline void record(const ComputationDuration & computation_duration)
+    {
+      solve.record(computation_duration.solve);
+      setup.record(computation_duration.setup);
+      opt.record(computation_duration.opt);
+      coeff.record(computation_duration.coeff);
+      backward.record(computation_duration.backward);
+      forward.record(computation_duration.forward);
+      update.record(computation_duration.update);
+      gain_pre.record(computation_duration.gain_pre);
+      gain_solve.record(computation_duration.gain_solve);
+      gain_post.record(computation_duration.gain_post);
+      fraction.record(computation_duration.fraction);
+    }
+
+    /** \brief Clear recorded durations. */
+    inline void reset()
+    {
+      solve.reset();
+      setup.reset();
+      opt.reset();
+      coeff.reset();
+      backward.reset();
+      forward.reset();
+      update.reset();
+      gain_pre.reset();
+      gain_solve.reset();
+      gain_post.reset();
+      fraction.reset();
+    }
+
+    /** \brief Add durations recorded by another solver instance. */
+    inline void merge(const LatencyHistogramData & data)
+    {
+      solve.merge(data.solve);
+      setup.merge(data.setup);
+      opt.merge(data.opt);
+      coeff.merge(data.coeff);
+      backward.merge(data.backward);
+      forward.merge(data.forward);
+      update.merge(data.update);
+      gain_pre.merge(data.gain_pre);
+      gain_solve.merge(data.gain_solve);
+      gain_post.merge(data.gain_post);
+      fraction.merge(data.fraction);
+    }
+
+    /** \brief Print summary of each histogram. */
+    inline void print() const
+    {
+      solve.print("solve");
+      setup.print("setup");
+      opt.print("opt");
+      coeff.print("coeff");
+      backward.print("backward");
+      forward.print("forward");
+      update.print("update");
+      gain_pre.print("gain_pre");
+      gain_solve.print("gain_solve");
+      gain_post.print("gain_post");
+      fraction.print("fraction");
+    }
+  };
+
+  /*! \brief Data of hardware performance counters (all zero if not measured). */
+  struct PerfCounterData
+  {
+    //! Counts to solve
+    nmpc_ddp::PerfCounter::Count solve;
+
+    //! Counts to calculate coefficients (included in solve)
+    nmpc_ddp::PerfCounter::Count coeff;
+
+    //! Counts to process backward pass (included in solve)
+    nmpc_ddp::PerfCounter::Count backward;
+
+    //! Counts to process forward pass (included in solve)
+    nmpc_ddp::PerfCounter::Count forward;
+
+    //! Counts to update variables (included in solve)
+    nmpc_ddp::PerfCounter::Count update;
+  };
+
+  /*! \brief Record of solver inputs and outputs for replay. */
+  struct SolveRecord
+  {
+    /** \brief Read record.
+        \param reader record reader (must be positioned at the beginning of record)
+    */
+    void read(nmpc_ddp::SolveRecordReader & reader);
+
+    /** \brief Calculate error between recorded output and solver output.
+        \param solver solver after replay
+        \return maximum absolute difference of sequence of input
+    */
+    double calcOutputError(const FmpcSolver & solver) const;
+
+    //! Configuration
+    Configuration config;
+
+    //! Current time [sec]
+    double current_t = 0;
+
+    //! Current state
+    StateDimVector current_x;
+
+    //! Initial guess of optimization variables
+    Variable initial_variable;
+
+    //! Barrier parameter at the beginning of solve
+    double barrier_eps = 0;
+
+    //! Result status
+    Status status = Status::Uninitialized;
+
+    //! Number of iterations
+    int iter = 0;
+
+    //! Optimization variables calculated by solve()
+    Variable variable;
+
+    //! Computation duration
+    ComputationDuration computation_duration;
+  };
+
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
@@ -307,6 +622,22 @@ public:
     return config_;
   }
 
+  /** \brief Const accessor to problem. */
+  inline const std::shared_ptr<FmpcProblem<StateDim, InputDim, IneqDim>> & problem() const
+  {
+    return problem_;
+  }
+
+  /** \brief Set problem.
+      \param problem problem with the same dimensions
+
+      This allows the solver to be reused for another instance of the problem (e.g., with different parameters).
+   */
+  inline void setProblem(const std::shared_ptr<FmpcProblem<StateDim, InputDim, IneqDim>> & problem)
+  {
+    problem_ = problem;
+  }
+
   /** \brief Solve optimization.
       \param current_t current time [sec]
       \param current_x current state
@@ -315,6 +646,51 @@ public:
   */
   Status solve(double current_t, const StateDimVector & current_x, const Variable & initial_variable);
 
+  /** \brief Begin step-wise optimization.
+      \param current_t current time [sec]
+      \param current_x current state
+      \param initial_variable initial guess of optimization variables
+
+      solve() is equivalent to calling begin(), then step() until done() returns true, and finally result(). This
+      allows a scheduler to interleave the optimization of multiple solvers in one thread by calling step() of each
+      solver in turn. The result is identical to solve(), except that the computation duration includes only the time
+      spent in begin() and step().
+  */
+  void begin(double current_t, const StateDimVector & current_x, const Variable & initial_variable);
+
+  /** \brief Process one iteration of step-wise optimization.
+      \return whether the optimization is finished (same as done())
+
+      Nothing is done if the optimization is already finished.
+  */
+  bool step();
+
+  /** \brief Whether step-wise optimization is finished. */
+  inline bool done() const
+  {
+    return step_done_;
+  }
+
+  /** \brief Abort step-wise optimization.
+
+      The optimization is finished with the current solution in the same manner as after the last iteration (e.g., the
+      observer is flushed and the solve is recorded), and result() returns Status::MaxIterationReached. Nothing is done
+      if the optimization is already finished.
+  */
+  inline void abort()
+  {
+    if(!step_done_)
+    {
+      finish();
+    }
+  }
+
+  /** \brief Result status of step-wise optimization (valid only after done() returns true). */
+  inline Status result() const
+  {
+    return step_status_;
+  }
+
   /** \brief Const accessor to optimization variables. */
   inline const Variable & variable() const
   {
@@ -339,15 +715,148 @@ public:
     return computation_duration_;
   }
 
+  /** \brief Const accessor to hardware performance counter data.
+
+      The data is measured only when Configuration::use_perf_counter is true.
+  */
+  inline const PerfCounterData & perfCounterData() const
+  {
+    return perf_counter_data_;
+  }
+
+  /** \brief Accessor to histograms of computation duration across solves.
+
+      The durations are recorded only when Configuration::use_latency_histogram is true.
+  */
+  inline LatencyHistogramData & latencyHistogramData()
+  {
+    return latency_histogram_data_;
+  }
+
+  /** \brief Const accessor to histograms of computation duration across solves. */
+  inline const LatencyHistogramData & latencyHistogramData() const
+  {
+    return latency_histogram_data_;
+  }
+
   /** \brief Dump trace data list.
       \param file_path path to output file
   */
   void dumpTraceDataList(const std::string & file_path) const;
 
+  /** \brief Set recorder of solver inputs and outputs.
+      \param recorder recorder (nullptr to disable recording)
+
+      When the recorder is set, SolveRecord is appended each time solve() is called.
+  */
+  void setRecorder(const std::shared_ptr<nmpc_ddp::SolveRecorder> & recorder);
+
+  /** \brief Set ring buffer of trace events.
+      \param trace_ring ring buffer (nullptr to disable tracing)
+
+      When the ring buffer is set, the durations of setup, coeff, backward, forward, and update (and of gain_pre,
+      gain_solve, gain_post, and fraction in them) and the KKT error are pushed to it in each solve, depending on the
+      instrumentation level of the solver policy.
+  */
+  void setTraceRing(const std::shared_ptr<nmpc_ddp::TraceRing> & trace_ring);
+
+  /** \brief Set thread pool.
+      \param thread_pool thread pool shared with other solvers (nullptr to calculate serially)
+
+      When the thread pool is set, the coefficients of the linearized KKT condition are calculated in parallel along
+      the horizon. The functions of the problem must be thread-safe.
+  */
+  void setThreadPool(const std::shared_ptr<nmpc_common::ThreadPool> & thread_pool);
+
+  /** \brief Accessor to observer.
+
+      Events of the levels up to Configuration::print_level (e.g., iteration start and end, line-search results, and
+      failures) are notified to the observer in each solve.
+  */
+  inline Observer & observer()
+  {
+    return observer_;
+  }
+
+  /** \brief Solve optimization with recorded inputs.
+      \param record record of solver inputs
+      \return result status
+
+      The configuration and the barrier parameter are overwritten by the recorded ones.
+  */
+  Status replay(const SolveRecord & record);
+
+  /** \brief Tag to identify the solver type in record file. */
+  static std::string recordTag();
+
 protected:
+  /** \brief Append solver inputs and outputs to recorder.
+      \param current_t current time [sec]
+      \param current_x current state
+      \param initial_variable initial guess of optimization variables
+      \param barrier_eps barrier parameter at the beginning of solve
+      \param status result status
+
+      The order of writing must be the same as the order of reading in SolveRecord::read().
+  */
+  void appendRecord(double current_t,
+                    const StateDimVector & current_x,
+                    const Variable & initial_variable,
+                    double barrier_eps,
+                    Status status);
+
   /** \brief Check optimization variables. */
   void checkVariable() const;
 
+  /** \brief Whether to measure at the instrumentation level. */
+  static constexpr bool instrumented(nmpc_ddp::Instrumentation level)
+  {
+    return Policy::instrumentation >= level;
+  }
+
+  /** \brief Get current time (default time if not measured at the instrumentation level). */
+  template<nmpc_ddp::Instrumentation Level>
+  static inline typename Clock::time_point now()
+  {
+    if constexpr(instrumented(Level))
+    {
+      return Clock::now();
+    }
+    else
+    {
+      return typename Clock::time_point();
+    }
+  }
+
+  /** \brief Read hardware performance counters (zeros if not measured at the instrumentation level). */
+  template<nmpc_ddp::Instrumentation Level>
+  inline nmpc_ddp::PerfCounter::Count readPerfCounter() const
+  {
+    if constexpr(instrumented(Level))
+    {
+      return perf_counter_ ? perf_counter_->read() : nmpc_ddp::PerfCounter::Count();
+    }
+    else
+    {
+      return nmpc_ddp::PerfCounter::Count();
+    }
+  }
+
+  /** \brief Print level bounded by the solver policy. */
+  inline int printLevel() const
+  {
+    return std::min(config_.print_level, Policy::max_print_level);
+  }
+
+  /** \brief Whether to check NaN. */
+  inline bool checkNan() const
+  {
+    return nmpc_ddp::resolvePolicy(Policy::check_nan, config_.check_nan);
+  }
+
+  /** \brief Finish step-wise optimization (e.g., measure computation duration and append record). */
+  void finish();
+
   /** \brief Process one iteration.
       \param iter current iteration
       \return result status
@@ -398,6 +907,9 @@ protected:
   //! Sequence of coefficients of linearized KKT condition
   std::vector<Coefficient> coeff_list_;
 
+  //! Workspace of backward pass
+  BackwardWorkspace backward_workspace_;
+
   //! Sequence of trace data
   std::vector<TraceData> trace_data_list_;
 
@@ -408,7 +920,7 @@ protected:
   double current_t_ = 0;
 
   //! Current state
-  StateDimVector current_x_ = StateDimVector::Zero();
+  StateDimVector current_x_ = StateDimVector::Zero(StateDim == Eigen::Dynamic ? 0 : StateDim);
 
   //! Barrier parameter
   double barrier_eps_ = 1e-4;
@@ -421,6 +933,48 @@ protected:
 
   //! Directional derivative of merit function
   double merit_deriv_ = 0.0;
+
+  //! Variable in line search
+  Variable ls_variable_;
+
+  //! Recorder of solver inputs and outputs
+  std::shared_ptr<nmpc_ddp::SolveRecorder> recorder_;
+
+  //! Ring buffer of trace events
+  std::shared_ptr<nmpc_ddp::TraceRing> trace_ring_;
+
+  //! Thread pool to calculate coefficients along the horizon in parallel
+  std::shared_ptr<nmpc_common::ThreadPool> thread_pool_;
+
+  //! Hardware performance counters (nullptr if not measured)
+  std::unique_ptr<nmpc_ddp::PerfCounter> perf_counter_;
+
+  //! Hardware performance counter data
+  PerfCounterData perf_counter_data_;
+
+  //! Histograms of computation duration across solves
+  LatencyHistogramData latency_histogram_data_;
+
+  //! Observer notified of events
+  Observer observer_;
+
+  //! Whether step-wise optimization is finished
+  bool step_done_ = true;
+
+  //! Next iteration of step-wise optimization
+  int step_iter_ = 0;
+
+  //! Status of step-wise optimization
+  Status step_status_ = Status::Uninitialized;
+
+  //! Start time of step-wise optimization
+  typename Clock::time_point step_start_time_;
+
+  //! Initial guess of optimization variables given to begin() (stored only for recorder)
+  Variable record_initial_variable_;
+
+  //! Barrier parameter at the beginning of step-wise optimization (stored only for recorder)
+  double record_barrier_eps_ = 0;
 };
 } // namespace nmpc_fmpc
 
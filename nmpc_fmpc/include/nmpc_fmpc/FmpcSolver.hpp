@@ -7,16 +7,19 @@
 
 #include <nmpc_fmpc/MathUtils.h>
 
-#define CHECK_NAN(VAR, PRINT_PREFIX)                                                                      \
-  if(VAR.array().isNaN().any() || VAR.array().isInf().any())                                              \
-  {                                                                                                       \
-    if(print_level >= 3)                                                                                  \
-    {                                                                                                     \
-      std::cout << PRINT_PREFIX << #VAR << " contains NaN or infinity: " << VAR.transpose() << std::endl; \
-    }                                                                                                     \
-    return true;                                                                                          \
+// The message is a string literal so that it can be passed to the observer without memory allocation
+#define CHECK_NAN(VAR, MESSAGE_PREFIX)                             \
+  if(VAR.array().isNaN().any() || VAR.array().isInf().any())       \
+  {                                                                \
+    if(message)                                                    \
+    {                                                              \
+      *message = MESSAGE_PREFIX #VAR " contains NaN or infinity."; \
+    }                                                              \
+    return true;                                                   \
   }
 
+namespace nmpc_fmpc
+{
 namespace
 {
 template<class Clock>
@@ -26,10 +29,8 @@ double calcDuration(const std::chrono::time_point<Clock> & start_time, const std
 }
 } // namespace
 
-namespace nmpc_fmpc
-{
-template<int StateDim, int InputDim, int IneqDim>
-FmpcSolver<StateDim, InputDim, IneqDim>::Variable::Variable(int _horizon_steps) : horizon_steps(_horizon_steps)
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+FmpcSolver<StateDim, InputDim, IneqDim, Policy>::Variable::Variable(int _horizon_steps) : horizon_steps(_horizon_steps)
 {
   x_list.resize(horizon_steps + 1);
   u_list.resize(horizon_steps);
@@ -38,8 +39,8 @@ FmpcSolver<StateDim, InputDim, IneqDim>::Variable::Variable(int _horizon_steps)
   nu_list.resize(horizon_steps);
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-void FmpcSolver<StateDim, InputDim, IneqDim>::Variable::reset(double _x,
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+void FmpcSolver<StateDim, InputDim, IneqDim, Policy>::Variable::reset(double _x,
                                                               double _u,
                                                               double _lambda,
                                                               double _s,
@@ -67,35 +68,35 @@ void FmpcSolver<StateDim, InputDim, IneqDim>::Variable::reset(double _x,
   }
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-bool FmpcSolver<StateDim, InputDim, IneqDim>::Variable::containsNaN() const
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+bool FmpcSolver<StateDim, InputDim, IneqDim, Policy>::Variable::containsNaN(const char ** message) const
 {
   for(auto & x : x_list)
   {
-    CHECK_NAN(x, "[FMPC/Variable] ");
+    CHECK_NAN(x, "variable.");
   }
   for(auto & u : u_list)
   {
-    CHECK_NAN(u, "[FMPC/Variable] ");
+    CHECK_NAN(u, "variable.");
   }
   for(auto & lambda : lambda_list)
   {
-    CHECK_NAN(lambda, "[FMPC/Variable] ");
+    CHECK_NAN(lambda, "variable.");
   }
   for(auto & s : s_list)
   {
-    CHECK_NAN(s, "[FMPC/Variable] ");
+    CHECK_NAN(s, "variable.");
   }
   for(auto & nu : nu_list)
   {
-    CHECK_NAN(nu, "[FMPC/Variable] ");
+    CHECK_NAN(nu, "variable.");
   }
 
   return false;
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-FmpcSolver<StateDim, InputDim, IneqDim>::Coefficient::Coefficient(int state_dim, int input_dim, int ineq_dim)
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+FmpcSolver<StateDim, InputDim, IneqDim, Policy>::Coefficient::Coefficient(int state_dim, int input_dim, int ineq_dim)
 {
   A.resize(state_dim, state_dim);
   B.resize(state_dim, input_dim);
@@ -119,8 +120,8 @@ FmpcSolver<StateDim, InputDim, IneqDim>::Coefficient::Coefficient(int state_dim,
   P.resize(state_dim, state_dim);
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-FmpcSolver<StateDim, InputDim, IneqDim>::Coefficient::Coefficient(int state_dim)
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+FmpcSolver<StateDim, InputDim, IneqDim, Policy>::Coefficient::Coefficient(int state_dim)
 {
   Lx.resize(state_dim);
   Lxx.resize(state_dim, state_dim);
@@ -130,43 +131,74 @@ FmpcSolver<StateDim, InputDim, IneqDim>::Coefficient::Coefficient(int state_dim)
   P.resize(state_dim, state_dim);
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-bool FmpcSolver<StateDim, InputDim, IneqDim>::Coefficient::containsNaN() const
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+bool FmpcSolver<StateDim, InputDim, IneqDim, Policy>::Coefficient::containsNaN(const char ** message) const
 {
-  CHECK_NAN(A, "[FMPC/Coefficient] ");
-  CHECK_NAN(B, "[FMPC/Coefficient] ");
-  CHECK_NAN(C, "[FMPC/Coefficient] ");
-  CHECK_NAN(D, "[FMPC/Coefficient] ");
-  CHECK_NAN(Lx, "[FMPC/Coefficient] ");
-  CHECK_NAN(Lu, "[FMPC/Coefficient] ");
-  CHECK_NAN(Lxx, "[FMPC/Coefficient] ");
-  CHECK_NAN(Luu, "[FMPC/Coefficient] ");
-  CHECK_NAN(Lxu, "[FMPC/Coefficient] ");
-  CHECK_NAN(x_bar, "[FMPC/Coefficient] ");
-  CHECK_NAN(g_bar, "[FMPC/Coefficient] ");
-  CHECK_NAN(Lx_bar, "[FMPC/Coefficient] ");
-  CHECK_NAN(Lu_bar, "[FMPC/Coefficient] ");
-  CHECK_NAN(k, "[FMPC/Coefficient] ");
-  CHECK_NAN(K, "[FMPC/Coefficient] ");
-  CHECK_NAN(s, "[FMPC/Coefficient] ");
-  CHECK_NAN(P, "[FMPC/Coefficient] ");
+  CHECK_NAN(A, "coeff.");
+  CHECK_NAN(B, "coeff.");
+  CHECK_NAN(C, "coeff.");
+  CHECK_NAN(D, "coeff.");
+  CHECK_NAN(Lx, "coeff.");
+  CHECK_NAN(Lu, "coeff.");
+  CHECK_NAN(Lxx, "coeff.");
+  CHECK_NAN(Luu, "coeff.");
+  CHECK_NAN(Lxu, "coeff.");
+  CHECK_NAN(x_bar, "coeff.");
+  CHECK_NAN(g_bar, "coeff.");
+  CHECK_NAN(Lx_bar, "coeff.");
+  CHECK_NAN(Lu_bar, "coeff.");
+  CHECK_NAN(k, "coeff.");
+  CHECK_NAN(K, "coeff.");
+  CHECK_NAN(s, "coeff.");
+  CHECK_NAN(P, "coeff.");
 
   return false;
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-typename FmpcSolver<StateDim, InputDim, IneqDim>::Status FmpcSolver<StateDim, InputDim, IneqDim>::solve(
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+typename FmpcSolver<StateDim, InputDim, IneqDim, Policy>::Status FmpcSolver<StateDim, InputDim, IneqDim, Policy>::solve(
     double current_t,
     const StateDimVector & current_x,
     const Variable & initial_variable)
 {
-  auto start_time = std::chrono::system_clock::now();
+  begin(current_t, current_x, initial_variable);
+  while(!step())
+  {
+  }
+  return result();
+}
+
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+void FmpcSolver<StateDim, InputDim, IneqDim, Policy>::begin(double current_t,
+                                                            const StateDimVector & current_x,
+                                                            const Variable & initial_variable)
+{
+  perf_counter_data_ = PerfCounterData();
+
+  // Counters are reopened if the calling thread changes because they only count the thread that opened them
+  if(!config_.use_perf_counter || !instrumented(nmpc_ddp::Instrumentation::Phase))
+  {
+    perf_counter_.reset();
+  }
+  else if(!perf_counter_ || !perf_counter_->isCountedThread())
+  {
+    perf_counter_ = std::make_unique<nmpc_ddp::PerfCounter>(printLevel());
+  }
+
+  auto start_time = now<nmpc_ddp::Instrumentation::Phase>();
+  auto start_count = readPerfCounter<nmpc_ddp::Instrumentation::Phase>();
+
+  // Store inputs for recording
+  if(recorder_)
+  {
+    record_initial_variable_ = initial_variable;
+    record_barrier_eps_ = barrier_eps_;
+  }
 
   // Initialize variables
   current_t_ = current_t;
   current_x_ = current_x;
   variable_ = initial_variable;
-  variable_.print_level = config_.print_level;
 
   // Initialize complementarity variables
   if(config_.init_complementary_variable)
@@ -194,7 +226,6 @@ typename FmpcSolver<StateDim, InputDim, IneqDim>::Status FmpcSolver<StateDim, In
   if(delta_variable_.horizon_steps != config_.horizon_steps)
   {
     delta_variable_ = Variable(config_.horizon_steps);
-    delta_variable_.print_level = config_.print_level;
   }
 
   // Setup coeff_list_
@@ -204,60 +235,122 @@ typename FmpcSolver<StateDim, InputDim, IneqDim>::Status FmpcSolver<StateDim, In
     for(int i = 0; i < config_.horizon_steps; i++)
     {
       double t = current_t_ + i * problem_->dt();
-      coeff_list_.emplace_back(problem_->stateDim(), problem_->inputDim(t), problem_->ineqDim(t));
+      coeff_list_.emplace_back(problem_->runtimeStateDim(), problem_->inputDim(t), problem_->ineqDim(t));
     }
   }
   else
   {
     // This assumes that the dimension is fixed, but it is efficient because it preserves existing elements
-    coeff_list_.resize(config_.horizon_steps,
-                       Coefficient(problem_->stateDim(), problem_->inputDim(), problem_->ineqDim()));
-  }
-  coeff_list_.emplace_back(problem_->stateDim());
-  for(auto & coeff : coeff_list_)
-  {
-    coeff.print_level = config_.print_level;
+    // The new elements are constructed in place instead of being copied from an uninitialized temporary
+    while(static_cast<int>(coeff_list_.size()) > config_.horizon_steps)
+    {
+      coeff_list_.pop_back();
+    }
+    while(static_cast<int>(coeff_list_.size()) < config_.horizon_steps)
+    {
+      coeff_list_.emplace_back(problem_->runtimeStateDim(), problem_->inputDim(), problem_->ineqDim());
+    }
   }
+  coeff_list_.emplace_back(problem_->runtimeStateDim());
+  backward_workspace_.resize(problem_->runtimeStateDim());
 
   // Clear trace_data_list_
   trace_data_list_.clear();
+  trace_data_list_.reserve(config_.max_iter);
 
   // Setup computation_duration_
   computation_duration_ = ComputationDuration();
 
-  auto setup_time = std::chrono::system_clock::now();
-  computation_duration_.setup = calcDuration(start_time, setup_time);
-
-  // Optimization loop
-  Status status = Status::Uninitialized;
-  for(int iter = 1; iter <= config_.max_iter; iter++)
+  auto setup_time = now<nmpc_ddp::Instrumentation::Phase>();
+  if constexpr(instrumented(nmpc_ddp::Instrumentation::Phase))
   {
-    status = procOnce(iter);
-    if(status != Status::IterationContinued)
+    computation_duration_.setup = calcDuration(start_time, setup_time);
+    perf_counter_data_.solve = readPerfCounter<nmpc_ddp::Instrumentation::Phase>() - start_count;
+    if(trace_ring_)
     {
-      break;
+      trace_ring_->pushComplete("FMPC", "setup", start_time, setup_time);
     }
   }
-  if(status == Status::IterationContinued)
+
+  // Prepare optimization loop
+  step_start_time_ = start_time;
+  step_iter_ = 1;
+  step_status_ = Status::Uninitialized;
+  step_done_ = false;
+  if(config_.max_iter < 1)
+  {
+    finish();
+  }
+}
+
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+bool FmpcSolver<StateDim, InputDim, IneqDim, Policy>::step()
+{
+  if(step_done_)
+  {
+    return true;
+  }
+
+  auto start_time = now<nmpc_ddp::Instrumentation::Phase>();
+  auto start_count = readPerfCounter<nmpc_ddp::Instrumentation::Phase>();
+
+  step_status_ = procOnce(step_iter_);
+
+  if constexpr(instrumented(nmpc_ddp::Instrumentation::Phase))
+  {
+    computation_duration_.opt += calcDuration(start_time, Clock::now());
+    perf_counter_data_.solve += readPerfCounter<nmpc_ddp::Instrumentation::Phase>() - start_count;
+  }
+
+  if(step_status_ != Status::IterationContinued || step_iter_ == config_.max_iter)
+  {
+    finish();
+  }
+  step_iter_++;
+
+  return step_done_;
+}
+
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+void FmpcSolver<StateDim, InputDim, IneqDim, Policy>::finish()
+{
+  if(step_status_ == Status::IterationContinued)
+  {
+    step_status_ = Status::MaxIterationReached;
+  }
+
+  if constexpr(instrumented(nmpc_ddp::Instrumentation::Phase))
   {
-    status = Status::MaxIterationReached;
+    computation_duration_.solve = computation_duration_.setup + computation_duration_.opt;
+    if(config_.use_latency_histogram)
+    {
+      latency_histogram_data_.record(computation_duration_);
+    }
+    if(trace_ring_ && !trace_data_list_.empty())
+    {
+      trace_ring_->pushComplete("FMPC", "solve", step_start_time_, Clock::now(), trace_data_list_.back().iter,
+                                trace_data_list_.back().kkt_error);
+    }
   }
 
-  auto end_time = std::chrono::system_clock::now();
-  computation_duration_.opt = calcDuration(setup_time, end_time);
-  computation_duration_.solve = calcDuration(start_time, end_time);
+  if(printLevel() >= 3 && !trace_data_list_.empty())
+  {
+    observer_.notify(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::Termination, 3, "FMPC", "Solve finished.",
+                                           trace_data_list_.back().iter,
+                                           {{"status", static_cast<int>(step_status_)}}));
+  }
+  observer_.flush();
 
-  if(config_.print_level >= 3)
+  if(recorder_)
   {
-    std::cout << "[FMPC] Solve finised. status: " << static_cast<int>(status)
-              << ", iter: " << trace_data_list_.back().iter << std::endl;
+    appendRecord(current_t_, current_x_, record_initial_variable_, record_barrier_eps_, step_status_);
   }
 
-  return status;
+  step_done_ = true;
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-void FmpcSolver<StateDim, InputDim, IneqDim>::dumpTraceDataList(const std::string & file_path) const
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+void FmpcSolver<StateDim, InputDim, IneqDim, Policy>::dumpTraceDataList(const std::string & file_path) const
 {
   std::ofstream ofs(file_path);
   // clang-format off
@@ -281,8 +374,8 @@ void FmpcSolver<StateDim, InputDim, IneqDim>::dumpTraceDataList(const std::strin
     // clang-format on
   }
 }
-template<int StateDim, int InputDim, int IneqDim>
-void FmpcSolver<StateDim, InputDim, IneqDim>::checkVariable() const
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+void FmpcSolver<StateDim, InputDim, IneqDim, Policy>::checkVariable() const
 {
   // Check sequence length
   if(static_cast<int>(variable_.x_list.size()) != config_.horizon_steps + 1)
@@ -361,12 +454,14 @@ void FmpcSolver<StateDim, InputDim, IneqDim>::checkVariable() const
   }
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-typename FmpcSolver<StateDim, InputDim, IneqDim>::Status FmpcSolver<StateDim, InputDim, IneqDim>::procOnce(int iter)
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+typename FmpcSolver<StateDim, InputDim, IneqDim, Policy>::Status
+    FmpcSolver<StateDim, InputDim, IneqDim, Policy>::procOnce(int iter)
 {
-  if(config_.print_level >= 3)
+  if(printLevel() >= 3)
   {
-    std::cout << "[FMPC] Start iteration " << iter << std::endl;
+    observer_.notify(
+        nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::IterationStart, 3, "FMPC", "Start iteration.", iter));
   }
 
   // Append trace data
@@ -400,10 +495,11 @@ typename FmpcSolver<StateDim, InputDim, IneqDim>::Status FmpcSolver<StateDim, In
 
   // Step 1: calculate coefficients of linearized KKT condition
   {
-    auto start_time = std::chrono::system_clock::now();
+    auto start_time = now<nmpc_ddp::Instrumentation::Phase>();
+    auto start_count = readPerfCounter<nmpc_ddp::Instrumentation::Phase>();
 
     double dt = problem_->dt();
-    for(int i = 0; i < config_.horizon_steps; i++)
+    auto calc_coeff = [this, dt](int i)
     {
       auto & coeff = coeff_list_[i];
       double t = current_t_ + i * dt;
@@ -424,6 +520,17 @@ typename FmpcSolver<StateDim, InputDim, IneqDim>::Status FmpcSolver<StateDim, In
       coeff.Lx_bar =
           -1 * lambda + dt * coeff.Lx + coeff.A.transpose() * next_lambda + coeff.C.transpose() * nu; // (2.25b)
       coeff.Lu_bar = dt * coeff.Lu + coeff.B.transpose() * next_lambda + coeff.D.transpose() * nu; // (2.25c)
+    };
+    if(thread_pool_)
+    {
+      thread_pool_->parallelFor(0, config_.horizon_steps, calc_coeff);
+    }
+    else
+    {
+      for(int i = 0; i < config_.horizon_steps; i++)
+      {
+        calc_coeff(i);
+      }
     }
     {
       auto & terminal_coeff = coeff_list_[config_.horizon_steps];
@@ -434,66 +541,123 @@ typename FmpcSolver<StateDim, InputDim, IneqDim>::Status FmpcSolver<StateDim, In
       terminal_coeff.Lx_bar = terminal_coeff.Lx - terminal_lambda; // (2.25a)
     }
 
-    double duration = calcDuration(start_time, std::chrono::system_clock::now());
-    trace_data.duration_coeff = duration;
-    computation_duration_.coeff += duration;
+    if constexpr(instrumented(nmpc_ddp::Instrumentation::Phase))
+    {
+      auto end_time = Clock::now();
+      double duration = calcDuration(start_time, end_time);
+      if(trace_ring_)
+      {
+        trace_ring_->pushComplete("FMPC", "coeff", start_time, end_time, iter);
+      }
+      trace_data.duration_coeff = duration;
+      computation_duration_.coeff += duration;
+      perf_counter_data_.coeff += readPerfCounter<nmpc_ddp::Instrumentation::Phase>() - start_count;
+    }
   }
 
   // Check KKT error
   double kkt_error = calcKktError(0.0);
   trace_data.kkt_error = kkt_error;
+  if constexpr(instrumented(nmpc_ddp::Instrumentation::Phase))
+  {
+    if(trace_ring_)
+    {
+      trace_ring_->pushCounter("FMPC", "kkt_error", Clock::now(), kkt_error);
+    }
+  }
   if(kkt_error <= config_.kkt_error_thre)
   {
+    if(printLevel() >= 2)
+    {
+      observer_.notify(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::Termination, 2, "FMPC",
+                                             "Terminate due to small KKT error.", iter, {{"kkt_error", kkt_error}}));
+    }
     return Status::Succeeded;
   }
 
   // Step 2: backward pass
   {
-    auto start_time = std::chrono::system_clock::now();
+    auto start_time = now<nmpc_ddp::Instrumentation::Phase>();
+    auto start_count = readPerfCounter<nmpc_ddp::Instrumentation::Phase>();
 
     if(!backwardPass())
     {
       return Status::ErrorInBackward;
     }
 
-    double duration = calcDuration(start_time, std::chrono::system_clock::now());
-    trace_data.duration_backward = duration;
-    computation_duration_.backward += duration;
+    if constexpr(instrumented(nmpc_ddp::Instrumentation::Phase))
+    {
+      auto end_time = Clock::now();
+      double duration = calcDuration(start_time, end_time);
+      if(trace_ring_)
+      {
+        trace_ring_->pushComplete("FMPC", "backward", start_time, end_time, iter);
+      }
+      trace_data.duration_backward = duration;
+      computation_duration_.backward += duration;
+      perf_counter_data_.backward += readPerfCounter<nmpc_ddp::Instrumentation::Phase>() - start_count;
+    }
   }
 
   // Step 3: forward pass
   {
-    auto start_time = std::chrono::system_clock::now();
+    auto start_time = now<nmpc_ddp::Instrumentation::Phase>();
+    auto start_count = readPerfCounter<nmpc_ddp::Instrumentation::Phase>();
 
     if(!forwardPass())
     {
       return Status::ErrorInForward;
     }
 
-    double duration = calcDuration(start_time, std::chrono::system_clock::now());
-    trace_data.duration_forward = duration;
-    computation_duration_.forward += duration;
+    if constexpr(instrumented(nmpc_ddp::Instrumentation::Phase))
+    {
+      auto end_time = Clock::now();
+      double duration = calcDuration(start_time, end_time);
+      if(trace_ring_)
+      {
+        trace_ring_->pushComplete("FMPC", "forward", start_time, end_time, iter);
+      }
+      trace_data.duration_forward = duration;
+      computation_duration_.forward += duration;
+      perf_counter_data_.forward += readPerfCounter<nmpc_ddp::Instrumentation::Phase>() - start_count;
+    }
   }
 
   // Step 4: update variables
   {
-    auto start_time = std::chrono::system_clock::now();
+    auto start_time = now<nmpc_ddp::Instrumentation::Phase>();
+    auto start_count = readPerfCounter<nmpc_ddp::Instrumentation::Phase>();
 
     if(!updateVariables())
     {
       return Status::ErrorInUpdate;
     }
 
-    double duration = calcDuration(start_time, std::chrono::system_clock::now());
-    trace_data.duration_update = duration;
-    computation_duration_.update += duration;
+    if constexpr(instrumented(nmpc_ddp::Instrumentation::Phase))
+    {
+      auto end_time = Clock::now();
+      double duration = calcDuration(start_time, end_time);
+      if(trace_ring_)
+      {
+        trace_ring_->pushComplete("FMPC", "update", start_time, end_time, iter);
+      }
+      trace_data.duration_update = duration;
+      computation_duration_.update += duration;
+      perf_counter_data_.update += readPerfCounter<nmpc_ddp::Instrumentation::Phase>() - start_count;
+    }
+  }
+
+  if(printLevel() >= 3)
+  {
+    observer_.notify(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::IterationEnd, 3, "FMPC", "End iteration.", iter,
+                                           {{"kkt_error", kkt_error}, {"barrier_eps", barrier_eps_}}));
   }
 
   return Status::IterationContinued;
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-double FmpcSolver<StateDim, InputDim, IneqDim>::calcKktError(double barrier_eps) const
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+double FmpcSolver<StateDim, InputDim, IneqDim, Policy>::calcKktError(double barrier_eps) const
 {
   double kkt_error = 0;
 
@@ -520,25 +684,26 @@ double FmpcSolver<StateDim, InputDim, IneqDim>::calcKktError(double barrier_eps)
   return kkt_error;
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-bool FmpcSolver<StateDim, InputDim, IneqDim>::backwardPass()
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+bool FmpcSolver<StateDim, InputDim, IneqDim, Policy>::backwardPass()
 {
-  // To avoid repetitive memory allocation, the vector and matrix variables are created outside of loop
-  StateStateDimMatrix Qxx_tilde;
-  InputInputDimMatrix Quu_tilde;
-  StateInputDimMatrix Qxu_tilde;
-  StateDimVector Lx_tilde;
-  InputDimVector Lu_tilde;
-
-  StateStateDimMatrix F;
-  StateInputDimMatrix H;
-  InputInputDimMatrix G;
-
-  InputDimVector k;
-  InputStateDimMatrix K;
-  StateDimVector s;
-  StateStateDimMatrix P;
-  StateStateDimMatrix P_symmetric;
+  // To avoid repetitive memory allocation, the vector and matrix variables are preallocated in the workspace
+  BackwardWorkspace & ws = backward_workspace_;
+  StateStateDimMatrix & Qxx_tilde = ws.Qxx_tilde;
+  InputInputDimMatrix & Quu_tilde = ws.Quu_tilde;
+  StateInputDimMatrix & Qxu_tilde = ws.Qxu_tilde;
+  StateDimVector & Lx_tilde = ws.Lx_tilde;
+  InputDimVector & Lu_tilde = ws.Lu_tilde;
+
+  StateStateDimMatrix & F = ws.F;
+  StateInputDimMatrix & H = ws.H;
+  InputInputDimMatrix & G = ws.G;
+
+  InputDimVector & k = ws.k;
+  InputStateDimMatrix & K = ws.K;
+  StateDimVector & s = ws.s;
+  StateStateDimMatrix & P = ws.P;
+  StateStateDimMatrix & P_symmetric = ws.P_symmetric;
 
   {
     auto & terminal_coeff = coeff_list_[config_.horizon_steps];
@@ -567,7 +732,7 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::backwardPass()
 
     // Pre-process for gain calculation
     {
-      auto start_time_gain_pre = std::chrono::system_clock::now();
+      auto start_time_gain_pre = now<nmpc_ddp::Instrumentation::Step>();
 
       IneqDimVector nu_s = (variable_.nu_list[i].array() / variable_.s_list[i].array()).matrix();
       IneqDimVector tilde_sub =
@@ -578,16 +743,30 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::backwardPass()
       Lx_tilde.noalias() = Lx_bar + C.transpose() * tilde_sub; // (2.28f)
       Lu_tilde.noalias() = Lu_bar + D.transpose() * tilde_sub; // (2.28g)
 
-      F.noalias() = Qxx_tilde + A.transpose() * P * A; // (2.35b)
-      H.noalias() = Qxu_tilde + A.transpose() * P * B; // (2.35c)
-      G.noalias() = Quu_tilde + B.transpose() * P * B; // (2.35d)
+      // The products with P are computed once and shared by F, H, and G
+      ws.PA.noalias() = P * A;
+      ws.PB.noalias() = P * B;
+      ws.Pxs.noalias() = P * x_bar;
+      ws.Pxs -= s;
+
+      F.noalias() = Qxx_tilde + A.transpose() * ws.PA; // (2.35b)
+      H.noalias() = Qxu_tilde + A.transpose() * ws.PB; // (2.35c)
+      G.noalias() = Quu_tilde + B.transpose() * ws.PB; // (2.35d)
 
-      computation_duration_.gain_pre += calcDuration(start_time_gain_pre, std::chrono::system_clock::now());
+      if constexpr(instrumented(nmpc_ddp::Instrumentation::Step))
+      {
+        auto end_time_gain_pre = Clock::now();
+        computation_duration_.gain_pre += calcDuration(start_time_gain_pre, end_time_gain_pre);
+        if(trace_ring_)
+        {
+          trace_ring_->pushComplete("FMPC", "gain_pre", start_time_gain_pre, end_time_gain_pre, i);
+        }
+      }
     }
 
     // Solve linear equation for gain calculation
     {
-      auto start_time_gain_solve = std::chrono::system_clock::now();
+      auto start_time_gain_solve = now<nmpc_ddp::Instrumentation::Step>();
 
       int input_dim = static_cast<int>(B.cols());
       if(input_dim > 0)
@@ -596,14 +775,16 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::backwardPass()
         Eigen::LDLT<InputInputDimMatrix> llt_G(G);
         if(llt_G.info() == Eigen::Success)
         {
-          k.noalias() = -1 * llt_G.solve(B.transpose() * (P * x_bar - s) + Lu_tilde); // (2.35e)
+          k.noalias() = -1 * llt_G.solve(B.transpose() * ws.Pxs + Lu_tilde); // (2.35e)
           K.noalias() = -1 * llt_G.solve(H.transpose()); // (2.35e)
         }
         else
         {
-          if(config_.print_level >= 1)
+          if(printLevel() >= 1)
           {
-            std::cout << "[FMPC/Backward] G is not positive definite in Cholesky decomposition (LLT)." << std::endl;
+            observer_.notify(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::Failure, 1, "FMPC/Backward",
+                                                   "G is not positive definite in Cholesky decomposition (LLT).", -1,
+                                                   {{"step", i}}));
           }
           if(config_.break_if_llt_fails)
           {
@@ -612,7 +793,7 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::backwardPass()
           else
           {
             Eigen::FullPivLU<InputInputDimMatrix> lu_G(G);
-            k.noalias() = -1 * lu_G.solve(B.transpose() * (P * x_bar - s) + Lu_tilde); // (2.35e)
+            k.noalias() = -1 * lu_G.solve(B.transpose() * ws.Pxs + Lu_tilde); // (2.35e)
             K.noalias() = -1 * lu_G.solve(H.transpose()); // (2.35e)
           }
         }
@@ -620,23 +801,43 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::backwardPass()
       else
       {
         k.setZero(0);
-        K.setZero(0, problem_->stateDim());
+        K.setZero(0, problem_->runtimeStateDim());
       }
 
-      computation_duration_.gain_solve += calcDuration(start_time_gain_solve, std::chrono::system_clock::now());
+      if constexpr(instrumented(nmpc_ddp::Instrumentation::Step))
+      {
+        auto end_time_gain_solve = Clock::now();
+        computation_duration_.gain_solve += calcDuration(start_time_gain_solve, end_time_gain_solve);
+        if(trace_ring_)
+        {
+          trace_ring_->pushComplete("FMPC", "gain_solve", start_time_gain_solve, end_time_gain_solve, i);
+        }
+      }
     }
 
     // Post-process for gain calculation
     {
-      auto start_time_gain_post = std::chrono::system_clock::now();
-
-      s = A.transpose() * (s - P * x_bar) - Lx_tilde - H * k; // (2.35a)
-      P.noalias() = F - K.transpose() * G * K; // (2.35a)
+      auto start_time_gain_post = now<nmpc_ddp::Instrumentation::Step>();
+
+      s = -1 * Lx_tilde; // (2.35a)
+      s.noalias() -= A.transpose() * ws.Pxs;
+      s.noalias() -= H * k;
+      ws.GK.noalias() = G * K;
+      P = F; // (2.35a)
+      P.noalias() -= K.transpose() * ws.GK;
       P_symmetric = 0.5 * (P + P.transpose()); // Enforce symmetric
       // Assigning directly to P without using the intermediate variable P_symmetric yields incorrect results!
       P = P_symmetric;
 
-      computation_duration_.gain_post += calcDuration(start_time_gain_post, std::chrono::system_clock::now());
+      if constexpr(instrumented(nmpc_ddp::Instrumentation::Step))
+      {
+        auto end_time_gain_post = Clock::now();
+        computation_duration_.gain_post += calcDuration(start_time_gain_post, end_time_gain_post);
+        if(trace_ring_)
+        {
+          trace_ring_->pushComplete("FMPC", "gain_post", start_time_gain_post, end_time_gain_post, i);
+        }
+      }
     }
 
     // Save gains
@@ -646,15 +847,17 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::backwardPass()
     coeff.P = P;
   }
 
-  if(config_.check_nan)
+  if(checkNan())
   {
-    for(const auto & coeff : coeff_list_)
+    for(int i = 0; i < config_.horizon_steps + 1; i++)
     {
-      if(coeff.containsNaN())
+      const char * message = nullptr;
+      if(coeff_list_[i].containsNaN(&message))
       {
-        if(config_.print_level >= 1)
+        if(printLevel() >= 1)
         {
-          std::cout << "[FMPC/Backward] coeff contains NaN." << std::endl;
+          observer_.notify(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::Failure, 1, "FMPC/Backward", message, -1,
+                                                 {{"step", i}}));
         }
         return false;
       }
@@ -664,8 +867,8 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::backwardPass()
   return true;
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-bool FmpcSolver<StateDim, InputDim, IneqDim>::forwardPass()
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+bool FmpcSolver<StateDim, InputDim, IneqDim, Policy>::forwardPass()
 {
   delta_variable_.x_list[0] = current_x_ - variable_.x_list[0];
 
@@ -695,11 +898,12 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::forwardPass()
             .matrix(); // (2.27b)
   }
 
-  if(config_.check_nan && delta_variable_.containsNaN())
+  const char * message = nullptr;
+  if(checkNan() && delta_variable_.containsNaN(&message))
   {
-    if(config_.print_level >= 1)
+    if(printLevel() >= 1)
     {
-      std::cout << "[FMPC/Forward] delta_variable contains NaN." << std::endl;
+      observer_.notify(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::Failure, 1, "FMPC/Forward", message));
     }
     return false;
   }
@@ -707,14 +911,14 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::forwardPass()
   return true;
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-bool FmpcSolver<StateDim, InputDim, IneqDim>::updateVariables()
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+bool FmpcSolver<StateDim, InputDim, IneqDim, Policy>::updateVariables()
 {
   // Fraction-to-boundary rule
   double alpha_s_max = 1.0;
   double alpha_nu_max = 1.0;
   {
-    auto start_time_fraction = std::chrono::system_clock::now();
+    auto start_time_fraction = now<nmpc_ddp::Instrumentation::Step>();
 
     constexpr double margin_ratio = 0.995;
     for(int i = 0; i < config_.horizon_steps; i++)
@@ -738,15 +942,24 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::updateVariables()
     }
     if(!(alpha_s_max > 0.0 && alpha_s_max <= 1.0 && alpha_nu_max > 0.0 && alpha_nu_max <= 1.0))
     {
-      if(config_.print_level >= 1)
+      if(printLevel() >= 1)
       {
-        std::cout << "[FMPC/Update] Invalid alpha. barrier_eps: " << barrier_eps_ << ", alpha_s_max: " << alpha_s_max
-                  << ", alpha_nu_max: " << alpha_nu_max << std::endl;
+        observer_.notify(nmpc_ddp::SolverEvent(
+            nmpc_ddp::SolverEventType::Failure, 1, "FMPC/Update", "Invalid alpha.", -1,
+            {{"barrier_eps", barrier_eps_}, {"alpha_s_max", alpha_s_max}, {"alpha_nu_max", alpha_nu_max}}));
       }
       return false;
     }
 
-    computation_duration_.fraction += calcDuration(start_time_fraction, std::chrono::system_clock::now());
+    if constexpr(instrumented(nmpc_ddp::Instrumentation::Step))
+    {
+      auto end_time_fraction = Clock::now();
+      computation_duration_.fraction += calcDuration(start_time_fraction, end_time_fraction);
+      if(trace_ring_)
+      {
+        trace_ring_->pushComplete("FMPC", "fraction", start_time_fraction, end_time_fraction);
+      }
+    }
   }
 
   // Line search
@@ -759,15 +972,18 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::updateVariables()
     constexpr double armijo_scale = 1e-3;
     constexpr double alpha_s_update_ratio = 0.5;
     constexpr double alpha_s_min = 1e-10;
-    Variable ls_variable = variable_;
+    // ls_variable_ is a member variable to avoid repetitive memory allocation
+    Variable & ls_variable = ls_variable_;
+    ls_variable = variable_;
     while(true)
     {
       if(alpha_s < alpha_s_min)
       {
-        if(config_.print_level >= 1)
+        if(printLevel() >= 1)
         {
-          std::cout << "[FMPC/Update] alpha_s is too small in line search backtracking. alpha_s_max: " << alpha_s_max
-                    << ", alpha_s: " << alpha_s << std::endl;
+          observer_.notify(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::LineSearch, 1, "FMPC/Update",
+                                                 "alpha_s is too small in line search backtracking.", -1,
+                                                 {{"alpha_s_max", alpha_s_max}, {"alpha_s", alpha_s}}));
         }
         break;
       }
@@ -792,11 +1008,15 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::updateVariables()
     }
   }
 
-  if(config_.print_level >= 3)
+  if(printLevel() >= 3)
   {
-    std::cout << "[FMPC/update] barrier_eps: " << barrier_eps_ << ", alpha_s_max: " << alpha_s_max
-              << ", alpha_nu_max: " << alpha_nu_max << ", alpha_s: " << alpha_s << ", alpha_nu: " << alpha_nu
-              << std::endl;
+    observer_.notify(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::LineSearch, 3, "FMPC/Update",
+                                           "Line search finished.", -1,
+                                           {{"barrier_eps", barrier_eps_},
+                                            {"alpha_s_max", alpha_s_max},
+                                            {"alpha_nu_max", alpha_nu_max},
+                                            {"alpha_s", alpha_s},
+                                            {"alpha_nu", alpha_nu}}));
   }
 
   for(int i = 0; i < config_.horizon_steps + 1; i++)
@@ -813,17 +1033,21 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::updateVariables()
       constexpr double min_positive_value = std::numeric_limits<double>::lowest();
       if((variable_.s_list[i].array() < 0).any())
       {
-        if(config_.print_level >= 1)
+        if(printLevel() >= 1)
         {
-          std::cout << "[FMPC/Update] Updated s is negative: " << variable_.s_list[i].transpose() << std::endl;
+          observer_.notify(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::Failure, 1, "FMPC/Update",
+                                                 "Updated s is negative.", -1,
+                                                 {{"step", i}, {"s_min", variable_.s_list[i].minCoeff()}}));
         }
         variable_.s_list[i] = variable_.s_list[i].array().max(min_positive_value).matrix();
       }
       if((variable_.nu_list[i].array() < 0).any())
       {
-        if(config_.print_level >= 1)
+        if(printLevel() >= 1)
         {
-          std::cout << "[FMPC/Update] Updated nu is negative: " << variable_.nu_list[i].transpose() << std::endl;
+          observer_.notify(nmpc_ddp::SolverEvent(nmpc_ddp::SolverEventType::Failure, 1, "FMPC/Update",
+                                                 "Updated nu is negative.", -1,
+                                                 {{"step", i}, {"nu_min", variable_.nu_list[i].minCoeff()}}));
         }
         variable_.nu_list[i] = variable_.nu_list[i].array().max(min_positive_value).matrix();
       }
@@ -833,8 +1057,8 @@ bool FmpcSolver<StateDim, InputDim, IneqDim>::updateVariables()
   return true;
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-void FmpcSolver<StateDim, InputDim, IneqDim>::setupMeritFunc()
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+void FmpcSolver<StateDim, InputDim, IneqDim, Policy>::setupMeritFunc()
 {
   double merit_func_obj = 0.0;
   double merit_func_const = 0.0;
@@ -845,8 +1069,9 @@ void FmpcSolver<StateDim, InputDim, IneqDim>::setupMeritFunc()
   {
     StateDimVector const_func = current_x_ - variable_.x_list[0];
     merit_func_const += const_func.template lpNorm<1>();
-    merit_deriv_const +=
-        l1NormDirectionalDeriv(const_func, (-1 * StateStateDimMatrix::Identity()).eval(), delta_variable_.x_list[0]);
+    merit_deriv_const += l1NormDirectionalDeriv(
+        const_func, (-1 * StateStateDimMatrix::Identity(const_func.size(), const_func.size())).eval(),
+        delta_variable_.x_list[0]);
   }
 
   for(int i = 0; i < config_.horizon_steps; i++)
@@ -877,8 +1102,8 @@ void FmpcSolver<StateDim, InputDim, IneqDim>::setupMeritFunc()
       merit_func_const += const_func.template lpNorm<1>();
       merit_deriv_const += l1NormDirectionalDeriv(const_func, coeff.A, delta_x);
       merit_deriv_const += l1NormDirectionalDeriv(const_func, coeff.B, delta_u);
-      merit_deriv_const +=
-          l1NormDirectionalDeriv(const_func, (-1 * StateStateDimMatrix::Identity()).eval(), delta_next_x);
+      merit_deriv_const += l1NormDirectionalDeriv(
+          const_func, (-1 * StateStateDimMatrix::Identity(const_func.size(), const_func.size())).eval(), delta_next_x);
     }
 
     {
@@ -886,7 +1111,8 @@ void FmpcSolver<StateDim, InputDim, IneqDim>::setupMeritFunc()
       merit_func_const += const_func.template lpNorm<1>();
       merit_deriv_const += l1NormDirectionalDeriv(const_func, coeff.C, delta_x);
       merit_deriv_const += l1NormDirectionalDeriv(const_func, coeff.D, delta_u);
-      merit_deriv_const += l1NormDirectionalDeriv(const_func, IneqIneqDimMatrix::Identity().eval(), delta_s);
+      merit_deriv_const += l1NormDirectionalDeriv(
+          const_func, IneqIneqDimMatrix::Identity(const_func.size(), const_func.size()).eval(), delta_s);
     }
   }
 
@@ -925,15 +1151,16 @@ void FmpcSolver<StateDim, InputDim, IneqDim>::setupMeritFunc()
   merit_func_ = merit_func_obj + merit_const_scale_ * merit_func_const;
   merit_deriv_ = merit_deriv_obj + merit_const_scale_ * merit_deriv_const;
 
-  if(config_.print_level >= 3)
+  if(printLevel() >= 3)
   {
-    std::cout << "[FMPC/merit] merit_func: " << merit_func_ << ", merit_deriv: " << merit_deriv_
-              << ", merit_const_scale: " << merit_const_scale_ << std::endl;
+    observer_.notify(nmpc_ddp::SolverEvent(
+        nmpc_ddp::SolverEventType::Info, 3, "FMPC/Merit", "Merit function.", -1,
+        {{"merit_func", merit_func_}, {"merit_deriv", merit_deriv_}, {"merit_const_scale", merit_const_scale_}}));
   }
 }
 
-template<int StateDim, int InputDim, int IneqDim>
-double FmpcSolver<StateDim, InputDim, IneqDim>::calcMeritFunc(const Variable & variable) const
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+double FmpcSolver<StateDim, InputDim, IneqDim, Policy>::calcMeritFunc(const Variable & variable) const
 {
   double merit_func_obj = 0.0;
   double merit_func_const = 0.0;
@@ -980,6 +1207,163 @@ double FmpcSolver<StateDim, InputDim, IneqDim>::calcMeritFunc(const Variable & v
 
   return merit_func_obj + merit_const_scale_ * merit_func_const;
 }
+
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+void FmpcSolver<StateDim, InputDim, IneqDim, Policy>::setRecorder(
+    const std::shared_ptr<nmpc_ddp::SolveRecorder> & recorder)
+{
+  recorder_ = recorder;
+  if(recorder_)
+  {
+    recorder_->setTag(recordTag());
+  }
+}
+
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+void FmpcSolver<StateDim, InputDim, IneqDim, Policy>::setTraceRing(
+    const std::shared_ptr<nmpc_ddp::TraceRing> & trace_ring)
+{
+  trace_ring_ = trace_ring;
+}
+
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+void FmpcSolver<StateDim, InputDim, IneqDim, Policy>::setThreadPool(
+    const std::shared_ptr<nmpc_common::ThreadPool> & thread_pool)
+{
+  thread_pool_ = thread_pool;
+}
+
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+typename FmpcSolver<StateDim, InputDim, IneqDim, Policy>::Status
+    FmpcSolver<StateDim, InputDim, IneqDim, Policy>::replay(const SolveRecord & record)
+{
+  config_ = record.config;
+  barrier_eps_ = record.barrier_eps;
+  return solve(record.current_t, record.current_x, record.initial_variable);
+}
+
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+std::string FmpcSolver<StateDim, InputDim, IneqDim, Policy>::recordTag()
+{
+  return "nmpc_fmpc::FmpcSolver<" + std::to_string(StateDim) + "," + std::to_string(InputDim) + ","
+         + std::to_string(IneqDim) + ">";
+}
+
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+void FmpcSolver<StateDim, InputDim, IneqDim, Policy>::appendRecord(double current_t,
+                                                                   const StateDimVector & current_x,
+                                                                   const Variable & initial_variable,
+                                                                   double barrier_eps,
+                                                                   Status status)
+{
+  auto writeVariable = [&](const Variable & variable)
+  {
+    recorder_->write<int32_t>(variable.horizon_steps);
+    recorder_->writeMatrixList(variable.x_list);
+    recorder_->writeMatrixList(variable.u_list);
+    recorder_->writeMatrixList(variable.lambda_list);
+    recorder_->writeMatrixList(variable.s_list);
+    recorder_->writeMatrixList(variable.nu_list);
+  };
+
+  recorder_->beginRecord();
+
+  // Configuration
+  recorder_->write<int32_t>(config_.print_level);
+  recorder_->write<int32_t>(config_.horizon_steps);
+  recorder_->write<int32_t>(config_.max_iter);
+  recorder_->write(config_.kkt_error_thre);
+  recorder_->write<bool>(config_.check_nan);
+  recorder_->write<bool>(config_.init_complementary_variable);
+  recorder_->write<bool>(config_.update_barrier_eps);
+  recorder_->write<bool>(config_.break_if_llt_fails);
+  recorder_->write<bool>(config_.enable_line_search);
+  recorder_->write<bool>(config_.merit_const_scale_from_lagrange_multipliers);
+
+  // Inputs
+  recorder_->write(current_t);
+  recorder_->writeMatrix(current_x);
+  writeVariable(initial_variable);
+  recorder_->write(barrier_eps);
+
+  // Outputs
+  recorder_->write<int32_t>(static_cast<int32_t>(status));
+  recorder_->write<int32_t>(trace_data_list_.empty() ? 0 : trace_data_list_.back().iter);
+  writeVariable(variable_);
+  recorder_->write(computation_duration_);
+
+  recorder_->endRecord();
+}
+
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+void FmpcSolver<StateDim, InputDim, IneqDim, Policy>::SolveRecord::read(nmpc_ddp::SolveRecordReader & reader)
+{
+  auto readVariable = [&](Variable & variable)
+  {
+    variable.horizon_steps = reader.read<int32_t>();
+    reader.readMatrixList(variable.x_list);
+    reader.readMatrixList(variable.u_list);
+    reader.readMatrixList(variable.lambda_list);
+    reader.readMatrixList(variable.s_list);
+    reader.readMatrixList(variable.nu_list);
+  };
+
+  // Configuration
+  config.print_level = reader.read<int32_t>();
+  config.horizon_steps = reader.read<int32_t>();
+  config.max_iter = reader.read<int32_t>();
+  config.kkt_error_thre = reader.read<double>();
+  config.check_nan = reader.read<bool>();
+  config.init_complementary_variable = reader.read<bool>();
+  config.update_barrier_eps = reader.read<bool>();
+  config.break_if_llt_fails = reader.read<bool>();
+  config.enable_line_search = reader.read<bool>();
+  config.merit_const_scale_from_lagrange_multipliers = reader.read<bool>();
+
+  // Inputs
+  current_t = reader.read<double>();
+  reader.readMatrix(current_x);
+  readVariable(initial_variable);
+  barrier_eps = reader.read<double>();
+
+  // Outputs
+  status = static_cast<Status>(reader.read<int32_t>());
+  iter = reader.read<int32_t>();
+  readVariable(variable);
+  computation_duration = reader.read<ComputationDuration>();
+}
+
+template<int StateDim, int InputDim, int IneqDim, class Policy>
+double FmpcSolver<StateDim, InputDim, IneqDim, Policy>::SolveRecord::calcOutputError(const FmpcSolver & solver) const
+{
+  const auto & u_list = solver.variable().u_list;
+  if(u_list.size() != variable.u_list.size())
+  {
+    return std::numeric_limits<double>::infinity();
+  }
+  double error = 0;
+  for(size_t i = 0; i < u_list.size(); i++)
+  {
+    if(u_list[i].size() != variable.u_list[i].size())
+    {
+      return std::numeric_limits<double>::infinity();
+    }
+    if(u_list[i].size() > 0)
+    {
+      error = std::max(error, (u_list[i] - variable.u_list[i]).cwiseAbs().maxCoeff());
+    }
+  }
+  return error;
+}
+
+#ifdef NMPC_FMPC_EXTERN_TEMPLATES
+// Explicitly instantiated in the nmpc_fmpc_instantiations library (see src/FmpcSolverInstantiations.cpp)
+extern template class FmpcSolver<2, 1, 3>;
+extern template class FmpcSolver<4, 1, 4>;
+extern template class FmpcSolver<4, Eigen::Dynamic, Eigen::Dynamic>;
+extern template class FmpcSolver<9, Eigen::Dynamic, Eigen::Dynamic>;
+extern template class FmpcSolver<Eigen::Dynamic, Eigen::Dynamic, Eigen::Dynamic>;
+#endif
 } // namespace nmpc_fmpc
 
 #undef CHECK_NAN
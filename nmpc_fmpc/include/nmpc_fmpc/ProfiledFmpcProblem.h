@@ -0,0 +1,86 @@
+/* Author: Masaki Murooka */
+
+#pragma once
+
+#include <nmpc_ddp/ProfiledDDPProblem.h>
+#include <nmpc_fmpc/FmpcProblem.h>
+
+namespace nmpc_fmpc
+{
+/** \brief Decorator of FMPC problem to profile the calls of its callbacks.
+    \tparam StateDim state dimension
+    \tparam InputDim input dimension
+    \tparam IneqDim inequality dimension
+
+    In addition to the callbacks of DDP problem (see nmpc_ddp::ProfiledDDPProblem), the calls of ineqConst() and
+    calcIneqConstDeriv() are profiled.
+ */
+template<int StateDim, int InputDim, int IneqDim>
+class ProfiledFmpcProblem
+: public nmpc_ddp::ProfiledDDPProblem<StateDim, InputDim, FmpcProblem<StateDim, InputDim, IneqDim>>
+{
+public:
+  /** \brief Type of base class. */
+  using Base = nmpc_ddp::ProfiledDDPProblem<StateDim, InputDim, FmpcProblem<StateDim, InputDim, IneqDim>>;
+
+  /** \brief Type of vector of state dimension. */
+  using StateDimVector = typename FmpcProblem<StateDim, InputDim, IneqDim>::StateDimVector;
+
+  /** \brief Type of vector of input dimension. */
+  using InputDimVector = typename FmpcProblem<StateDim, InputDim, IneqDim>::InputDimVector;
+
+  /** \brief Type of vector of inequality dimension. */
+  using IneqDimVector = typename FmpcProblem<StateDim, InputDim, IneqDim>::IneqDimVector;
+
+  /** \brief Type of matrix of inequality x state dimension. */
+  using IneqStateDimMatrix = typename FmpcProblem<StateDim, InputDim, IneqDim>::IneqStateDimMatrix;
+
+  /** \brief Type of matrix of inequality x input dimension. */
+  using IneqInputDimMatrix = typename FmpcProblem<StateDim, InputDim, IneqDim>::IneqInputDimMatrix;
+
+  /*! \brief Index of callback in profile (following nmpc_ddp::ProfiledDDPProblem::Call). */
+  enum FmpcCall : int
+  {
+    //! ineqConst()
+    IneqConst = Base::CallNum,
+
+    //! calcIneqConstDeriv()
+    IneqConstDeriv
+  };
+
+public:
+  /** \brief Constructor.
+      \param problem decorated problem
+   */
+  ProfiledFmpcProblem(const std::shared_ptr<FmpcProblem<StateDim, InputDim, IneqDim>> & problem)
+  : Base(problem, {"ineqConst", "calcIneqConstDeriv"})
+  {
+  }
+
+  inline virtual int ineqDim() const override
+  {
+    return this->problem_->ineqDim();
+  }
+
+  inline virtual int ineqDim(double t) const override
+  {
+    return this->problem_->ineqDim(t);
+  }
+
+  virtual IneqDimVector ineqConst(double t, const StateDimVector & x, const InputDimVector & u) const override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*this->profile_, IneqConst);
+    return this->problem_->ineqConst(t, x, u);
+  }
+
+  virtual void calcIneqConstDeriv(double t,
+                                  const StateDimVector & x,
+                                  const InputDimVector & u,
+                                  Eigen::Ref<IneqStateDimMatrix> ineq_const_deriv_x,
+                                  Eigen::Ref<IneqInputDimMatrix> ineq_const_deriv_u) const override
+  {
+    nmpc_common::ProblemProfile::ScopedCall call(*this->profile_, IneqConstDeriv);
+    this->problem_->calcIneqConstDeriv(t, x, u, ineq_const_deriv_x, ineq_const_deriv_u);
+  }
+};
+} // namespace nmpc_fmpc
@@ -0,0 +1,13 @@
+/* Author: Masaki Murooka */
+
+#include <nmpc_fmpc/FmpcSolver.h>
+
+// The instantiations must be consistent with the extern template declarations in FmpcSolver.hpp
+namespace nmpc_fmpc
+{
+template class FmpcSolver<2, 1, 3>;
+template class FmpcSolver<4, 1, 4>;
+template class FmpcSolver<4, Eigen::Dynamic, Eigen::Dynamic>;
+template class FmpcSolver<9, Eigen::Dynamic, Eigen::Dynamic>;
+template class FmpcSolver<Eigen::Dynamic, Eigen::Dynamic, Eigen::Dynamic>;
+} // namespace nmpc_fmpc
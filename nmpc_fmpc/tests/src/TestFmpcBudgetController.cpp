@@ -0,0 +1,63 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/BudgetController.h>
+#include <nmpc_fmpc/FmpcMpcRunner.h>
+
+#include "FmpcProblemCartPole.h"
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+
+TEST(TestFmpcBudgetController, CartPole)
+{
+  // Instantiate problem and solver
+  double horizon_dt = 0.01; // [sec]
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(horizon_dt, [](double // t
+                                                                           ) { return 0.0; });
+  auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+  fmpc_solver->config().print_level = 0;
+  fmpc_solver->config().horizon_steps = 200;
+  fmpc_solver->config().max_iter = 5;
+
+  // Instantiate controller
+  nmpc_ddp::BudgetController<FmpcSolverCartPole> controller(fmpc_solver);
+  controller.config().window_size = 5;
+  controller.config().target_latency = 1e-6;
+  controller.config().min_horizon_steps = 50;
+  controller.config().min_max_iter = 5;
+
+  // Run closed-loop simulation with a target latency that cannot be achieved
+  double mpc_dt = 0.01; // [sec]
+  FmpcSolverCartPole::Variable variable(fmpc_solver->config().horizon_steps);
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+  FmpcProblemCartPole::StateDimVector x(0.0, 0.5, 0.0, 0.0);
+  for(int i = 0; i < 100; i++)
+  {
+    double t = i * mpc_dt;
+    controller.solve(t, x, variable);
+    EXPECT_EQ(variable.horizon_steps, static_cast<int>(variable.u_list.size()));
+    EXPECT_EQ(variable.x_list.size(), variable.u_list.size() + 1);
+    EXPECT_EQ(variable.lambda_list.size(), variable.u_list.size() + 1);
+    EXPECT_EQ(variable.s_list.size(), variable.u_list.size());
+    EXPECT_EQ(variable.nu_list.size(), variable.u_list.size());
+    x = fmpc_problem->stateEq(t, x, variable.u_list[0], mpc_dt);
+    nmpc_ddp::MpcRunnerAdapter<FmpcSolverCartPole>::shift(variable, 1);
+  }
+
+  // Check that the horizon steps are decreased to the minimum
+  EXPECT_EQ(static_cast<int>(controller.decisionList().size()), 100 / 5);
+  EXPECT_EQ(fmpc_solver->config().horizon_steps, 50);
+  EXPECT_EQ(fmpc_solver->config().max_iter, 5);
+  EXPECT_EQ(controller.decisionList().back().type,
+            nmpc_ddp::BudgetController<FmpcSolverCartPole>::DecisionType::Keep);
+  EXPECT_LT(std::abs(x[1]), 0.1);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
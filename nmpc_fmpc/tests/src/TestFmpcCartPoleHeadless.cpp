@@ -0,0 +1,137 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include <nmpc_ddp/ClosedLoopHarness.h>
+#include <nmpc_fmpc/FmpcSolver.h>
+
+#include "FmpcProblemCartPole.h"
+
+using Variable = typename nmpc_fmpc::FmpcSolver<4, 1, 4>::Variable;
+
+using Harness = nmpc_ddp::ClosedLoopHarness<4, 1>;
+
+void test(Harness::TimeMode time_mode, double end_t)
+{
+  // Instantiate problem
+  double horizon_dt = 0.01; // [sec]
+  double horizon_duration = 2.0; // [sec]
+  double target_pos = 0.0; // [m]
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(horizon_dt, [&](double // t
+                                                                           ) { return target_pos; });
+
+  // Instantiate solver
+  auto fmpc_solver = std::make_shared<nmpc_fmpc::FmpcSolver<4, 1, 4>>(fmpc_problem);
+  fmpc_solver->config().horizon_steps = static_cast<int>(horizon_duration / horizon_dt);
+  fmpc_solver->config().max_iter = 5;
+
+  // Instantiate harness
+  // In the wall-clock mode, a simulated clock is used, where each solve takes solve_duration
+  constexpr double solve_duration = 1e-3; // [sec]
+  double clock_time = 0.0; // [sec]
+  FmpcProblemCartPole::InputDimVector current_u = FmpcProblemCartPole::InputDimVector::Zero();
+  Variable variable(fmpc_solver->config().horizon_steps);
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+  bool first_iter = true;
+  Harness harness(
+      [&](double t, const FmpcProblemCartPole::StateDimVector & x, const FmpcProblemCartPole::InputDimVector & u,
+          double dt) { return fmpc_problem->stateEq(t, x, u, dt); },
+      [&](double t, const FmpcProblemCartPole::StateDimVector & x)
+      {
+        fmpc_solver->solve(t, x, variable);
+        clock_time += solve_duration;
+        current_u = fmpc_solver->variable().u_list[0];
+        variable = fmpc_solver->variable();
+        first_iter = false;
+      },
+      [&](double, // t
+          const FmpcProblemCartPole::StateDimVector & x)
+      {
+        FmpcProblemCartPole::InputDimVector u = current_u;
+        if(!first_iter)
+        {
+          u += fmpc_solver->coeffList().front().K * (fmpc_solver->variable().x_list[0] - x);
+        }
+        return u;
+      });
+  harness.config().time_mode = time_mode;
+  harness.config().sim_dt = 0.002;
+  harness.config().mpc_dt = 0.004;
+  harness.config().end_t = end_t;
+  if(time_mode == Harness::TimeMode::WallClock)
+  {
+    harness.setClock([&]() { return clock_time; }, [&](double time) { clock_time = std::max(clock_time, time); });
+  }
+  harness.setRefFunc([&](double // t
+                     ) { return FmpcProblemCartPole::StateDimVector(target_pos, 0, 0, 0); });
+
+  // Schedule disturbances and target changes as in the GUI of TestFmpcCartPole
+  // The large disturbance is not applied because the input limit is imposed as a hard constraint in FMPC
+  constexpr double dist_force_small = 10; // [N]
+  harness.addDisturbance(3.0, Eigen::Vector1d(dist_force_small));
+  harness.addDisturbance(4.0, Eigen::Vector1d(-1 * dist_force_small));
+  harness.addEvent(5.0, [&]() { target_pos = 2.0; });
+  harness.addEvent(7.0, [&]() { target_pos = 0.0; });
+
+  // Run closed-loop simulation
+  std::string file_path = "/tmp/TestFmpcCartPoleHeadlessResult.txt";
+  std::ofstream ofs(file_path);
+  ofs << "time pos theta vel omega force ref_pos disturbance" << std::endl;
+  harness.setStepFunc(
+      [&](double t, const FmpcProblemCartPole::StateDimVector & x, const FmpcProblemCartPole::InputDimVector & u,
+          const FmpcProblemCartPole::InputDimVector & dist_u)
+      {
+        EXPECT_LT(std::abs(x[0] - target_pos), 1e2);
+        ofs << t << " " << x.transpose() << " " << u.transpose() << " " << target_pos << " " << dist_u.transpose()
+            << std::endl;
+      });
+  FmpcProblemCartPole::StateDimVector initial_x;
+  initial_x << 0, M_PI, 0, 0;
+  const auto & result = harness.run(initial_x);
+
+  // Check result
+  EXPECT_EQ(result.latency.num, static_cast<int>(std::round(end_t / harness.config().mpc_dt)));
+  EXPECT_LE(result.latency.min, result.latency.p50);
+  EXPECT_LE(result.latency.p50, result.latency.p99);
+  EXPECT_LE(result.latency.p99, result.latency.max);
+  if(time_mode == Harness::TimeMode::WallClock)
+  {
+    EXPECT_NEAR(result.latency.mean, 1e3 * solve_duration, 1e-6);
+    EXPECT_EQ(result.latency.deadline_miss_num, 0);
+    EXPECT_EQ(result.sim_overrun_num, 0);
+    EXPECT_NEAR(result.wall_duration, end_t, 1e-6);
+    EXPECT_NEAR(result.real_time_factor, 1.0, 1e-6);
+  }
+  EXPECT_LT(std::abs(result.final_x[0] - target_pos), 1.0);
+  EXPECT_LT(std::abs(result.final_x[1]), 1e-1);
+  EXPECT_LT(std::abs(result.final_x[2]), 1.0);
+  EXPECT_LT(std::abs(result.final_x[3]), 1e-1);
+
+  std::cout << "Tracking error (RMS): " << result.tracking_error_rms.transpose() << std::endl;
+  std::cout << "Run the following commands in gnuplot:\n"
+            << "  set key autotitle columnhead\n"
+            << "  set key noenhanced\n"
+            << "  plot \"" << file_path << "\" u 1:2 w lp, \"\" u 1:3 w lp, \"\" u 1:7 w l lw 3 # State\n"
+            << "  plot \"" << file_path << "\" u 1:6 w lp # Input\n";
+}
+
+TEST(TestFmpcCartPoleHeadless, SimulatedTime)
+{
+  test(Harness::TimeMode::Simulated, 10.0);
+}
+
+TEST(TestFmpcCartPoleHeadless, WallClockTime)
+{
+  test(Harness::TimeMode::WallClock, 10.0);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,89 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include <nmpc_ddp/ConfigTuner.h>
+#include <nmpc_fmpc/FmpcMpcRunner.h>
+
+#include "FmpcProblemCartPole.h"
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+using ConfigTunerCartPole = nmpc_ddp::ConfigTuner<FmpcSolverCartPole>;
+
+TEST(TestFmpcConfigTuner, CartPole)
+{
+  constexpr int horizon_steps = 100;
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(0.01, [](double // t
+                                                                     ) { return 0.0; });
+  FmpcSolverCartPole::Configuration baseline_config;
+  baseline_config.print_level = 0;
+  baseline_config.horizon_steps = horizon_steps;
+  baseline_config.max_iter = 100;
+  baseline_config.kkt_error_thre = 1e-6;
+
+  nmpc_common::ThreadPool::Configuration thread_pool_config;
+  thread_pool_config.thread_num = 2;
+  ConfigTunerCartPole tuner([&]() { return std::make_shared<FmpcSolverCartPole>(fmpc_problem); }, baseline_config);
+  tuner.config().percentile = 0.99;
+  tuner.config().cost_tolerance = 1e-2;
+  tuner.config().candidate_num = 15;
+  tuner.setThreadPool(std::make_shared<nmpc_common::ThreadPool>(thread_pool_config));
+
+  // Sample initial states around the initial posture of the swing-up
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> dist(-0.1, 0.1);
+  std::vector<ConfigTunerCartPole::Sample> sample_list(9);
+  for(auto & sample : sample_list)
+  {
+    sample.x << dist(engine), 0.5 + dist(engine), dist(engine), dist(engine);
+    sample.warm_start = FmpcSolverCartPole::Variable(horizon_steps);
+    sample.warm_start.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+  }
+
+  using Configuration = FmpcSolverCartPole::Configuration;
+  std::vector<ConfigTunerCartPole::Knob> knob_list = {
+      ConfigTunerCartPole::makeKnob("kkt_error_thre", &Configuration::kkt_error_thre,
+                                    std::vector<double>{1e-6, 1e-4, 1e-2}),
+      ConfigTunerCartPole::makeKnob("update_barrier_eps", &Configuration::update_barrier_eps,
+                                    std::vector<bool>{false, true}),
+      ConfigTunerCartPole::makeKnob("init_complementary_variable", &Configuration::init_complementary_variable,
+                                    std::vector<bool>{false, true}),
+      ConfigTunerCartPole::makeKnob("enable_line_search", &Configuration::enable_line_search,
+                                    std::vector<bool>{false, true})};
+
+  auto result = tuner.tune(knob_list, sample_list);
+
+  // Check that the tuned configuration is not slower than the baseline and satisfies the cost tolerance
+  EXPECT_FALSE(result.best.rejected);
+  EXPECT_EQ(result.best.sample_num, static_cast<int>(sample_list.size()));
+  EXPECT_LE(result.best.duration, result.baseline.duration);
+  EXPECT_EQ(result.candidate_list.size(), 16);
+
+  auto solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+  for(const auto & sample : sample_list)
+  {
+    auto solve = [&](const FmpcSolverCartPole::Configuration & config)
+    {
+      solver->config() = config;
+      auto variable = sample.warm_start;
+      EXPECT_TRUE(nmpc_ddp::MpcRunnerAdapter<FmpcSolverCartPole>::solve(*solver, sample.t, sample.x, variable));
+      double cost = fmpc_problem->terminalCost(sample.t + horizon_steps * fmpc_problem->dt(), variable.x_list.back());
+      for(int i = 0; i < horizon_steps; i++)
+      {
+        cost += fmpc_problem->runningCost(sample.t + i * fmpc_problem->dt(), variable.x_list[i], variable.u_list[i]);
+      }
+      return cost;
+    };
+    double baseline_cost = solve(result.baseline.config);
+    double best_cost = solve(result.best.config);
+    EXPECT_LE(best_cost, baseline_cost + tuner.config().cost_tolerance * std::abs(baseline_cost));
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,276 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <nmpc_fmpc/FmpcSolver.h>
+
+/** \brief FMPC problem for a chain of masses connected by springs and dampers between two walls.
+
+    State is [pos_1, ..., pos_N, vel_1, ..., vel_N]. Input is [force_1, ..., force_N].
+    Running cost is sum of the respective quadratic terms of state and input.
+    Terminal cost is quadratic term of state.
+    Inequality constraints are upper and lower limits of input.
+ */
+template<int StateDim, int InputDim, int IneqDim>
+class FmpcProblemMassChain : public nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>
+{
+public:
+  using typename nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>::StateDimVector;
+  using typename nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>::InputDimVector;
+  using typename nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>::IneqDimVector;
+  using typename nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>::StateStateDimMatrix;
+  using typename nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>::InputInputDimMatrix;
+  using typename nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>::StateInputDimMatrix;
+  using typename nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>::IneqStateDimMatrix;
+  using typename nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>::IneqInputDimMatrix;
+
+public:
+  FmpcProblemMassChain(double dt, int mass_num)
+  : nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>(dt, 2 * mass_num), mass_num_(mass_num)
+  {
+    constexpr double stiffness = 10.0;
+    constexpr double damping = 0.5;
+    Eigen::MatrixXd Ac = Eigen::MatrixXd::Zero(2 * mass_num_, 2 * mass_num_);
+    Ac.topRightCorner(mass_num_, mass_num_).setIdentity();
+    for(int i = 0; i < mass_num_; i++)
+    {
+      Ac(mass_num_ + i, i) = -2 * stiffness;
+      if(i > 0)
+      {
+        Ac(mass_num_ + i, i - 1) = stiffness;
+      }
+      if(i < mass_num_ - 1)
+      {
+        Ac(mass_num_ + i, i + 1) = stiffness;
+      }
+      Ac(mass_num_ + i, mass_num_ + i) = -damping;
+    }
+    Eigen::MatrixXd Bc = Eigen::MatrixXd::Zero(2 * mass_num_, mass_num_);
+    Bc.bottomRows(mass_num_).setIdentity();
+
+    A_ = Eigen::MatrixXd::Identity(2 * mass_num_, 2 * mass_num_) + this->dt_ * Ac;
+    B_ = this->dt_ * Bc;
+    ref_x_ = Eigen::VectorXd::Zero(2 * mass_num_);
+    ref_x_.head(mass_num_).setConstant(0.1);
+  }
+
+  using nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>::inputDim;
+  using nmpc_fmpc::FmpcProblem<StateDim, InputDim, IneqDim>::ineqDim;
+
+  virtual int inputDim() const override
+  {
+    return mass_num_;
+  }
+
+  virtual int inputDim(double // t
+  ) const override
+  {
+    return mass_num_;
+  }
+
+  virtual int ineqDim() const override
+  {
+    return 2 * mass_num_;
+  }
+
+  virtual int ineqDim(double // t
+  ) const override
+  {
+    return 2 * mass_num_;
+  }
+
+  virtual StateDimVector stateEq(double, // t
+                                 const StateDimVector & x,
+                                 const InputDimVector & u) const override
+  {
+    return A_ * x + B_ * u;
+  }
+
+  virtual double runningCost(double, // t
+                             const StateDimVector & x,
+                             const InputDimVector & u) const override
+  {
+    return 0.5 * running_x_weight_ * (x - ref_x_).squaredNorm() + 0.5 * running_u_weight_ * u.squaredNorm();
+  }
+
+  virtual double terminalCost(double, // t
+                              const StateDimVector & x) const override
+  {
+    return 0.5 * terminal_x_weight_ * (x - ref_x_).squaredNorm();
+  }
+
+  virtual IneqDimVector ineqConst(double, // t
+                                  const StateDimVector &, // x
+                                  const InputDimVector & u) const override
+  {
+    IneqDimVector g(2 * mass_num_);
+    g << u.array() - u_max_, -u.array() - u_max_;
+    return g;
+  }
+
+  virtual void calcStateEqDeriv(double, // t
+                                const StateDimVector &, // x
+                                const InputDimVector &, // u
+                                Eigen::Ref<StateStateDimMatrix> state_eq_deriv_x,
+                                Eigen::Ref<StateInputDimMatrix> state_eq_deriv_u) const override
+  {
+    state_eq_deriv_x = A_;
+    state_eq_deriv_u = B_;
+  }
+
+  virtual void calcRunningCostDeriv(double, // t
+                                    const StateDimVector & x,
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u) const override
+  {
+    running_cost_deriv_x = running_x_weight_ * (x - ref_x_);
+    running_cost_deriv_u = running_u_weight_ * u;
+  }
+
+  virtual void calcRunningCostDeriv(double t,
+                                    const StateDimVector & x,
+                                    const InputDimVector & u,
+                                    Eigen::Ref<StateDimVector> running_cost_deriv_x,
+                                    Eigen::Ref<InputDimVector> running_cost_deriv_u,
+                                    Eigen::Ref<StateStateDimMatrix> running_cost_deriv_xx,
+                                    Eigen::Ref<InputInputDimMatrix> running_cost_deriv_uu,
+                                    Eigen::Ref<StateInputDimMatrix> running_cost_deriv_xu) const override
+  {
+    calcRunningCostDeriv(t, x, u, running_cost_deriv_x, running_cost_deriv_u);
+    running_cost_deriv_xx.setIdentity();
+    running_cost_deriv_xx *= running_x_weight_;
+    running_cost_deriv_uu.setIdentity();
+    running_cost_deriv_uu *= running_u_weight_;
+    running_cost_deriv_xu.setZero();
+  }
+
+  virtual void calcTerminalCostDeriv(double, // t
+                                     const StateDimVector & x,
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x) const override
+  {
+    terminal_cost_deriv_x = terminal_x_weight_ * (x - ref_x_);
+  }
+
+  virtual void calcTerminalCostDeriv(double t,
+                                     const StateDimVector & x,
+                                     Eigen::Ref<StateDimVector> terminal_cost_deriv_x,
+                                     Eigen::Ref<StateStateDimMatrix> terminal_cost_deriv_xx) const override
+  {
+    calcTerminalCostDeriv(t, x, terminal_cost_deriv_x);
+    terminal_cost_deriv_xx.setIdentity();
+    terminal_cost_deriv_xx *= terminal_x_weight_;
+  }
+
+  virtual void calcIneqConstDeriv(double, // t
+                                  const StateDimVector &, // x
+                                  const InputDimVector &, // u
+                                  Eigen::Ref<IneqStateDimMatrix> ineq_const_deriv_x,
+                                  Eigen::Ref<IneqInputDimMatrix> ineq_const_deriv_u) const override
+  {
+    ineq_const_deriv_x.setZero();
+    ineq_const_deriv_u.topRows(mass_num_).setIdentity();
+    ineq_const_deriv_u.bottomRows(mass_num_) = -1 * Eigen::MatrixXd::Identity(mass_num_, mass_num_);
+  }
+
+protected:
+  int mass_num_;
+
+  Eigen::MatrixXd A_;
+  Eigen::MatrixXd B_;
+  Eigen::VectorXd ref_x_;
+
+  double running_x_weight_ = 1.0;
+  double running_u_weight_ = 1e-2;
+  double terminal_x_weight_ = 10.0;
+  double u_max_ = 1.0;
+};
+
+template<int StateDim, int InputDim, int IneqDim>
+std::shared_ptr<nmpc_fmpc::FmpcSolver<StateDim, InputDim, IneqDim>> solveMassChain(int mass_num, int horizon_steps)
+{
+  using Problem = FmpcProblemMassChain<StateDim, InputDim, IneqDim>;
+  using Solver = nmpc_fmpc::FmpcSolver<StateDim, InputDim, IneqDim>;
+  auto fmpc_problem = std::make_shared<Problem>(0.01, mass_num);
+  auto fmpc_solver = std::make_shared<Solver>(fmpc_problem);
+  fmpc_solver->config().print_level = 0;
+  fmpc_solver->config().horizon_steps = horizon_steps;
+  fmpc_solver->config().max_iter = 10;
+
+  // The dimensions of variables must be set if they are dynamic
+  typename Solver::Variable variable(horizon_steps);
+  for(auto & x : variable.x_list)
+  {
+    x.resize(2 * mass_num);
+  }
+  for(auto & u : variable.u_list)
+  {
+    u.resize(mass_num);
+  }
+  for(auto & lambda : variable.lambda_list)
+  {
+    lambda.resize(2 * mass_num);
+  }
+  for(auto & s : variable.s_list)
+  {
+    s.resize(2 * mass_num);
+  }
+  for(auto & nu : variable.nu_list)
+  {
+    nu.resize(2 * mass_num);
+  }
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+
+  typename Problem::StateDimVector current_x = Problem::StateDimVector::Zero(2 * mass_num);
+  auto status = fmpc_solver->solve(0.0, current_x, variable);
+  EXPECT_TRUE(status == Solver::Status::Succeeded || status == Solver::Status::MaxIterationReached);
+  return fmpc_solver;
+}
+
+TEST(TestFmpcDynamicStateDim, FixedVsDynamic)
+{
+  constexpr int mass_num = 3;
+  constexpr int horizon_steps = 100;
+  auto fixed_solver = solveMassChain<2 * mass_num, mass_num, 2 * mass_num>(mass_num, horizon_steps);
+  auto dynamic_solver = solveMassChain<Eigen::Dynamic, Eigen::Dynamic, Eigen::Dynamic>(mass_num, horizon_steps);
+  auto dynamic_state_solver = solveMassChain<Eigen::Dynamic, mass_num, 2 * mass_num>(mass_num, horizon_steps);
+
+  static_assert(FmpcProblemMassChain<2 * mass_num, mass_num, 2 * mass_num>::stateDim() == 2 * mass_num);
+  EXPECT_EQ(fixed_solver->problem()->runtimeStateDim(), 2 * mass_num);
+  EXPECT_EQ(dynamic_solver->problem()->runtimeStateDim(), 2 * mass_num);
+  EXPECT_THROW(dynamic_solver->problem()->stateDim(), std::runtime_error);
+  EXPECT_EQ(dynamic_solver->traceDataList().size(), fixed_solver->traceDataList().size());
+  EXPECT_EQ(dynamic_state_solver->traceDataList().size(), fixed_solver->traceDataList().size());
+  for(int i = 0; i < horizon_steps; i++)
+  {
+    EXPECT_LT((dynamic_solver->variable().u_list[i] - fixed_solver->variable().u_list[i]).norm(), 1e-8)
+        << "i: " << i;
+    EXPECT_LT((dynamic_state_solver->variable().u_list[i] - fixed_solver->variable().u_list[i]).norm(), 1e-8)
+        << "i: " << i;
+  }
+  EXPECT_LT((dynamic_solver->variable().x_list.back() - fixed_solver->variable().x_list.back()).norm(), 1e-8);
+}
+
+TEST(TestFmpcDynamicStateDim, LargeModel)
+{
+  // 200 states, 100 inputs
+  constexpr int mass_num = 100;
+  constexpr int horizon_steps = 50;
+  auto fmpc_solver = solveMassChain<Eigen::Dynamic, Eigen::Dynamic, Eigen::Dynamic>(mass_num, horizon_steps);
+
+  // Check that the masses are moved toward the reference position within the input limits
+  const Eigen::VectorXd & terminal_x = fmpc_solver->variable().x_list.back();
+  EXPECT_EQ(terminal_x.size(), 2 * mass_num);
+  EXPECT_TRUE(terminal_x.allFinite());
+  EXPECT_GT(terminal_x.head(mass_num).minCoeff(), 0.0);
+  for(const auto & u : fmpc_solver->variable().u_list)
+  {
+    EXPECT_LE(u.cwiseAbs().maxCoeff(), 1.0 + 1e-3);
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,56 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/EventTriggeredMpc.h>
+#include <nmpc_fmpc/FmpcMpcRunner.h>
+
+#include "FmpcProblemCartPole.h"
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+
+TEST(TestFmpcEventTriggeredMpc, CartPole)
+{
+  // Instantiate problem and solver
+  double horizon_dt = 0.01; // [sec]
+  double horizon_duration = 2.0; // [sec]
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(horizon_dt, [](double // t
+                                                                           ) { return 0.0; });
+  auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+  fmpc_solver->config().print_level = 0;
+  fmpc_solver->config().horizon_steps = static_cast<int>(horizon_duration / horizon_dt);
+  fmpc_solver->config().max_iter = 5;
+
+  // Instantiate event-triggered MPC
+  FmpcSolverCartPole::Variable variable(fmpc_solver->config().horizon_steps);
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+  nmpc_ddp::EventTriggeredMpc<FmpcSolverCartPole> mpc(fmpc_solver, variable);
+  mpc.config().partial_error_thre = 1e-3;
+  mpc.config().full_error_thre = 1e-2;
+
+  // Run closed-loop simulation with input calculation in every simulation step
+  double sim_dt = 0.002; // [sec]
+  int sim_step_num = 2500;
+  FmpcProblemCartPole::StateDimVector x(0.0, 0.5, 0.0, 0.0);
+  for(int i = 0; i < sim_step_num; i++)
+  {
+    double t = i * sim_dt;
+    x = fmpc_problem->stateEq(t, x, mpc.calcInput(t, x), sim_dt);
+  }
+
+  const auto & statistics = mpc.statistics();
+  statistics.print();
+  EXPECT_EQ(statistics.step_num, sim_step_num);
+  EXPECT_LT(statistics.triggerRate(), 0.5);
+  EXPECT_GT(statistics.full_solve_num, 0);
+  EXPECT_LT(std::abs(x[0]), 0.5);
+  EXPECT_LT(std::abs(x[1]), 0.05);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
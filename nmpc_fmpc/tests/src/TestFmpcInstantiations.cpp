@@ -0,0 +1,47 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_fmpc/FmpcSolver.h>
+
+#include "FmpcProblemCartPole.h"
+
+#ifndef NMPC_FMPC_EXTERN_TEMPLATES
+#  error "NMPC_FMPC_EXTERN_TEMPLATES must be defined by linking nmpc_fmpc_instantiations."
+#endif
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+
+TEST(TestFmpcInstantiations, CartPole)
+{
+  // FmpcSolver<4, 1, 4> is not instantiated in this translation unit but linked from nmpc_fmpc_instantiations
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(0.01, [](double // t
+                                                                   ) { return 0.0; });
+  auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+  fmpc_solver->config().print_level = 0;
+  fmpc_solver->config().horizon_steps = 200;
+  fmpc_solver->config().max_iter = 10;
+
+  FmpcProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  FmpcSolverCartPole::Variable variable(200);
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+  auto status = fmpc_solver->solve(0.0, current_x, variable);
+  EXPECT_TRUE(status == FmpcSolverCartPole::Status::Succeeded
+              || status == FmpcSolverCartPole::Status::MaxIterationReached);
+
+  const auto & u_list = fmpc_solver->variable().u_list;
+  EXPECT_EQ(u_list.size(), 200);
+  for(const auto & u : u_list)
+  {
+    EXPECT_TRUE(u.allFinite());
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,67 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <thread>
+
+#include <nmpc_fmpc/FmpcMpcRunner.h>
+
+#include "FmpcProblemCartPole.h"
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+
+TEST(TestFmpcMpcRunner, CartPole)
+{
+  // Instantiate problem
+  double horizon_dt = 0.01; // [sec]
+  double horizon_duration = 2.0; // [sec]
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(horizon_dt, [](double // t
+                                                                           ) { return 0.0; });
+
+  // Instantiate solver
+  auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+  fmpc_solver->config().horizon_steps = static_cast<int>(horizon_duration / horizon_dt);
+  fmpc_solver->config().max_iter = 5;
+
+  // Instantiate runner
+  FmpcSolverCartPole::Variable variable(fmpc_solver->config().horizon_steps);
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+  nmpc_ddp::MpcRunner<FmpcSolverCartPole> runner(fmpc_solver, variable);
+  runner.start();
+
+  // Run closed-loop simulation in which the control thread waits for the solution of each state
+  double sim_dt = 0.002; // [sec]
+  double mpc_dt = 0.02; // [sec]
+  double end_t = 5.0; // [sec]
+  FmpcProblemCartPole::StateDimVector x(0.0, 0.5, 0.0, 0.0);
+  int mpc_count = 0;
+  for(double t = 0; t < end_t; t += mpc_dt)
+  {
+    runner.setState(t, x);
+    mpc_count++;
+    while(!runner.updateSolution() || runner.solution().solve_count < mpc_count)
+    {
+      std::this_thread::yield();
+    }
+    const auto & solution = runner.solution();
+    EXPECT_TRUE(solution.valid);
+    EXPECT_EQ(solution.t, t);
+    EXPECT_EQ(solution.u_list.size(), fmpc_solver->config().horizon_steps);
+
+    for(double sim_t = t; sim_t < t + mpc_dt - 1e-10; sim_t += sim_dt)
+    {
+      x = fmpc_problem->stateEq(sim_t, x, runner.calcInput(sim_t), sim_dt);
+    }
+  }
+  EXPECT_LT(std::abs(x[0]), 0.5);
+  EXPECT_LT(std::abs(x[1]), 0.05);
+
+  runner.stop();
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,91 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+#include <nmpc_ddp/ParameterSweep.h>
+#include <nmpc_fmpc/FmpcMpcRunner.h>
+
+#include "FmpcProblemCartPole.h"
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+using ParameterSweepCartPole = nmpc_ddp::ParameterSweep<FmpcSolverCartPole, FmpcProblemCartPole::Param>;
+
+std::shared_ptr<ParameterSweepCartPole> makeParameterSweep(int horizon_steps)
+{
+  auto sweep = std::make_shared<ParameterSweepCartPole>(
+      [](const FmpcProblemCartPole::Param & param)
+      {
+        return std::make_shared<FmpcProblemCartPole>(
+            0.01, [](double // t
+                  ) { return 0.0; }, param);
+      },
+      [horizon_steps](const std::shared_ptr<nmpc_fmpc::FmpcProblem<4, 1, 4>> & problem)
+      {
+        auto solver = std::make_shared<FmpcSolverCartPole>(problem);
+        solver->config().print_level = 0;
+        solver->config().horizon_steps = horizon_steps;
+        solver->config().max_iter = 100;
+        return solver;
+      });
+  sweep->config().chunk_size = 8;
+  return sweep;
+}
+
+TEST(TestFmpcParameterSweep, CartPole)
+{
+  // Sweep the model parameters
+  constexpr int horizon_steps = 100;
+  std::vector<FmpcProblemCartPole::Param> param_list;
+  auto point_list = ParameterSweepCartPole::makeGrid({{0.8, 1.0, 1.2}, {0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0}});
+  for(const auto & point : point_list)
+  {
+    FmpcProblemCartPole::Param param;
+    param.cart_mass = point[0];
+    param.pole_mass = point[1];
+    param_list.push_back(param);
+  }
+
+  FmpcProblemCartPole::StateDimVector x(0.0, 0.5, 0.0, 0.0);
+  FmpcSolverCartPole::Variable initial_variable(horizon_steps);
+  initial_variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+
+  auto serial_sweep = makeParameterSweep(horizon_steps);
+  auto serial_table = serial_sweep->run(param_list, 0.0, x, initial_variable);
+
+  nmpc_common::ThreadPool::Configuration thread_pool_config;
+  thread_pool_config.thread_num = 2;
+  auto parallel_sweep = makeParameterSweep(horizon_steps);
+  parallel_sweep->setThreadPool(std::make_shared<nmpc_common::ThreadPool>(thread_pool_config));
+  auto parallel_table = parallel_sweep->run(param_list, 0.0, x, initial_variable);
+
+  auto cold_sweep = makeParameterSweep(horizon_steps);
+  cold_sweep->config().warm_start_from_neighbor = false;
+  auto cold_table = cold_sweep->run(param_list, 0.0, x, initial_variable);
+
+  ASSERT_EQ(serial_table.rowNum(), param_list.size());
+  for(size_t i = 0; i < param_list.size(); i++)
+  {
+    EXPECT_EQ(serial_table.column("succeeded")[i], 1) << "i: " << i;
+
+    // Check that the results do not depend on the thread pool
+    EXPECT_EQ(serial_table.column("cost")[i], parallel_table.column("cost")[i]) << "i: " << i;
+    EXPECT_EQ(serial_table.column("iter")[i], parallel_table.column("iter")[i]) << "i: " << i;
+
+    // Check that the warm-start does not change the solution
+    EXPECT_NEAR(serial_table.column("cost")[i], cold_table.column("cost")[i],
+                1e-2 * std::abs(cold_table.column("cost")[i]))
+        << "i: " << i;
+  }
+
+  // Check that the warm-start reduces the iterations
+  auto sum = [](const std::vector<double> & column) { return std::accumulate(column.begin(), column.end(), 0.0); };
+  EXPECT_LT(sum(serial_table.column("iter")), sum(cold_table.column("iter")));
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,68 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_fmpc/FmpcSolver.h>
+
+#include "FmpcProblemCartPole.h"
+#include "PerfRegression.h"
+
+// The steps of horizon are also measured to record the durations of the gain calculation
+using FmpcSolverPerf = nmpc_fmpc::FmpcSolver<4, 1, 4, nmpc_fmpc::FmpcStepInstrumentedPolicy>;
+using Variable = typename FmpcSolverPerf::Variable;
+
+TEST(TestFmpcPerf, CartPoleSwingUp)
+{
+  nmpc_ddp::PerfRegression perf("TestFmpcPerf.CartPoleSwingUp", NMPC_PERF_BASELINE_DIR);
+
+  // Instantiate problem
+  double horizon_dt = 0.01; // [sec]
+  double horizon_duration = 2.0; // [sec]
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(horizon_dt, [](double // t
+                                                                        ) { return 0.0; });
+
+  perf.run(
+      [&]()
+      {
+        // Instantiate solver
+        auto fmpc_solver = std::make_shared<FmpcSolverPerf>(fmpc_problem);
+        fmpc_solver->config().print_level = 0;
+        fmpc_solver->config().horizon_steps = static_cast<int>(horizon_duration / horizon_dt);
+        fmpc_solver->config().max_iter = 50;
+
+        // Solve from cold start
+        FmpcProblemCartPole::StateDimVector initial_x;
+        initial_x << 0, M_PI, 0, 0;
+        Variable initial_variable(fmpc_solver->config().horizon_steps);
+        initial_variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+        fmpc_solver->solve(0, initial_x, initial_variable);
+
+        // Add samples
+        const auto & duration = fmpc_solver->computationDuration();
+        perf.addDuration("solve", duration.solve);
+        perf.addDuration("setup", duration.setup);
+        perf.addDuration("opt", duration.opt);
+        perf.addDuration("coeff", duration.coeff);
+        perf.addDuration("backward", duration.backward);
+        perf.addDuration("forward", duration.forward);
+        perf.addDuration("update", duration.update);
+        perf.addDuration("gain_pre", duration.gain_pre);
+        perf.addDuration("gain_solve", duration.gain_solve);
+        perf.addDuration("gain_post", duration.gain_post);
+        perf.addDuration("fraction", duration.fraction);
+        perf.addCount("iter", fmpc_solver->traceDataList().back().iter);
+      });
+
+  for(const auto & failure : perf.check())
+  {
+    ADD_FAILURE() << failure;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
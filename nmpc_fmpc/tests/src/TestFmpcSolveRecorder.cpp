@@ -0,0 +1,71 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_ddp/SolveRecorder.h>
+#include <nmpc_ddp/SolveReplayer.h>
+#include <nmpc_fmpc/FmpcSolver.h>
+
+#include "FmpcProblemCartPole.h"
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+
+using Variable = typename FmpcSolverCartPole::Variable;
+
+TEST(TestFmpcSolveRecorder, RecordAndReplay)
+{
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(0.01, [](double // t
+                                                                   ) { return 0.0; });
+  std::string file_path = "/tmp/TestFmpcSolveRecorder.bin";
+
+  // Record closed-loop solves
+  constexpr int record_num = 30;
+  {
+    auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+    fmpc_solver->config().print_level = 0;
+    fmpc_solver->config().horizon_steps = 100;
+    fmpc_solver->config().max_iter = 5;
+    auto recorder = std::make_shared<nmpc_ddp::SolveRecorder>(file_path);
+    fmpc_solver->setRecorder(recorder);
+
+    double sim_dt = 0.01; // [sec]
+    double current_t = 0;
+    FmpcProblemCartPole::StateDimVector current_x;
+    current_x << 0, M_PI, 0, 0;
+    Variable variable(fmpc_solver->config().horizon_steps);
+    variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+    for(int i = 0; i < record_num; i++)
+    {
+      fmpc_solver->solve(current_t, current_x, variable);
+      variable = fmpc_solver->variable();
+      current_x = fmpc_problem->stateEq(current_t, current_x, variable.u_list[0], sim_dt);
+      current_t += sim_dt;
+    }
+    EXPECT_EQ(recorder->recordNum(), record_num);
+  }
+
+  // Replay records with another solver
+  {
+    auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+    nmpc_ddp::SolveReplayer<FmpcSolverCartPole> replayer(fmpc_solver);
+    const auto & result_list = replayer.replay(file_path);
+    ASSERT_EQ(result_list.size(), record_num);
+    for(const auto & result : result_list)
+    {
+      EXPECT_EQ(result.recorded_iter, result.replayed_iter);
+      EXPECT_LT(result.output_error, 1e-10);
+    }
+
+    // Replay the last record, which depends on the barrier parameter updated in the previous solves
+    const auto & result = replayer.replay(file_path, record_num - 1);
+    EXPECT_LT(result.output_error, 1e-10);
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,116 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <nmpc_fmpc/FmpcSolver.h>
+
+#include "FmpcProblemCartPole.h"
+
+template<class Policy>
+std::shared_ptr<nmpc_fmpc::FmpcSolver<4, 1, 4, Policy>> solve()
+{
+  using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4, Policy>;
+
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(0.01, [](double // t
+                                                                   ) { return 0.0; });
+  auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+  fmpc_solver->config().print_level = 1;
+  fmpc_solver->config().horizon_steps = 100;
+  fmpc_solver->config().max_iter = 10;
+  fmpc_solver->config().check_nan = false;
+
+  FmpcProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  typename FmpcSolverCartPole::Variable variable(fmpc_solver->config().horizon_steps);
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+  fmpc_solver->solve(0.0, current_x, variable);
+
+  return fmpc_solver;
+}
+
+TEST(TestFmpcSolverPolicy, StaticPolicy)
+{
+  auto runtime_solver = solve<nmpc_fmpc::FmpcRuntimePolicy>();
+  auto static_solver = solve<nmpc_fmpc::FmpcStaticPolicy<>>();
+
+  const auto & runtime_u_list = runtime_solver->variable().u_list;
+  const auto & static_u_list = static_solver->variable().u_list;
+  ASSERT_EQ(runtime_u_list.size(), static_u_list.size());
+  for(size_t i = 0; i < runtime_u_list.size(); i++)
+  {
+    EXPECT_LT((runtime_u_list[i] - static_u_list[i]).norm(), 1e-10) << "i: " << i;
+  }
+  EXPECT_EQ(runtime_solver->traceDataList().size(), static_solver->traceDataList().size());
+}
+
+TEST(TestFmpcSolverPolicy, Instrumentation)
+{
+  {
+    auto fmpc_solver = solve<nmpc_fmpc::FmpcStepInstrumentedPolicy>();
+    const auto & computation_duration = fmpc_solver->computationDuration();
+    EXPECT_GT(computation_duration.solve, 0.0);
+    EXPECT_GT(computation_duration.backward, 0.0);
+    EXPECT_GT(computation_duration.gain_solve, 0.0);
+  }
+  {
+    auto fmpc_solver = solve<nmpc_fmpc::FmpcRuntimePolicy>();
+    const auto & computation_duration = fmpc_solver->computationDuration();
+    EXPECT_GT(computation_duration.solve, 0.0);
+    EXPECT_GT(computation_duration.backward, 0.0);
+    EXPECT_EQ(computation_duration.gain_solve, 0.0);
+  }
+  {
+    auto fmpc_solver = solve<nmpc_fmpc::FmpcStaticPolicy<false, 1, nmpc_ddp::Instrumentation::Phase>>();
+    const auto & computation_duration = fmpc_solver->computationDuration();
+    EXPECT_GT(computation_duration.solve, 0.0);
+    EXPECT_GT(computation_duration.backward, 0.0);
+    EXPECT_EQ(computation_duration.gain_solve, 0.0);
+  }
+  {
+    auto fmpc_solver = solve<nmpc_fmpc::FmpcStaticPolicy<false, 1, nmpc_ddp::Instrumentation::None>>();
+    const auto & computation_duration = fmpc_solver->computationDuration();
+    EXPECT_EQ(computation_duration.solve, 0.0);
+    EXPECT_EQ(computation_duration.backward, 0.0);
+    EXPECT_EQ(computation_duration.gain_solve, 0.0);
+  }
+}
+
+TEST(TestFmpcSolverPolicy, NaNEvent)
+{
+  using Policy = nmpc_fmpc::FmpcStaticPolicy<true, 1, nmpc_ddp::Instrumentation::Phase, nmpc_ddp::CallbackObserver>;
+  using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4, Policy>;
+
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(0.01, [](double // t
+                                                                   ) { return 0.0; });
+  auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+  fmpc_solver->config().horizon_steps = 100;
+  fmpc_solver->config().max_iter = 10;
+
+  // Check that NaN is notified to the observer as a failure event naming the variable
+  std::vector<std::string> failure_message_list;
+  fmpc_solver->observer().callback = [&failure_message_list](const nmpc_ddp::SolverEvent & event)
+  {
+    if(event.type == nmpc_ddp::SolverEventType::Failure)
+    {
+      failure_message_list.push_back(event.message);
+    }
+  };
+  FmpcProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, std::numeric_limits<double>::quiet_NaN(), 0;
+  typename FmpcSolverCartPole::Variable variable(fmpc_solver->config().horizon_steps);
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+  EXPECT_EQ(fmpc_solver->solve(0.0, current_x, variable), FmpcSolverCartPole::Status::ErrorInForward);
+  ASSERT_EQ(failure_message_list.size(), 1);
+  EXPECT_EQ(failure_message_list[0], "variable.x contains NaN or infinity.");
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
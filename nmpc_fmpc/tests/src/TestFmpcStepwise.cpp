@@ -0,0 +1,78 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_fmpc/FmpcSolver.h>
+
+#include "FmpcProblemCartPole.h"
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+
+std::shared_ptr<FmpcSolverCartPole> makeSolver(double target_pos)
+{
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(0.01, [target_pos](double // t
+                                                                               ) { return target_pos; });
+  auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+  fmpc_solver->config().print_level = 0;
+  fmpc_solver->config().horizon_steps = 100;
+  fmpc_solver->config().max_iter = 10;
+  return fmpc_solver;
+}
+
+TEST(TestFmpcStepwise, Interleave)
+{
+  constexpr int solver_num = 3;
+  FmpcProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  FmpcSolverCartPole::Variable variable(100);
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+
+  // Solve by solve()
+  std::vector<std::shared_ptr<FmpcSolverCartPole>> ref_solver_list;
+  std::vector<FmpcSolverCartPole::Status> ref_status_list;
+  for(int i = 0; i < solver_num; i++)
+  {
+    ref_solver_list.push_back(makeSolver(0.5 * i));
+    ref_status_list.push_back(ref_solver_list[i]->solve(0.0, current_x, variable));
+  }
+
+  // Solve by interleaving steps of solvers
+  std::vector<std::shared_ptr<FmpcSolverCartPole>> solver_list;
+  for(int i = 0; i < solver_num; i++)
+  {
+    solver_list.push_back(makeSolver(0.5 * i));
+    EXPECT_TRUE(solver_list[i]->done());
+    solver_list[i]->begin(0.0, current_x, variable);
+  }
+  bool all_done = false;
+  while(!all_done)
+  {
+    all_done = true;
+    for(auto & solver : solver_list)
+    {
+      all_done = solver->step() && all_done;
+    }
+  }
+
+  // Check that the results are identical
+  for(int i = 0; i < solver_num; i++)
+  {
+    EXPECT_EQ(solver_list[i]->result(), ref_status_list[i]);
+    EXPECT_EQ(solver_list[i]->traceDataList().size(), ref_solver_list[i]->traceDataList().size());
+    const auto & u_list = solver_list[i]->variable().u_list;
+    const auto & ref_u_list = ref_solver_list[i]->variable().u_list;
+    ASSERT_EQ(u_list.size(), ref_u_list.size());
+    for(size_t j = 0; j < u_list.size(); j++)
+    {
+      EXPECT_EQ(u_list[j], ref_u_list[j]) << "i: " << i << ", j: " << j;
+    }
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,78 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <thread>
+
+#include <nmpc_fmpc/FmpcSolver.h>
+
+#include "FmpcProblemCartPole.h"
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+
+std::shared_ptr<FmpcSolverCartPole> makeSolver(double target_pos)
+{
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(0.01, [target_pos](double // t
+                                                                               ) { return target_pos; });
+  auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+  fmpc_solver->config().print_level = 0;
+  fmpc_solver->config().horizon_steps = 200;
+  fmpc_solver->config().max_iter = 10;
+  return fmpc_solver;
+}
+
+TEST(TestFmpcThreadPool, CartPole)
+{
+  constexpr int solver_num = 3;
+  FmpcProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  FmpcSolverCartPole::Variable variable(200);
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+
+  // Solve serially
+  std::vector<std::shared_ptr<FmpcSolverCartPole>> ref_solver_list;
+  std::vector<FmpcSolverCartPole::Status> ref_status_list;
+  for(int i = 0; i < solver_num; i++)
+  {
+    ref_solver_list.push_back(makeSolver(0.5 * i));
+    ref_status_list.push_back(ref_solver_list[i]->solve(0.0, current_x, variable));
+  }
+
+  // Solve concurrently from multiple threads sharing one thread pool
+  nmpc_common::ThreadPool::Configuration config;
+  config.thread_num = 2;
+  auto thread_pool = std::make_shared<nmpc_common::ThreadPool>(config);
+  std::vector<std::shared_ptr<FmpcSolverCartPole>> solver_list;
+  std::vector<FmpcSolverCartPole::Status> status_list(solver_num);
+  std::vector<std::thread> thread_list;
+  for(int i = 0; i < solver_num; i++)
+  {
+    solver_list.push_back(makeSolver(0.5 * i));
+    solver_list[i]->setThreadPool(thread_pool);
+  }
+  for(int i = 0; i < solver_num; i++)
+  {
+    thread_list.emplace_back([&, i]() { status_list[i] = solver_list[i]->solve(0.0, current_x, variable); });
+  }
+  for(auto & thread : thread_list)
+  {
+    thread.join();
+  }
+
+  // Check that the results are identical
+  for(int i = 0; i < solver_num; i++)
+  {
+    EXPECT_EQ(status_list[i], ref_status_list[i]);
+    EXPECT_EQ(solver_list[i]->traceDataList().size(), ref_solver_list[i]->traceDataList().size());
+    EXPECT_EQ(solver_list[i]->variable().x_list, ref_solver_list[i]->variable().x_list);
+    EXPECT_EQ(solver_list[i]->variable().u_list, ref_solver_list[i]->variable().u_list);
+    EXPECT_EQ(solver_list[i]->variable().lambda_list, ref_solver_list[i]->variable().lambda_list);
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,82 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+
+#include <nmpc_ddp/WarmStartCache.h>
+#include <nmpc_fmpc/FmpcMpcRunner.h>
+
+#include "FmpcProblemCartPole.h"
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+using WarmStartCacheCartPole = nmpc_ddp::WarmStartCache<FmpcSolverCartPole>;
+
+TEST(TestFmpcWarmStartCache, CartPole)
+{
+  std::string file_path = "/tmp/TestFmpcWarmStartCache.bin";
+  std::remove(file_path.c_str());
+
+  constexpr int horizon_steps = 200;
+  // x_list and lambda_list have (N + 1) vectors, and u_list, s_list, and nu_list have N vectors
+  constexpr int max_data_size = 5 + 2 * (horizon_steps + 1) * (1 + 4) + horizon_steps * ((1 + 1) + 2 * (1 + 4));
+  double target_pos = 0.0;
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(0.01, [&](double // t
+                                                                      ) { return target_pos; });
+  auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+  fmpc_solver->config().print_level = 0;
+  fmpc_solver->config().horizon_steps = horizon_steps;
+  fmpc_solver->config().max_iter = 100;
+
+  FmpcProblemCartPole::StateDimVector current_x(0, 0.5, 0, 0);
+  FmpcSolverCartPole::Variable cold_variable(horizon_steps);
+  cold_variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+  auto solve = [&](FmpcSolverCartPole::Variable & variable)
+  {
+    EXPECT_TRUE(nmpc_ddp::MpcRunnerAdapter<FmpcSolverCartPole>::solve(*fmpc_solver, 0.0, current_x, variable));
+    return fmpc_solver->traceDataList().back().iter;
+  };
+
+  // Fill library with the solutions for various target positions
+  FmpcSolverCartPole::Variable inserted_variable;
+  {
+    WarmStartCacheCartPole cache(file_path, 5, max_data_size);
+    for(double pos : {-0.8, -0.4, 0.0, 0.4, 0.8})
+    {
+      target_pos = pos;
+      FmpcSolverCartPole::Variable variable = cold_variable;
+      solve(variable);
+      cache.insert(current_x, Eigen::VectorXd::Constant(1, target_pos), variable);
+      inserted_variable = variable;
+    }
+  }
+
+  // Check that all optimization variables are restored
+  WarmStartCacheCartPole cache(file_path, 5, max_data_size);
+  EXPECT_EQ(cache.size(), 5);
+  FmpcSolverCartPole::Variable variable;
+  ASSERT_TRUE(cache.lookup(current_x, Eigen::VectorXd::Constant(1, 0.8), variable));
+  EXPECT_EQ(variable.horizon_steps, horizon_steps);
+  EXPECT_EQ(variable.x_list, inserted_variable.x_list);
+  EXPECT_EQ(variable.u_list, inserted_variable.u_list);
+  EXPECT_EQ(variable.lambda_list, inserted_variable.lambda_list);
+  EXPECT_EQ(variable.s_list, inserted_variable.s_list);
+  EXPECT_EQ(variable.nu_list, inserted_variable.nu_list);
+
+  // Check that a solve for a similar target position is warm-started
+  target_pos = 0.7;
+  variable = cold_variable;
+  int cold_iter = solve(variable);
+  ASSERT_TRUE(cache.lookup(current_x, Eigen::VectorXd::Constant(1, target_pos), variable));
+  int warm_iter = solve(variable);
+  EXPECT_LT(warm_iter, cold_iter);
+
+  std::remove(file_path.c_str());
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,60 @@
+/* Author: Masaki Murooka */
+
+// AllocationCounter.h must be included before any Eigen header
+#include <nmpc_common/AllocationCounter.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_fmpc/FmpcSolver.h>
+
+#include "FmpcProblemCartPole.h"
+
+NMPC_DEFINE_ALLOCATION_COUNTER()
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+
+using Variable = typename FmpcSolverCartPole::Variable;
+
+TEST(TestFmpcZeroAllocation, FmpcSolver)
+{
+  auto fmpc_problem = std::make_shared<FmpcProblemCartPole>(0.01, [](double // t
+                                                                   ) { return 0.0; });
+  auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(fmpc_problem);
+  fmpc_solver->config().print_level = 0;
+  fmpc_solver->config().horizon_steps = 100;
+  fmpc_solver->config().max_iter = 5;
+
+  double sim_dt = 0.01; // [sec]
+  double current_t = 0;
+  FmpcProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  Variable variable(fmpc_solver->config().horizon_steps);
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+
+  // Warm up (the buffers are allocated in the first solve)
+  {
+    nmpc_common::AllocationCounter counter;
+    fmpc_solver->solve(current_t, current_x, variable);
+    EXPECT_GT(counter.stop(), 0);
+  }
+
+  // Check that no memory is allocated in steady state
+  for(int i = 0; i < 10; i++)
+  {
+    variable = fmpc_solver->variable();
+    current_x = fmpc_problem->stateEq(current_t, current_x, variable.u_list[0], sim_dt);
+    current_t += sim_dt;
+
+    nmpc_common::AllocationCounter counter;
+    fmpc_solver->solve(current_t, current_x, variable);
+    EXPECT_EQ(counter.stop(), 0) << "solve: " << i;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,64 @@
+/* Author: Masaki Murooka */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <nmpc_fmpc/FmpcSolver.h>
+#include <nmpc_fmpc/ProfiledFmpcProblem.h>
+
+#include "FmpcProblemCartPole.h"
+
+using FmpcSolverCartPole = nmpc_fmpc::FmpcSolver<4, 1, 4>;
+
+std::shared_ptr<FmpcSolverCartPole> makeSolver(const std::shared_ptr<nmpc_fmpc::FmpcProblem<4, 1, 4>> & problem)
+{
+  auto fmpc_solver = std::make_shared<FmpcSolverCartPole>(problem);
+  fmpc_solver->config().print_level = 0;
+  fmpc_solver->config().horizon_steps = 200;
+  fmpc_solver->config().max_iter = 10;
+  return fmpc_solver;
+}
+
+TEST(TestProfiledFmpcProblem, CartPole)
+{
+  constexpr int horizon_steps = 200;
+  FmpcProblemCartPole::StateDimVector current_x;
+  current_x << 0, M_PI, 0, 0;
+  FmpcSolverCartPole::Variable variable(horizon_steps);
+  variable.reset(0.0, 0.0, 0.0, 1e0, 1e0);
+  auto make_problem = []()
+  {
+    return std::make_shared<FmpcProblemCartPole>(0.01, [](double // t
+                                                       ) { return 0.0; });
+  };
+
+  // Solve without profile
+  auto ref_solver = makeSolver(make_problem());
+  auto ref_status = ref_solver->solve(0.0, current_x, variable);
+
+  // Solve with profile
+  auto profiled_problem = std::make_shared<nmpc_fmpc::ProfiledFmpcProblem<4, 1, 4>>(make_problem());
+  auto solver = makeSolver(profiled_problem);
+  EXPECT_EQ(solver->solve(0.0, current_x, variable), ref_status);
+
+  // Check that the results are identical
+  EXPECT_EQ(solver->traceDataList().size(), ref_solver->traceDataList().size());
+  EXPECT_EQ(solver->variable().u_list, ref_solver->variable().u_list);
+
+  // Check the number of calls in the solve
+  auto report = profiled_problem->profile().takeReport();
+  report.print();
+  int iter_num = static_cast<int>(solver->traceDataList().size());
+  EXPECT_EQ(report.find("calcStateEqDeriv")->count, iter_num * horizon_steps);
+  EXPECT_EQ(report.find("calcIneqConstDeriv")->count, iter_num * horizon_steps);
+  EXPECT_GE(report.find("ineqConst")->count, iter_num * horizon_steps);
+  EXPECT_EQ(report.find("calcTerminalCostDeriv (2nd)")->count, iter_num);
+  EXPECT_EQ(profiled_problem->profile().report().totalCount(), 0);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}